@@ -0,0 +1,149 @@
+#ifndef __ARCHIVE_H__
+#define __ARCHIVE_H__
+
+#include "lightning.h"
+
+/**
+ * @file	archive.h
+ * @brief	compact storage for large libraries of pre-generated bolts. points are quantized to a per-bolt grid around the bolt's first
+ *			point and stored either as int16 offsets or, when every step along the bolt fits, as int8 deltas. thickness is a half float.
+ *			decoding expands straight into a Bolt's points, with an SSE2 path for batches.
+ *
+ *			the file is a 16 byte header ("LSBA", version, 3 reserved bytes, number of bolts, number of data bytes), a 20 byte
+ *			record for each bolt (see ArchiveBolt, little endian) and then the data bytes.
+ */
+
+#define ARCHIVE_MAGIC			"LSBA"		/**< the first four bytes of every bolt archive */
+
+#define ARCHIVE_VERSION			1			/**< version of the archive format written */
+
+#define ARCHIVE_MAX_SHIFT		12			/**< coarsest grid allowed, a step of 2^ARCHIVE_MAX_SHIFT / 16 pixels */
+
+/**
+ * @enum how the points of a bolt are stored
+ */
+typedef enum
+{
+	ARCHIVE_OFFSET16 = 0,					/**< every point as an int16 x, y offset from the origin, 4 bytes a point */
+	ARCHIVE_DELTA8 = 1						/**< every point after the origin as an int8 x, y step from the point before it, 2 bytes a point */
+}ArchiveEncoding;
+
+/**
+ * @struct one packed bolt in an archive
+ * @brief where a bolt's quantized points are in the archive's data and how to turn them back into positions
+ */
+typedef struct ArchiveBolt_t
+{
+	Vect2d origin;							/**< the bolt's first point, every other point is stored relative to it */
+	Uint16 thickness;						/**< thickness of the bolt as a half float */
+	Uint8 encoding;							/**< the ArchiveEncoding the points are stored with */
+	Uint8 shift;							/**< the grid step is 2^shift / 16 pixels */
+	Uint32 numPoints;						/**< how many points the bolt has, including the origin */
+	Uint32 offset;							/**< where the bolt's points start in the archive's data, in bytes */
+}ArchiveBolt;
+
+/**
+ * @struct a library of packed bolts
+ * @brief the bolt records and the one block of data all their points are packed into
+ */
+typedef struct Archive_t
+{
+	ArchiveBolt *bolts;						/**< the packed bolts */
+	int numBolts;							/**< how many bolts are in the archive */
+	int maxBolts;							/**< how many bolts fit before bolts has to grow */
+
+	Uint8 *data;							/**< the quantized points of every bolt */
+	Uint32 dataSize;						/**< how many bytes of data are used */
+	Uint32 dataMax;							/**< how many bytes fit before data has to grow */
+}Archive;
+
+/**
+ * @brief converts a float to a half float, rounding to nearest
+ * @param value		the float to convert
+ * @return the half float bits
+ */
+Uint16 archive_float_to_half(float value);
+
+/**
+ * @brief converts a half float to a float
+ * @param half		the half float bits
+ * @return the float
+ */
+float archive_half_to_float(Uint16 half);
+
+/**
+ * @brief creates an empty archive
+ * @return the new archive, NULL if it could not be allocated
+ */
+Archive *archive_new();
+
+/**
+ * @brief frees an archive and everything in it, and destroys the pointer to it
+ * @param archive [in,out]	the archive to free
+ */
+void archive_free(Archive **archive);
+
+/**
+ * @brief packs a bolt's points into the archive, picking the smallest encoding that keeps every point within maxError of where it was
+ * @param archive [in,out]	the archive to add to
+ * @param points [in]		the bolt's points
+ * @param numPoints			how many points the bolt has
+ * @param thickness			the bolt's thickness
+ * @param maxError			the furthest a decoded point may be from the original, in pixels. the finest grid is 1/16 of a pixel,
+ *							so a point can always be up to 1/32 of a pixel off along each axis however small this is
+ * @return the index of the packed bolt, -1 if it could not be added
+ */
+int archive_add(Archive *archive, Vect2d *points, int numPoints, float thickness, float maxError);
+
+/**
+ * @brief unpacks a bolt's points one at a time, the reference for archive_decode
+ * @param archive [in]	the archive holding the bolt
+ * @param index			which bolt to unpack
+ * @param out [out]		filled with the bolt's points, needs room for the bolt's numPoints
+ * @return the number of points written
+ */
+int archive_decode_scalar(Archive *archive, int index, Vect2d *out);
+
+/**
+ * @brief unpacks a bolt's points, using SSE2 to expand four points at a time when it is available
+ * @param archive [in]	the archive holding the bolt
+ * @param index			which bolt to unpack
+ * @param out [out]		filled with the bolt's points, needs room for the bolt's numPoints
+ * @return the number of points written
+ */
+int archive_decode(Archive *archive, int index, Vect2d *out);
+
+/**
+ * @brief unpacks a range of bolts straight into new bolts in a lightning system's boltList
+ * @param system [in,out]	the lightning system to create the bolts in
+ * @param archive [in]	the archive holding the bolts
+ * @param first			the first bolt to unpack
+ * @param count			how many bolts to unpack
+ * @return the number of bolts created
+ */
+int archive_load_bolts(LightningSystem *system, Archive *archive, int first, int count);
+
+/**
+ * @brief writes the archive to a file
+ * @param archive [in]	the archive to save
+ * @param [in] path		the file to write
+ * @return 1 if the archive was written, 0 otherwise
+ */
+int archive_save(Archive *archive, char *path);
+
+/**
+ * @brief reads an archive written by archive_save, turning away any whose bolt records can't be decoded within its data
+ * @param [in] path		the file to read
+ * @return the archive, NULL if it could not be read or a bolt record is broken
+ */
+Archive *archive_load(char *path);
+
+/**
+ * @brief checks that bolts survive a round trip through an archive file and that archive_load turns away archives whose records are
+ *			broken and archive_add turns away points no encoding can hold, logging every failure
+ * @param [in] path		a scratch file the archives are written to, removed afterwards
+ * @return 1 if every check passed, 0 otherwise
+ */
+int archive_test(char *path);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "lightning.h"
+
+/**
+ * @file	batch.h
+ * @brief	headless generation of large numbers of bolts straight to a file, for pre-baking bolt libraries. never touches video, the
+ *			lightningList or rand, every bolt gets its own random state from the seed and its index so the output doesn't depend on
+ *			how many workers made it. bolts are generated on the job system's workers.
+ *
+ *			the binary format is a 16 byte header ("LSBB", version, 3 reserved bytes, number of bolts, 4 reserved bytes) and then for
+ *			each bolt its number of points, its thickness and then x, y for every point, all 32 bit little endian. a bolt's segments
+ *			run between its consecutive points. the CSV format is one line per segment: bolt, segment, x0, y0, x1, y1, thickness
+ */
+
+#define BATCH_MAGIC				"LSBB"		/**< the first four bytes of every binary batch file */
+
+#define BATCH_VERSION			1			/**< version of the binary batch format written */
+
+#define BATCH_CHUNK				1024		/**< how many bolts a job generates before they are written out */
+
+#define BATCH_WAVE				4			/**< how many chunks per job worker are generated while the chunks before them are written */
+
+/**
+ * @enum what a batch writes its bolts as
+ */
+typedef enum
+{
+	BATCH_BINARY = 0,						/**< the packed little endian format */
+	BATCH_CSV = 1							/**< one line of text per segment */
+}BatchFormat;
+
+/**
+ * @struct everything a batch run needs to know
+ * @brief how many bolts to make, where they go, how they look and where they are written
+ */
+typedef struct BatchOptions_t
+{
+	int count;								/**< how many bolts to generate */
+
+	Vect2d start;							/**< starting point of every bolt, unless randomSpawn is set */
+	Vect2d end;								/**< end point of every bolt, unless randomSpawn is set */
+	int randomSpawn;						/**< if set each bolt's start and end are picked at random inside the spawn region */
+	Vect2d spawnMin;						/**< top left corner of the spawn region */
+	Vect2d spawnMax;						/**< bottom right corner of the spawn region */
+
+	float thickness;						/**< thickness of every bolt */
+	Uint32 seed;							/**< seed the random state of every bolt is made from */
+	int threads;							/**< how many job workers to start for the batch, 0 uses one per cpu core */
+
+	char *path;								/**< the file to write, - writes to stdout */
+	BatchFormat format;						/**< what to write the bolts as */
+}BatchOptions;
+
+/**
+ * @brief fills in the options a batch uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void batch_default_options(BatchOptions *options);
+
+/**
+ * @brief generates one bolt of a batch, the same bolt whichever worker or run makes it
+ * @param options [in]		what the batch generates
+ * @param index				which bolt of the batch to generate
+ * @param points [in,out]	the points are written here, grown as needed
+ * @param maxPoints [in,out]	how many points fit in points
+ * @return how many points the bolt has, 0 if points could not grow
+ */
+int batch_generate(BatchOptions *options, int index, Vect2d **points, int *maxPoints);
+
+/**
+ * @brief generates every bolt of a batch on the job system's workers and writes them to the output in order, then logs how many
+ *			bolts a second were made
+ * @param options [in]	what to generate and where to write it
+ * @return 1 if every bolt was written, 0 otherwise
+ */
+int batch_run(BatchOptions *options);
+
+#endif
\ No newline at end of file
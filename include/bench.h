@@ -0,0 +1,50 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include "lightning.h"
+
+/**
+ * @file	bench.h
+ * @brief	headless microbenchmarks of the hot paths: sort_positions, lightning_create_bolt, lightning_new and lightning_purge_system
+ *			churn and the vect2d helpers, each swept over its parameters. every case is run a few times to warm up and then
+ *			repetitions times, and the median and median absolute deviation of the time per operation are written out as JSON so
+ *			runs from different versions can be diffed. never opens a window or touches the sprites.
+ */
+
+#define BENCH_VERSION			1			/**< version of the JSON written, bumped when cases or fields change meaning */
+
+#define BENCH_WARMUP			3			/**< runs of every case thrown away before timing starts */
+
+#define BENCH_REPETITIONS		15			/**< timed runs of every case the median is taken over */
+
+#define BENCH_CHURN_COUNT		1000		/**< segments created and purged by each run of the churn case */
+
+#define BENCH_VECTORS			4096		/**< vectors each run of a vect2d case goes through */
+
+#define BENCH_STORM_SEGMENTS	100000		/**< segments each run of the segment measuring cases goes through, a whole storm's worth */
+
+/**
+ * @struct what a benchmark run needs to know
+ * @brief how many times each case is run and where the results go
+ */
+typedef struct BenchOptions_t
+{
+	int warmup;								/**< runs of every case before timing starts */
+	int repetitions;						/**< timed runs of every case */
+	char *path;								/**< the file the JSON is written to, - writes to stdout */
+}BenchOptions;
+
+/**
+ * @brief fills in the options a benchmark run uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void bench_default_options(BenchOptions *options);
+
+/**
+ * @brief runs every benchmark case and writes the results as JSON
+ * @param options [in]	how to run them and where to write them
+ * @return 1 if every case ran and the results were written, 0 otherwise
+ */
+int bench_run(BenchOptions *options);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef __BOLTSTREAM_H__
+#define __BOLTSTREAM_H__
+
+#include "lightning.h"
+#include "boltstream_format.h"
+
+/**
+ * @file	boltstream.h
+ * @brief	publishes each frame's bolts into a POSIX shared memory ring so other local processes can read them without a file. the
+ *			producer never waits, readers that fall more than a ring behind skip ahead (see boltstream_format.h for the protocol and
+ *			boltstream_reader.h for the consumer side)
+ */
+
+#define BOLTSTREAM_SLOTS		8			/**< default number of frames the ring holds */
+
+#define BOLTSTREAM_SLOT_SIZE	(1 << 20)	/**< default bytes per frame */
+
+/**
+ * @brief creates the shared memory and sets up an empty ring
+ * @param [in] name		name of the shared memory object, a leading / is added if it is missing
+ * @param slotCount		how many frames the ring holds, at least 2, 0 uses BOLTSTREAM_SLOTS
+ * @param slotSize		bytes per frame, 0 uses BOLTSTREAM_SLOT_SIZE
+ * @return 1 if the stream is open, 0 otherwise
+ */
+int boltstream_open(char *name, int slotCount, int slotSize);
+
+/**
+ * @brief unmaps and removes the shared memory, readers that still have it mapped keep their view of it
+ */
+void boltstream_close();
+
+/**
+ * @brief checks if the stream is open
+ * @return 1 if frames are being published
+ */
+int boltstream_is_active();
+
+/**
+ * @brief starts collecting the bolts of a new frame
+ * @param time	the clock to stamp the frame with, in milliseconds
+ */
+void boltstream_begin_frame(Uint32 time);
+
+/**
+ * @brief adds a bolt to the frame being collected
+ * @param points [in]	the points of the bolt
+ * @param numPoints		how many points the bolt has
+ * @param thickness		thickness of the bolt
+ */
+void boltstream_add_bolt(Vect2d *points, int numPoints, float thickness);
+
+/**
+ * @brief copies the collected frame into its slot under the slot's seqlock and advances the head
+ */
+void boltstream_end_frame();
+
+#endif
\ No newline at end of file
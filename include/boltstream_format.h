@@ -0,0 +1,63 @@
+#ifndef __BOLTSTREAM_FORMAT_H__
+#define __BOLTSTREAM_FORMAT_H__
+
+#include <stdint.h>
+
+/**
+ * @file	boltstream_format.h
+ * @brief	layout of the shared memory the bolt stream is published through, shared by the producer (boltstream.h) and the consumer
+ *			library (boltstream_reader.h). only uses stdint so the consumer can be built without SDL.
+ *
+ *			the memory is a BoltStreamHeader followed by slotCount slots of slotSize bytes. each slot holds one frame: a
+ *			BoltStreamFrame, then numBolts BoltStreamBolt records, then the x, y floats of every point. frame n is in slot
+ *			n % slotCount. a slot's sequence is odd while the producer is writing it and even once it is done, readers check it
+ *			before and after reading and throw the read away if it changed (a seqlock), so the producer never waits on anyone.
+ */
+
+#define BOLTSTREAM_MAGIC		0x5053424c	/**< "LBSP" read as a little endian 32 bit value, written last so a half set up stream is never read */
+
+#define BOLTSTREAM_VERSION		1			/**< version of the layout */
+
+#define BOLTSTREAM_TRUNCATED	1			/**< frame flag, some bolts did not fit in the slot and were left out */
+
+/**
+ * @struct the start of the shared memory
+ * @brief how the slots are laid out and how far the producer has got
+ */
+typedef struct BoltStreamHeader_t
+{
+	uint32_t magic;							/**< BOLTSTREAM_MAGIC once the stream is ready */
+	uint32_t version;						/**< BOLTSTREAM_VERSION */
+	uint32_t slotCount;						/**< how many frames the ring holds */
+	uint32_t slotSize;						/**< bytes in each slot, including its BoltStreamFrame */
+	uint64_t head;							/**< how many frames have been published, the newest is head - 1 */
+	uint8_t reserved[40];					/**< pads the header to a cache line */
+}BoltStreamHeader;
+
+/**
+ * @struct the start of a slot
+ * @brief the frame's seqlock and what is in it
+ */
+typedef struct BoltStreamFrame_t
+{
+	uint64_t sequence;						/**< odd while the producer is writing the slot, even once it is done */
+	uint64_t frame;							/**< which frame the slot holds */
+	uint32_t time;							/**< the producer's clock when the frame was published, in milliseconds */
+	uint32_t numBolts;						/**< how many BoltStreamBolt records follow */
+	uint32_t numPoints;						/**< how many points follow the records */
+	uint32_t flags;							/**< BOLTSTREAM_TRUNCATED if bolts were left out */
+}BoltStreamFrame;
+
+/**
+ * @struct one bolt of a frame
+ * @brief where the bolt's points are in the frame, segment i runs from point i to point i + 1
+ */
+typedef struct BoltStreamBolt_t
+{
+	uint32_t firstPoint;					/**< index of the bolt's first point in the frame's points */
+	uint32_t numPoints;						/**< how many points the bolt has */
+	float thickness;						/**< thickness of the bolt */
+	uint32_t reserved;						/**< pads the record to 16 bytes */
+}BoltStreamBolt;
+
+#endif
\ No newline at end of file
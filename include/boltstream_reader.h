@@ -0,0 +1,84 @@
+#ifndef __BOLTSTREAM_READER_H__
+#define __BOLTSTREAM_READER_H__
+
+#include <stddef.h>
+
+#include "boltstream_format.h"
+
+/**
+ * @file	boltstream_reader.h
+ * @brief	the consumer side of the bolt stream, a small library for other processes. maps the producer's shared memory read only
+ *			and hands out views straight into it, with no copies. a view is only trustworthy if boltstream_reader_check still
+ *			passes after it has been used, otherwise the producer lapped the reader and the frame should be dropped. depends only
+ *			on the C library and POSIX, not on SDL or the rest of the simulator
+ */
+
+/**
+ * @struct a reader's mapping of the stream
+ * @brief the mapped memory and the next frame the reader wants
+ */
+typedef struct BoltStreamReader_t
+{
+	const uint8_t *map;						/**< the mapped shared memory */
+	size_t size;							/**< bytes mapped */
+	const BoltStreamHeader *header;			/**< the start of the mapped memory */
+	uint32_t slotCount;						/**< the header's slotCount when the stream was opened, the only one the reader uses */
+	uint32_t slotSize;						/**< the header's slotSize when the stream was opened, the only one the reader uses */
+	uint64_t nextFrame;						/**< the frame boltstream_reader_next returns next */
+	uint64_t dropped;						/**< how many frames were skipped because the reader fell behind or was lapped */
+}BoltStreamReader;
+
+/**
+ * @struct one frame as seen by a reader
+ * @brief pointers into the shared memory for a frame, and the sequence that has to be unchanged for them to be valid
+ */
+typedef struct BoltStreamView_t
+{
+	const BoltStreamFrame *slot;			/**< the slot the frame is in */
+	uint64_t sequence;						/**< the slot's sequence when the view was taken */
+	uint64_t frame;							/**< which frame this is */
+	uint32_t time;							/**< the producer's clock when it was published, in milliseconds */
+	uint32_t flags;							/**< the frame's flags, see BOLTSTREAM_TRUNCATED */
+	uint32_t numBolts;						/**< how many bolts are in the frame */
+	uint32_t numPoints;						/**< how many points all the bolts have together */
+	const BoltStreamBolt *bolts;			/**< the frame's bolts */
+	const float *points;					/**< x, y of every point, a bolt's points start at points[bolt->firstPoint * 2] */
+}BoltStreamView;
+
+/**
+ * @brief maps a stream a producer has opened
+ * @param [in] name		the name the producer opened it with
+ * @return the reader, NULL if the stream doesn't exist or isn't ready yet
+ */
+BoltStreamReader *boltstream_reader_open(const char *name);
+
+/**
+ * @brief unmaps a stream and frees the reader, and destroys the pointer to it
+ * @param reader [in,out]	the reader to close
+ */
+void boltstream_reader_close(BoltStreamReader **reader);
+
+/**
+ * @brief gets the next frame in order, skipping ahead to the oldest frame still in the ring if the reader fell behind
+ * @param reader [in,out]	the reader
+ * @param view [out]		filled with the frame
+ * @return 1 if a frame was read, 0 if the reader is caught up with the producer
+ */
+int boltstream_reader_next(BoltStreamReader *reader, BoltStreamView *view);
+
+/**
+ * @brief gets the newest frame, skipping any the reader hasn't seen
+ * @param reader [in,out]	the reader
+ * @param view [out]		filled with the frame
+ * @return 1 if a frame was read, 0 if nothing has been published since the last frame read
+ */
+int boltstream_reader_latest(BoltStreamReader *reader, BoltStreamView *view);
+
+/**
+ * @brief checks that the producer hasn't started rewriting a frame's slot, call it after using the view
+ * @param view [in]	the view to check
+ * @return 1 if everything read through the view was intact, 0 if it has to be thrown away
+ */
+int boltstream_reader_check(const BoltStreamView *view);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef __BREAKDOWN_H__
+#define __BREAKDOWN_H__
+
+#include "lightning.h"
+
+/**
+ * @file	breakdown.h
+ * @brief	a more physical bolt generator using the dielectric breakdown model. the channel grows one cell at a time on a grid of
+ *			electric potential, picking where to grow by the strength of the field, and Laplace's equation is re-solved after every
+ *			step with SIMD red-black SOR spread over the job system's workers, warm started from the previous solution.
+ */
+
+#define BREAKDOWN_CELL_SIZE		4			/**< size of one grid cell in pixels */
+
+#define BREAKDOWN_MARGIN		0.35f		/**< how far the grid reaches past the bolt's endpoints, as a fraction of the bolt's length */
+
+#define BREAKDOWN_ETA			2.0f		/**< how strongly growth follows the field, lower values give more branches */
+
+#define BREAKDOWN_OMEGA			1.85f		/**< over-relaxation factor for SOR, between 1 and 2 */
+
+#define BREAKDOWN_FIRST_SWEEPS	200			/**< SOR sweeps for the first solve, before the channel starts to grow */
+
+#define BREAKDOWN_STEP_SWEEPS	6			/**< SOR sweeps after each growth step, enough since the last solution is the starting guess */
+
+/**
+ * @brief initializes the breakdown generator, the solver runs on the job system's workers
+ */
+void breakdown_init_system();
+
+/**
+ * @brief frees the grids
+ */
+void breakdown_close_system();
+
+/**
+ * @brief grows a branched bolt from start to end with the dielectric breakdown model, writing each growth step into the system's lightningList
+ *			as one segment so it is drawn by lightning_draw_all. the channel that reaches end is drawn twice as thick as the branches
+ * @param system [in,out]	the lightning system to create the segments in
+ * @param start		where the channel starts growing from
+ * @param end		the point the channel is drawn towards, growth stops when it is reached
+ * @param thickness	thickness of the branches
+ * @return the number of segments created
+ */
+int breakdown_create_bolt(LightningSystem *system, Vect2d start, Vect2d end, float thickness);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef __CANVAS_H__
+#define __CANVAS_H__
+
+#include "batch.h"
+
+/**
+ * @file	canvas.h
+ * @brief	headless rendering of bolts onto a canvas far bigger than a window or a texture, for print and high resolution video. the
+ *			window's WINDOW_WIDTH x WINDOW_HEIGHT is scaled up to fit the canvas, bolts and all, so a scene looks the same at any size.
+ *			the canvas is drawn one tile at a time by the CPU rasterizer, each tile only visiting the bolts whose bounds reach it, and
+ *			every tile is written straight to its place in the file when it is done, so memory depends on the tile size and the
+ *			bolts, never on the size of the canvas.
+ *
+ *			the file is a binary PPM (P6), 8 bit RGB, which most image tools read
+ */
+
+#define CANVAS_TILE_SIZE		512			/**< width and height of the tiles the canvas is drawn and written in unless set otherwise */
+
+#define CANVAS_CHUNK			16			/**< how many of a bolt's segments share a bounding box when the bolt is culled against a tile */
+
+/**
+ * @struct everything a canvas render needs to know
+ */
+typedef struct CanvasOptions_t
+{
+	char *path;								/**< the PPM file to write */
+	int width;								/**< width of the canvas in pixels */
+	int height;								/**< height of the canvas in pixels */
+	int tileSize;							/**< width and height of a tile in pixels */
+	int count;								/**< how many bolts are drawn */
+	Vect3d color;							/**< color of the bolts, each component 0 - 255 */
+	BatchOptions *bolts;					/**< where the bolts go on the window and how they look, bolt i is bolt i of a batch with them */
+}CanvasOptions;
+
+/**
+ * @brief fills in the options a canvas render uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void canvas_default_options(CanvasOptions *options);
+
+/**
+ * @brief generates the bolts on the job system's workers, then draws the canvas tile by tile, writing each tile to the file as it is
+ *			done, and logs how long it took
+ * @param options [in]	the canvas and the bolts to draw on it
+ * @return 1 if the whole canvas was written, 0 otherwise
+ */
+int canvas_run(CanvasOptions *options);
+
+#endif
\ No newline at end of file
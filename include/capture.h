@@ -0,0 +1,59 @@
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include "SDL.h"
+
+/**
+ * @file	capture.h
+ * @brief	frame export pipeline. presented frames are copied into a ring of preallocated buffers and a writer thread streams them
+ *			to a file or stdout as raw RGBA or Y4M, so the render loop never waits on disk I/O.
+ */
+
+#define CAPTURE_RING_SIZE		8			/**< default number of frames that can be waiting for the writer thread */
+
+/**
+ * @enum the file formats frames can be exported as
+ */
+typedef enum
+{
+	CAPTURE_RAW = 0,						/**< raw R, G, B, A bytes, one frame after the other with no header */
+	CAPTURE_Y4M = 1							/**< YUV4MPEG2 with 4:4:4 chroma, readable by ffmpeg and most players */
+}CaptureFormat;
+
+/**
+ * @brief opens the output, allocates the ring of frame buffers and starts the writer thread
+ * @param [in] path		file to write the frames to, "-" writes to stdout so the frames can be piped into an encoder
+ * @param format		the format to write the frames as
+ * @param width			width of the captured frames
+ * @param height		height of the captured frames
+ * @param fps			frame rate written into the Y4M header
+ * @param ringSize		how many frames can be waiting for the writer, 0 uses CAPTURE_RING_SIZE
+ * @param waitForWriter	if 0, frames are dropped when the ring is full so the render loop never blocks,
+ *						otherwise the render loop waits for a free buffer so no frame is lost (for fixed timestep captures)
+ */
+void capture_init(char *path, CaptureFormat format, int width, int height, int fps, int ringSize, int waitForWriter);
+
+/**
+ * @brief writes out every frame still in the ring, stops the writer thread and closes the output
+ */
+void capture_close();
+
+/**
+ * @brief checks if frames are being captured
+ * @return 1 if capture_init succeeded and capture_close hasn't been called, 0 otherwise
+ */
+int capture_is_active();
+
+/**
+ * @brief reads back the renderer's current frame into the next free buffer and hands it to the writer. must be called before the frame is presented
+ */
+void capture_frame();
+
+/**
+ * @brief copies an already CPU side frame (such as the raster framebuffer) into the next free buffer and hands it to the writer
+ * @param [in] pixels	R, G, B, A bytes, the same size the capture was initialized with
+ * @param pitch			number of bytes in one row of pixels
+ */
+void capture_pixels(Uint8 *pixels, int pitch);
+
+#endif
\ No newline at end of file
@@ -10,6 +10,8 @@
  * @brief	the graphic and rendering pipeline for the project, also keeps track of gametime
  */
 
+#define GRAPHICS_MAX_FIXED_RATE	1000		/**< the highest fixed timestep frame rate, the game's time is in whole milliseconds */
+
 /**
  * @brief	initializes the main window and the main renderer.
  * @param   [in]	windowName	If non-null, name of the window, will be displayed at the top of the window.
@@ -28,12 +30,40 @@ void graphics_next_frame();
 /** @brief	delay's frame rate so the screen and code are synched up properly */
 void graphics_frame_delay();
 
+/**
+ * @brief	sets the shortest time a frame is allowed to take.
+ * @param	frameDelay	milliseconds each frame is held for at least, 0 runs as fast as possible.
+ */
+void graphics_set_frame_delay(Uint32 frameDelay);
+
+/**
+ * @brief	makes the game's time advance by a fixed step each frame instead of following the wall clock, used to capture footage offline.
+ *			frame n is at n * 1000 / framesPerSecond milliseconds, rounded down, so a step that isn't a whole millisecond is spread
+ *			over the frames instead of drifting.
+ * @param	framesPerSecond	how many frames make a second of the game's time, 0 goes back to the wall clock.
+ * @return	1 if the rate was set, 0 if it is over GRAPHICS_MAX_FIXED_RATE and frames would share a millisecond.
+ */
+int graphics_set_fixed_timestep(Uint32 framesPerSecond);
+
+/**
+ * @brief	moves the game's time up to the wall clock without holding for a frame, for loops that sleep waiting on events
+ *			instead. does nothing on a fixed timestep, where only graphics_next_frame advances the time.
+ * @return	the game's time after the update
+ */
+Uint32 graphics_update_time();
+
 /**
  * @brief	getter for the game's renderer so the rest of the code can use it.
  * @return	a SDL_Renderer pointer used for all the game's rendering.
  */
 SDL_Renderer *graphics_get_renderer();
 
+/**
+ * @brief	checks if the game's renderer is SDL's software renderer, in which case the lightning should be drawn with the CPU rasterizer.
+ * @return	1 if the renderer is not hardware accelerated, 0 otherwise.
+ */
+int graphics_is_software();
+
 /**
  * @brief	getter for the game's time
  * @return	the graphicsNow
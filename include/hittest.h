@@ -0,0 +1,139 @@
+#ifndef __HITTEST_H__
+#define __HITTEST_H__
+
+#include "lightning.h"
+
+/**
+ * @file	hittest.h
+ * @brief	hit testing bolts against the scene with bounding volume hierarchies. a bolt's tree is built over its segments, split in
+ *			halves along the bolt since consecutive segments are already close together, so building one never sorts. a scene's
+ *			tree is built over its rectangles, split at the median along the longer side. bolts are tested against every rectangle
+ *			they touch by walking both trees together, so only the parts of the two whose boxes overlap are ever compared.
+ *			trees are rebuilt or refit in place without reallocating when what they were built over changes.
+ */
+
+#define HIT_LEAF_SIZE			4			/**< the most segments or rectangles in a leaf of a tree */
+
+#define HIT_STACK				256			/**< how many nodes or pairs of nodes a query can have waiting to be visited */
+
+/**
+ * @struct an axis aligned bounding box
+ */
+typedef struct HitBox_t
+{
+	float minX;								/**< left edge */
+	float minY;								/**< top edge */
+	float maxX;								/**< right edge */
+	float maxY;								/**< bottom edge */
+}HitBox;
+
+/**
+ * @struct one node of a tree, stored in depth first order so a node's first child is the node right after it
+ */
+typedef struct HitNode_t
+{
+	HitBox box;								/**< bounds everything under the node */
+	int right;								/**< index of the second child, -1 for a leaf */
+	int first;								/**< for a leaf, the first of its items in the tree's order */
+	int count;								/**< for a leaf, how many items it has */
+}HitNode;
+
+/**
+ * @struct a bounding volume hierarchy over a bolt's segments or a scene's rectangles
+ * @brief owns its arrays and keeps them between builds, so rebuilding a tree every frame doesn't allocate
+ */
+typedef struct HitTree_t
+{
+	HitNode *nodes;							/**< the nodes, the root first */
+	int numNodes;							/**< how many nodes are in use */
+
+	HitBox *boxes;							/**< the box of every item */
+	int *order;								/**< item indexes in the order the leaves refer to them */
+	Uint32 *marks;							/**< the query each item was last reported by, so it is reported once */
+	Uint32 query;							/**< counts the queries against the tree, the mark of the current one */
+	int numItems;							/**< how many items the tree was built over */
+	int maxItems;							/**< how many items the arrays have room for */
+
+	Vect2d *points;							/**< for a bolt tree, a copy of the points, segment i runs from points[i] to points[i + 1] */
+	float radius;							/**< for a bolt tree, half the thickness of the bolt, how far from its segments it reaches */
+	Bolt *bolt;								/**< for a bolt tree, the bolt it was last built from */
+	Uint32 version;							/**< for a bolt tree, the version of the bolt it was last built from */
+
+	SDL_Rect *rects;						/**< for a scene tree, the caller's rectangles */
+}HitTree;
+
+/**
+ * @brief allocates an empty tree
+ * @return the new tree, NULL if it could not be allocated
+ */
+HitTree *hit_tree_new();
+
+/**
+ * @brief frees a tree and its arrays, and destroys the pointer to it
+ * @param tree [in,out]	the tree to free
+ */
+void hit_tree_free(HitTree **tree);
+
+/**
+ * @brief builds a tree over the segments of a bolt that are drawn
+ * @param tree [in,out]	the tree to build, its arrays are reused and grown if they are too small
+ * @param bolt [in]		the bolt
+ * @return 1 if the tree was built, 0 if its arrays could not be grown
+ */
+int hit_tree_build_bolt(HitTree *tree, Bolt *bolt);
+
+/**
+ * @brief brings a bolt tree up to date with its bolt for as little as it can: nothing if the bolt hasn't changed since the tree was
+ *			built, refitting the boxes if the bolt has the same number of points drawn and rebuilding it otherwise
+ * @param tree [in,out]	the tree to update
+ * @param bolt [in]		the bolt, if it isn't the one the tree was built from the tree is rebuilt
+ * @return 1 if the tree is up to date, 0 if its arrays could not be grown
+ */
+int hit_tree_update_bolt(HitTree *tree, Bolt *bolt);
+
+/**
+ * @brief builds a tree over a scene's rectangles
+ * @param tree [in,out]	the tree to build, its arrays are reused and grown if they are too small
+ * @param rects [in]	the rectangles, kept by the tree so they must stay around as long as it does
+ * @param count			how many rectangles there are
+ * @return 1 if the tree was built, 0 if its arrays could not be grown
+ */
+int hit_tree_build_rects(HitTree *tree, SDL_Rect *rects, int count);
+
+/**
+ * @brief refits the boxes of a scene tree after its rectangles have moved, without changing how they are split. much cheaper than
+ *			building it again, but the tree gets slower to query the further the rectangles have moved since it was built
+ * @param tree [in,out]	the tree built over the rectangles
+ */
+void hit_tree_refit_rects(HitTree *tree);
+
+/**
+ * @brief finds every rectangle of a scene that a bolt touches, counting the bolt's thickness
+ * @param bolt [in,out]		the bolt's tree
+ * @param scene [in,out]	the scene's tree, each rectangle is reported once however many segments touch it
+ * @param hits [out]		the indexes of the rectangles touched, in no particular order
+ * @param maxHits			how many indexes fit in hits, the rest are counted but not written
+ * @return how many rectangles the bolt touches
+ */
+int hit_bolt_rects(HitTree *bolt, HitTree *scene, int *hits, int maxHits);
+
+/**
+ * @brief finds the point along a bolt's segments closest to a point
+ * @param bolt [in]			the bolt's tree
+ * @param point				the point to measure from
+ * @param closest [out]		if non-null, set to the closest point on the bolt's center line
+ * @return the distance from point to the center line, the bolt's surface is the tree's radius closer. -1 if the tree is empty
+ */
+float hit_bolt_closest(HitTree *bolt, Vect2d point, Vect2d *closest);
+
+/**
+ * @brief finds the closest point along a bolt's segments for each of many points
+ * @param bolt [in]			the bolt's tree
+ * @param points [in]		the points to measure from
+ * @param count				how many points there are
+ * @param closest [out]		if non-null, set to the closest point on the bolt's center line for each point
+ * @param distances [out]	if non-null, set to the distance from each point to the center line, -1 if the tree is empty
+ */
+void hit_bolt_closest_points(HitTree *bolt, Vect2d *points, int count, Vect2d *closest, float *distances);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include "SDL.h"
+
+/**
+ * @file	input.h
+ * @brief	waits on SDL's event queue instead of polling it, and folds everything that arrived while waiting into one
+ *			snapshot so the main loop reacts to a burst of mouse motion once instead of once per event
+ */
+
+/**
+ * @struct what happened during one wait
+ * @brief the coalesced result of every event handled by the last input_wait
+ */
+typedef struct InputState_t
+{
+	int quit;				/**< the window was closed or escape was pressed */
+	int moved;				/**< the mouse moved during the wait */
+	int mouseX, mouseY;		/**< where the mouse is, the last of all the motion handled */
+	int redraw;				/**< the window was exposed or resized and has to be drawn again */
+	int events;				/**< how many events the wait handled */
+}InputState;
+
+/**
+ * @brief reads where the mouse starts so the first frame has something to aim at
+ */
+void input_init_system();
+
+/**
+ * @brief sleeps until an event arrives or the timeout runs out, then handles every event that is queued
+ * @param timeout	milliseconds to wait at most, 0 only handles what is already queued, negative waits until something happens
+ * @return the state of the input after the wait, the per wait flags only cover this wait
+ */
+InputState *input_wait(int timeout);
+
+/**
+ * @brief getter for the input state without waiting
+ * @return the state left by the last input_wait
+ */
+InputState *input_get_state();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,142 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include "SDL.h"
+
+/**
+ * @file	jobs.h
+ * @brief	work stealing job scheduler shared by everything that runs in parallel, so features submit work instead of starting their own
+ *			threads. each worker owns a deque, it pushes and pops its own jobs at the bottom while idle workers steal the oldest jobs
+ *			from the top of someone else's. the thread that calls jobs_init_system is worker 0 and runs jobs while it waits on them.
+ *			a job is a function over a range of indexes, ranges submitted with a grain are split in half as they run so the pieces
+ *			spread over the workers that steal them. counters track when a group of jobs is done and jobs can be held back until a
+ *			counter reaches 0.
+ */
+
+#define JOBS_MAX_WORKERS		64			/**< the most workers the scheduler will run, including the calling thread */
+
+#define JOBS_DEQUE_SIZE			1024		/**< how many jobs fit in each worker's deque, a power of 2. jobs that don't fit are run right away */
+
+#define JOBS_SPIN				4000		/**< how many times an idle worker looks for work before it sleeps */
+
+/**
+ * @brief the work of a job
+ * @param data [in,out]		what the job was submitted with
+ * @param start				first index of the range to do
+ * @param end				one past the last index of the range to do
+ * @param worker			index of the worker running the job, 0 to jobs_get_worker_count() - 1, for picking per worker scratch space
+ */
+typedef void (*JobFunction)(void *data, int start, int end, int worker);
+
+/**
+ * @struct a job waiting to run
+ * @brief the function and range to run, and the counter to tell when it is done
+ */
+typedef struct Job_t
+{
+	JobFunction function;					/**< what to run */
+	void *data;								/**< passed to function */
+	int start;								/**< first index of the range */
+	int end;								/**< one past the last index of the range */
+	int grain;								/**< ranges longer than this are split in half before running, 0 never splits */
+	struct JobCounter_t *counter;			/**< counts the job until it is done, can be NULL */
+	struct Job_t *next;						/**< the next job held back on the same counter */
+}Job;
+
+/**
+ * @struct counts jobs that haven't finished
+ * @brief a group of jobs is done when the count reaches 0, jobs held back on the counter are submitted then
+ */
+typedef struct JobCounter_t
+{
+	SDL_atomic_t count;						/**< how many jobs counted by it haven't finished */
+	SDL_SpinLock lock;						/**< guards waiting */
+	Job *waiting;							/**< jobs to submit once count reaches 0 */
+}JobCounter;
+
+/**
+ * @brief starts the workers, the calling thread becomes worker 0
+ * @param threads	how many workers to run including the calling thread, 0 uses one per cpu core
+ */
+void jobs_init_system(int threads);
+
+/**
+ * @brief finishes every queued job, then stops the workers
+ */
+void jobs_close_system();
+
+/**
+ * @brief getter for how many workers there are, size per worker scratch space with it
+ * @return the number of workers including the calling thread, 1 if the scheduler isn't running
+ */
+int jobs_get_worker_count();
+
+/**
+ * @brief getter for which worker the calling thread is
+ * @return the worker's index, -1 if the thread isn't one of the scheduler's, 0 if the scheduler isn't running
+ */
+int jobs_get_worker_index();
+
+/**
+ * @brief sets a counter to 0 with nothing held back on it, call before first use
+ * @param counter [out]	the counter
+ */
+void jobs_counter_init(JobCounter *counter);
+
+/**
+ * @brief queues one job over a range, the range is run in one call
+ * @param function			what to run
+ * @param data [in,out]		passed to function
+ * @param start				first index of the range
+ * @param end				one past the last index of the range
+ * @param counter [in,out]	incremented now and decremented when the job is done, can be NULL
+ */
+void jobs_submit(JobFunction function, void *data, int start, int end, JobCounter *counter);
+
+/**
+ * @brief queues a range that is split in half as it runs until the pieces are no longer than grain, so idle workers can steal them
+ * @param function			what to run on each piece
+ * @param data [in,out]		passed to function
+ * @param start				first index of the range
+ * @param end				one past the last index of the range
+ * @param grain				the longest piece function is called on, at least 1
+ * @param counter [in,out]	counts the pieces until they are all done, can be NULL
+ */
+void jobs_submit_range(JobFunction function, void *data, int start, int end, int grain, JobCounter *counter);
+
+/**
+ * @brief holds a job back until a counter reaches 0, then queues it
+ * @param dependency [in,out]	the counter to wait for, if it is already 0 the job is queued right away
+ * @param function				what to run
+ * @param data [in,out]			passed to function
+ * @param start					first index of the range
+ * @param end					one past the last index of the range
+ * @param counter [in,out]		incremented now and decremented when the job is done, can be NULL
+ */
+void jobs_submit_after(JobCounter *dependency, JobFunction function, void *data, int start, int end, JobCounter *counter);
+
+/**
+ * @brief runs queued jobs until a counter reaches 0, threads that aren't workers sleep instead. the counter can be dropped as soon as
+ *			this returns
+ * @param counter [in]	the counter to wait for
+ */
+void jobs_wait(JobCounter *counter);
+
+/**
+ * @brief runs function over a range on every worker and returns once it is all done
+ * @param function			what to run on each piece
+ * @param data [in,out]		passed to function
+ * @param start				first index of the range
+ * @param end				one past the last index of the range
+ * @param grain				the longest piece function is called on, at least 1
+ */
+void jobs_parallel_for(JobFunction function, void *data, int start, int end, int grain);
+
+/**
+ * @brief measures what scheduling costs per job and how a fixed amount of bolt generation scales from 1 worker up to threads,
+ *			restarting the scheduler for each worker count, and logs the results
+ * @param threads	the most workers to measure, 0 uses one per cpu core
+ */
+void jobs_benchmark(int threads);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef __LIGHT_H__
+#define __LIGHT_H__
+
+#include "vector.h"
+
+/**
+ * @file	light.h
+ * @brief	lights the background with the bolts. every bolt is a line light whose light falls off with the distance from it, added up on a
+ *			light buffer a fraction of the screen's resolution, tile by tile on the job system's workers with only the lights that reach
+ *			each tile, then upsampled over the background by the GPU or the CPU rasterizer.
+ */
+
+#define LIGHT_SCALE				4			/**< screen pixels per light buffer texel along each axis unless set otherwise */
+
+#define LIGHT_TILE_SIZE			16			/**< width and height of a culling tile in light buffer texels, must be a multiple of 4 for the SIMD path */
+
+#define LIGHT_MAX_SEGMENTS		8			/**< most segments a bolt is lit along, a longer bolt lights along every few of its points. its jags are lost in a light this wide anyway */
+
+#define LIGHT_RADIUS			260.0f		/**< screen pixels a bolt's light reaches before it has faded out completely */
+
+#define LIGHT_INTENSITY			1.2f		/**< brightness of a bolt's light right at the bolt */
+
+#define LIGHT_AMBIENT			0.45f		/**< how bright the background is where no light reaches, full light brings it to this times 2 */
+
+#define LIGHT_BACKGROUND		"images/test.jpg"	/**< the background lit by the bolts */
+
+/**
+ * @struct a light, one bolt or lightning segment
+ */
+typedef struct Light_t
+{
+	Vect3d color;							/**< color of the light times its intensity, each component 0 - 1 */
+	float radius;							/**< how far in texels the light reaches */
+	float invRadius2;						/**< one over the square of the distance in texels the light fades out at */
+}Light;
+
+/**
+ * @struct one segment a light is lit along, in light buffer texels
+ */
+typedef struct LightSegment_t
+{
+	Vect2d start;							/**< starting point of the segment */
+	Vect2d end;								/**< end point of the segment */
+	int light;								/**< index of the light the segment belongs to */
+}LightSegment;
+
+/**
+ * @brief initializes the lighting and allocates a light buffer covering the screen at one texel per scale pixels
+ * @param width		width of the screen in pixels
+ * @param height	height of the screen in pixels
+ * @param scale		screen pixels per light buffer texel along each axis, 0 uses LIGHT_SCALE
+ */
+void light_init_system(int width, int height, int scale);
+
+/**
+ * @brief frees the light buffer, the background, the queued lights and the workers' scratch
+ */
+void light_close_system();
+
+/**
+ * @brief loads the image that is lit and stretches it over the screen
+ * @param filename	the image to load
+ * @return 1 if it was loaded, 0 otherwise
+ */
+int light_load_background(char *filename);
+
+/**
+ * @brief empties the queued lights
+ */
+void light_clear();
+
+/**
+ * @brief starts a new light for the next light_render, its segments are queued with light_add_segment. the light at a texel comes from
+ *			the light's closest segment, so the segments can overlap and branch without lighting any brighter where they do
+ * @param color		color of the light, each component 0 - 255
+ * @param radius	screen pixels the light reaches
+ * @param intensity	brightness of the light right at its segments
+ * @return 1 if the light was queued, 0 if the queue could not grow
+ */
+int light_add_light(Vect3d color, float radius, float intensity);
+
+/**
+ * @brief queues a segment of the light last started with light_add_light
+ * @param start		starting point of the segment in screen pixels
+ * @param end		end point of the segment in screen pixels
+ */
+void light_add_segment(Vect2d start, Vect2d end);
+
+/**
+ * @brief queues a polyline as a line light for the next light_render, a polyline of more than LIGHT_MAX_SEGMENTS segments is lit
+ *			along every few of its points
+ * @param points [in]	the points of the polyline in screen pixels
+ * @param count			how many points there are, a single point is lit as a point light
+ * @param color			color of the light, each component 0 - 255
+ * @param radius		screen pixels the light reaches
+ * @param intensity		brightness of the light right at the polyline
+ */
+void light_add_polyline(Vect2d *points, int count, Vect3d color, float radius, float intensity);
+
+/**
+ * @brief bins every queued light segment into the tiles it reaches, then adds up the light of every tile in parallel into the light buffer
+ */
+void light_render();
+
+/**
+ * @brief lights the background with the light buffer, upsampled, and adds it under a frame of the CPU rasterizer
+ * @param pixels [in,out]	the frame, R, G, B, A bytes the size of the screen
+ * @param pitch				bytes in one row of the frame
+ */
+void light_composite(Uint8 *pixels, int pitch);
+
+/**
+ * @brief draws the background onto the game's renderer with the light buffer, upsampled, brightening it
+ */
+void light_present();
+
+/**
+ * @brief getter for the light buffer, texels are stored as R, G, B, A bytes with the light of each channel 0 - 255
+ * @param width [out]	if non-null, set to the width of the light buffer in texels
+ * @param height [out]	if non-null, set to the height of the light buffer in texels
+ * @return the light buffer, NULL if the lighting was never initialized
+ */
+Uint8 *light_get_texels(int *width, int *height);
+
+#endif
\ No newline at end of file
@@ -10,10 +10,36 @@
 
 #define LIGHTNING_THICKNESS		8			/**< the thickness of the standard image for the lightning bolt (frameSize.y) */
 
+#define LIGHTNING_MIDDLE_IMAGE	"images/middle_chunk.png"	/**< the sprite stretched along every segment, embedded in the binary by -embed */
+
+#define LIGHTNING_LEFT_IMAGE	"images/left_cap.png"		/**< the cap drawn at the start of every segment, embedded in the binary by -embed */
+
+#define LIGHTNING_RIGHT_IMAGE	"images/right_cap.png"		/**< the cap drawn at the end of every segment, embedded in the binary by -embed */
+
+#define LIGHTNING_CACHE_BUDGET	(16 * 1024 * 1024)	/**< bytes of texture the cached drawings of the bolts may use unless set otherwise */
+
+#define LIGHTNING_CACHE_PAD		32			/**< pixels a bolt's cached drawing reaches past its points, room for the caps and the widest bloom */
+
+#define LIGHTNING_CACHE_ROUND	64			/**< cached drawings are sized up to a multiple of this, so a texture fits the slot's next bolt too */
+
 #define SWAY					100			/**< The amount of displacement allowed for from segment to segment in the lightning bolt */
 
 #define JAGGEDNESS				1 / SWAY	/**< how perpendicular the segments in the bolt are allowed to be */
 
+#define LIGHTNING_LEADER_TIME	150			/**< milliseconds a growing bolt's leader takes to reach the end of the bolt */
+
+#define LIGHTNING_RETURN_TIME	80			/**< milliseconds the return stroke lights the whole bolt once the leader arrives */
+
+#define LIGHTNING_RETURN_SCALE	2.5f		/**< how much thicker the return stroke pass is drawn than the bolt */
+
+#define LIGHTNING_RAINBOW_TIME	14000		/**< milliseconds a bolt's color takes to go once around the rainbow */
+
+#define LIGHTNING_BLOOM_ALPHA	40			/**< alpha of the bloom drawn around every segment, out of the bolt's alpha */
+
+#define LIGHTNING_LAYERS		6			/**< the bloom of the bodies, left caps and right caps, then their cores, each batched into its own geometry */
+
+struct LightningSystem_t;
+
 /**
  * @struct the Lightning (Line) structure, contains the start and end points of the lightning, thickness of the lightning, and function pointers to free and draw the lightning
  * @brief a line segment and function pointers that allow for the creation of a lightning bolt
@@ -27,10 +53,124 @@ typedef struct Line_t
 
 	float thickness;						/**< thickness of the line segment */
 
-	void (*free)(struct Line_t **self);		/**< function that frees the lightning from memory */
-	void (*draw)(struct Line_t *self);		/**< function that will draw the lightning to screen (also blooms it) */
+	int trailed;							/**< if the segment has been drawn into the trail */
+
+	void (*free)(struct LightningSystem_t *system, struct Line_t **self);	/**< function that frees the lightning from memory */
+	void (*draw)(struct LightningSystem_t *system, struct Line_t *self);	/**< function that will draw the lightning to screen (also blooms it) */
 }Lightning;
 
+/**
+ * @struct a whole bolt of lightning stored as one polyline, segment i runs from points[i] to points[i + 1]
+ * @brief the points of a bolt in one contiguous array along with the attributes every segment of the bolt shares
+ */
+typedef struct Bolt_t
+{
+	int inUse;								/**< flag to know if the bolt is in use */
+
+	Vect2d *points;							/**< the points along the bolt, from the start of the bolt to its end */
+	int numPoints;							/**< how many points the bolt has, one more than its number of segments */
+	int maxPoints;							/**< how many points fit in points, kept between uses so the array is reused */
+
+	float thickness;						/**< thickness of every segment in the bolt */
+
+	int drawPoints;							/**< how many points from the start are drawn, in the order they were generated. -1 draws them all */
+	int returnStroke;						/**< if set the bolt is drawn a second time, thicker, over itself */
+
+	Vect3d color;							/**< color the bolt is drawn in this frame, each component 0 - 255 */
+	int rainbow;							/**< if set color follows the rainbow over time, otherwise it is left as it was set */
+	float hue;								/**< how far around the rainbow the bolt is from the others, 0 - 1 */
+	int alpha;								/**< alpha the bolt is drawn with, 0 - 255 */
+	float intensity;						/**< how bright the bolt is, multiplies its color */
+
+	Uint32 version;							/**< bumped whenever the bolt is reused or its points change, so a cached drawing knows it is stale */
+
+	SDL_Texture *cache;						/**< the bolt drawn once into a texture, NULL if it isn't cached */
+	int cacheW;								/**< width of the cache texture, it may be bigger than the drawing in it */
+	int cacheH;								/**< height of the cache texture */
+	SDL_Rect cacheBounds;					/**< where on screen the drawing in the cache goes, its size is the part of the texture used */
+	Uint32 cacheVersion;					/**< the version of the bolt that was drawn into the cache */
+	int cachePoints;						/**< how many points were drawn into the cache */
+	int cacheReturn;						/**< if the return stroke was drawn into the cache */
+	Uint32 cacheUsed;						/**< the frame the cache was last drawn in, the least recently drawn is evicted first */
+
+	int trailPoints;						/**< how many points from the start have been drawn into the trail, reset when the bolt is reused */
+	int trailReturn;						/**< if the return stroke has been drawn into the trail */
+
+	void (*free)(struct LightningSystem_t *system, struct Bolt_t **self);	/**< function that frees the bolt from memory */
+	void (*draw)(struct LightningSystem_t *system, struct Bolt_t *self);	/**< function that will draw the bolt to screen (also blooms it) */
+}Bolt;
+
+/**
+ * @struct a lightning system, one independent simulation
+ * @brief owns the lightning and bolt pools, the sprites they are drawn with and the rainbow they cycle through. nothing is shared
+ *			between systems, so each thread or viewport can run its own without locks as long as each also has its own sprite system
+ */
+typedef struct LightningSystem_t
+{
+	Lightning *lightningList;				/**< the pool of lightning segments */
+	int lightningNum;						/**< how many lightning segments are in use */
+	int lightningMax;						/**< how many lightning segments fit in lightningList */
+
+	Bolt *boltList;							/**< the pool of polyline bolts */
+	int boltNum;							/**< how many bolts are in use */
+	int boltMax;							/**< how many bolts fit in boltList */
+
+	Vect2d *scratchPoints;					/**< points lightning_create_bolt generates into before making segments of them */
+	int scratchMax;							/**< how many points fit in scratchPoints */
+
+	SpriteSystem *sprites;					/**< the sprite system the sprites were loaded from and are drawn with */
+	Sprite *middleChunk;					/**< the body of a segment, stretched along it */
+	Sprite *rightCap;						/**< the cap drawn at the end of a segment */
+	Sprite *leftCap;						/**< the cap drawn at the start of a segment */
+
+	Vect3d color;							/**< the rainbow color the lightning segments are drawn with this frame */
+	int alpha;								/**< alpha the lightning segments are drawn with, and new bolts start with */
+	Uint32 randState;						/**< xorshift state the system's bolts and the flicker of their bloom are drawn from, see lightning_system_seed */
+
+	SDL_Vertex *batchVertices[LIGHTNING_LAYERS];	/**< the quads of every segment queued to be drawn, one array per sprite and pass */
+	int batchNum[LIGHTNING_LAYERS];			/**< how many vertices are queued in each layer */
+	int batchMax[LIGHTNING_LAYERS];			/**< how many vertices fit in each layer */
+	int *batchIndices;						/**< two triangles for every quad, shared by all the layers */
+	int batchIndexMax;						/**< how many indices fit in batchIndices */
+	float *segmentLengths;					/**< the length of every segment of the bolt being queued, measured all at once */
+	Vect2d *segmentDirections;				/**< the direction of every segment of the bolt being queued */
+	int segmentMax;							/**< how many segments fit in segmentLengths and segmentDirections */
+
+	float simplifyTolerance;				/**< how far a point may be from the line through its neighbours and still be dropped */
+	Uint64 simplifyBefore;					/**< how many points the bolts were generated with */
+	Uint64 simplifyAfter;					/**< how many of those points were kept */
+
+	size_t cacheBudget;						/**< the most bytes the bolts' cached drawings may use together, 0 draws every bolt directly */
+	size_t cacheBytes;						/**< how many bytes the cached drawings use */
+	Uint32 cacheFrame;						/**< counts the calls to lightning_draw_all, to know which cache was drawn longest ago */
+
+	float trailFade;						/**< how much of the trail is left after each frame, 0 if the bolts leave no trail */
+	SDL_Texture *trail;						/**< the screen sized texture the trail is kept in by lightning_draw_all, NULL until it is first drawn */
+}LightningSystem;
+
+/**
+ * @struct a bolt being generated a slice at a time
+ * @brief everything needed to pick up where the last slice stopped. the points go straight into a bolt in the boltList, so the
+ *			part that has been generated is drawn like any other bolt while the rest is still to come
+ */
+typedef struct BoltGenerator_t
+{
+	Bolt *bolt;								/**< the bolt being grown, NULL when the generator isn't running */
+
+	Vect2d start;							/**< starting point of the bolt */
+	Vect2d end;								/**< end point of the bolt */
+	Vect2d tangent;							/**< from start to end */
+	Vect2d normal;							/**< unit vector the points are displaced along */
+	float length;							/**< distance from start to end */
+
+	int count;								/**< how many points go between start and end */
+	int made;								/**< how many of them have been generated, count + 1 once end has been added too */
+	int blockStart;							/**< index of the first point that hasn't been simplified yet */
+	float prevPos;							/**< how far along the bolt the last point was, 0 - 1 */
+	float prevDisplacement;					/**< how far the last point was displaced from the line */
+	Uint32 state;							/**< the random state, so the same seed always grows the same bolt */
+}BoltGenerator;
+
 /**
  * @struct used to make a linked list of points (float) on the line segment of the main lightning bolt
  * @brief contains a pointer to the next point on the line, and the position of this point
@@ -49,55 +189,256 @@ typedef struct Position_t
 Position *sort_positions(Position *head);
 
 /**
- * @brief initializes the lightning memory management system, also loads the sprites needed to draw the lightning
+ * @brief creates a lightning system and its memory, also loads the sprites needed to draw the lightning
+ * @param sprites [in,out]	the sprite system to load the sprites from and draw them with
  * @param maxLightning		the maximum amount of lightning segments that can exist at a time
+ * @param maxBolts			the maximum amount of polyline bolts that can exist at a time
+ * @return the new lightning system, NULL if it could not be allocated
  */
-void lightning_init_system(int maxLightning);
+LightningSystem *lightning_system_new(SpriteSystem *sprites, int maxLightning, int maxBolts);
 
 /**
- * @brief closes the lightning memory management system
+ * @brief seeds the random state the system generates its bolts and flickers their bloom with, so the same seed always makes the same
+ *			bolts whatever other systems or rand are doing on other threads
+ * @param system [in,out]	the lightning system to seed
+ * @param seed				the seed, any value works
  */
-void lightning_close_system();
+void lightning_system_seed(LightningSystem *system, Uint32 seed);
+
+/**
+ * @brief frees a lightning system, its pools and its references to its sprites, and destroys the pointer to it
+ * @param system [in,out]	the lightning system to free
+ */
+void lightning_system_free(LightningSystem **system);
 
 /**
  * @brief frees a lightning segment from the lightningList and destroys the pointer to it so anything with a pointer to that lightning segment is destroyed
+ * @param system [in,out]			the lightning system the lightning belongs to
  * @param lightning [in,out]		the lightning that is to be removed from memory
  */
-void lightning_free(Lightning **lightning);
+void lightning_free(LightningSystem *system, Lightning **lightning);
 
 /**
  * @brief creates a new lightning in the lightningList with the given info
+ * @param system [in,out]	the lightning system to create it in
  * @param start		vect2d of the starting point for the lightning
  * @param end		vect2d of the ending point for the lightning
  * @param thickness	how thick the lightning will be 
  * @return pointer to the position in the lightningList where the newly created lightning exists
  */
-Lightning *lightning_new(Vect2d start, Vect2d end, float thickness);
+Lightning *lightning_new(LightningSystem *system, Vect2d start, Vect2d end, float thickness);
+
+/**
+ * @brief queues the lightning and its bloom in the system's color onto the system's batch of geometry, which lightning_draw_all
+ *			draws with one call per sprite. uses trig to determine how long the lightning should be, and what angle it should be drawn at
+ * @param system [in,out]	the lightning system the lightning belongs to
+ * @param self [in]			the lightning that is to be drawn
+ */
+void lightning_draw(LightningSystem *system, Lightning *self);
+
+/**
+ * @brief draw all lighting in the lightningList and all bolts in the boltList that have a draw function, each in its own color, as one
+ *			batch of geometry per sprite. with a trail, the trail is drawn first and what is new of the bolts is added to it
+ * @param system [in,out]	the lightning system to draw
+ */
+void lightning_draw_all(LightningSystem *system);
+
+/**
+ * @brief queues every lightning and bolt that has a draw function onto the CPU rasterizer, in the same colors as lightning_draw_all.
+ *			with a trail, what is new of the bolts is queued with raster_add_trail_segment instead
+ * @param system [in,out]	the lightning system to draw
+ */
+void lightning_raster_all(LightningSystem *system);
 
 /**
- * @brief draws the lightning to the renderer using the statically held sprites, also draws the bloom for the lightning
- *			uses trig to determine how long the lightning should be, and what angle it should be drawn at
- * @param self [in]	the lightning that is to be drawn
+ * @brief queues every bolt that has a draw function as a line light on the background in its own color, and every lightning segment
+ *			together as one light in the system's color
+ * @param system [in,out]	the lightning system to light with
  */
-void lightning_draw(Lightning *self);
+void lightning_light_all(LightningSystem *system);
 
 /**
- * @brief draw all lighting in the lightningList that has a draw function. Also color mods the sprites that all lightning share periodically to go throught the rainbow.
+ * @brief adds every lightning and bolt that has a draw function to the bolt stream's frame, a lightning segment goes in as a bolt of two points
+ * @param system [in]	the lightning system to publish
  */
-void lightning_draw_all();
+void lightning_publish_all(LightningSystem *system);
 
 /**
- * @breif creates the actual bolt of lightning, generates points randomly on the line segment, based on how long it is. 
+ * @brief creates the actual bolt of lightning as separate segments in the lightningList. generates points randomly on the line segment, based on how long it is. 
  *			Then sorts the linked list of points on the line. Finally randomly displace the points under parameters of the previous point,
  *			and predefined values for sway and jaggedness that we want the bolt to have.
+ * @param system [in,out]		the lightning system to create the segments in
  * @param main_lightning [in]	the main lightning, that defines the start and end of the bolt we are about to make
  * @param thickness				the thickness of the bolt we are creating
  */
-void lightning_create_bolt(Lightning *main_lightning, float thickness);
+void lightning_create_bolt(LightningSystem *system, Lightning *main_lightning, float thickness);
+
+/**
+ * @brief sets how far in pixels a point of a bolt may be from the line through its neighbours and still be dropped before the bolt
+ *			is drawn. below a pixel the bolt looks the same with far fewer segments to draw
+ * @param system [in,out]	the lightning system to set it for
+ * @param tolerance			the distance in pixels, 0 keeps every point
+ */
+void lightning_set_simplify_tolerance(LightningSystem *system, float tolerance);
+
+/**
+ * @brief sets how much texture memory the bolts' cached drawings may use, evicting the least recently drawn until they fit. a bolt is
+ *			drawn into its own texture the first frame it is drawn and that texture is drawn as one quad until the bolt changes
+ * @param system [in,out]	the lightning system to set it for
+ * @param bytes				the budget in bytes, 0 frees every cache and draws the bolts directly
+ */
+void lightning_set_cache_budget(LightningSystem *system, size_t bytes);
+
+/**
+ * @brief leaves an afterglow behind the bolts. each bolt is drawn into the trail once, the frame it or a part of it is new, and the
+ *			trail is faded by a constant factor every frame and drawn under the bolts, so a longer trail costs nothing more.
+ *			lightning_draw_all keeps the trail in a texture, lightning_raster_all queues it with raster_add_trail_segment, so set
+ *			the rasterizer's trail to the same fade with raster_set_trail
+ * @param system [in,out]	the lightning system to set it for
+ * @param fade				how much of the trail is left after each frame, under 1. 0 leaves no trail
+ */
+void lightning_set_trail(LightningSystem *system, float fade);
+
+/**
+ * @brief getter for how much simplification has cut the bolts down since the system was created
+ * @param system [in]	the lightning system
+ * @return the number of points kept over the number generated, 1 if nothing has been generated
+ */
+float lightning_get_simplify_ratio(LightningSystem *system);
+
+/**
+ * @brief creates a bolt of lightning in the boltList, with all its points stored in one array instead of as separate segments.
+ *			the bolt is shaped the same way as lightning_create_bolt shapes it
+ * @param system [in,out]	the lightning system to create the bolt in
+ * @param start		starting point of the bolt
+ * @param end		end point of the bolt
+ * @param thickness	the thickness of the bolt
+ * @return pointer to the position in the boltList where the newly created bolt exists
+ */
+Bolt *lightning_bolt_new(LightningSystem *system, Vect2d start, Vect2d end, float thickness);
+
+/**
+ * @brief generates the points of a bolt into the caller's array without touching the lightningList, boltList or rand, so it can be
+ *			called from several threads at once as long as each has its own state and array. shaped like lightning_bolt_new
+ * @param start				starting point of the bolt
+ * @param end				end point of the bolt
+ * @param thickness			the thickness of the bolt
+ * @param state [in,out]	random state to generate with, any seed works and the same seed gives the same bolt
+ * @param points [in,out]	the array to write the points to, grown with realloc if it is too small
+ * @param maxPoints [in,out]	how many points fit in points
+ * @return the number of points written, the first is start and the last is end. 0 if the thickness isn't positive, the bolt
+ *			would need more points than an int holds or the points could not be allocated
+ */
+int lightning_generate(Vect2d start, Vect2d end, float thickness, Uint32 *state, Vect2d **points, int *maxPoints);
+
+/**
+ * @brief creates a bolt in the boltList with room for the given number of points, for callers that fill in the points themselves
+ * @param system [in,out]	the lightning system to create the bolt in
+ * @param numPoints			how many points the bolt will have
+ * @param thickness			the thickness of the bolt
+ * @return pointer to the new bolt, its numPoints points are left for the caller to write
+ */
+Bolt *lightning_bolt_alloc(LightningSystem *system, int numPoints, float thickness);
+
+/**
+ * @brief the color of the rainbow at a time, fading one channel at a time from yellow through red, magenta, blue, cyan and green
+ * @param time		milliseconds, the rainbow goes around once every LIGHTNING_RAINBOW_TIME
+ * @param hue		how far around the rainbow to start, 0 - 1
+ * @return the color, each component 0 - 255
+ */
+Vect3d lightning_rainbow(Uint32 time, float hue);
+
+/**
+ * @brief gives a bolt a color of its own instead of the rainbow
+ * @param bolt [in,out]	the bolt
+ * @param color			its color, each component 0 - 255
+ * @param alpha			its alpha, 0 - 255
+ * @param intensity		how bright it is, multiplies the color
+ */
+void lightning_bolt_set_color(Bolt *bolt, Vect3d color, int alpha, float intensity);
+
+/**
+ * @brief sets a bolt's color to follow the rainbow over time, which is what a new bolt does
+ * @param bolt [in,out]	the bolt
+ * @param hue			how far around the rainbow from the other bolts it is, 0 - 1
+ */
+void lightning_bolt_set_rainbow(Bolt *bolt, float hue);
+
+/**
+ * @brief counts the points of a bolt that are drawn, a bolt that is still growing only draws the start of its points
+ * @param bolt [in]	the bolt
+ * @return how many points from the start are drawn
+ */
+int lightning_bolt_drawn(Bolt *bolt);
+
+/**
+ * @brief sets how much of a bolt is drawn as it grows from its start like a stepped leader, followed by a brighter return stroke
+ *			over the whole bolt. only the bolt's draw count changes, the points are left alone
+ * @param bolt [in,out]	the bolt to animate
+ * @param age			milliseconds since the bolt was created
+ * @return 1 while the bolt is still growing or flashing, 0 once it is drawn normally
+ */
+int lightning_bolt_set_growth(Bolt *bolt, Uint32 age);
+
+/**
+ * @brief starts growing a bolt in the boltList that is generated a slice at a time by lightning_generator_step, for bolts too big to
+ *			generate in one frame. shaped like lightning_bolt_new, but the points along it are drawn already in order so there is
+ *			nothing to sort
+ * @param system [in,out]		the lightning system to create the bolt in
+ * @param generator [out]		the generator to start, anything it was running is forgotten without being freed
+ * @param start					starting point of the bolt
+ * @param end					end point of the bolt
+ * @param thickness				the thickness of the bolt
+ * @param segments				how many segments to grow the bolt with, 0 picks it from the length and thickness like every other bolt
+ * @param seed					random state to start from, the same seed always grows the same bolt
+ * @return the bolt, which has only its starting point so far. NULL if it could not be created or the thickness isn't positive
+ */
+Bolt *lightning_generator_start(LightningSystem *system, BoltGenerator *generator, Vect2d start, Vect2d end, float thickness, int segments, Uint32 seed);
+
+/**
+ * @brief generates the next slice of a bolt, stopping once either budget is used up
+ * @param system [in,out]		the lightning system the bolt is in
+ * @param generator [in,out]	the running generator
+ * @param maxPoints				the most points to generate, 0 for no limit
+ * @param maxMilliseconds		how long to spend, 0 for no limit
+ * @return 1 if the bolt is complete or the generator isn't running, 0 if there is more to generate
+ */
+int lightning_generator_step(LightningSystem *system, BoltGenerator *generator, int maxPoints, float maxMilliseconds);
+
+/**
+ * @brief generates whatever is left of a bolt and stops the generator, the bolt stays in the boltList
+ * @param system [in,out]		the lightning system the bolt is in
+ * @param generator [in,out]	the generator to finish
+ * @return the complete bolt, NULL if the generator wasn't running
+ */
+Bolt *lightning_generator_finish(LightningSystem *system, BoltGenerator *generator);
+
+/**
+ * @brief stops a generator and frees the bolt it was growing, call it before the bolt is freed any other way
+ * @param system [in,out]		the lightning system the bolt is in
+ * @param generator [in,out]	the generator to cancel
+ */
+void lightning_generator_cancel(LightningSystem *system, BoltGenerator *generator);
+
+/**
+ * @brief frees a bolt from the boltList and destroys the pointer to it, the bolt's points are kept to be reused by the next bolt
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param bolt [in,out]		the bolt that is to be removed from memory
+ */
+void lightning_bolt_free(LightningSystem *system, Bolt **bolt);
+
+/**
+ * @brief draws the bolt from its cache when it can be cached, otherwise queues every segment and its bloom in the bolt's color onto
+ *			the system's batch of geometry with one walk along its points
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param self [in,out]		the bolt that is to be drawn
+ */
+void lightning_bolt_draw(LightningSystem *system, Bolt *self);
 
 /**
- * @brief removes all lightning in the lightningList
+ * @brief removes all lightning in the lightningList and all bolts in the boltList
+ * @param system [in,out]	the lightning system to empty
  */
-void lightning_purge_system();
+void lightning_purge_system(LightningSystem *system);
 
 #endif
\ No newline at end of file
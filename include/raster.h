@@ -0,0 +1,97 @@
+#ifndef __RASTER_H__
+#define __RASTER_H__
+
+#include "vector.h"
+
+/**
+ * @file	raster.h
+ * @brief	tile based CPU rasterizer for the lightning, draws anti-aliased capsules with an additive glow into an RGBA framebuffer, one tile per job on the job system's workers.
+ *			used when there is no GPU and SDL's software renderer would have to rotate every sprite one at a time.
+ */
+
+#define RASTER_TILE_SIZE		64			/**< width and height of a screen tile in pixels, must be a multiple of 4 for the SIMD path */
+
+#define RASTER_GLOW_SCALE		3.0f		/**< how far the glow reaches from the segment, in multiples of the segment's thickness */
+
+#define RASTER_GLOW_INTENSITY	0.35f		/**< brightness of the glow right at the edge of the segment */
+
+#define RASTER_TRAIL_FLOOR		(0.5f / 255.0f)	/**< once the brightest light left in a tile of the trail fades under this the tile is cleared and skipped */
+
+/**
+ * @struct a segment queued to be rasterized
+ * @brief the capsule that will be drawn, along with its color and the bounding box used to bin it into tiles
+ */
+typedef struct RasterSegment_t
+{
+	Vect2d start;							/**< starting point of the capsule */
+	Vect2d end;								/**< end point of the capsule */
+	float radius;							/**< half of the thickness of the capsule */
+	float glowRadius;						/**< distance from the center line where the glow fades out completely */
+	Vect3d color;							/**< color of the capsule, each component 0 - 1 */
+	int trail;								/**< if set the capsule is drawn into the trail, to fade out over the next frames */
+}RasterSegment;
+
+/**
+ * @brief initializes the rasterizer and allocates the framebuffer, tiles are rasterized on the job system's workers
+ * @param width		width of the framebuffer in pixels
+ * @param height	height of the framebuffer in pixels
+ * @return 1 if the rasterizer is ready, 0 if the size isn't positive or the framebuffer could not be allocated
+ */
+int raster_init_system(int width, int height);
+
+/**
+ * @brief frees the framebuffer, the segment queue and the workers' accumulation buffers
+ */
+void raster_close_system();
+
+/**
+ * @brief empties the segment queue and sets the color the framebuffer will be cleared to on the next render
+ * @param color		clear color, each component 0 - 255
+ */
+void raster_clear(Vect3d color);
+
+/**
+ * @brief queues a segment to be drawn on the next raster_render
+ * @param start		starting point of the segment
+ * @param end		end point of the segment
+ * @param thickness	how thick the segment is
+ * @param color		color of the segment, each component 0 - 255
+ */
+void raster_add_segment(Vect2d start, Vect2d end, float thickness, Vect3d color);
+
+/**
+ * @brief queues a segment to be drawn into the trail on the next raster_render. it shows the same as any other segment that frame,
+ *			then stays behind and fades by the trail's factor every frame after, without being queued again. drawn like
+ *			raster_add_segment if there is no trail
+ * @param start		starting point of the segment
+ * @param end		end point of the segment
+ * @param thickness	how thick the segment is
+ * @param color		color of the segment, each component 0 - 255
+ */
+void raster_add_trail_segment(Vect2d start, Vect2d end, float thickness, Vect3d color);
+
+/**
+ * @brief keeps the light of the segments queued with raster_add_trail_segment in a buffer the size of the framebuffer, multiplied by
+ *			fade every render and added under the frame. the cost per frame is one pass over the lit tiles however long the trail is
+ * @param fade		how much of the trail is left after each frame, under 1. 0 frees the trail
+ */
+void raster_set_trail(float fade);
+
+/**
+ * @brief bins every queued segment into the tiles it touches, then rasterizes all the tiles in parallel into the framebuffer
+ */
+void raster_render();
+
+/**
+ * @brief getter for the framebuffer, pixels are stored as R, G, B, A bytes
+ * @param pitch [out]	if non-null, set to the number of bytes in one row of the framebuffer
+ * @return the framebuffer, NULL if the rasterizer was never initialized
+ */
+Uint8 *raster_get_pixels(int *pitch);
+
+/**
+ * @brief uploads the framebuffer to a streaming texture and copies it onto the game's renderer
+ */
+void raster_present();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "vector.h"
+
+/**
+ * @file	replay.h
+ * @brief	records the inputs of every bolt that gets generated into a compact append only log, and reads the log back so the exact
+ *			same bolts can be regenerated and drawn again, either at the recorded pace or as fast as possible.
+ *
+ *			the log is an 8 byte header ("LSRP", version, 3 reserved bytes) followed by frame records:
+ *				varint time since the previous frame (ms), varint number of bolts, then for each bolt
+ *				zigzag varint deltas of start x, start y, end x, end y and thickness from the previous bolt (in 1/16 pixel), and a varint seed
+ *			a record cut short by a crash is ignored when reading.
+ */
+
+#define REPLAY_MAGIC			"LSRP"		/**< the first four bytes of every replay log */
+
+#define REPLAY_VERSION			1			/**< version of the log format written */
+
+#define REPLAY_SUBPIXEL			16.0f		/**< positions and thickness are stored in 1/REPLAY_SUBPIXEL pixel steps */
+
+/**
+ * @enum how fast a replay is played back
+ */
+typedef enum
+{
+	REPLAY_WALL_CLOCK = 0,					/**< frames are played at the times they were recorded at */
+	REPLAY_MAX_THROUGHPUT = 1				/**< frames are played back to back as fast as they can be generated and drawn */
+}ReplayMode;
+
+/**
+ * @struct the inputs of one bolt request
+ * @brief everything lightning_create_bolt needs to make the same bolt again
+ */
+typedef struct ReplayBolt_t
+{
+	Vect2d start;							/**< starting point of the bolt */
+	Vect2d end;								/**< end point of the bolt */
+	float thickness;						/**< thickness the bolt was created with */
+	Uint32 seed;							/**< the value rand and the lightning system were seeded with right before the bolt was generated */
+}ReplayBolt;
+
+/**
+ * @brief opens a replay log for recording, an existing log at the path is replaced
+ * @param [in] path		the file to record to
+ * @return 1 if the log was opened, 0 otherwise
+ */
+int replay_record_open(char *path);
+
+/**
+ * @brief writes out any pending frame and closes the log being recorded
+ */
+void replay_record_close();
+
+/**
+ * @brief adds a bolt request to the frame being recorded
+ * @param start		starting point of the bolt
+ * @param end		end point of the bolt
+ * @param thickness	thickness the bolt is created with
+ * @param seed		the value rand and the lightning system were seeded with right before the bolt is generated
+ */
+void replay_record_bolt(Vect2d start, Vect2d end, float thickness, Uint32 seed);
+
+/**
+ * @brief ends the frame being recorded and appends it to the log, frames without any bolts are not written
+ * @param time		the game time of the frame
+ */
+void replay_record_frame(Uint32 time);
+
+/**
+ * @brief maps a replay log into memory for playing back
+ * @param [in] path		the log to play
+ * @return 1 if the log was opened, 0 otherwise
+ */
+int replay_open(char *path);
+
+/**
+ * @brief unmaps the replay log being played
+ */
+void replay_close();
+
+/**
+ * @brief decodes the next frame of the replay log
+ * @param time [out]		the game time the frame was recorded at, relative to the first frame in the log
+ * @param bolts [out]		filled with the frame's bolt requests
+ * @param maxBolts			the most bolts that fit in bolts, any extra in the frame are skipped
+ * @return the number of bolts put in bolts, -1 when there are no frames left
+ */
+int replay_next_frame(Uint32 *time, ReplayBolt *bolts, int maxBolts);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#include "lightning.h"
+
+/**
+ * @file	scene.h
+ * @brief	headless whole-frame benchmark. plays scripted scenes for a fixed number of frames: one bolt chasing a moving target, a
+ *			storm of a thousand bolts a frame and bolts across the whole window, generating them with lightning_bolt_new, drawing them
+ *			with the rasterizer and copying each finished frame out the way a capture or texture upload would. rand is seeded the
+ *			same way for every run so every run draws the same frames.
+ *
+ *			the p50, p99 and max of each phase's frame times are compared against the thresholds in a baseline file, one per line:
+ *			scene, phase (generate, draw, present or total), statistic (p50, p99 or max) and the most milliseconds allowed.
+ *			lines starting with # are comments
+ */
+
+#define SCENE_BASELINE			"scene_baseline.txt"	/**< the checked in baseline read when no other is asked for */
+
+#define SCENE_SEED				1			/**< what rand is seeded with at the start of every scene */
+
+#define SCENE_HEADROOM			2.0f		/**< how far over a run's own times the thresholds it writes with -sceneupdate are set */
+
+#define SCENE_FLOOR				1.0f		/**< the lowest threshold -sceneupdate writes, in milliseconds, so phases that take next to nothing don't fail on noise */
+
+#define SCENE_MAX_BOLTS			1024		/**< the most bolts a scene draws in one frame */
+
+/**
+ * @enum the parts of a frame that are timed
+ */
+typedef enum
+{
+	SCENE_GENERATE = 0,						/**< purging last frame's bolts and generating this frame's */
+	SCENE_DRAW = 1,							/**< queueing the bolts and rasterizing them */
+	SCENE_PRESENT = 2,						/**< copying the finished frame out of the framebuffer */
+	SCENE_TOTAL = 3,						/**< all of the above */
+	SCENE_PHASES = 4
+}ScenePhase;
+
+/**
+ * @struct what a scene benchmark run needs to know
+ */
+typedef struct SceneOptions_t
+{
+	char *baseline;							/**< the file of thresholds to check the run against */
+	int update;								/**< if set the baseline is rewritten from this run's times instead of checked */
+	int threads;							/**< how many job workers to rasterize on, 0 uses one per cpu core */
+}SceneOptions;
+
+/**
+ * @brief fills in the options a scene benchmark uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void scene_default_options(SceneOptions *options);
+
+/**
+ * @brief plays every scene, logs the p50, p99 and max of each phase and checks them against the baseline, or rewrites the baseline
+ *			from them if options->update is set
+ * @param options [in]	the baseline and how to run
+ * @return 1 if every scene ran within its thresholds, 0 if one was exceeded or the benchmark could not run
+ */
+int scene_run(SceneOptions *options);
+
+#endif
\ No newline at end of file
@@ -28,6 +28,13 @@
 */
 void init_logger(const char *log_file_path);
 
+/**
+  @brief turns echoing log messages to stdout on or off, off is needed when stdout is used for data such as a frame capture
+
+  @param echo 0 to only log to the file
+*/
+void set_logger_echo(int echo);
+
 /**
   @brief logs a message to stdout and to the configured log file
   @param msg a string with tokens
@@ -0,0 +1,26 @@
+#ifndef __SIMPLIFY_H__
+#define __SIMPLIFY_H__
+
+#include "vector.h"
+
+/**
+ * @file	simplify.h
+ * @brief	thins out the points of a polyline that sit too close to the line through their neighbours to be seen, so nearly
+ *			straight runs of a bolt are drawn as one segment instead of many
+ */
+
+#define SIMPLIFY_TOLERANCE		0.5f		/**< default largest distance in pixels a dropped point may be from the simplified line */
+
+#define SIMPLIFY_STACK			64			/**< how many ranges the simplification can have waiting, ranges past this keep all their points */
+
+/**
+ * @brief simplifies a polyline in place with Douglas-Peucker, without recursing or allocating. the first and last points are
+ *			always kept, and every dropped point is within tolerance of the segment that replaced it
+ * @param points [in,out]	the points of the polyline, the kept points are moved to the front in order
+ * @param numPoints			how many points the polyline has
+ * @param tolerance			largest distance a dropped point may be from the simplified line, 0 or less keeps every point
+ * @return how many points were kept
+ */
+int simplify_polyline(Vect2d *points, int numPoints, float tolerance);
+
+#endif
\ No newline at end of file
@@ -26,33 +26,78 @@ typedef struct Sprite_t
 }Sprite;
 
 /**
- * @brief	removes one reference from spriteList, if the
+ * @struct an image baked into the binary, already converted to RGBA bytes, so sprite_load can upload it without touching the disk
+ * @brief written by sprite_write_embedded into sprite_embedded.c, which is regenerated whenever one of the images changes
+ */
+typedef struct SpriteEmbedded_t
+{
+	char *filename;			/**< the path the image was loaded from, sprite_load matches it against the filename it is asked for */
+	int w;					/**< width of the image in pixels */
+	int h;					/**< height of the image in pixels */
+	const Uint8 *pixels;	/**< R, G, B, A bytes for every pixel, rows top to bottom with no padding */
+}SpriteEmbedded;
+
+extern SpriteEmbedded spriteEmbedded[];	/**< every embedded image, ended by one with a NULL filename */
+
+/**
+ * @struct a sprite system, the sprites loaded for one renderer
+ * @brief owns a spriteList and the renderer its textures belong to, so each thread or viewport can have its own without sharing any state
+ */
+typedef struct SpriteSystem_t
+{
+	Sprite *spriteList;			/**< the sprites of the system, a sprite is free when its refCount is 0 */
+	int spriteNum;				/**< how many sprites are loaded */
+	int spriteMax;				/**< how many sprites fit in spriteList */
+	SDL_Renderer *renderer;		/**< the renderer the textures are created for and drawn with */
+	Uint32 randState;			/**< xorshift state the bloom's flicker is drawn from, so systems on different threads share nothing */
+}SpriteSystem;
+
+/**
+ * @brief	removes one reference from the system's spriteList, if the
  * 			refCount is 0 frees the sprite from spriteList and frees the sprite pointer.
+ * @param [in,out]	system	the sprite system the sprite was loaded from.
  * @param [in,out]	sprite	double pointer to the sprite.
  */
-void sprite_free(Sprite **free);
+void sprite_free(SpriteSystem *system, Sprite **sprite);
 
-/** @brief	closes the sprite system by freeing the entire sprite list and setting the number of sprites in the list to 0*/
-void sprite_close_system();
+/**
+ * @brief	frees a sprite system by destroying every texture in its sprite list and freeing the list, and destroys the pointer to it
+ * @param [in,out]	system	the sprite system to free.
+ */
+void sprite_system_free(SpriteSystem **system);
 
 /**
- *  @brief opens the sprite system by allocating and memsetting the spriteList to have room for the provided number of sprites 
- *  @param	maxSprites	the maximum number of different sprites the spriteList will be able to support
+ *  @brief creates a sprite system by allocating and memsetting a spriteList to have room for the provided number of sprites 
+ *  @param	maxSprites		the maximum number of different sprites the spriteList will be able to support
+ *  @param	[in] renderer	the renderer to load and draw the sprites with
+ *  @return the new sprite system, NULL if it could not be allocated
  */
-void sprite_init_system(int maxSprites);
+SpriteSystem *sprite_system_new(int maxSprites, SDL_Renderer *renderer);
 
 /** 
- * @brief loads a sprite into the spriteList using the given info
+ * @brief loads a sprite into the system's spriteList using the given info
+ * @param	[in,out] system	the sprite system to load into
  * @param	[in] filename	the filepath for the image
  * @param	frameSize		2d vector defining how large a frame of the image will be
  * @param	fpl				the frames per line on the image
  * @param	frames			the total number of frames that the image has, used to know when the sprite has gone through the animation
  * @return A pointer to the sprite with the info provided
  */
-Sprite *sprite_load(char *filename, Vect2d frameSize, int fpl, int frames);
+Sprite *sprite_load(SpriteSystem *system, char *filename, Vect2d frameSize, int fpl, int frames);
+
+/**
+ * @brief loads images from disk the way sprite_load does, converts them to RGBA bytes and writes them as C source for a table of
+ *			SpriteEmbedded, so they can be compiled into the binary in place of sprite_embedded.c
+ * @param	[in] path		the C file to write
+ * @param	[in] filenames	the images to embed, the same paths sprite_load will be asked for
+ * @param	count			how many images there are
+ * @return 1 if every image was written, 0 otherwise
+ */
+int sprite_write_embedded(char *path, char **filenames, int count);
 
 /**
  * @brief draws the sprite frame to the screen at the given position
+ * @param	[in] system		the sprite system whose renderer to draw with
  * @param	[in] sprite		the image reference to be drawn from
  * @param	frame			the frame of  the image to draw
  * @param	drawPos			2D vector of where the sprite should be drawn in the game world
@@ -61,10 +106,11 @@ Sprite *sprite_load(char *filename, Vect2d frameSize, int fpl, int frames);
  * @param	angle			the angle to rotate it by
  * @param	flip			whether or not to flip the image
  */
-void sprite_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip);
+void sprite_draw(SpriteSystem *system, Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip);
 
 /**
  * @brief draws the sprite frame to the screen at the position given, adds alpha and size variation to scale the sprite and create a bloom
+ * @param	[in] system		the sprite system whose renderer to draw with
  * @param	[in] sprite		the image reference to be drawn from
  * @param	frame			the frame of  the image to draw
  * @param	drawPos			2D vector of where the sprite should be drawn in the game world
@@ -73,7 +119,7 @@ void sprite_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Po
  * @param	angle			the angle to rotate it by
  * @param	flip			whether or not to flip the image
  */
-void sprite_bloom_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip);
+void sprite_bloom_draw(SpriteSystem *system, Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip);
 
 
 
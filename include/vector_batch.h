@@ -0,0 +1,100 @@
+#ifndef __VECTOR_BATCH_H__
+#define __VECTOR_BATCH_H__
+
+#include "vector.h"
+
+/**
+ * @file	vector_batch.h
+ * @brief	the vect2d helpers over whole arrays at once, four vectors at a time with SSE2 when the compiler targets it and one at a time
+ *			otherwise, and fast approximations of atan2 and sincos with a known worst case. the vect2d arrays are the usual array of
+ *			Vect2d (x, y, x, y...), the angle arrays are plain arrays of floats. outputs may be the same arrays as inputs unless said
+ *			otherwise, no array needs any alignment.
+ */
+
+#define VECT_ATAN2_ERROR		2.0e-6f		/**< the most vect_atan2 is ever off from atan2, in radians */
+
+#define VECT_SINCOS_ERROR		1.0e-7f		/**< the most vect_sincos is ever off from sin and cos, for angles within VECT_SINCOS_RANGE */
+
+#define VECT_SINCOS_RANGE		8192.0f		/**< how far from 0 an angle can be before vect_sincos loses accuracy, in radians */
+
+/**
+ * @brief	fast atan2, a polynomial on the octant the vector is in. off by at most VECT_ATAN2_ERROR, atan2(0, 0) is 0
+ * @param	y	the y of the vector, finite
+ * @param	x	the x of the vector, finite
+ * @return	the angle of the vector from the x axis, -PI to PI.
+ */
+float vect_atan2(float y, float x);
+
+/**
+ * @brief	fast sine and cosine of the same angle, polynomials on the angle folded into -PI/4 to PI/4. off by at most
+ *			VECT_SINCOS_ERROR within VECT_SINCOS_RANGE of 0
+ * @param	angle	the angle, in radians
+ * @param [out]	sine	the sine of the angle
+ * @param [out]	cosine	the cosine of the angle
+ */
+void vect_sincos(float angle, float *sine, float *cosine);
+
+/**
+ * @brief	vect_atan2 of every pair of components.
+ * @param [in]	y		the y of every vector
+ * @param [in]	x		the x of every vector
+ * @param [out]	angles	the angle of every vector
+ * @param	count		how many vectors there are
+ */
+void vect_batch_atan2(const float *y, const float *x, float *angles, int count);
+
+/**
+ * @brief	vect_sincos of every angle.
+ * @param [in]	angles	the angles
+ * @param [out]	sines	the sine of every angle
+ * @param [out]	cosines	the cosine of every angle
+ * @param	count		how many angles there are
+ */
+void vect_batch_sincos(const float *angles, float *sines, float *cosines, int count);
+
+/**
+ * @brief	the length of every vect2d.
+ * @param [in]	vects	the vectors
+ * @param [out]	lengths	the length of every vector
+ * @param	count		how many vectors there are
+ */
+void vect2d_batch_length(const Vect2d *vects, float *lengths, int count);
+
+/**
+ * @brief	normalizes every vect2d in place, vectors of length 0 are left as they are the way vect2d_normalize leaves them.
+ * @param [in,out]	vects	the vectors
+ * @param	count			how many vectors there are
+ */
+void vect2d_batch_normalize(Vect2d *vects, int count);
+
+/**
+ * @brief	out = a + b * factor for every vect2d, the step the generators take along a bolt.
+ * @param [out]	out		the results
+ * @param [in]	a		the vectors added to
+ * @param [in]	b		the vectors scaled and added
+ * @param	factor		what every b is scaled by
+ * @param	count		how many vectors there are
+ */
+void vect2d_batch_scale_add(Vect2d *out, const Vect2d *a, const Vect2d *b, float factor, int count);
+
+/**
+ * @brief	rotates every vect2d about the origin by the same angle.
+ * @param [out]	out		the rotated vectors
+ * @param [in]	in		the vectors
+ * @param	angle		how far to rotate them, in radians, positive turns x towards y
+ * @param	count		how many vectors there are
+ */
+void vect2d_batch_rotate(Vect2d *out, const Vect2d *in, float angle, int count);
+
+/**
+ * @brief	measures every segment of a line through the points, segment i running from points[i] to points[i + 1]. any of the outputs
+ *			can be NULL if it isn't wanted, none of them can be the points.
+ * @param [in]	points		the points along the line
+ * @param	numPoints		how many points there are, there is one segment fewer
+ * @param [out]	lengths		the length of every segment
+ * @param [out]	angles		the angle of every segment from the x axis, from vect_atan2
+ * @param [out]	directions	the unit vector every segment runs along, (1, 0) for segments of length 0 to agree with their angle of 0
+ */
+void vect2d_batch_segments(const Vect2d *points, int numPoints, float *lengths, float *angles, Vect2d *directions);
+
+#endif
\ No newline at end of file
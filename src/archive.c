@@ -0,0 +1,676 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "archive.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ARCHIVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define ARCHIVE_HEADER_SIZE		16			/**< magic, version, 3 reserved bytes, number of bolts and number of data bytes */
+
+#define ARCHIVE_RECORD_SIZE		20			/**< bytes each ArchiveBolt takes in the file */
+
+/**
+ * @brief converts a float to a half float, rounding to nearest
+ * @param value		the float to convert
+ * @return the half float bits
+ */
+Uint16 archive_float_to_half(float value)
+{
+	union { float f; Uint32 u; } bits;
+	Uint32 sign, mantissa;
+	Sint32 exponent;
+	Uint32 half;
+
+	bits.f = value;
+	sign = (bits.u >> 16) & 0x8000;
+	exponent = (Sint32)((bits.u >> 23) & 0xff) - 127 + 15;
+	mantissa = bits.u & 0x7fffff;
+
+	if(((bits.u >> 23) & 0xff) == 0xff)
+	{
+		/*infinity stays infinity, every nan becomes a quiet nan*/
+		return (Uint16)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+	if(exponent >= 31)
+	{
+		return (Uint16)(sign | 0x7c00);
+	}
+	if(exponent <= 0)
+	{
+		if(exponent < -10)
+		{
+			return (Uint16)sign;
+		}
+		mantissa |= 0x800000;
+		half = mantissa >> (14 - exponent);
+		if((mantissa >> (13 - exponent)) & 1)
+		{
+			half++;
+		}
+		return (Uint16)(sign | half);
+	}
+	half = sign | (exponent << 10) | (mantissa >> 13);
+	if(mantissa & 0x1000)
+	{
+		/*a carry out of the mantissa rolls correctly into the exponent*/
+		half++;
+	}
+	return (Uint16)half;
+}
+
+/**
+ * @brief converts a half float to a float
+ * @param half		the half float bits
+ * @return the float
+ */
+float archive_half_to_float(Uint16 half)
+{
+	union { float f; Uint32 u; } bits;
+	Uint32 sign = (Uint32)(half & 0x8000) << 16;
+	Uint32 exponent = (half >> 10) & 0x1f;
+	Uint32 mantissa = half & 0x3ff;
+
+	if(exponent == 0)
+	{
+		/*zero or subnormal, mantissa * 2^-24*/
+		bits.f = mantissa * (1.0f / 16777216.0f);
+		bits.u |= sign;
+	}
+	else if(exponent == 31)
+	{
+		bits.u = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits.u = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	return bits.f;
+}
+
+/**
+ * @brief size of one step of a bolt's grid
+ * @param shift		the bolt's grid shift
+ * @return the step in pixels
+ */
+static float archive_step(int shift)
+{
+	return (float)(1 << shift) / 16.0f;
+}
+
+/**
+ * @brief creates an empty archive
+ * @return the new archive, NULL if it could not be allocated
+ */
+Archive *archive_new()
+{
+	Archive *archive = (Archive *)malloc(sizeof(Archive));
+	if(!archive)
+	{
+		slog("archive failed to allocate");
+		return NULL;
+	}
+	memset(archive, 0, sizeof(Archive));
+	return archive;
+}
+
+/**
+ * @brief frees an archive and everything in it, and destroys the pointer to it
+ * @param archive [in,out]	the archive to free
+ */
+void archive_free(Archive **archive)
+{
+	if(!archive || !*archive)
+	{
+		return;
+	}
+	free((*archive)->bolts);
+	free((*archive)->data);
+	free(*archive);
+	*archive = NULL;
+}
+
+/**
+ * @brief makes sure the archive has room for one more bolt and the given number of data bytes
+ * @param archive [in,out]	the archive to grow
+ * @param bytes				data bytes needed
+ * @return 0 if the archive could not grow
+ */
+static int archive_reserve(Archive *archive, Uint32 bytes)
+{
+	ArchiveBolt *bolts;
+	Uint8 *data;
+	Uint32 dataMax;
+	if(archive->numBolts >= archive->maxBolts)
+	{
+		bolts = (ArchiveBolt *)realloc(archive->bolts, sizeof(ArchiveBolt) * MAX(64, archive->maxBolts * 2));
+		if(!bolts)
+		{
+			return 0;
+		}
+		archive->bolts = bolts;
+		archive->maxBolts = MAX(64, archive->maxBolts * 2);
+	}
+	if(archive->dataSize + bytes > archive->dataMax)
+	{
+		dataMax = MAX(4096, archive->dataMax * 2);
+		while(dataMax < archive->dataSize + bytes)
+		{
+			dataMax *= 2;
+		}
+		data = (Uint8 *)realloc(archive->data, dataMax);
+		if(!data)
+		{
+			return 0;
+		}
+		archive->data = data;
+		archive->dataMax = dataMax;
+	}
+	return 1;
+}
+
+/**
+ * @brief checks if every step between points fits in an int8 on a grid, following the quantized points rather than the originals so error never builds up
+ * @param points [in]	the bolt's points
+ * @param numPoints		how many points the bolt has
+ * @param shift			the grid shift to try
+ * @param out [out]		if non-null, the deltas are written here
+ * @return 1 if every step fits
+ */
+static int archive_fit_delta8(Vect2d *points, int numPoints, int shift, Uint8 *out)
+{
+	int i;
+	float step = archive_step(shift);
+	double gx, gy;
+	Sint32 x = 0, y = 0, dx, dy;
+
+	for(i = 1; i < numPoints; i++)
+	{
+		gx = floor((points[i].x - points[0].x) / step + 0.5f) - x;
+		gy = floor((points[i].y - points[0].y) / step + 0.5f) - y;
+		/*checked before the cast, which is undefined for values out of range and for NaN, which fails every comparison*/
+		if(!(gx >= -128 && gx <= 127 && gy >= -128 && gy <= 127))
+		{
+			return 0;
+		}
+		dx = (Sint32)gx;
+		dy = (Sint32)gy;
+		x += dx;
+		y += dy;
+		if(out)
+		{
+			*out++ = (Uint8)(Sint8)dx;
+			*out++ = (Uint8)(Sint8)dy;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief checks if every point's offset from the first point fits in an int16 on a grid
+ * @param points [in]	the bolt's points
+ * @param numPoints		how many points the bolt has
+ * @param shift			the grid shift to try
+ * @param out [out]		if non-null, the offsets are written here as little endian int16s
+ * @return 1 if every offset fits
+ */
+static int archive_fit_offset16(Vect2d *points, int numPoints, int shift, Uint8 *out)
+{
+	int i;
+	float step = archive_step(shift);
+	double gx, gy;
+	Sint32 x, y;
+
+	for(i = 0; i < numPoints; i++)
+	{
+		gx = floor((points[i].x - points[0].x) / step + 0.5f);
+		gy = floor((points[i].y - points[0].y) / step + 0.5f);
+		if(!(gx >= -32768 && gx <= 32767 && gy >= -32768 && gy <= 32767))
+		{
+			return 0;
+		}
+		x = (Sint32)gx;
+		y = (Sint32)gy;
+		if(out)
+		{
+			*out++ = (Uint8)(x & 0xff);
+			*out++ = (Uint8)((x >> 8) & 0xff);
+			*out++ = (Uint8)(y & 0xff);
+			*out++ = (Uint8)((y >> 8) & 0xff);
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief packs a bolt's points into the archive, picking the smallest encoding that keeps every point within maxError of where it was
+ * @param archive [in,out]	the archive to add to
+ * @param points [in]		the bolt's points
+ * @param numPoints			how many points the bolt has
+ * @param thickness			the bolt's thickness
+ * @param maxError			the furthest a decoded point may be from the original, in pixels. the finest grid is 1/16 of a pixel,
+ *							so a point can always be up to 1/32 of a pixel off along each axis however small this is
+ * @return the index of the packed bolt, -1 if it could not be added
+ */
+int archive_add(Archive *archive, Vect2d *points, int numPoints, float thickness, float maxError)
+{
+	int shift, maxShift;
+	Uint32 bytes;
+	ArchiveBolt *bolt;
+	ArchiveEncoding encoding = ARCHIVE_DELTA8;
+
+	if(!archive || !points || numPoints <= 0)
+	{
+		slog("nothing to add to the archive");
+		return -1;
+	}
+
+	/*rounding to the grid moves a point at most half a step along each axis*/
+	for(maxShift = 0; maxShift < ARCHIVE_MAX_SHIFT && archive_step(maxShift + 1) * 0.5f <= maxError; maxShift++);
+
+	for(shift = 0; shift <= maxShift; shift++)
+	{
+		if(archive_fit_delta8(points, numPoints, shift, NULL))
+		{
+			break;
+		}
+	}
+	if(shift > maxShift)
+	{
+		encoding = ARCHIVE_OFFSET16;
+		for(shift = 0; shift <= maxShift; shift++)
+		{
+			if(archive_fit_offset16(points, numPoints, shift, NULL))
+			{
+				break;
+			}
+		}
+		if(shift > maxShift)
+		{
+			slog("bolt is too large to archive within %f pixels", maxError);
+			return -1;
+		}
+	}
+
+	bytes = encoding == ARCHIVE_DELTA8 ? (numPoints - 1) * 2 : numPoints * 4;
+	if(!archive_reserve(archive, bytes + 1))
+	{
+		slog("archive failed to grow");
+		return -1;
+	}
+	if(encoding == ARCHIVE_OFFSET16)
+	{
+		/*keep int16 data 2 byte aligned*/
+		archive->dataSize = (archive->dataSize + 1) & ~1;
+	}
+
+	bolt = &archive->bolts[archive->numBolts];
+	bolt->origin = points[0];
+	bolt->thickness = archive_float_to_half(thickness);
+	bolt->encoding = (Uint8)encoding;
+	bolt->shift = (Uint8)shift;
+	bolt->numPoints = numPoints;
+	bolt->offset = archive->dataSize;
+	if(encoding == ARCHIVE_DELTA8)
+	{
+		archive_fit_delta8(points, numPoints, shift, &archive->data[bolt->offset]);
+	}
+	else
+	{
+		archive_fit_offset16(points, numPoints, shift, &archive->data[bolt->offset]);
+	}
+	archive->dataSize += bytes;
+	return archive->numBolts++;
+}
+
+/**
+ * @brief unpacks a bolt's points one at a time, the reference for archive_decode
+ * @param archive [in]	the archive holding the bolt
+ * @param index			which bolt to unpack
+ * @param out [out]		filled with the bolt's points, needs room for the bolt's numPoints
+ * @return the number of points written
+ */
+int archive_decode_scalar(Archive *archive, int index, Vect2d *out)
+{
+	Uint32 i;
+	ArchiveBolt *bolt;
+	Uint8 *data;
+	float step;
+	Sint32 x = 0, y = 0;
+
+	if(!archive || index < 0 || index >= archive->numBolts)
+	{
+		return 0;
+	}
+	bolt = &archive->bolts[index];
+	data = &archive->data[bolt->offset];
+	step = archive_step(bolt->shift);
+
+	if(bolt->encoding == ARCHIVE_DELTA8)
+	{
+		out[0] = bolt->origin;
+		for(i = 1; i < bolt->numPoints; i++, data += 2)
+		{
+			x += (Sint8)data[0];
+			y += (Sint8)data[1];
+			out[i].x = bolt->origin.x + x * step;
+			out[i].y = bolt->origin.y + y * step;
+		}
+	}
+	else
+	{
+		for(i = 0; i < bolt->numPoints; i++, data += 4)
+		{
+			x = (Sint16)(data[0] | (data[1] << 8));
+			y = (Sint16)(data[2] | (data[3] << 8));
+			out[i].x = bolt->origin.x + x * step;
+			out[i].y = bolt->origin.y + y * step;
+		}
+	}
+	return bolt->numPoints;
+}
+
+/**
+ * @brief unpacks a bolt's points, using SSE2 to expand four points at a time when it is available
+ * @param archive [in]	the archive holding the bolt
+ * @param index			which bolt to unpack
+ * @param out [out]		filled with the bolt's points, needs room for the bolt's numPoints
+ * @return the number of points written
+ */
+int archive_decode(Archive *archive, int index, Vect2d *out)
+{
+#ifdef ARCHIVE_SSE2
+	Uint32 i, n;
+	ArchiveBolt *bolt;
+	Uint8 *data;
+	float step;
+	Sint32 x, y;
+	__m128 vstep, vorigin;
+	__m128i bytes, words, lo, hi, carry;
+
+	if(!archive || index < 0 || index >= archive->numBolts)
+	{
+		return 0;
+	}
+	bolt = &archive->bolts[index];
+	data = &archive->data[bolt->offset];
+	step = archive_step(bolt->shift);
+	vstep = _mm_set1_ps(step);
+	vorigin = _mm_setr_ps(bolt->origin.x, bolt->origin.y, bolt->origin.x, bolt->origin.y);
+
+	if(bolt->encoding == ARCHIVE_DELTA8)
+	{
+		out[0] = bolt->origin;
+		n = bolt->numPoints - 1;
+		carry = _mm_setzero_si128();
+		for(i = 0; i + 4 <= n; i += 4, data += 8)
+		{
+			/*sign extend 4 points of int8 x, y steps to int32, then a prefix sum gives each point's position on the grid*/
+			bytes = _mm_loadl_epi64((__m128i *)data);
+			words = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+			lo = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+			hi = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16);
+			lo = _mm_add_epi32(_mm_add_epi32(lo, _mm_slli_si128(lo, 8)), carry);
+			carry = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 2, 3, 2));
+			hi = _mm_add_epi32(_mm_add_epi32(hi, _mm_slli_si128(hi, 8)), carry);
+			carry = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 2, 3, 2));
+			_mm_storeu_ps(&out[i + 1].x, _mm_add_ps(vorigin, _mm_mul_ps(_mm_cvtepi32_ps(lo), vstep)));
+			_mm_storeu_ps(&out[i + 3].x, _mm_add_ps(vorigin, _mm_mul_ps(_mm_cvtepi32_ps(hi), vstep)));
+		}
+		x = _mm_cvtsi128_si32(carry);
+		y = _mm_cvtsi128_si32(_mm_shuffle_epi32(carry, _MM_SHUFFLE(1, 1, 1, 1)));
+		for(; i < n; i++, data += 2)
+		{
+			x += (Sint8)data[0];
+			y += (Sint8)data[1];
+			out[i + 1].x = bolt->origin.x + x * step;
+			out[i + 1].y = bolt->origin.y + y * step;
+		}
+	}
+	else
+	{
+		n = bolt->numPoints;
+		for(i = 0; i + 4 <= n; i += 4, data += 16)
+		{
+			words = _mm_loadu_si128((__m128i *)data);
+			lo = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+			hi = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16);
+			_mm_storeu_ps(&out[i].x, _mm_add_ps(vorigin, _mm_mul_ps(_mm_cvtepi32_ps(lo), vstep)));
+			_mm_storeu_ps(&out[i + 2].x, _mm_add_ps(vorigin, _mm_mul_ps(_mm_cvtepi32_ps(hi), vstep)));
+		}
+		for(; i < n; i++, data += 4)
+		{
+			x = (Sint16)(data[0] | (data[1] << 8));
+			y = (Sint16)(data[2] | (data[3] << 8));
+			out[i].x = bolt->origin.x + x * step;
+			out[i].y = bolt->origin.y + y * step;
+		}
+	}
+	return bolt->numPoints;
+#else
+	return archive_decode_scalar(archive, index, out);
+#endif
+}
+
+/**
+ * @brief unpacks a range of bolts straight into new bolts in a lightning system's boltList
+ * @param system [in,out]	the lightning system to create the bolts in
+ * @param archive [in]	the archive holding the bolts
+ * @param first			the first bolt to unpack
+ * @param count			how many bolts to unpack
+ * @return the number of bolts created
+ */
+int archive_load_bolts(LightningSystem *system, Archive *archive, int first, int count)
+{
+	int i;
+	Bolt *bolt;
+
+	if(!archive)
+	{
+		return 0;
+	}
+	for(i = first; i < first + count && i < archive->numBolts; i++)
+	{
+		bolt = lightning_bolt_alloc(system, archive->bolts[i].numPoints, archive_half_to_float(archive->bolts[i].thickness));
+		if(!bolt)
+		{
+			break;
+		}
+		archive_decode(archive, i, bolt->points);
+	}
+	return i - first;
+}
+
+/**
+ * @brief writes a 32 bit value little endian
+ * @param [out] out	where to write the 4 bytes
+ * @param value		the value to write
+ */
+static void archive_put32(Uint8 *out, Uint32 value)
+{
+	out[0] = (Uint8)value;
+	out[1] = (Uint8)(value >> 8);
+	out[2] = (Uint8)(value >> 16);
+	out[3] = (Uint8)(value >> 24);
+}
+
+/**
+ * @brief reads a little endian 32 bit value
+ * @param [in] in	the 4 bytes to read
+ * @return the value
+ */
+static Uint32 archive_get32(Uint8 *in)
+{
+	return in[0] | (in[1] << 8) | (in[2] << 16) | ((Uint32)in[3] << 24);
+}
+
+/**
+ * @brief writes the archive to a file
+ * @param archive [in]	the archive to save
+ * @param [in] path		the file to write
+ * @return 1 if the archive was written, 0 otherwise
+ */
+int archive_save(Archive *archive, char *path)
+{
+	int i;
+	FILE *file;
+	Uint8 header[ARCHIVE_HEADER_SIZE] = {0};
+	Uint8 record[ARCHIVE_RECORD_SIZE];
+	union { float f; Uint32 u; } bits;
+	ArchiveBolt *bolt;
+
+	if(!archive)
+	{
+		return 0;
+	}
+	file = fopen(path, "wb");
+	if(!file)
+	{
+		slog("unable to open archive %s", path);
+		return 0;
+	}
+	memcpy(header, ARCHIVE_MAGIC, 4);
+	header[4] = ARCHIVE_VERSION;
+	archive_put32(&header[8], archive->numBolts);
+	archive_put32(&header[12], archive->dataSize);
+	fwrite(header, 1, ARCHIVE_HEADER_SIZE, file);
+
+	for(i = 0; i < archive->numBolts; i++)
+	{
+		bolt = &archive->bolts[i];
+		bits.f = bolt->origin.x;
+		archive_put32(&record[0], bits.u);
+		bits.f = bolt->origin.y;
+		archive_put32(&record[4], bits.u);
+		record[8] = (Uint8)bolt->thickness;
+		record[9] = (Uint8)(bolt->thickness >> 8);
+		record[10] = bolt->encoding;
+		record[11] = bolt->shift;
+		archive_put32(&record[12], bolt->numPoints);
+		archive_put32(&record[16], bolt->offset);
+		fwrite(record, 1, ARCHIVE_RECORD_SIZE, file);
+	}
+	fwrite(archive->data, 1, archive->dataSize, file);
+	if(ferror(file))
+	{
+		slog("failed writing archive %s", path);
+		fclose(file);
+		return 0;
+	}
+	fclose(file);
+	return 1;
+}
+
+/**
+ * @brief reads an archive written by archive_save, turning away any whose bolt records can't be decoded within its data
+ * @param [in] path		the file to read
+ * @return the archive, NULL if it could not be read or a bolt record is broken
+ */
+Archive *archive_load(char *path)
+{
+	int i;
+	FILE *file;
+	Uint8 header[ARCHIVE_HEADER_SIZE];
+	Uint8 record[ARCHIVE_RECORD_SIZE];
+	union { float f; Uint32 u; } bits;
+	Uint32 numBolts, dataSize;
+	Uint64 size;
+	ArchiveBolt *bolt;
+	Archive *archive;
+
+	file = fopen(path, "rb");
+	if(!file)
+	{
+		slog("unable to open archive %s", path);
+		return NULL;
+	}
+	if(fread(header, 1, ARCHIVE_HEADER_SIZE, file) != ARCHIVE_HEADER_SIZE ||
+	   memcmp(header, ARCHIVE_MAGIC, 4) != 0 || header[4] != ARCHIVE_VERSION)
+	{
+		slog("%s is not a version %i bolt archive", path, ARCHIVE_VERSION);
+		fclose(file);
+		return NULL;
+	}
+	numBolts = archive_get32(&header[8]);
+	dataSize = archive_get32(&header[12]);
+	if(numBolts > INT_MAX)
+	{
+		slog("archive %s has too many bolts", path);
+		fclose(file);
+		return NULL;
+	}
+
+	archive = archive_new();
+	if(!archive)
+	{
+		fclose(file);
+		return NULL;
+	}
+	archive->bolts = (ArchiveBolt *)malloc(sizeof(ArchiveBolt) * MAX(numBolts, 1));
+	archive->data = (Uint8 *)malloc(MAX(dataSize, 1));
+	if(!archive->bolts || !archive->data)
+	{
+		slog("archive %s failed to allocate", path);
+		archive_free(&archive);
+		fclose(file);
+		return NULL;
+	}
+	archive->maxBolts = MAX(numBolts, 1);
+	archive->dataMax = MAX(dataSize, 1);
+
+	for(i = 0; i < (int)numBolts; i++)
+	{
+		if(fread(record, 1, ARCHIVE_RECORD_SIZE, file) != ARCHIVE_RECORD_SIZE)
+		{
+			slog("archive %s is cut short", path);
+			archive_free(&archive);
+			fclose(file);
+			return NULL;
+		}
+		bolt = &archive->bolts[i];
+		bits.u = archive_get32(&record[0]);
+		bolt->origin.x = bits.f;
+		bits.u = archive_get32(&record[4]);
+		bolt->origin.y = bits.f;
+		bolt->thickness = record[8] | (record[9] << 8);
+		bolt->encoding = record[10];
+		bolt->shift = record[11];
+		bolt->numPoints = archive_get32(&record[12]);
+		bolt->offset = archive_get32(&record[16]);
+		if(bolt->numPoints == 0 || bolt->numPoints > INT_MAX || bolt->shift > ARCHIVE_MAX_SHIFT ||
+		   (bolt->encoding != ARCHIVE_OFFSET16 && bolt->encoding != ARCHIVE_DELTA8))
+		{
+			slog("archive %s has a bolt that can't be decoded", path);
+			archive_free(&archive);
+			fclose(file);
+			return NULL;
+		}
+		/*in 64 bits, so a huge count of points can't wrap round to something that fits*/
+		size = bolt->encoding == ARCHIVE_DELTA8 ? ((Uint64)bolt->numPoints - 1) * 2 : (Uint64)bolt->numPoints * 4;
+		if(bolt->offset > dataSize || size > dataSize - bolt->offset)
+		{
+			slog("archive %s has a bolt outside of its data", path);
+			archive_free(&archive);
+			fclose(file);
+			return NULL;
+		}
+	}
+	archive->numBolts = numBolts;
+	if(fread(archive->data, 1, dataSize, file) != dataSize)
+	{
+		slog("archive %s is cut short", path);
+		archive_free(&archive);
+		fclose(file);
+		return NULL;
+	}
+	archive->dataSize = dataSize;
+	fclose(file);
+	return archive;
+}
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "archive.h"
+
+#define ARCHIVE_TEST_BOLTS		32			/**< how many bolts the round trip packs, saves, loads and unpacks */
+
+#define ARCHIVE_TEST_DATA		8			/**< data bytes in each hand made archive */
+
+/**
+ * @struct a hand made archive of one bolt that archive_load must turn away, or load if it is the valid one
+ */
+typedef struct ArchiveTestRecord_t
+{
+	char *name;								/**< what is wrong with it */
+	Uint32 numBolts;						/**< the header's number of bolts */
+	Uint8 encoding;							/**< the bolt's encoding */
+	Uint8 shift;							/**< the bolt's grid shift */
+	Uint32 numPoints;						/**< the bolt's number of points */
+	Uint32 offset;							/**< where the bolt's points start in the data */
+	int valid;								/**< if set the archive is fine and has to load */
+}ArchiveTestRecord;
+
+static ArchiveTestRecord archiveTestRecords[] =
+{
+	{"valid", 1, ARCHIVE_OFFSET16, 0, 2, 0, 1},
+	{"offset16 count that wraps to 4 bytes", 1, ARCHIVE_OFFSET16, 0, 0xC0000001, 0, 0},
+	{"delta8 count that wraps to 0 bytes", 1, ARCHIVE_DELTA8, 0, 0x80000001, 0, 0},
+	{"count past INT_MAX", 1, ARCHIVE_DELTA8, 0, 0x80000000, 0, 0},
+	{"no points", 1, ARCHIVE_OFFSET16, 0, 0, 0, 0},
+	{"shift past ARCHIVE_MAX_SHIFT", 1, ARCHIVE_DELTA8, 200, 2, 0, 0},
+	{"unknown encoding", 1, 7, 0, 2, 0, 0},
+	{"points past the data", 1, ARCHIVE_OFFSET16, 0, 3, 0, 0},
+	{"offset past the data", 1, ARCHIVE_DELTA8, 0, 1, ARCHIVE_TEST_DATA + 1, 0},
+	{"bolt count past INT_MAX", 0x80000000, ARCHIVE_OFFSET16, 0, 2, 0, 0}
+};
+
+#define ARCHIVE_TEST_RECORDS	(sizeof(archiveTestRecords) / sizeof(ArchiveTestRecord))
+
+/**
+ * @brief writes a 32 bit value little endian
+ * @param [out] out	where to write the 4 bytes
+ * @param value		the value to write
+ */
+static void archive_test_put32(Uint8 *out, Uint32 value)
+{
+	out[0] = (Uint8)value;
+	out[1] = (Uint8)(value >> 8);
+	out[2] = (Uint8)(value >> 16);
+	out[3] = (Uint8)(value >> 24);
+}
+
+/**
+ * @brief writes a hand made archive of one bolt at the origin and ARCHIVE_TEST_DATA bytes of zeroes
+ * @param [in] path		the file to write
+ * @param record [in]	the header and bolt record to write
+ * @return 1 if it was written, 0 otherwise
+ */
+static int archive_test_write(char *path, ArchiveTestRecord *record)
+{
+	FILE *file;
+	Uint8 bytes[16 + 20 + ARCHIVE_TEST_DATA];
+
+	memset(bytes, 0, sizeof(bytes));
+	memcpy(bytes, ARCHIVE_MAGIC, 4);
+	bytes[4] = ARCHIVE_VERSION;
+	archive_test_put32(&bytes[8], record->numBolts);
+	archive_test_put32(&bytes[12], ARCHIVE_TEST_DATA);
+	bytes[16 + 8] = (Uint8)archive_float_to_half(1);
+	bytes[16 + 9] = (Uint8)(archive_float_to_half(1) >> 8);
+	bytes[16 + 10] = record->encoding;
+	bytes[16 + 11] = record->shift;
+	archive_test_put32(&bytes[16 + 12], record->numPoints);
+	archive_test_put32(&bytes[16 + 16], record->offset);
+
+	file = fopen(path, "wb");
+	if(!file)
+	{
+		slog("archive test could not write %s", path);
+		return 0;
+	}
+	fwrite(bytes, 1, sizeof(bytes), file);
+	return fclose(file) == 0;
+}
+
+/**
+ * @brief checks that archive_load loads the valid hand made archive and turns away every broken one
+ * @param [in] path		the scratch file to write them to
+ * @return the number of archives it got wrong
+ */
+static int archive_test_records(char *path)
+{
+	int i, failed = 0;
+	Archive *archive;
+
+	for(i = 0; i < ARCHIVE_TEST_RECORDS; i++)
+	{
+		if(!archive_test_write(path, &archiveTestRecords[i]))
+		{
+			failed++;
+			continue;
+		}
+		archive = archive_load(path);
+		if((archive != NULL) != archiveTestRecords[i].valid)
+		{
+			slog("archive test: %s was %s", archiveTestRecords[i].name, archive ? "loaded" : "turned away");
+			failed++;
+		}
+		archive_free(&archive);
+	}
+	return failed;
+}
+
+/**
+ * @brief packs bolts of every thickness at a coarse and a fine error so both encodings are used, saves and loads them, and checks
+ *			every point comes back within its error, that both decoders agree and that archive_load_bolts unpacks the same points
+ * @param [in] path		the scratch file to save to
+ * @return the number of bolts it got wrong
+ */
+static int archive_test_round_trip(char *path)
+{
+	int i, j, numPoints, failed = 0, used[2] = {0, 0};
+	float maxError;
+	Uint32 state;
+	Vect2d *points = NULL, *decoded = NULL, *reference = NULL;
+	int maxPoints = 0;
+	Archive *archive, *loaded = NULL;
+	LightningSystem *system = NULL;
+
+	archive = archive_new();
+	for(i = 0; archive && i < ARCHIVE_TEST_BOLTS; i++)
+	{
+		state = 0x9e3779b9 * (i + 1);
+		numPoints = lightning_generate(vect2d_new(100, 100 + i * 10), vect2d_new(WINDOW_WIDTH - 100, WINDOW_HEIGHT - 100), 1 + i % 3,
+			&state, &points, &maxPoints);
+		if(archive_add(archive, points, numPoints, 1 + i % 3, i % 2 ? 0.05f : 0.5f) != i)
+		{
+			slog("archive test: bolt %i could not be packed", i);
+			failed++;
+			break;
+		}
+	}
+	if(!failed && archive_save(archive, path))
+	{
+		loaded = archive_load(path);
+	}
+	decoded = (Vect2d *)malloc(sizeof(Vect2d) * MAX(maxPoints, 1));
+	reference = (Vect2d *)malloc(sizeof(Vect2d) * MAX(maxPoints, 1));
+	if(!loaded || !decoded || !reference || loaded->numBolts != ARCHIVE_TEST_BOLTS)
+	{
+		slog("archive test: the round trip archive could not be saved and loaded");
+		free(points);
+		free(decoded);
+		free(reference);
+		archive_free(&archive);
+		archive_free(&loaded);
+		return MAX(failed, 1);
+	}
+
+	for(i = 0; i < ARCHIVE_TEST_BOLTS; i++)
+	{
+		state = 0x9e3779b9 * (i + 1);
+		numPoints = lightning_generate(vect2d_new(100, 100 + i * 10), vect2d_new(WINDOW_WIDTH - 100, WINDOW_HEIGHT - 100), 1 + i % 3,
+			&state, &points, &maxPoints);
+		maxError = i % 2 ? 0.05f : 0.5f;
+		used[loaded->bolts[i].encoding == ARCHIVE_DELTA8] = 1;
+		if(archive_decode(loaded, i, decoded) != numPoints || archive_decode_scalar(loaded, i, reference) != numPoints ||
+			memcmp(decoded, reference, sizeof(Vect2d) * numPoints) != 0)
+		{
+			slog("archive test: the decoders disagree on bolt %i", i);
+			failed++;
+			continue;
+		}
+		for(j = 0; j < numPoints; j++)
+		{
+			/*a little over the error for the float rounding of the grid step*/
+			if(fabs(decoded[j].x - points[j].x) > maxError + 0.001f || fabs(decoded[j].y - points[j].y) > maxError + 0.001f)
+			{
+				slog("archive test: point %i of bolt %i came back %f, %f from where it was", j, i,
+					decoded[j].x - points[j].x, decoded[j].y - points[j].y);
+				failed++;
+				break;
+			}
+		}
+	}
+	if(!used[0] || !used[1])
+	{
+		slog("archive test: the round trip only used one encoding");
+		failed++;
+	}
+
+	system = lightning_system_new(NULL, 1, ARCHIVE_TEST_BOLTS);
+	if(!system || archive_load_bolts(system, loaded, 0, ARCHIVE_TEST_BOLTS) != ARCHIVE_TEST_BOLTS)
+	{
+		slog("archive test: archive_load_bolts did not unpack every bolt");
+		failed++;
+	}
+	else
+	{
+		for(i = 0; i < ARCHIVE_TEST_BOLTS; i++)
+		{
+			numPoints = archive_decode(loaded, i, decoded);
+			if(system->boltList[i].numPoints != numPoints || memcmp(system->boltList[i].points, decoded, sizeof(Vect2d) * numPoints) != 0)
+			{
+				slog("archive test: archive_load_bolts unpacked bolt %i differently", i);
+				failed++;
+			}
+		}
+	}
+
+	lightning_system_free(&system);
+	free(points);
+	free(decoded);
+	free(reference);
+	archive_free(&archive);
+	archive_free(&loaded);
+	return failed;
+}
+
+/**
+ * @brief checks that archive_add turns away bolts with a point too far out for either encoding or a point that is not a number
+ * @return the number of bolts it packed anyway
+ */
+static int archive_test_unfit()
+{
+	int i, failed = 0;
+	Vect2d points[3];
+	Archive *archive;
+	float bad[] = {1e30f, -1e30f, NAN};
+
+	archive = archive_new();
+	if(!archive)
+	{
+		return 1;
+	}
+	for(i = 0; i < 3; i++)
+	{
+		points[0] = vect2d_new(10, 10);
+		points[1] = vect2d_new(12, 11);
+		points[2] = vect2d_new(bad[i], 12);
+		if(archive_add(archive, points, 3, 1, 0.5f) != -1)
+		{
+			slog("archive test: a bolt with a point at %f was packed", bad[i]);
+			failed++;
+		}
+	}
+	archive_free(&archive);
+	return failed;
+}
+
+/**
+ * @brief checks that bolts survive a round trip through an archive file and that archive_load turns away archives whose records are
+ *			broken and archive_add turns away points no encoding can hold, logging every failure
+ * @param [in] path		a scratch file the archives are written to, removed afterwards
+ * @return 1 if every check passed, 0 otherwise
+ */
+int archive_test(char *path)
+{
+	int failed;
+
+	failed = archive_test_round_trip(path);
+	failed += archive_test_records(path);
+	failed += archive_test_unfit();
+	remove(path);
+	slog("archive test: %i failures", failed);
+	return failed == 0;
+}
\ No newline at end of file
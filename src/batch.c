@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "simple_logger.h"
+
+#include "jobs.h"
+#include "batch.h"
+
+#define BATCH_HEADER_SIZE		16			/**< bytes in the binary header */
+
+#define BATCH_CSV_LINE			256			/**< the longest a line of CSV can be, five floats printed with %.3f can each be 44 characters */
+
+/**
+ * @struct the scratch space of a job worker generating bolts
+ * @brief kept for the whole run so the points buffer only grows
+ */
+typedef struct BatchWorker_t
+{
+	Vect2d *points;							/**< points of the bolt being generated */
+	int maxPoints;							/**< how many points fit in points */
+	Uint64 segments;						/**< how many segments the worker has generated */
+}BatchWorker;
+
+/**
+ * @struct a chunk of encoded bolts waiting to be written
+ * @brief chunks are generated in any order by the job workers, then written in order by the thread that started the run
+ */
+typedef struct BatchChunk_t
+{
+	Uint8 *buffer;							/**< the encoded bolts of the chunk */
+	Uint32 size;							/**< how many bytes of buffer are used */
+	Uint32 max;								/**< how many bytes fit in buffer */
+}BatchChunk;
+
+/* the run in progress */
+static BatchOptions *batchOptions = NULL;
+static FILE *batchFile = NULL;
+static SDL_atomic_t batchFailed;
+static BatchWorker *batchWorkers = NULL;
+static BatchChunk *batchChunks = NULL;		/* two waves of chunks, one being generated while the other is written */
+static int batchWaveChunks = 0;
+
+/**
+ * @brief fills in the options a batch uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void batch_default_options(BatchOptions *options)
+{
+	memset(options, 0, sizeof(BatchOptions));
+	options->count = 1000;
+	options->start = vect2d_new(100, 300);
+	options->end = vect2d_new(WINDOW_WIDTH - 100, WINDOW_HEIGHT / 2);
+	options->spawnMin = vect2d_new(0, 0);
+	options->spawnMax = vect2d_new(WINDOW_WIDTH, WINDOW_HEIGHT);
+	options->thickness = 3;
+	options->seed = 1;
+	options->path = "bolts.bin";
+	options->format = BATCH_BINARY;
+}
+
+/**
+ * @brief mixes a seed and an index into a well spread 32 bit value, so neighboring bolts get unrelated random states
+ * @param seed		the batch's seed
+ * @param index		what to mix in
+ * @return the mixed value
+ */
+static Uint32 batch_hash(Uint32 seed, Uint32 index)
+{
+	Uint32 h = seed ^ (index * 0x9e3779b9);
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+/**
+ * @brief writes a 32 bit value little endian
+ * @param [out] out	where to write the 4 bytes
+ * @param value		the value to write
+ */
+static void batch_put32(Uint8 *out, Uint32 value)
+{
+	out[0] = (Uint8)value;
+	out[1] = (Uint8)(value >> 8);
+	out[2] = (Uint8)(value >> 16);
+	out[3] = (Uint8)(value >> 24);
+}
+
+/**
+ * @brief generates one bolt of a batch, the same bolt whichever worker or run makes it
+ * @param options [in]		what the batch generates
+ * @param index				which bolt of the batch to generate
+ * @param points [in,out]	the points are written here, grown as needed
+ * @param maxPoints [in,out]	how many points fit in points
+ * @return how many points the bolt has, 0 if points could not grow
+ */
+int batch_generate(BatchOptions *options, int index, Vect2d **points, int *maxPoints)
+{
+	Uint32 state;
+	Vect2d start, end;
+
+	start = options->start;
+	end = options->end;
+	if(options->randomSpawn)
+	{
+		start.x = options->spawnMin.x + (options->spawnMax.x - options->spawnMin.x) * (batch_hash(options->seed, (Uint32)index * 5 + 1) / 4294967295.0f);
+		start.y = options->spawnMin.y + (options->spawnMax.y - options->spawnMin.y) * (batch_hash(options->seed, (Uint32)index * 5 + 2) / 4294967295.0f);
+		end.x = options->spawnMin.x + (options->spawnMax.x - options->spawnMin.x) * (batch_hash(options->seed, (Uint32)index * 5 + 3) / 4294967295.0f);
+		end.y = options->spawnMin.y + (options->spawnMax.y - options->spawnMin.y) * (batch_hash(options->seed, (Uint32)index * 5 + 4) / 4294967295.0f);
+	}
+	state = batch_hash(options->seed, (Uint32)index * 5);
+	return lightning_generate(start, end, options->thickness, &state, points, maxPoints);
+}
+
+/**
+ * @brief generates one bolt of the batch and encodes it onto the end of a chunk
+ * @param worker [in,out]	the scratch space of the worker generating the bolt
+ * @param chunk [in,out]	the chunk the bolt is encoded onto
+ * @param index				which bolt of the batch to generate
+ * @return 1 if the bolt was generated, 0 if a buffer could not grow
+ */
+static int batch_generate_bolt(BatchWorker *worker, BatchChunk *chunk, int index)
+{
+	int i, numPoints;
+	Uint32 needed;
+	Uint8 *grown, *out;
+	union { float f; Uint32 u; } bits;
+
+	numPoints = batch_generate(batchOptions, index, &worker->points, &worker->maxPoints);
+	if(numPoints == 0)
+	{
+		return 0;
+	}
+
+	needed = (batchOptions->format == BATCH_CSV) ? (numPoints - 1) * BATCH_CSV_LINE : 8 + numPoints * 8;
+	if(chunk->size + needed > chunk->max)
+	{
+		grown = (Uint8 *)realloc(chunk->buffer, (chunk->size + needed) * 2);
+		if(!grown)
+		{
+			slog("batch buffer failed to grow to %u bytes", (chunk->size + needed) * 2);
+			return 0;
+		}
+		chunk->buffer = grown;
+		chunk->max = (chunk->size + needed) * 2;
+	}
+
+	out = &chunk->buffer[chunk->size];
+	if(batchOptions->format == BATCH_CSV)
+	{
+		for(i = 0; i + 1 < numPoints; i++)
+		{
+			out += sprintf((char *)out, "%i,%i,%.3f,%.3f,%.3f,%.3f,%.3f\n", index, i,
+						   worker->points[i].x, worker->points[i].y, worker->points[i + 1].x, worker->points[i + 1].y, batchOptions->thickness);
+		}
+	}
+	else
+	{
+		batch_put32(out, numPoints);
+		bits.f = batchOptions->thickness;
+		batch_put32(&out[4], bits.u);
+		out += 8;
+		for(i = 0; i < numPoints; i++)
+		{
+			bits.f = worker->points[i].x;
+			batch_put32(out, bits.u);
+			bits.f = worker->points[i].y;
+			batch_put32(&out[4], bits.u);
+			out += 8;
+		}
+	}
+	chunk->size = (Uint32)(out - chunk->buffer);
+	worker->segments += numPoints - 1;
+	return 1;
+}
+
+/**
+ * @brief job that generates a range of chunks into their buffers
+ * @param data		unused
+ * @param start		first chunk of the batch
+ * @param end		one past the last chunk
+ * @param worker	index of the job worker running it
+ */
+static void batch_chunk_job(void *data, int start, int end, int worker)
+{
+	int i, c, last;
+	BatchChunk *chunk;
+
+	for(c = start; c < end && !SDL_AtomicGet(&batchFailed); c++)
+	{
+		/*waves alternate between the two halves of batchChunks*/
+		chunk = &batchChunks[c % (batchWaveChunks * 2)];
+		chunk->size = 0;
+		last = MIN((c + 1) * BATCH_CHUNK, batchOptions->count);
+		for(i = c * BATCH_CHUNK; i < last; i++)
+		{
+			if(!batch_generate_bolt(&batchWorkers[worker], chunk, i))
+			{
+				SDL_AtomicSet(&batchFailed, 1);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief starts generating a wave of chunks on the job system
+ * @param wave				which wave of the batch
+ * @param chunkNum			how many chunks the batch has
+ * @param counter [in,out]	counts the wave's jobs until they are done
+ */
+static void batch_submit_wave(int wave, int chunkNum, JobCounter *counter)
+{
+	int first = wave * batchWaveChunks;
+	if(first < chunkNum)
+	{
+		jobs_submit_range(batch_chunk_job, NULL, first, MIN(first + batchWaveChunks, chunkNum), 1, counter);
+	}
+}
+
+/**
+ * @brief generates every bolt of a batch on the job system's workers and writes them to the output in order, then logs how many
+ *			bolts a second were made
+ * @param options [in]	what to generate and where to write it
+ * @return 1 if every bolt was written, 0 otherwise
+ */
+int batch_run(BatchOptions *options)
+{
+	int i, c, wave, workers, chunkNum;
+	Uint8 header[BATCH_HEADER_SIZE] = {0};
+	Uint64 counter, segments = 0;
+	double seconds;
+	BatchChunk *chunk;
+	JobCounter waveDone[2];
+
+	if(options->count <= 0 || options->thickness <= 0)
+	{
+		slog("batch needs a positive count and thickness");
+		return 0;
+	}
+	workers = jobs_get_worker_count();
+	chunkNum = (options->count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+
+	if(strcmp(options->path, "-") == 0)
+	{
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		batchFile = stdout;
+	}
+	else
+	{
+		batchFile = fopen(options->path, "wb");
+	}
+	if(!batchFile)
+	{
+		slog("unable to open batch output %s", options->path);
+		return 0;
+	}
+	if(options->format == BATCH_CSV)
+	{
+		fprintf(batchFile, "bolt,segment,x0,y0,x1,y1,thickness\n");
+	}
+	else
+	{
+		memcpy(header, BATCH_MAGIC, 4);
+		header[4] = BATCH_VERSION;
+		batch_put32(&header[8], options->count);
+		fwrite(header, 1, BATCH_HEADER_SIZE, batchFile);
+	}
+
+	batchWaveChunks = workers * BATCH_WAVE;
+	batchWorkers = (BatchWorker *)malloc(sizeof(BatchWorker) * workers);
+	batchChunks = (BatchChunk *)malloc(sizeof(BatchChunk) * batchWaveChunks * 2);
+	if(!batchWorkers || !batchChunks)
+	{
+		slog("batch failed to initialize");
+		SDL_AtomicSet(&batchFailed, 1);
+	}
+	else
+	{
+		memset(batchWorkers, 0, sizeof(BatchWorker) * workers);
+		memset(batchChunks, 0, sizeof(BatchChunk) * batchWaveChunks * 2);
+		batchOptions = options;
+		SDL_AtomicSet(&batchFailed, 0);
+		jobs_counter_init(&waveDone[0]);
+		jobs_counter_init(&waveDone[1]);
+
+		/*the next wave is generated while this thread writes the last one out in order*/
+		counter = SDL_GetPerformanceCounter();
+		batch_submit_wave(0, chunkNum, &waveDone[0]);
+		for(wave = 0; wave * batchWaveChunks < chunkNum && !SDL_AtomicGet(&batchFailed); wave++)
+		{
+			jobs_wait(&waveDone[wave & 1]);
+			batch_submit_wave(wave + 1, chunkNum, &waveDone[(wave + 1) & 1]);
+			for(c = wave * batchWaveChunks; c < MIN((wave + 1) * batchWaveChunks, chunkNum) && !SDL_AtomicGet(&batchFailed); c++)
+			{
+				chunk = &batchChunks[c % (batchWaveChunks * 2)];
+				if(fwrite(chunk->buffer, 1, chunk->size, batchFile) != chunk->size)
+				{
+					slog("failed writing batch to %s", options->path);
+					SDL_AtomicSet(&batchFailed, 1);
+				}
+			}
+		}
+		jobs_wait(&waveDone[0]);
+		jobs_wait(&waveDone[1]);
+		seconds = (double)(SDL_GetPerformanceCounter() - counter) / SDL_GetPerformanceFrequency();
+
+		for(i = 0; i < workers; i++)
+		{
+			segments += batchWorkers[i].segments;
+		}
+		if(!SDL_AtomicGet(&batchFailed))
+		{
+			slog("generated %i bolts, %.0f segments on %i workers in %f seconds (%f bolts/sec)",
+				options->count, (double)segments, workers, seconds, options->count / seconds);
+		}
+		for(i = 0; i < workers; i++)
+		{
+			free(batchWorkers[i].points);
+		}
+		for(i = 0; i < batchWaveChunks * 2; i++)
+		{
+			free(batchChunks[i].buffer);
+		}
+	}
+	free(batchWorkers);
+	free(batchChunks);
+	batchWorkers = NULL;
+	batchChunks = NULL;
+
+	if(fflush(batchFile) != 0)
+	{
+		slog("failed writing batch to %s", options->path);
+		SDL_AtomicSet(&batchFailed, 1);
+	}
+	if(batchFile != stdout)
+	{
+		fclose(batchFile);
+	}
+	batchFile = NULL;
+	batchOptions = NULL;
+	return !SDL_AtomicGet(&batchFailed);
+}
\ No newline at end of file
@@ -0,0 +1,631 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "simple_logger.h"
+
+#include "bench.h"
+#include "lightning.h"
+#include "vector_batch.h"
+
+/**
+ * @brief what every benchmark case looks like, it sets up whatever run needs, times only the operations being measured and cleans up
+ * @param data		the case's own state
+ * @param run		which run this is, counting the warmup, so each run can get its own random inputs
+ * @return the seconds spent in the operations being measured
+ */
+typedef double (*BenchFunc)(void *data, int run);
+
+/**
+ * @struct state of the sort_positions case
+ */
+typedef struct BenchSort_t
+{
+	Position *positions;					/**< the list nodes, relinked in their original order before every run */
+	int size;								/**< how many nodes are in the list */
+	Uint32 state;							/**< random state the positions are picked with */
+}BenchSort;
+
+/**
+ * @struct state of the lightning_create_bolt case
+ */
+typedef struct BenchBolt_t
+{
+	LightningSystem *system;				/**< the system the segments are created in */
+	Lightning main;							/**< the line the bolt is made along */
+	float thickness;						/**< thickness of the bolt */
+	int segments;							/**< how many segments the last run created */
+}BenchBolt;
+
+/**
+ * @struct state of the lightning_new and lightning_purge_system churn case
+ */
+typedef struct BenchChurn_t
+{
+	LightningSystem *system;				/**< the system the segments are churned through */
+	int occupied;							/**< how many slots at the front of the pool are taken for the whole case */
+}BenchChurn;
+
+/**
+ * @struct state of the vect2d cases
+ */
+typedef struct BenchVect_t
+{
+	Vect2d *vects;							/**< the vectors every run goes through */
+	Vect2d *results;						/**< where the runs that make vectors write them */
+	float *lengths;							/**< where the runs that measure vectors write their lengths */
+}BenchVect;
+
+/**
+ * @struct state of the segment measuring cases
+ */
+typedef struct BenchSegments_t
+{
+	Vect2d *points;							/**< the line the segments run along, one more point than there are segments */
+	float *lengths;							/**< the length of every segment */
+	float *angles;							/**< the angle of every segment */
+	Vect2d *directions;						/**< the direction of every segment */
+}BenchSegments;
+
+static FILE *benchOut = NULL;
+static int benchCases = 0;
+static BenchOptions *benchOptions = NULL;
+static volatile float benchSink = 0;		/**< results are summed in here so the compiler can't drop the work */
+
+/**
+ * @brief fills in the options a benchmark run uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void bench_default_options(BenchOptions *options)
+{
+	memset(options, 0, sizeof(BenchOptions));
+	options->warmup = BENCH_WARMUP;
+	options->repetitions = BENCH_REPETITIONS;
+	options->path = "bench.json";
+}
+
+/**
+ * @brief a small xorshift so the inputs are the same on every run and every platform
+ * @param state [in,out]	the random state
+ * @return a random float from 0 to 1
+ */
+static float bench_random(Uint32 *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return (float)(*state >> 8) / (float)(1 << 24);
+}
+
+/**
+ * @brief seconds since a performance counter reading
+ * @param counter	the earlier reading
+ * @return the seconds that have passed
+ */
+static double bench_seconds(Uint64 counter)
+{
+	return (double)(SDL_GetPerformanceCounter() - counter) / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief orders doubles smallest to largest for qsort
+ */
+static int bench_compare(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief the median of some values, sorting them in place
+ * @param values [in,out]	the values
+ * @param count		how many there are
+ * @return the median
+ */
+static double bench_median(double *values, int count)
+{
+	qsort(values, count, sizeof(double), bench_compare);
+	if(count % 2)
+	{
+		return values[count / 2];
+	}
+	return (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+/**
+ * @brief runs a case through the warmup and the timed runs and writes its median, median absolute deviation, fastest and slowest
+ *			time per operation as one JSON object
+ * @param name		what the case measures
+ * @param params	the case's parameters as the members of a JSON object, without the braces
+ * @param func		the case
+ * @param data		the case's state
+ * @param ops		how many operations one run of the case times
+ * @return 1 if the case ran, 0 if its times could not be allocated
+ */
+static int bench_measure(char *name, char *params, BenchFunc func, void *data, int ops)
+{
+	int i, runs;
+	double *times, median, mad, fastest, slowest;
+
+	runs = benchOptions->repetitions;
+	times = (double *)malloc(sizeof(double) * runs);
+	if(!times)
+	{
+		slog("benchmark failed to allocate times for %s", name);
+		return 0;
+	}
+	for(i = 0; i < benchOptions->warmup; i++)
+	{
+		func(data, i);
+	}
+	for(i = 0; i < runs; i++)
+	{
+		times[i] = func(data, benchOptions->warmup + i) * 1e9 / ops;
+	}
+
+	median = bench_median(times, runs);
+	fastest = times[0];
+	slowest = times[runs - 1];
+	for(i = 0; i < runs; i++)
+	{
+		times[i] = times[i] > median ? times[i] - median : median - times[i];
+	}
+	mad = bench_median(times, runs);
+	free(times);
+
+	fprintf(benchOut, "%s\n\t\t{\"name\": \"%s\", \"params\": {%s}, \"ops\": %i, \"median_ns\": %.3f, \"mad_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f}",
+		benchCases ? "," : "", name, params, ops, median, mad, fastest, slowest);
+	benchCases++;
+	return 1;
+}
+
+/**
+ * @brief links the nodes into a list of random positions in the order they sit in memory and sorts it
+ * @param data		the BenchSort
+ * @param run		unused
+ * @return the seconds sort_positions took
+ */
+static double bench_sort(void *data, int run)
+{
+	int i;
+	Uint64 counter;
+	BenchSort *sort = (BenchSort *)data;
+
+	for(i = 0; i < sort->size; i++)
+	{
+		sort->positions[i].pos = bench_random(&sort->state);
+		sort->positions[i].next = i + 1 < sort->size ? &sort->positions[i + 1] : NULL;
+	}
+	counter = SDL_GetPerformanceCounter();
+	sort_positions(sort->positions);
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief creates one bolt's segments from the same seed every run, then purges them untimed
+ * @param data		the BenchBolt
+ * @param run		unused, the seed is fixed so every run makes the same bolt
+ * @return the seconds lightning_create_bolt took
+ */
+static double bench_bolt(void *data, int run)
+{
+	Uint64 counter;
+	double seconds;
+	BenchBolt *bolt = (BenchBolt *)data;
+
+	lightning_system_seed(bolt->system, 1);
+	counter = SDL_GetPerformanceCounter();
+	lightning_create_bolt(bolt->system, &bolt->main, bolt->thickness);
+	seconds = bench_seconds(counter);
+	bolt->segments = bolt->system->lightningNum;
+	lightning_purge_system(bolt->system);
+	return seconds;
+}
+
+/**
+ * @brief creates BENCH_CHURN_COUNT segments in the free slots of the pool and purges them, the purge walks the whole pool
+ * @param data		the BenchChurn
+ * @param run		unused
+ * @return the seconds the creating and purging took
+ */
+static double bench_churn(void *data, int run)
+{
+	int i;
+	Uint64 counter;
+	BenchChurn *churn = (BenchChurn *)data;
+
+	counter = SDL_GetPerformanceCounter();
+	for(i = 0; i < BENCH_CHURN_COUNT; i++)
+	{
+		lightning_new(churn->system, vect2d_new(i, 0), vect2d_new(i + 1, 1), 1);
+	}
+	lightning_purge_system(churn->system);
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief builds a vector from every pair of components
+ */
+static double bench_vect2d_new(void *data, int run)
+{
+	int i;
+	Uint64 counter;
+	BenchVect *vect = (BenchVect *)data;
+
+	counter = SDL_GetPerformanceCounter();
+	for(i = 0; i < BENCH_VECTORS; i++)
+	{
+		vect->results[i] = vect2d_new(vect->vects[i].x, vect->vects[i].y);
+	}
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief measures the length of every vector
+ */
+static double bench_vect2d_get_length(void *data, int run)
+{
+	int i;
+	float sum = 0;
+	Uint64 counter;
+	BenchVect *vect = (BenchVect *)data;
+
+	counter = SDL_GetPerformanceCounter();
+	for(i = 0; i < BENCH_VECTORS; i++)
+	{
+		sum += vect2d_get_length(vect->vects[i]);
+	}
+	benchSink += sum;
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief normalizes a copy of every vector
+ */
+static double bench_vect2d_normalize(void *data, int run)
+{
+	int i;
+	Uint64 counter;
+	BenchVect *vect = (BenchVect *)data;
+
+	memcpy(vect->results, vect->vects, sizeof(Vect2d) * BENCH_VECTORS);
+	counter = SDL_GetPerformanceCounter();
+	for(i = 0; i < BENCH_VECTORS; i++)
+	{
+		vect2d_normalize(&vect->results[i]);
+	}
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief runs every vector through the subtract, scale and add macros the way the generators step along a bolt
+ */
+static double bench_vect2d_macros(void *data, int run)
+{
+	int i;
+	Uint64 counter;
+	Vect2d diff, step;
+	BenchVect *vect = (BenchVect *)data;
+
+	counter = SDL_GetPerformanceCounter();
+	for(i = 0; i < BENCH_VECTORS; i++)
+	{
+		vect2d_subtract(vect->vects[i], vect->vects[(i + 1) % BENCH_VECTORS], diff);
+		vect2d_scale(step, diff, 0.5f);
+		vect2d_add(vect->vects[i], step, vect->results[i]);
+	}
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief measures the length of every vector with one batch call
+ */
+static double bench_vect2d_batch_length(void *data, int run)
+{
+	Uint64 counter;
+	BenchVect *vect = (BenchVect *)data;
+
+	counter = SDL_GetPerformanceCounter();
+	vect2d_batch_length(vect->vects, vect->lengths, BENCH_VECTORS);
+	benchSink += vect->lengths[run % BENCH_VECTORS];
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief normalizes a copy of every vector with one batch call
+ */
+static double bench_vect2d_batch_normalize(void *data, int run)
+{
+	Uint64 counter;
+	BenchVect *vect = (BenchVect *)data;
+
+	memcpy(vect->results, vect->vects, sizeof(Vect2d) * BENCH_VECTORS);
+	counter = SDL_GetPerformanceCounter();
+	vect2d_batch_normalize(vect->results, BENCH_VECTORS);
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief measures the length, angle and direction of every segment one at a time, with atan2 and a divide by the length
+ */
+static double bench_segments(void *data, int run)
+{
+	int i;
+	Uint64 counter;
+	Vect2d tangent;
+	BenchSegments *segments = (BenchSegments *)data;
+
+	counter = SDL_GetPerformanceCounter();
+	for(i = 0; i < BENCH_STORM_SEGMENTS; i++)
+	{
+		vect2d_subtract(segments->points[i + 1], segments->points[i], tangent);
+		segments->lengths[i] = vect2d_get_length(tangent);
+		segments->angles[i] = atan2(tangent.y, tangent.x);
+		segments->directions[i] = segments->lengths[i] > 0 ?
+			vect2d_new(tangent.x / segments->lengths[i], tangent.y / segments->lengths[i]) : vect2d_new(1, 0);
+	}
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief measures the length, angle and direction of every segment with one batch call
+ */
+static double bench_batch_segments(void *data, int run)
+{
+	Uint64 counter;
+	BenchSegments *segments = (BenchSegments *)data;
+
+	counter = SDL_GetPerformanceCounter();
+	vect2d_batch_segments(segments->points, BENCH_STORM_SEGMENTS + 1, segments->lengths, segments->angles, segments->directions);
+	return bench_seconds(counter);
+}
+
+/**
+ * @brief sorts lists of more and more positions
+ * @return 1 if every size ran, 0 otherwise
+ */
+static int bench_sort_cases()
+{
+	static int sizes[] = {16, 64, 256, 1024, 4096};
+	int i;
+	char params[128];
+	BenchSort sort;
+
+	for(i = 0; i < sizeof(sizes) / sizeof(int); i++)
+	{
+		memset(&sort, 0, sizeof(BenchSort));
+		sort.size = sizes[i];
+		sort.state = 0x9e3779b9;
+		sort.positions = (Position *)malloc(sizeof(Position) * sort.size);
+		if(!sort.positions)
+		{
+			slog("benchmark failed to allocate %i positions", sort.size);
+			return 0;
+		}
+		sprintf(params, "\"size\": %i", sort.size);
+		if(!bench_measure("sort_positions", params, bench_sort, &sort, sort.size))
+		{
+			free(sort.positions);
+			return 0;
+		}
+		free(sort.positions);
+	}
+	return 1;
+}
+
+/**
+ * @brief creates bolts of every length at every thickness, timed per segment created
+ * @return 1 if every bolt ran, 0 otherwise
+ */
+static int bench_bolt_cases()
+{
+	static float lengths[] = {100, 400, 1000};
+	static float thicknesses[] = {1, 3, 6};
+	int i, j;
+	char params[128];
+	BenchBolt bolt;
+
+	memset(&bolt, 0, sizeof(BenchBolt));
+	bolt.system = lightning_system_new(NULL, 100000, 1);
+	if(!bolt.system)
+	{
+		return 0;
+	}
+	for(i = 0; i < sizeof(lengths) / sizeof(float); i++)
+	{
+		for(j = 0; j < sizeof(thicknesses) / sizeof(float); j++)
+		{
+			bolt.main.start = vect2d_new(100, 300);
+			bolt.main.end = vect2d_new(100 + lengths[i], 300);
+			bolt.thickness = thicknesses[j];
+
+			//one untimed run first to learn how many segments the bolt has, every run makes the same bolt
+			bench_bolt(&bolt, 0);
+			sprintf(params, "\"length\": %.0f, \"thickness\": %.0f, \"segments\": %i", lengths[i], thicknesses[j], bolt.segments);
+			if(!bench_measure("lightning_create_bolt", params, bench_bolt, &bolt, MAX(bolt.segments, 1)))
+			{
+				lightning_system_free(&bolt.system);
+				return 0;
+			}
+		}
+	}
+	lightning_system_free(&bolt.system);
+	return 1;
+}
+
+/**
+ * @brief churns segments through pools of growing size, empty and with the front half taken so lightning_new has to search for a slot
+ * @return 1 if every pool ran, 0 otherwise
+ */
+static int bench_churn_cases()
+{
+	static int pools[] = {2000, 10000, 100000};
+	int i, j, k;
+	char params[128];
+	BenchChurn churn;
+
+	for(i = 0; i < sizeof(pools) / sizeof(int); i++)
+	{
+		for(j = 0; j < 2; j++)
+		{
+			memset(&churn, 0, sizeof(BenchChurn));
+			churn.system = lightning_system_new(NULL, pools[i], 1);
+			if(!churn.system)
+			{
+				return 0;
+			}
+			/*taken slots are marked in use without a free function, so lightning_new skips them and the purge leaves them be*/
+			churn.occupied = j ? pools[i] / 2 : 0;
+			for(k = 0; k < churn.occupied; k++)
+			{
+				churn.system->lightningList[k].inUse = 1;
+			}
+			churn.system->lightningNum = churn.occupied;
+
+			sprintf(params, "\"pool\": %i, \"occupied\": %i", pools[i], churn.occupied);
+			if(!bench_measure("lightning_churn", params, bench_churn, &churn, BENCH_CHURN_COUNT))
+			{
+				lightning_system_free(&churn.system);
+				return 0;
+			}
+			lightning_system_free(&churn.system);
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief times each vect2d helper over the same random vectors
+ * @return 1 if every helper ran, 0 otherwise
+ */
+static int bench_vect_cases()
+{
+	int i, ok;
+	char params[128];
+	Uint32 state = 0x9e3779b9;
+	BenchVect vect;
+
+	vect.vects = (Vect2d *)malloc(sizeof(Vect2d) * BENCH_VECTORS);
+	vect.results = (Vect2d *)malloc(sizeof(Vect2d) * BENCH_VECTORS);
+	vect.lengths = (float *)malloc(sizeof(float) * BENCH_VECTORS);
+	if(!vect.vects || !vect.results || !vect.lengths)
+	{
+		slog("benchmark failed to allocate vectors");
+		free(vect.vects);
+		free(vect.results);
+		free(vect.lengths);
+		return 0;
+	}
+	for(i = 0; i < BENCH_VECTORS; i++)
+	{
+		vect.vects[i] = vect2d_new(bench_random(&state) * 2000 - 1000, bench_random(&state) * 2000 - 1000);
+	}
+	sprintf(params, "\"count\": %i", BENCH_VECTORS);
+
+	ok = bench_measure("vect2d_new", params, bench_vect2d_new, &vect, BENCH_VECTORS)
+		&& bench_measure("vect2d_get_length", params, bench_vect2d_get_length, &vect, BENCH_VECTORS)
+		&& bench_measure("vect2d_normalize", params, bench_vect2d_normalize, &vect, BENCH_VECTORS)
+		&& bench_measure("vect2d_subtract_scale_add", params, bench_vect2d_macros, &vect, BENCH_VECTORS)
+		&& bench_measure("vect2d_batch_length", params, bench_vect2d_batch_length, &vect, BENCH_VECTORS)
+		&& bench_measure("vect2d_batch_normalize", params, bench_vect2d_batch_normalize, &vect, BENCH_VECTORS);
+	free(vect.vects);
+	free(vect.results);
+	free(vect.lengths);
+	return ok;
+}
+
+/**
+ * @brief measures a storm's worth of segments along a random line across the window, one at a time and then batched
+ * @return 1 if both ran, 0 otherwise
+ */
+static int bench_segment_cases()
+{
+	int i, ok;
+	char params[128];
+	Uint32 state = 0x2545f491;
+	BenchSegments segments;
+
+	segments.points = (Vect2d *)malloc(sizeof(Vect2d) * (BENCH_STORM_SEGMENTS + 1));
+	segments.lengths = (float *)malloc(sizeof(float) * BENCH_STORM_SEGMENTS);
+	segments.angles = (float *)malloc(sizeof(float) * BENCH_STORM_SEGMENTS);
+	segments.directions = (Vect2d *)malloc(sizeof(Vect2d) * BENCH_STORM_SEGMENTS);
+	if(!segments.points || !segments.lengths || !segments.angles || !segments.directions)
+	{
+		slog("benchmark failed to allocate segments");
+		free(segments.points);
+		free(segments.lengths);
+		free(segments.angles);
+		free(segments.directions);
+		return 0;
+	}
+	for(i = 0; i <= BENCH_STORM_SEGMENTS; i++)
+	{
+		segments.points[i] = vect2d_new(bench_random(&state) * WINDOW_WIDTH, bench_random(&state) * WINDOW_HEIGHT);
+	}
+	sprintf(params, "\"count\": %i", BENCH_STORM_SEGMENTS);
+
+	ok = bench_measure("vect2d_segments", params, bench_segments, &segments, BENCH_STORM_SEGMENTS)
+		&& bench_measure("vect2d_batch_segments", params, bench_batch_segments, &segments, BENCH_STORM_SEGMENTS);
+	free(segments.points);
+	free(segments.lengths);
+	free(segments.angles);
+	free(segments.directions);
+	return ok;
+}
+
+/**
+ * @brief runs every benchmark case and writes the results as JSON
+ * @param options [in]	how to run them and where to write them
+ * @return 1 if every case ran and the results were written, 0 otherwise
+ */
+int bench_run(BenchOptions *options)
+{
+	int ok;
+	Uint64 counter;
+
+	if(!options || options->repetitions <= 0 || options->warmup < 0)
+	{
+		slog("benchmark needs at least one repetition");
+		return 0;
+	}
+	if(strcmp(options->path, "-") == 0)
+	{
+		benchOut = stdout;
+	}
+	else
+	{
+		benchOut = fopen(options->path, "w");
+		if(!benchOut)
+		{
+			slog("could not open benchmark output %s", options->path);
+			return 0;
+		}
+	}
+	benchOptions = options;
+	benchCases = 0;
+
+	fprintf(benchOut, "{\n\t\"version\": %i,\n\t\"warmup\": %i,\n\t\"repetitions\": %i,\n\t\"results\": [",
+		BENCH_VERSION, options->warmup, options->repetitions);
+	counter = SDL_GetPerformanceCounter();
+	ok = bench_sort_cases()
+		&& bench_bolt_cases()
+		&& bench_churn_cases()
+		&& bench_vect_cases()
+		&& bench_segment_cases();
+	fprintf(benchOut, "\n\t]\n}\n");
+
+	if(benchOut != stdout)
+	{
+		ok = (fclose(benchOut) == 0) && ok;
+	}
+	else
+	{
+		fflush(stdout);
+	}
+	benchOut = NULL;
+	benchOptions = NULL;
+	slog("benchmark ran %i cases in %f seconds", benchCases, bench_seconds(counter));
+	return ok;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "bench.h"
+
+/**
+ * @brief the lightning_bench executable, runs the same cases as the game's -bench flag without the game around them
+ *			lightning_bench [file] [-warmup <n>] [-reps <n>]
+ *			file				where the JSON is written, - writes to stdout, bench.json if not given
+ *			-warmup <n>			runs of every case thrown away before timing
+ *			-reps <n>			timed runs of every case
+ * @param argc	how many arguments there are
+ * @param argv	the arguments
+ * @return 0 if every case ran and the results were written, 1 otherwise
+ */
+int main(int argc, char *argv[])
+{
+	int i;
+	BenchOptions options;
+
+	bench_default_options(&options);
+	for(i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-warmup") == 0 && i + 1 < argc)
+		{
+			options.warmup = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-reps") == 0 && i + 1 < argc)
+		{
+			options.repetitions = atoi(argv[++i]);
+		}
+		else if(argv[i][0] != '-' || strcmp(argv[i], "-") == 0)
+		{
+			options.path = argv[i];
+		}
+		else
+		{
+			fprintf(stderr, "unknown argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if(strcmp(options.path, "-") == 0)
+	{
+		//stdout is carrying the results, so the log can only go to the file
+		set_logger_echo(0);
+	}
+	init_logger("log.txt");
+	return bench_run(&options) ? 0 : 1;
+}
\ No newline at end of file
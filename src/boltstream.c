@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "simple_logger.h"
+
+#include "boltstream.h"
+
+/* shared memory */
+static char boltstreamName[256];
+static Uint8 *boltstreamMap = NULL;
+static size_t boltstreamSize = 0;
+static BoltStreamHeader *boltstreamHeader = NULL;
+static Uint64 boltstreamHead = 0;
+
+/* the frame being collected, copied into its slot all at once so the slot is only odd for a memcpy */
+static BoltStreamFrame stageFrame;
+static BoltStreamBolt *stageBolts = NULL;
+static float *stagePoints = NULL;
+static Uint32 stageMaxBolts = 0;
+static Uint32 stageMaxPoints = 0;
+static int stageWarned = 0;
+
+/**
+ * @brief creates the shared memory and sets up an empty ring
+ * @param [in] name		name of the shared memory object, a leading / is added if it is missing
+ * @param slotCount		how many frames the ring holds, 0 uses BOLTSTREAM_SLOTS
+ * @param slotSize		bytes per frame, 0 uses BOLTSTREAM_SLOT_SIZE
+ * @return 1 if the stream is open, 0 otherwise
+ */
+int boltstream_open(char *name, int slotCount, int slotSize)
+{
+#ifdef _WIN32
+	slog("the bolt stream needs POSIX shared memory, %s was not opened", name);
+	return 0;
+#else
+	int fd;
+
+	if(boltstreamMap)
+	{
+		boltstream_close();
+	}
+	if(slotCount <= 0)
+	{
+		slotCount = BOLTSTREAM_SLOTS;
+	}
+	/*readers stay a slot clear of the one being written, so there has to be another*/
+	slotCount = MAX(slotCount, 2);
+	if(slotSize <= 0)
+	{
+		slotSize = BOLTSTREAM_SLOT_SIZE;
+	}
+	/*slots stay 8 byte aligned so the sequences can be read atomically*/
+	slotSize = MAX(slotSize, (int)(sizeof(BoltStreamFrame) + sizeof(BoltStreamBolt) + 16)) & ~7;
+	snprintf(boltstreamName, sizeof(boltstreamName), "%s%s", name[0] == '/' ? "" : "/", name);
+	boltstreamSize = sizeof(BoltStreamHeader) + (size_t)slotCount * slotSize;
+
+	fd = shm_open(boltstreamName, O_CREAT | O_RDWR, 0644);
+	if(fd < 0)
+	{
+		slog("unable to create shared memory %s", boltstreamName);
+		return 0;
+	}
+	if(ftruncate(fd, boltstreamSize) != 0)
+	{
+		slog("unable to size shared memory %s to %u bytes", boltstreamName, (Uint32)boltstreamSize);
+		close(fd);
+		shm_unlink(boltstreamName);
+		return 0;
+	}
+	boltstreamMap = (Uint8 *)mmap(NULL, boltstreamSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(boltstreamMap == MAP_FAILED)
+	{
+		slog("unable to map shared memory %s", boltstreamName);
+		boltstreamMap = NULL;
+		shm_unlink(boltstreamName);
+		return 0;
+	}
+
+	stageMaxBolts = (slotSize - sizeof(BoltStreamFrame)) / sizeof(BoltStreamBolt);
+	stageMaxPoints = (slotSize - sizeof(BoltStreamFrame)) / (sizeof(float) * 2);
+	stageBolts = (BoltStreamBolt *)malloc(sizeof(BoltStreamBolt) * stageMaxBolts);
+	stagePoints = (float *)malloc(sizeof(float) * 2 * stageMaxPoints);
+	if(!stageBolts || !stagePoints)
+	{
+		slog("bolt stream staging failed to allocate");
+		boltstream_close();
+		return 0;
+	}
+
+	/*a stream left by an earlier run may still be mapped by readers, hide it until the ring is reset*/
+	boltstreamHeader = (BoltStreamHeader *)boltstreamMap;
+	__atomic_store_n(&boltstreamHeader->magic, 0, __ATOMIC_RELEASE);
+	memset(boltstreamMap + sizeof(Uint32), 0, boltstreamSize - sizeof(Uint32));
+	boltstreamHeader->version = BOLTSTREAM_VERSION;
+	boltstreamHeader->slotCount = slotCount;
+	boltstreamHeader->slotSize = slotSize;
+	boltstreamHead = 0;
+	stageWarned = 0;
+	memset(&stageFrame, 0, sizeof(BoltStreamFrame));
+	__atomic_store_n(&boltstreamHeader->magic, BOLTSTREAM_MAGIC, __ATOMIC_RELEASE);
+
+	slog("publishing bolts to shared memory %s, %i slots of %i bytes", boltstreamName, slotCount, slotSize);
+	atexit(boltstream_close);
+	return 1;
+#endif
+}
+
+/**
+ * @brief unmaps and removes the shared memory, readers that still have it mapped keep their view of it
+ */
+void boltstream_close()
+{
+#ifndef _WIN32
+	if(boltstreamMap)
+	{
+		munmap(boltstreamMap, boltstreamSize);
+		shm_unlink(boltstreamName);
+		boltstreamMap = NULL;
+		boltstreamHeader = NULL;
+	}
+#endif
+	free(stageBolts);
+	free(stagePoints);
+	stageBolts = NULL;
+	stagePoints = NULL;
+	stageMaxBolts = stageMaxPoints = 0;
+}
+
+/**
+ * @brief checks if the stream is open
+ * @return 1 if frames are being published
+ */
+int boltstream_is_active()
+{
+	return boltstreamMap != NULL;
+}
+
+/**
+ * @brief starts collecting the bolts of a new frame
+ * @param time	the clock to stamp the frame with, in milliseconds
+ */
+void boltstream_begin_frame(Uint32 time)
+{
+	memset(&stageFrame, 0, sizeof(BoltStreamFrame));
+	stageFrame.time = time;
+}
+
+/**
+ * @brief adds a bolt to the frame being collected
+ * @param points [in]	the points of the bolt
+ * @param numPoints		how many points the bolt has
+ * @param thickness		thickness of the bolt
+ */
+void boltstream_add_bolt(Vect2d *points, int numPoints, float thickness)
+{
+	int i;
+	BoltStreamBolt *bolt;
+	float *out;
+
+	if(!boltstreamMap || numPoints <= 0)
+	{
+		return;
+	}
+	if(sizeof(BoltStreamFrame) + (stageFrame.numBolts + 1) * sizeof(BoltStreamBolt) +
+	   (stageFrame.numPoints + numPoints) * sizeof(float) * 2 > boltstreamHeader->slotSize)
+	{
+		if(!stageWarned)
+		{
+			slog("a frame of bolts does not fit in the %u byte stream slots, the rest are left out", boltstreamHeader->slotSize);
+			stageWarned = 1;
+		}
+		stageFrame.flags |= BOLTSTREAM_TRUNCATED;
+		return;
+	}
+	bolt = &stageBolts[stageFrame.numBolts++];
+	bolt->firstPoint = stageFrame.numPoints;
+	bolt->numPoints = numPoints;
+	bolt->thickness = thickness;
+	bolt->reserved = 0;
+	out = &stagePoints[stageFrame.numPoints * 2];
+	for(i = 0; i < numPoints; i++)
+	{
+		out[i * 2] = points[i].x;
+		out[i * 2 + 1] = points[i].y;
+	}
+	stageFrame.numPoints += numPoints;
+}
+
+/**
+ * @brief copies the collected frame into its slot under the slot's seqlock and advances the head
+ */
+void boltstream_end_frame()
+{
+	Uint8 *slot;
+	BoltStreamFrame *frame;
+	Uint64 sequence;
+
+	if(!boltstreamMap)
+	{
+		return;
+	}
+	slot = boltstreamMap + sizeof(BoltStreamHeader) + (size_t)(boltstreamHead % boltstreamHeader->slotCount) * boltstreamHeader->slotSize;
+	frame = (BoltStreamFrame *)slot;
+
+	/*odd while writing, the fence keeps the odd sequence ahead of the data for readers*/
+	sequence = frame->sequence;
+	__atomic_store_n(&frame->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	frame->frame = boltstreamHead;
+	frame->time = stageFrame.time;
+	frame->numBolts = stageFrame.numBolts;
+	frame->numPoints = stageFrame.numPoints;
+	frame->flags = stageFrame.flags;
+	memcpy(slot + sizeof(BoltStreamFrame), stageBolts, stageFrame.numBolts * sizeof(BoltStreamBolt));
+	memcpy(slot + sizeof(BoltStreamFrame) + stageFrame.numBolts * sizeof(BoltStreamBolt), stagePoints, stageFrame.numPoints * sizeof(float) * 2);
+
+	__atomic_store_n(&frame->sequence, sequence + 2, __ATOMIC_RELEASE);
+	boltstreamHead++;
+	__atomic_store_n(&boltstreamHeader->head, boltstreamHead, __ATOMIC_RELEASE);
+}
\ No newline at end of file
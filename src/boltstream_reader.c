@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "boltstream_reader.h"
+
+/**
+ * @brief maps a stream a producer has opened
+ * @param [in] name		the name the producer opened it with
+ * @return the reader, NULL if the stream doesn't exist or isn't ready yet
+ */
+BoltStreamReader *boltstream_reader_open(const char *name)
+{
+#ifdef _WIN32
+	return NULL;
+#else
+	int fd;
+	char path[256];
+	struct stat info;
+	const uint8_t *map;
+	const BoltStreamHeader *header;
+	uint32_t slotCount, slotSize;
+	BoltStreamReader *reader;
+
+	snprintf(path, sizeof(path), "%s%s", name[0] == '/' ? "" : "/", name);
+	fd = shm_open(path, O_RDONLY, 0);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(BoltStreamHeader))
+	{
+		close(fd);
+		return NULL;
+	}
+	map = (const uint8_t *)mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	header = (const BoltStreamHeader *)map;
+	if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != BOLTSTREAM_MAGIC || header->version != BOLTSTREAM_VERSION)
+	{
+		munmap((void *)map, info.st_size);
+		return NULL;
+	}
+	/*read the ring's shape once, everything after uses these copies so whatever is written to the header can't move a read
+	  out of the mapping*/
+	slotCount = __atomic_load_n(&header->slotCount, __ATOMIC_RELAXED);
+	slotSize = __atomic_load_n(&header->slotSize, __ATOMIC_RELAXED);
+	if(slotCount < 2 || slotSize < sizeof(BoltStreamFrame) || sizeof(BoltStreamHeader) + (uint64_t)slotCount * slotSize > (uint64_t)info.st_size)
+	{
+		munmap((void *)map, info.st_size);
+		return NULL;
+	}
+
+	reader = (BoltStreamReader *)malloc(sizeof(BoltStreamReader));
+	if(!reader)
+	{
+		munmap((void *)map, info.st_size);
+		return NULL;
+	}
+	memset(reader, 0, sizeof(BoltStreamReader));
+	reader->map = map;
+	reader->size = info.st_size;
+	reader->header = header;
+	reader->slotCount = slotCount;
+	reader->slotSize = slotSize;
+	/*start with the frames published from now on*/
+	reader->nextFrame = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+	return reader;
+#endif
+}
+
+/**
+ * @brief unmaps a stream and frees the reader, and destroys the pointer to it
+ * @param reader [in,out]	the reader to close
+ */
+void boltstream_reader_close(BoltStreamReader **reader)
+{
+	if(!reader || !*reader)
+	{
+		return;
+	}
+#ifndef _WIN32
+	munmap((void *)(*reader)->map, (*reader)->size);
+#endif
+	free(*reader);
+	*reader = NULL;
+}
+
+/**
+ * @brief checks that the producer hasn't started rewriting a frame's slot, call it after using the view
+ * @param view [in]	the view to check
+ * @return 1 if everything read through the view was intact, 0 if it has to be thrown away
+ */
+int boltstream_reader_check(const BoltStreamView *view)
+{
+	/*keeps the reads through the view ahead of the second look at the sequence*/
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&view->slot->sequence, __ATOMIC_RELAXED) == view->sequence;
+}
+
+/**
+ * @brief points a view at a frame's slot, if the slot still holds that frame and isn't being written
+ * @param reader [in]	the reader
+ * @param frame			which frame to view
+ * @param view [out]	filled with the frame
+ * @return 1 if the view is of the frame, 0 if the producer has lapped it
+ */
+static int boltstream_reader_take(BoltStreamReader *reader, uint64_t frame, BoltStreamView *view)
+{
+	const uint8_t *slot;
+
+	slot = reader->map + sizeof(BoltStreamHeader) + (size_t)(frame % reader->slotCount) * reader->slotSize;
+	view->slot = (const BoltStreamFrame *)slot;
+	view->sequence = __atomic_load_n(&view->slot->sequence, __ATOMIC_ACQUIRE);
+	if(view->sequence & 1)
+	{
+		return 0;
+	}
+	view->frame = view->slot->frame;
+	view->time = view->slot->time;
+	view->flags = view->slot->flags;
+	view->numBolts = view->slot->numBolts;
+	view->numPoints = view->slot->numPoints;
+	if(view->frame != frame || !boltstream_reader_check(view))
+	{
+		return 0;
+	}
+	if(sizeof(BoltStreamFrame) + (uint64_t)view->numBolts * sizeof(BoltStreamBolt) + (uint64_t)view->numPoints * sizeof(float) * 2 > reader->slotSize)
+	{
+		return 0;
+	}
+	view->bolts = (const BoltStreamBolt *)(slot + sizeof(BoltStreamFrame));
+	view->points = (const float *)(slot + sizeof(BoltStreamFrame) + view->numBolts * sizeof(BoltStreamBolt));
+	return 1;
+}
+
+/**
+ * @brief gets the next frame in order, skipping ahead to the oldest frame still in the ring if the reader fell behind
+ * @param reader [in,out]	the reader
+ * @param view [out]		filled with the frame
+ * @return 1 if a frame was read, 0 if the reader is caught up with the producer
+ */
+int boltstream_reader_next(BoltStreamReader *reader, BoltStreamView *view)
+{
+	uint64_t head;
+
+	while(1)
+	{
+		head = __atomic_load_n(&reader->header->head, __ATOMIC_ACQUIRE);
+		if(reader->nextFrame >= head)
+		{
+			/*caught up, or the producer restarted and the head went back*/
+			reader->nextFrame = head;
+			return 0;
+		}
+		/*the slot after the newest frame is the next one the producer writes, so stay a slot clear of it*/
+		if(head - reader->nextFrame > reader->slotCount - 1)
+		{
+			reader->dropped += head - reader->nextFrame - (reader->slotCount - 1);
+			reader->nextFrame = head - (reader->slotCount - 1);
+		}
+		if(boltstream_reader_take(reader, reader->nextFrame, view))
+		{
+			reader->nextFrame++;
+			return 1;
+		}
+		reader->dropped++;
+		reader->nextFrame++;
+	}
+}
+
+/**
+ * @brief gets the newest frame, skipping any the reader hasn't seen
+ * @param reader [in,out]	the reader
+ * @param view [out]		filled with the frame
+ * @return 1 if a frame was read, 0 if nothing has been published since the last frame read
+ */
+int boltstream_reader_latest(BoltStreamReader *reader, BoltStreamView *view)
+{
+	uint64_t head;
+
+	while(1)
+	{
+		head = __atomic_load_n(&reader->header->head, __ATOMIC_ACQUIRE);
+		if(head == 0 || head - 1 < reader->nextFrame)
+		{
+			if(head < reader->nextFrame)
+			{
+				reader->nextFrame = head;
+			}
+			return 0;
+		}
+		reader->dropped += head - 1 - reader->nextFrame;
+		reader->nextFrame = head - 1;
+		if(boltstream_reader_take(reader, reader->nextFrame, view))
+		{
+			reader->nextFrame++;
+			return 1;
+		}
+	}
+}
\ No newline at end of file
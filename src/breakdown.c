@@ -0,0 +1,356 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "jobs.h"
+#include "breakdown.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BREAKDOWN_SSE2
+#include <emmintrin.h>
+#endif
+
+#define BREAKDOWN_MAX_STEPS		5000		/**< the most cells the channel can grow by, so a bolt never fills the whole lightningList */
+
+#define BREAKDOWN_BANDS			4			/**< how many bands of rows a pass is split into per worker, so a worker that falls behind can have its rows stolen */
+
+#define CELL_EMPTY				0			/**< a cell the channel hasn't reached */
+#define CELL_CANDIDATE			1			/**< a cell next to the channel that it could grow into */
+#define CELL_CHANNEL			2			/**< a cell in the channel, held at potential 0 */
+#define CELL_TARGET				3			/**< the cell the bolt is heading for, held at potential 1 */
+
+/* grid, reused between bolts and only grown. the potential and free mask are split by color, the red cells ((x + y) even) first
+   and then the black cells, each color packed gridWidth / 2 to a row, so a pass reads one color and writes the other contiguously */
+static float *gridPhi = NULL;				/* the potential of each cell */
+static float *gridFree = NULL;				/* 1 for cells the solver updates, 0 for cells held at a fixed potential */
+static Uint8 *gridState = NULL;
+static int *gridParent = NULL;
+static Vect2d *gridPoint = NULL;
+static Lightning **gridSegment = NULL;
+static int *candidates = NULL;
+static int gridCells = 0;
+static int gridWidth = 0;
+static int gridHeight = 0;
+static int candidateNum = 0;
+
+static int breakdownReady = 0;
+
+/**
+ * @brief finds where a cell's potential is kept in the color split layout of gridPhi and gridFree
+ * @param cell		index of the cell, y * gridWidth + x
+ * @return the index into gridPhi and gridFree
+ */
+static int breakdown_slot(int cell)
+{
+	int x = cell % gridWidth;
+	int y = cell / gridWidth;
+	return ((x + y) & 1) * (gridWidth / 2) * gridHeight + y * (gridWidth / 2) + (x >> 1);
+}
+
+/**
+ * @brief one red-black SOR pass over a band of rows, only the cells of one color are updated. a cell's four neighbors are
+ *			always the other color: the cells above and below are at the same packed index, the ones beside it at the same index
+ *			and the one before or after it depending on the row
+ * @param color		0 for the red cells, 1 for the black cells
+ * @param rowStart	first row to update
+ * @param rowEnd	one past the last row to update
+ */
+static void breakdown_relax_rows(int color, int rowStart, int rowEnd)
+{
+	int k, y, side;
+	int halfWidth = gridWidth / 2;
+	float *phi, *cellFree, *other;
+	float gauss;
+#ifdef BREAKDOWN_SSE2
+	__m128 vomega = _mm_set1_ps(BREAKDOWN_OMEGA);
+	__m128 vquarter = _mm_set1_ps(0.25f);
+	__m128 vc, vsum;
+#endif
+
+	for(y = MAX(rowStart, 1); y < MIN(rowEnd, gridHeight - 1); y++)
+	{
+		phi = &gridPhi[color * halfWidth * gridHeight + y * halfWidth];
+		cellFree = &gridFree[color * halfWidth * gridHeight + y * halfWidth];
+		other = &gridPhi[(color ^ 1) * halfWidth * gridHeight + y * halfWidth];
+		/*the cell at packed index k is at x = 2k + ((y + color) & 1), its other neighbor in the row is at k - 1 or k + 1*/
+		side = ((y + color) & 1) ? 1 : -1;
+		k = 0;
+#ifdef BREAKDOWN_SSE2
+		/*halfWidth is a multiple of 4, every lane of every block is a cell of this color*/
+		for(; k + 4 <= halfWidth; k += 4)
+		{
+			vc = _mm_loadu_ps(&phi[k]);
+			vsum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(&other[k]), _mm_loadu_ps(&other[k + side])),
+							  _mm_add_ps(_mm_loadu_ps(&other[k - halfWidth]), _mm_loadu_ps(&other[k + halfWidth])));
+			vsum = _mm_sub_ps(_mm_mul_ps(vsum, vquarter), vc);
+			vsum = _mm_mul_ps(_mm_mul_ps(vsum, vomega), _mm_loadu_ps(&cellFree[k]));
+			_mm_storeu_ps(&phi[k], _mm_add_ps(vc, vsum));
+		}
+#endif
+		for(; k < halfWidth; k++)
+		{
+			gauss = 0.25f * (other[k] + other[k + side] + other[k - halfWidth] + other[k + halfWidth]);
+			phi[k] += BREAKDOWN_OMEGA * (gauss - phi[k]) * cellFree[k];
+		}
+	}
+}
+
+/**
+ * @brief job that relaxes a band of rows, the color is passed through data
+ * @param data [in]	points to the color being updated
+ * @param start		first row
+ * @param end		one past the last row
+ * @param worker	unused
+ */
+static void breakdown_relax_job(void *data, int start, int end, int worker)
+{
+	breakdown_relax_rows(*(int *)data, start, end);
+}
+
+/**
+ * @brief runs SOR sweeps over the whole grid, each sweep is a red pass then a black pass split into bands of rows across the
+ *			job system's workers. a pass only writes one color, so the bands never touch the same cell
+ * @param sweeps	how many sweeps to run
+ */
+static void breakdown_solve(int sweeps)
+{
+	int s, color;
+	int band = MAX(gridHeight / (jobs_get_worker_count() * BREAKDOWN_BANDS), 1);
+
+	for(s = 0; s < sweeps * 2; s++)
+	{
+		color = s & 1;
+		jobs_parallel_for(breakdown_relax_job, &color, 0, gridHeight, band);
+	}
+}
+
+/**
+ * @brief initializes the breakdown generator, the solver runs on the job system's workers
+ */
+void breakdown_init_system()
+{
+	breakdownReady = 1;
+	atexit(breakdown_close_system);
+}
+
+/**
+ * @brief frees the grids
+ */
+void breakdown_close_system()
+{
+	breakdownReady = 0;
+	free(gridPhi);
+	free(gridFree);
+	free(gridState);
+	free(gridParent);
+	free(gridPoint);
+	free(gridSegment);
+	free(candidates);
+	gridPhi = gridFree = NULL;
+	gridState = NULL;
+	gridParent = candidates = NULL;
+	gridPoint = NULL;
+	gridSegment = NULL;
+	gridCells = 0;
+}
+
+/**
+ * @brief makes sure the grids have room for the given number of cells
+ * @param cells		how many cells are needed
+ * @return 0 if the grids could not be allocated
+ */
+static int breakdown_reserve(int cells)
+{
+	if(cells <= gridCells)
+	{
+		return 1;
+	}
+	free(gridPhi);
+	free(gridFree);
+	free(gridState);
+	free(gridParent);
+	free(gridPoint);
+	free(gridSegment);
+	free(candidates);
+	gridPhi = (float *)malloc(sizeof(float) * cells);
+	gridFree = (float *)malloc(sizeof(float) * cells);
+	gridState = (Uint8 *)malloc(cells);
+	gridParent = (int *)malloc(sizeof(int) * cells);
+	gridPoint = (Vect2d *)malloc(sizeof(Vect2d) * cells);
+	gridSegment = (Lightning **)malloc(sizeof(Lightning *) * cells);
+	candidates = (int *)malloc(sizeof(int) * cells);
+	if(!gridPhi || !gridFree || !gridState || !gridParent || !gridPoint || !gridSegment || !candidates)
+	{
+		slog("breakdown grid failed to allocate %i cells", cells);
+		gridCells = 0;
+		return 0;
+	}
+	gridCells = cells;
+	return 1;
+}
+
+/**
+ * @brief adds a cell to the channel: holds it at potential 0 and makes its empty neighbors candidates that grow from it
+ * @param cell		index of the cell
+ * @param point		where the channel passes through the cell
+ */
+static void breakdown_add_channel(int cell, Vect2d point)
+{
+	int dx, dy, neighbor;
+	int x = cell % gridWidth;
+	int y = cell / gridWidth;
+
+	gridState[cell] = CELL_CHANNEL;
+	gridPhi[breakdown_slot(cell)] = 0;
+	gridFree[breakdown_slot(cell)] = 0;
+	gridPoint[cell] = point;
+	for(dy = -1; dy <= 1; dy++)
+	{
+		for(dx = -1; dx <= 1; dx++)
+		{
+			if(x + dx <= 0 || x + dx >= gridWidth - 1 || y + dy <= 0 || y + dy >= gridHeight - 1)
+			{
+				continue;
+			}
+			neighbor = cell + dy * gridWidth + dx;
+			if(gridState[neighbor] == CELL_EMPTY)
+			{
+				gridState[neighbor] = CELL_CANDIDATE;
+				gridParent[neighbor] = cell;
+				candidates[candidateNum++] = neighbor;
+			}
+		}
+	}
+}
+
+/**
+ * @brief checks if a cell touches the target cell
+ * @param cell		index of the cell
+ * @param target	index of the target cell
+ * @return 1 if the cell is one of the target's 8 neighbors
+ */
+static int breakdown_touches(int cell, int target)
+{
+	int dx = cell % gridWidth - target % gridWidth;
+	int dy = cell / gridWidth - target / gridWidth;
+	return dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1;
+}
+
+/**
+ * @brief grows a branched bolt from start to end with the dielectric breakdown model, writing each growth step into the system's lightningList
+ *			as one segment so it is drawn by lightning_draw_all. the channel that reaches end is drawn twice as thick as the branches
+ * @param system [in,out]	the lightning system to create the segments in
+ * @param start		where the channel starts growing from
+ * @param end		the point the channel is drawn towards, growth stops when it is reached
+ * @param thickness	thickness of the branches
+ * @return the number of segments created
+ */
+int breakdown_create_bolt(LightningSystem *system, Vect2d start, Vect2d end, float thickness)
+{
+	int i, step, pick;
+	int seed, target, cell;
+	int segments = 0;
+	float length, margin;
+	float sum, choice;
+	Vect2d origin, point;
+	Lightning *segment;
+
+	if(!breakdownReady)
+	{
+		slog("breakdown uninitialized");
+		return 0;
+	}
+
+	vect2d_subtract(end, start, point);
+	length = vect2d_get_length(point);
+	margin = MAX(length * BREAKDOWN_MARGIN, BREAKDOWN_CELL_SIZE * 4);
+
+	/*one border cell all the way around is held at 0, and the width is padded to a multiple of 8 so each color's rows are a multiple of 4*/
+	origin = vect2d_new(MIN(start.x, end.x) - margin - BREAKDOWN_CELL_SIZE, MIN(start.y, end.y) - margin - BREAKDOWN_CELL_SIZE);
+	gridWidth = ((int)((fabs(end.x - start.x) + margin * 2) / BREAKDOWN_CELL_SIZE) + 2 + 7) & ~7;
+	gridHeight = (int)((fabs(end.y - start.y) + margin * 2) / BREAKDOWN_CELL_SIZE) + 2;
+	if(!breakdown_reserve(gridWidth * gridHeight))
+	{
+		return 0;
+	}
+
+	memset(gridState, CELL_EMPTY, gridWidth * gridHeight);
+	memset(gridSegment, 0, sizeof(Lightning *) * gridWidth * gridHeight);
+	for(i = 0; i < gridWidth * gridHeight; i++)
+	{
+		gridPhi[i] = 0.5f;
+		gridFree[i] = 1;
+	}
+	for(i = 0; i < gridWidth; i++)
+	{
+		gridPhi[breakdown_slot(i)] = gridFree[breakdown_slot(i)] = 0;
+		gridPhi[breakdown_slot((gridHeight - 1) * gridWidth + i)] = gridFree[breakdown_slot((gridHeight - 1) * gridWidth + i)] = 0;
+	}
+	for(i = 0; i < gridHeight; i++)
+	{
+		gridPhi[breakdown_slot(i * gridWidth)] = gridFree[breakdown_slot(i * gridWidth)] = 0;
+		gridPhi[breakdown_slot(i * gridWidth + gridWidth - 1)] = gridFree[breakdown_slot(i * gridWidth + gridWidth - 1)] = 0;
+	}
+
+	seed = (int)((start.y - origin.y) / BREAKDOWN_CELL_SIZE) * gridWidth + (int)((start.x - origin.x) / BREAKDOWN_CELL_SIZE);
+	target = (int)((end.y - origin.y) / BREAKDOWN_CELL_SIZE) * gridWidth + (int)((end.x - origin.x) / BREAKDOWN_CELL_SIZE);
+	if(seed == target || breakdown_touches(seed, target))
+	{
+		lightning_new(system, start, end, thickness * 2);
+		return 1;
+	}
+	gridState[target] = CELL_TARGET;
+	gridPhi[breakdown_slot(target)] = 1;
+	gridFree[breakdown_slot(target)] = 0;
+
+	candidateNum = 0;
+	breakdown_add_channel(seed, start);
+	breakdown_solve(BREAKDOWN_FIRST_SWEEPS);
+
+	for(step = 0; step < BREAKDOWN_MAX_STEPS && candidateNum > 0; step++)
+	{
+		/*growth is picked with probability proportional to phi^eta*/
+		sum = 0;
+		for(i = 0; i < candidateNum; i++)
+		{
+			sum += pow(MAX(gridPhi[breakdown_slot(candidates[i])], 0), BREAKDOWN_ETA);
+		}
+		choice = ((float)rand() / (float)RAND_MAX) * sum;
+		for(pick = 0; pick < candidateNum - 1; pick++)
+		{
+			choice -= pow(MAX(gridPhi[breakdown_slot(candidates[pick])], 0), BREAKDOWN_ETA);
+			if(choice <= 0)
+			{
+				break;
+			}
+		}
+		cell = candidates[pick];
+		candidates[pick] = candidates[--candidateNum];
+
+		point.x = origin.x + ((cell % gridWidth) + 0.15f + 0.7f * rand() / (float)RAND_MAX) * BREAKDOWN_CELL_SIZE;
+		point.y = origin.y + ((cell / gridWidth) + 0.15f + 0.7f * rand() / (float)RAND_MAX) * BREAKDOWN_CELL_SIZE;
+		breakdown_add_channel(cell, point);
+		gridSegment[cell] = lightning_new(system, gridPoint[gridParent[cell]], point, thickness);
+		segments++;
+
+		if(breakdown_touches(cell, target))
+		{
+			lightning_new(system, point, end, thickness * 2);
+			segments++;
+			/*the path back to the start is the main channel*/
+			for(; cell != seed; cell = gridParent[cell])
+			{
+				segment = gridSegment[cell];
+				if(segment)
+				{
+					segment->thickness = thickness * 2;
+				}
+			}
+			break;
+		}
+		breakdown_solve(BREAKDOWN_STEP_SWEEPS);
+	}
+	return segments;
+}
\ No newline at end of file
@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "canvas.h"
+#include "jobs.h"
+#include "raster.h"
+
+#define CANVAS_HEADER			64			/**< the most bytes the PPM header can take */
+
+/**
+ * @struct a bolt drawn on the canvas
+ * @brief its points already scaled onto the canvas, with the bounds it is culled against the tiles by
+ */
+typedef struct CanvasBolt_t
+{
+	Vect2d *points;							/**< the points of the bolt in canvas pixels */
+	int numPoints;							/**< how many points the bolt has */
+	int maxPoints;							/**< how many points fit in points */
+	float bounds[4];						/**< left, top, right and bottom of everything the bolt lights */
+	float *chunkBounds;						/**< the same for every CANVAS_CHUNK segments in turn, 4 floats each */
+}CanvasBolt;
+
+/* the render in progress */
+static CanvasOptions *canvasOptions = NULL;
+static CanvasBolt *canvasBolts = NULL;
+static SDL_atomic_t canvasFailed;
+static float canvasScale = 1;
+static Vect2d canvasOffset;
+static float canvasThickness = 1;
+
+/* tile bins, the bolts reaching tile i are canvasTileIndex[canvasTileStart[i]] to canvasTileIndex[canvasTileStart[i + 1] - 1] */
+static int canvasTilesX = 0;
+static int canvasTilesY = 0;
+static int *canvasTileStart = NULL;
+static int *canvasTileIndex = NULL;
+
+/**
+ * @brief fills in the options a canvas render uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void canvas_default_options(CanvasOptions *options)
+{
+	memset(options, 0, sizeof(CanvasOptions));
+	options->path = "canvas.ppm";
+	options->width = WINDOW_WIDTH * 4;
+	options->height = WINDOW_HEIGHT * 4;
+	options->tileSize = CANVAS_TILE_SIZE;
+	options->count = 1;
+	options->color = vect3d_new(255, 255, 0);
+}
+
+/**
+ * @brief grows a bounding box to take in a point
+ * @param bounds [in,out]	left, top, right and bottom of the box
+ * @param point				the point
+ */
+static void canvas_bound(float *bounds, Vect2d point)
+{
+	bounds[0] = MIN(bounds[0], point.x);
+	bounds[1] = MIN(bounds[1], point.y);
+	bounds[2] = MAX(bounds[2], point.x);
+	bounds[3] = MAX(bounds[3], point.y);
+}
+
+/**
+ * @brief job that generates a range of bolts, scales them onto the canvas and bounds them
+ * @param data		unused
+ * @param start		first bolt
+ * @param end		one past the last bolt
+ * @param worker	unused
+ */
+static void canvas_bolt_job(void *data, int start, int end, int worker)
+{
+	int i, j, chunks;
+	float reach = MAX(canvasThickness * RASTER_GLOW_SCALE, 1.0f) + 1;
+	float *chunk;
+	CanvasBolt *bolt;
+
+	for(i = start; i < end && !SDL_AtomicGet(&canvasFailed); i++)
+	{
+		bolt = &canvasBolts[i];
+		bolt->numPoints = batch_generate(canvasOptions->bolts, i, &bolt->points, &bolt->maxPoints);
+		chunks = (bolt->numPoints + CANVAS_CHUNK - 2) / CANVAS_CHUNK;
+		bolt->chunkBounds = (float *)malloc(sizeof(float) * 4 * MAX(chunks, 1));
+		if(bolt->numPoints == 0 || !bolt->chunkBounds)
+		{
+			slog("canvas failed to generate bolt %i", i);
+			SDL_AtomicSet(&canvasFailed, 1);
+			return;
+		}
+		for(j = 0; j < bolt->numPoints; j++)
+		{
+			bolt->points[j].x = bolt->points[j].x * canvasScale + canvasOffset.x;
+			bolt->points[j].y = bolt->points[j].y * canvasScale + canvasOffset.y;
+		}
+
+		/*chunk c covers segments c * CANVAS_CHUNK up to the one ending on point (c + 1) * CANVAS_CHUNK, so neighbours share a point*/
+		bolt->bounds[0] = bolt->bounds[1] = 1e30f;
+		bolt->bounds[2] = bolt->bounds[3] = -1e30f;
+		for(j = 0; j < chunks; j++)
+		{
+			chunk = &bolt->chunkBounds[j * 4];
+			chunk[0] = chunk[1] = 1e30f;
+			chunk[2] = chunk[3] = -1e30f;
+		}
+		for(j = 0; j < bolt->numPoints; j++)
+		{
+			if(j / CANVAS_CHUNK < chunks)
+			{
+				canvas_bound(&bolt->chunkBounds[(j / CANVAS_CHUNK) * 4], bolt->points[j]);
+			}
+			if(j > 0 && j % CANVAS_CHUNK == 0)
+			{
+				canvas_bound(&bolt->chunkBounds[(j / CANVAS_CHUNK - 1) * 4], bolt->points[j]);
+			}
+			canvas_bound(bolt->bounds, bolt->points[j]);
+		}
+		for(j = 0; j < chunks; j++)
+		{
+			chunk = &bolt->chunkBounds[j * 4];
+			chunk[0] -= reach;
+			chunk[1] -= reach;
+			chunk[2] += reach;
+			chunk[3] += reach;
+		}
+		bolt->bounds[0] -= reach;
+		bolt->bounds[1] -= reach;
+		bolt->bounds[2] += reach;
+		bolt->bounds[3] += reach;
+	}
+}
+
+/**
+ * @brief finds the range of tiles a bolt's bounds reach
+ * @param bolt [in]		the bolt
+ * @param x0 [out]		first tile column
+ * @param y0 [out]		first tile row
+ * @param x1 [out]		last tile column
+ * @param y1 [out]		last tile row
+ * @return 0 if the bolt is completely off the canvas, 1 otherwise
+ */
+static int canvas_bolt_tiles(CanvasBolt *bolt, int *x0, int *y0, int *x1, int *y1)
+{
+	int tileSize = canvasOptions->tileSize;
+
+	if(bolt->bounds[2] < 0 || bolt->bounds[3] < 0 || bolt->bounds[0] >= canvasOptions->width || bolt->bounds[1] >= canvasOptions->height)
+	{
+		return 0;
+	}
+	*x0 = MAX(0, (int)bolt->bounds[0] / tileSize);
+	*y0 = MAX(0, (int)bolt->bounds[1] / tileSize);
+	*x1 = MIN(canvasTilesX - 1, (int)bolt->bounds[2] / tileSize);
+	*y1 = MIN(canvasTilesY - 1, (int)bolt->bounds[3] / tileSize);
+	return 1;
+}
+
+/**
+ * @brief sorts the bolts into per tile lists with a counting sort, so each tile only visits the bolts that reach it
+ * @return 0 if the bins could not be allocated
+ */
+static int canvas_bin_bolts()
+{
+	int i, x, y;
+	int x0, y0, x1, y1;
+	int tileNum = canvasTilesX * canvasTilesY;
+	int total = 0, count;
+
+	canvasTileStart = (int *)malloc(sizeof(int) * (tileNum + 1));
+	if(!canvasTileStart)
+	{
+		slog("canvas failed to allocate %i tiles", tileNum);
+		return 0;
+	}
+	memset(canvasTileStart, 0, sizeof(int) * (tileNum + 1));
+	for(i = 0; i < canvasOptions->count; i++)
+	{
+		if(!canvas_bolt_tiles(&canvasBolts[i], &x0, &y0, &x1, &y1))
+		{
+			continue;
+		}
+		for(y = y0; y <= y1; y++)
+		{
+			for(x = x0; x <= x1; x++)
+			{
+				canvasTileStart[y * canvasTilesX + x + 1]++;
+			}
+		}
+	}
+	for(i = 0; i < tileNum; i++)
+	{
+		count = canvasTileStart[i + 1];
+		canvasTileStart[i + 1] = total;
+		total += count;
+	}
+	canvasTileIndex = (int *)malloc(sizeof(int) * MAX(total, 1));
+	if(!canvasTileIndex)
+	{
+		slog("canvas tile bins failed to allocate");
+		return 0;
+	}
+
+	/*canvasTileStart[i + 1] is used as the write cursor for tile i, once filled it is the end of tile i*/
+	for(i = 0; i < canvasOptions->count; i++)
+	{
+		if(!canvas_bolt_tiles(&canvasBolts[i], &x0, &y0, &x1, &y1))
+		{
+			continue;
+		}
+		for(y = y0; y <= y1; y++)
+		{
+			for(x = x0; x <= x1; x++)
+			{
+				canvasTileIndex[canvasTileStart[y * canvasTilesX + x + 1]++] = i;
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief queues the segments of every bolt reaching a tile onto the rasterizer, moved so the tile's top left is its origin. only the
+ *			chunks of a bolt whose bounds reach the tile are looked at
+ * @param tile		index of the tile
+ * @param left		x of the tile's left column on the canvas
+ * @param top		y of the tile's top row on the canvas
+ * @return how many segments were queued
+ */
+static int canvas_queue_tile(int tile, float left, float top)
+{
+	int i, j, c, chunks, last, queued = 0;
+	float right = left + canvasOptions->tileSize;
+	float bottom = top + canvasOptions->tileSize;
+	float *chunk;
+	Vect2d origin = vect2d_new(left, top);
+	Vect2d start, end;
+	CanvasBolt *bolt;
+
+	for(i = canvasTileStart[tile]; i < canvasTileStart[tile + 1]; i++)
+	{
+		bolt = &canvasBolts[canvasTileIndex[i]];
+		chunks = (bolt->numPoints + CANVAS_CHUNK - 2) / CANVAS_CHUNK;
+		for(c = 0; c < chunks; c++)
+		{
+			chunk = &bolt->chunkBounds[c * 4];
+			if(chunk[2] < left || chunk[3] < top || chunk[0] >= right || chunk[1] >= bottom)
+			{
+				continue;
+			}
+			last = MIN((c + 1) * CANVAS_CHUNK, bolt->numPoints - 1);
+			for(j = c * CANVAS_CHUNK; j < last; j++)
+			{
+				vect2d_subtract(bolt->points[j], origin, start);
+				vect2d_subtract(bolt->points[j + 1], origin, end);
+				raster_add_segment(start, end, canvasThickness, canvasOptions->color);
+				queued++;
+			}
+		}
+	}
+	return queued;
+}
+
+/**
+ * @brief writes a rendered tile into its place in the PPM, one row at a time, dropping the alpha
+ * @param file [in,out]	the PPM
+ * @param header		bytes in the PPM's header
+ * @param left			x of the tile's left column on the canvas
+ * @param top			y of the tile's top row on the canvas
+ * @param width			how many of the tile's columns are on the canvas
+ * @param height		how many of the tile's rows are on the canvas
+ * @param row [out]		scratch for one row of RGB
+ * @return 1 if it was written, 0 otherwise
+ */
+static int canvas_write_tile(SDL_RWops *file, int header, int left, int top, int width, int height, Uint8 *row)
+{
+	int x, y, pitch;
+	Uint8 *pixels = raster_get_pixels(&pitch);
+	Uint8 *pixel;
+
+	for(y = 0; y < height; y++)
+	{
+		pixel = &pixels[y * pitch];
+		for(x = 0; x < width; x++, pixel += 4)
+		{
+			row[x * 3] = pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = pixel[2];
+		}
+		/*64 bit offsets, a print sized canvas is well past what a long can seek to on some platforms*/
+		if(SDL_RWseek(file, header + ((Sint64)(top + y) * canvasOptions->width + left) * 3, RW_SEEK_SET) < 0
+			|| SDL_RWwrite(file, row, 3, width) != (size_t)width)
+		{
+			slog("canvas failed to write to %s: %s", canvasOptions->path, SDL_GetError());
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief frees the bolts and the tile bins
+ */
+static void canvas_free()
+{
+	int i;
+
+	if(canvasBolts)
+	{
+		for(i = 0; i < canvasOptions->count; i++)
+		{
+			free(canvasBolts[i].points);
+			free(canvasBolts[i].chunkBounds);
+		}
+	}
+	free(canvasBolts);
+	free(canvasTileStart);
+	free(canvasTileIndex);
+	canvasBolts = NULL;
+	canvasTileStart = NULL;
+	canvasTileIndex = NULL;
+}
+
+/**
+ * @brief generates the bolts on the job system's workers, then draws the canvas tile by tile, writing each tile to the file as it is
+ *			done, and logs how long it took
+ * @param options [in]	the canvas and the bolts to draw on it
+ * @return 1 if the whole canvas was written, 0 otherwise
+ */
+int canvas_run(CanvasOptions *options)
+{
+	int tile, left, top, header, ok = 1;
+	Uint64 counter, segments = 0;
+	double seconds;
+	char text[CANVAS_HEADER];
+	Uint8 *row;
+	SDL_RWops *file;
+
+	if(options->width <= 0 || options->height <= 0 || options->tileSize <= 0 || options->count < 0 || !options->bolts)
+	{
+		slog("canvas needs a positive size and tile size (%i x %i, tiles of %i)", options->width, options->height, options->tileSize);
+		return 0;
+	}
+	if(options->bolts->thickness <= 0)
+	{
+		slog("canvas needs a positive thickness");
+		return 0;
+	}
+	canvasOptions = options;
+	counter = SDL_GetPerformanceCounter();
+
+	/*the window is scaled up as much as fits and centered, so the scene keeps its shape on a canvas of any shape*/
+	canvasScale = MIN((float)options->width / WINDOW_WIDTH, (float)options->height / WINDOW_HEIGHT);
+	canvasOffset = vect2d_new((options->width - WINDOW_WIDTH * canvasScale) / 2, (options->height - WINDOW_HEIGHT * canvasScale) / 2);
+	canvasThickness = options->bolts->thickness * canvasScale;
+
+	canvasBolts = (CanvasBolt *)malloc(sizeof(CanvasBolt) * MAX(options->count, 1));
+	if(!canvasBolts)
+	{
+		slog("canvas failed to allocate %i bolts", options->count);
+		return 0;
+	}
+	memset(canvasBolts, 0, sizeof(CanvasBolt) * MAX(options->count, 1));
+	SDL_AtomicSet(&canvasFailed, 0);
+	jobs_parallel_for(canvas_bolt_job, NULL, 0, options->count, 16);
+	canvasTilesX = (options->width + options->tileSize - 1) / options->tileSize;
+	canvasTilesY = (options->height + options->tileSize - 1) / options->tileSize;
+	if(SDL_AtomicGet(&canvasFailed) || !canvas_bin_bolts())
+	{
+		canvas_free();
+		return 0;
+	}
+
+	raster_init_system(options->tileSize, options->tileSize);
+	row = (Uint8 *)malloc(options->tileSize * 3);
+	file = SDL_RWFromFile(options->path, "wb");
+	if(!raster_get_pixels(NULL) || !row || !file)
+	{
+		slog("canvas could not start %s: %s", options->path, SDL_GetError());
+		free(row);
+		if(file)
+		{
+			SDL_RWclose(file);
+		}
+		canvas_free();
+		return 0;
+	}
+	header = sprintf(text, "P6\n%i %i\n255\n", options->width, options->height);
+	if(SDL_RWwrite(file, text, 1, header) != (size_t)header)
+	{
+		slog("canvas failed to write to %s: %s", options->path, SDL_GetError());
+		ok = 0;
+	}
+
+	/*the tiles are drawn one after another, each spread over the workers by the rasterizer's own smaller tiles*/
+	for(tile = 0; ok && tile < canvasTilesX * canvasTilesY; tile++)
+	{
+		left = (tile % canvasTilesX) * options->tileSize;
+		top = (tile / canvasTilesX) * options->tileSize;
+		raster_clear(vect3d_new(0, 0, 0));
+		segments += canvas_queue_tile(tile, (float)left, (float)top);
+		raster_render();
+		ok = canvas_write_tile(file, header, left, top, MIN(options->tileSize, options->width - left), MIN(options->tileSize, options->height - top), row);
+	}
+	if(SDL_RWclose(file) != 0)
+	{
+		slog("canvas failed to finish %s: %s", options->path, SDL_GetError());
+		ok = 0;
+	}
+	free(row);
+	canvas_free();
+
+	seconds = (double)(SDL_GetPerformanceCounter() - counter) / SDL_GetPerformanceFrequency();
+	if(ok)
+	{
+		slog("canvas %i x %i of %i bolts written to %s in %f seconds, %i tiles of %i, %.0f segments drawn",
+			options->width, options->height, options->count, options->path, seconds, canvasTilesX * canvasTilesY, options->tileSize, (double)segments);
+	}
+	return ok;
+}
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "simple_logger.h"
+
+#include "graphics.h"
+#include "capture.h"
+
+/* output */
+static FILE *captureFile = NULL;
+static CaptureFormat captureFormat = CAPTURE_RAW;
+static int captureWidth = 0;
+static int captureHeight = 0;
+
+/* ring of frames, the render thread fills captureWrite and the writer thread empties captureRead */
+static Uint8 **captureRing = NULL;
+static int captureRingSize = 0;
+static int captureWrite = 0;
+static int captureRead = 0;
+static SDL_sem *captureFree = NULL;
+static SDL_sem *captureFilled = NULL;
+static SDL_atomic_t captureQueued;
+static int captureWait = 0;
+static int captureDropped = 0;
+static int captureWritten = 0;
+
+/* writer */
+static SDL_Thread *captureThread = NULL;
+static Uint8 *captureYUV = NULL;
+
+/**
+ * @brief converts an RGBA frame into the three full resolution Y, U, V planes of a 4:4:4 Y4M frame, using BT.601 studio swing
+ * @param [in] frame	the RGBA frame
+ * @param [out] yuv		the planes, width * height * 3 bytes
+ */
+static void capture_rgba_to_yuv(Uint8 *frame, Uint8 *yuv)
+{
+	int i;
+	int size = captureWidth * captureHeight;
+	int r, g, b;
+	Uint8 *y = yuv;
+	Uint8 *u = yuv + size;
+	Uint8 *v = yuv + size * 2;
+
+	for(i = 0; i < size; i++, frame += 4)
+	{
+		r = frame[0];
+		g = frame[1];
+		b = frame[2];
+		y[i] = (Uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		u[i] = (Uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		v[i] = (Uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+}
+
+/**
+ * @brief writer thread, waits for frames in the ring and writes them out until capture_close runs out of frames for it
+ * @param data	unused
+ * @return 0 when the capture is closed
+ */
+static int capture_writer_thread(void *data)
+{
+	Uint8 *frame;
+	int size = captureWidth * captureHeight;
+
+	while(1)
+	{
+		SDL_SemWait(captureFilled);
+		if(SDL_AtomicGet(&captureQueued) == 0)
+		{
+			/*the only wake up without a frame is capture_close telling the writer to stop*/
+			break;
+		}
+		frame = captureRing[captureRead];
+		captureRead = (captureRead + 1) % captureRingSize;
+
+		if(captureFormat == CAPTURE_Y4M)
+		{
+			capture_rgba_to_yuv(frame, captureYUV);
+			fputs("FRAME\n", captureFile);
+			fwrite(captureYUV, 1, size * 3, captureFile);
+		}
+		else
+		{
+			fwrite(frame, 1, size * 4, captureFile);
+		}
+		captureWritten++;
+
+		SDL_AtomicAdd(&captureQueued, -1);
+		SDL_SemPost(captureFree);
+	}
+	fflush(captureFile);
+	return 0;
+}
+
+/**
+ * @brief opens the output, allocates the ring of frame buffers and starts the writer thread
+ * @param [in] path		file to write the frames to, "-" writes to stdout so the frames can be piped into an encoder
+ * @param format		the format to write the frames as
+ * @param width			width of the captured frames
+ * @param height		height of the captured frames
+ * @param fps			frame rate written into the Y4M header
+ * @param ringSize		how many frames can be waiting for the writer, 0 uses CAPTURE_RING_SIZE
+ * @param waitForWriter	if 0, frames are dropped when the ring is full so the render loop never blocks,
+ *						otherwise the render loop waits for a free buffer so no frame is lost (for fixed timestep captures)
+ */
+void capture_init(char *path, CaptureFormat format, int width, int height, int fps, int ringSize, int waitForWriter)
+{
+	int i;
+	if(captureFile)
+	{
+		slog("capture already running");
+		return;
+	}
+	if(!path || width <= 0 || height <= 0)
+	{
+		slog("capture needs a path and a frame size");
+		return;
+	}
+	if(ringSize <= 0)
+	{
+		ringSize = CAPTURE_RING_SIZE;
+	}
+
+	if(strcmp(path, "-") == 0)
+	{
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		captureFile = stdout;
+	}
+	else
+	{
+		captureFile = fopen(path, "wb");
+	}
+	if(!captureFile)
+	{
+		slog("unable to open capture output %s", path);
+		return;
+	}
+
+	captureRing = (Uint8 **)malloc(sizeof(Uint8 *) * ringSize);
+	if(!captureRing)
+	{
+		slog("capture ring failed to initialize");
+		capture_close();
+		return;
+	}
+	memset(captureRing, 0, sizeof(Uint8 *) * ringSize);
+	captureRingSize = ringSize;
+	for(i = 0; i < ringSize; i++)
+	{
+		captureRing[i] = (Uint8 *)malloc(width * height * 4);
+		if(!captureRing[i])
+		{
+			slog("capture frame %i failed to allocate", i);
+			capture_close();
+			return;
+		}
+	}
+	if(format == CAPTURE_Y4M)
+	{
+		captureYUV = (Uint8 *)malloc(width * height * 3);
+		if(!captureYUV)
+		{
+			slog("capture conversion buffer failed to allocate");
+			capture_close();
+			return;
+		}
+		fprintf(captureFile, "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C444\n", width, height, MAX(fps, 1));
+	}
+
+	captureFormat = format;
+	captureWidth = width;
+	captureHeight = height;
+	captureWrite = captureRead = 0;
+	captureWait = waitForWriter;
+	captureDropped = captureWritten = 0;
+	SDL_AtomicSet(&captureQueued, 0);
+	captureFree = SDL_CreateSemaphore(ringSize);
+	captureFilled = SDL_CreateSemaphore(0);
+	captureThread = SDL_CreateThread(capture_writer_thread, "capture", NULL);
+	if(!captureThread)
+	{
+		slog("failed to start capture thread: %s", SDL_GetError());
+		capture_close();
+		return;
+	}
+	slog("capturing %i x %i frames to %s", width, height, path);
+	atexit(capture_close);
+}
+
+/**
+ * @brief writes out every frame still in the ring, stops the writer thread and closes the output
+ */
+void capture_close()
+{
+	int i;
+	if(captureThread)
+	{
+		SDL_SemPost(captureFilled);
+		SDL_WaitThread(captureThread, NULL);
+		captureThread = NULL;
+		slog("capture wrote %i frames, dropped %i", captureWritten, captureDropped);
+	}
+	if(captureFree)
+	{
+		SDL_DestroySemaphore(captureFree);
+		captureFree = NULL;
+	}
+	if(captureFilled)
+	{
+		SDL_DestroySemaphore(captureFilled);
+		captureFilled = NULL;
+	}
+	if(captureRing)
+	{
+		for(i = 0; i < captureRingSize; i++)
+		{
+			free(captureRing[i]);
+		}
+		free(captureRing);
+		captureRing = NULL;
+	}
+	free(captureYUV);
+	captureYUV = NULL;
+	captureRingSize = 0;
+	if(captureFile && captureFile != stdout)
+	{
+		fclose(captureFile);
+	}
+	captureFile = NULL;
+}
+
+/**
+ * @brief checks if frames are being captured
+ * @return 1 if capture_init succeeded and capture_close hasn't been called, 0 otherwise
+ */
+int capture_is_active()
+{
+	return captureThread != NULL;
+}
+
+/**
+ * @brief claims the next free buffer in the ring
+ * @return the buffer to copy the frame into, NULL if the ring is full and frames are being dropped
+ */
+static Uint8 *capture_claim()
+{
+	if(!captureThread)
+	{
+		return NULL;
+	}
+	if(captureWait)
+	{
+		SDL_SemWait(captureFree);
+	}
+	else if(SDL_SemTryWait(captureFree) != 0)
+	{
+		captureDropped++;
+		return NULL;
+	}
+	return captureRing[captureWrite];
+}
+
+/**
+ * @brief hands the claimed buffer to the writer thread
+ */
+static void capture_submit()
+{
+	captureWrite = (captureWrite + 1) % captureRingSize;
+	SDL_AtomicAdd(&captureQueued, 1);
+	SDL_SemPost(captureFilled);
+}
+
+/**
+ * @brief gives the claimed buffer back to the ring without handing it to the writer, counting the frame as dropped
+ */
+static void capture_release()
+{
+	captureDropped++;
+	SDL_SemPost(captureFree);
+}
+
+/**
+ * @brief reads back the renderer's current frame into the next free buffer and hands it to the writer. must be called before the frame is presented
+ */
+void capture_frame()
+{
+	Uint8 *frame = capture_claim();
+	if(!frame)
+	{
+		return;
+	}
+	if(SDL_RenderReadPixels(graphics_get_renderer(), NULL, SDL_PIXELFORMAT_RGBA32, frame, captureWidth * 4) != 0)
+	{
+		slog("unable to read back frame: %s", SDL_GetError());
+		capture_release();
+		return;
+	}
+	capture_submit();
+}
+
+/**
+ * @brief copies an already CPU side frame (such as the raster framebuffer) into the next free buffer and hands it to the writer
+ * @param [in] pixels	R, G, B, A bytes, the same size the capture was initialized with
+ * @param pitch			number of bytes in one row of pixels
+ */
+void capture_pixels(Uint8 *pixels, int pitch)
+{
+	int y;
+	Uint8 *frame;
+	if(!pixels)
+	{
+		return;
+	}
+	frame = capture_claim();
+	if(!frame)
+	{
+		return;
+	}
+	for(y = 0; y < captureHeight; y++)
+	{
+		memcpy(&frame[y * captureWidth * 4], &pixels[y * pitch], captureWidth * 4);
+	}
+	capture_submit();
+}
\ No newline at end of file
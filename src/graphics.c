@@ -14,6 +14,9 @@ static Uint32				graphicsNow = 0;
 static Uint32				graphicsThen = 0;
 static Uint8				graphicsPrintFPS = 1;
 static float				graphicsFPS = 0; 
+static Uint32				graphicsFixedRate = 0;
+static Uint32				graphicsFixedStart = 0;
+static Uint64				graphicsFixedFrame = 0;
 
 /**
  * @brief	initializes the main window and the main renderer.
@@ -25,7 +28,8 @@ static float				graphicsFPS = 0;
 void graphics_init(char *windowName, Vect2d viewSize, Vect2d renderSize, int fullscreen)
 {
 	Uint32 flags = 0;
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
+    //only what the window, its events and the timer need, the audio, joystick and haptic subsystems are slow to probe and never used
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER) != 0)
     {
         slog("Unable to initilaize SDL system: %s",SDL_GetError());
         return;
@@ -53,6 +57,11 @@ void graphics_init(char *windowName, Vect2d viewSize, Vect2d renderSize, int ful
 
 	graphicsRenderer = SDL_CreateRenderer(graphicsMainWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
     if (!graphicsRenderer)
+    {
+        slog("no accelerated renderer, falling back to software: %s",SDL_GetError());
+        graphicsRenderer = SDL_CreateRenderer(graphicsMainWindow, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+    }
+    if (!graphicsRenderer)
     {
         slog("failed to create renderer: %s",SDL_GetError());
         graphics_close();
@@ -96,6 +105,14 @@ void graphics_frame_delay()
 {
 	Uint32 diff;
 	graphicsThen = graphicsNow;
+    if (graphicsFixedRate)
+    {
+        //offline captures advance by exactly one step a frame and run as fast as they can, counting frames so the steps add up to the rate
+        graphicsFixedFrame++;
+        graphicsNow = graphicsFixedStart + (Uint32)(graphicsFixedFrame * 1000 / graphicsFixedRate);
+        graphicsFPS = graphicsFixedRate;
+        return;
+    }
     graphicsNow = SDL_GetTicks();
     diff = (graphicsNow - graphicsThen);
     if (diff < graphicsFrameDelay)
@@ -109,6 +126,53 @@ void graphics_frame_delay()
     }
 }
 
+/**
+ * @brief	sets the shortest time a frame is allowed to take.
+ * @param	frameDelay	milliseconds each frame is held for at least, 0 runs as fast as possible.
+ */
+void graphics_set_frame_delay(Uint32 frameDelay)
+{
+	graphicsFrameDelay = frameDelay;
+}
+
+/**
+ * @brief	makes the game's time advance by a fixed step each frame instead of following the wall clock, used to capture footage offline.
+ *			frame n is at n * 1000 / framesPerSecond milliseconds, rounded down, so a step that isn't a whole millisecond is spread
+ *			over the frames instead of drifting.
+ * @param	framesPerSecond	how many frames make a second of the game's time, 0 goes back to the wall clock.
+ * @return	1 if the rate was set, 0 if it is over GRAPHICS_MAX_FIXED_RATE and frames would share a millisecond.
+ */
+int graphics_set_fixed_timestep(Uint32 framesPerSecond)
+{
+	if (framesPerSecond > GRAPHICS_MAX_FIXED_RATE)
+	{
+		slog("a fixed timestep of %u frames a second is over the most of %i", framesPerSecond, GRAPHICS_MAX_FIXED_RATE);
+		return 0;
+	}
+	graphicsFixedRate = framesPerSecond;
+	graphicsFixedStart = graphicsNow;
+	graphicsFixedFrame = 0;
+	if (!framesPerSecond)
+	{
+		graphicsNow = SDL_GetTicks();
+	}
+	return 1;
+}
+
+/**
+ * @brief	moves the game's time up to the wall clock without holding for a frame, for loops that sleep waiting on events
+ *			instead. does nothing on a fixed timestep, where only graphics_next_frame advances the time.
+ * @return	the game's time after the update
+ */
+Uint32 graphics_update_time()
+{
+	if (!graphicsFixedRate)
+	{
+		graphicsNow = SDL_GetTicks();
+	}
+	return graphicsNow;
+}
+
 /**
  * @brief	getter for the game's renderer so the rest of the code can use it.
  * @return	a SDL_Renderer pointer used for all the game's rendering.
@@ -118,6 +182,20 @@ SDL_Renderer *graphics_get_renderer()
 	return graphicsRenderer;
 }
 
+/**
+ * @brief	checks if the game's renderer is SDL's software renderer, in which case the lightning should be drawn with the CPU rasterizer.
+ * @return	1 if the renderer is not hardware accelerated, 0 otherwise.
+ */
+int graphics_is_software()
+{
+	SDL_RendererInfo info;
+	if (!graphicsRenderer || SDL_GetRendererInfo(graphicsRenderer, &info) != 0)
+	{
+		return 0;
+	}
+	return (info.flags & SDL_RENDERER_SOFTWARE) ? 1 : 0;
+}
+
 /**
  * @brief	getter for the game's time
  * @return	the graphicsNow
@@ -0,0 +1,715 @@
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "simple_logger.h"
+
+#include "hittest.h"
+
+/**
+ * @brief allocates an empty tree
+ * @return the new tree, NULL if it could not be allocated
+ */
+HitTree *hit_tree_new()
+{
+	HitTree *tree = (HitTree *)malloc(sizeof(HitTree));
+	if(!tree)
+	{
+		slog("hit tree failed to allocate");
+		return NULL;
+	}
+	memset(tree, 0, sizeof(HitTree));
+	return tree;
+}
+
+/**
+ * @brief frees a tree and its arrays, and destroys the pointer to it
+ * @param tree [in,out]	the tree to free
+ */
+void hit_tree_free(HitTree **tree)
+{
+	HitTree *target;
+	if(!tree || !*tree)
+	{
+		return;
+	}
+	target = *tree;
+	free(target->nodes);
+	free(target->boxes);
+	free(target->order);
+	free(target->marks);
+	free(target->points);
+	free(target);
+	*tree = NULL;
+}
+
+/**
+ * @brief grows the tree's arrays to fit a number of items, a tree of n items never needs more than 2n nodes
+ * @param tree [in,out]	the tree
+ * @param items			how many items it will be built over
+ * @param points		how many points the bolt has, 0 for a scene
+ * @return 1 if everything fits, 0 if an array could not be grown
+ */
+static int hit_tree_reserve(HitTree *tree, int items, int points)
+{
+	HitNode *nodes;
+	HitBox *boxes;
+	int *order;
+	Uint32 *marks;
+	Vect2d *grown;
+	int grew = 0;
+
+	if(items > tree->maxItems)
+	{
+		nodes = (HitNode *)realloc(tree->nodes, sizeof(HitNode) * items * 2);
+		if(nodes)
+		{
+			tree->nodes = nodes;
+		}
+		boxes = (HitBox *)realloc(tree->boxes, sizeof(HitBox) * items);
+		if(boxes)
+		{
+			tree->boxes = boxes;
+		}
+		order = (int *)realloc(tree->order, sizeof(int) * items);
+		if(order)
+		{
+			tree->order = order;
+		}
+		marks = (Uint32 *)realloc(tree->marks, sizeof(Uint32) * items);
+		if(marks)
+		{
+			tree->marks = marks;
+			memset(tree->marks, 0, sizeof(Uint32) * items);
+			tree->query = 0;
+		}
+		if(!nodes || !boxes || !order || !marks)
+		{
+			slog("hit tree failed to grow to %i items", items);
+			return 0;
+		}
+		tree->maxItems = items;
+		grew = 1;
+	}
+	if(points > 0 && (grew || !tree->points))
+	{
+		/*bolt trees always have one more point than segments, so the points fit whenever the items do after this*/
+		grown = (Vect2d *)realloc(tree->points, sizeof(Vect2d) * (tree->maxItems + 1));
+		if(!grown)
+		{
+			slog("hit tree failed to grow to %i points", points);
+			return 0;
+		}
+		tree->points = grown;
+	}
+	return 1;
+}
+
+/**
+ * @brief grows a box to cover another
+ * @param box [in,out]	the box to grow
+ * @param other [in]	the box to cover
+ */
+static void hit_box_union(HitBox *box, HitBox *other)
+{
+	box->minX = MIN(box->minX, other->minX);
+	box->minY = MIN(box->minY, other->minY);
+	box->maxX = MAX(box->maxX, other->maxX);
+	box->maxY = MAX(box->maxY, other->maxY);
+}
+
+/**
+ * @brief checks if two boxes overlap, touching edges count the same as rect_intersect
+ */
+static int hit_box_overlap(HitBox *a, HitBox *b)
+{
+	return a->minX <= b->maxX && b->minX <= a->maxX && a->minY <= b->maxY && b->minY <= a->maxY;
+}
+
+/**
+ * @brief the squared distance from a point to a box, 0 if it is inside
+ */
+static float hit_box_distance2(HitBox *box, Vect2d point)
+{
+	float dx = MAX(MAX(box->minX - point.x, point.x - box->maxX), 0);
+	float dy = MAX(MAX(box->minY - point.y, point.y - box->maxY), 0);
+	return dx * dx + dy * dy;
+}
+
+/**
+ * @brief the box of the items a leaf refers to
+ */
+static HitBox hit_leaf_box(HitTree *tree, int first, int count)
+{
+	int i;
+	HitBox box = tree->boxes[tree->order[first]];
+
+	for(i = first + 1; i < first + count; i++)
+	{
+		hit_box_union(&box, &tree->boxes[tree->order[i]]);
+	}
+	return box;
+}
+
+/**
+ * @brief the center of an item's box along an axis, doubled since only the order matters
+ */
+static float hit_center(HitTree *tree, int item, int axis)
+{
+	HitBox *box = &tree->boxes[item];
+	return axis ? box->minY + box->maxY : box->minX + box->maxX;
+}
+
+/**
+ * @brief partly sorts a range of the order by the items' centers along the longer side of the range, so the nth item is where it
+ *			would be sorted, everything before it is no further along and everything after it is no nearer
+ * @param tree [in,out]	the tree
+ * @param first		start of the range
+ * @param count		how many items are in the range
+ * @param nth		which item of the range to put in place
+ */
+static void hit_select(HitTree *tree, int first, int count, int nth)
+{
+	int i, j, lo, hi, axis, swap;
+	float pivot;
+	HitBox centers;
+
+	centers.minX = centers.minY = FLT_MAX;
+	centers.maxX = centers.maxY = -FLT_MAX;
+	for(i = first; i < first + count; i++)
+	{
+		centers.minX = MIN(centers.minX, hit_center(tree, tree->order[i], 0));
+		centers.maxX = MAX(centers.maxX, hit_center(tree, tree->order[i], 0));
+		centers.minY = MIN(centers.minY, hit_center(tree, tree->order[i], 1));
+		centers.maxY = MAX(centers.maxY, hit_center(tree, tree->order[i], 1));
+	}
+	axis = centers.maxY - centers.minY > centers.maxX - centers.minX;
+
+	lo = first;
+	hi = first + count - 1;
+	nth += first;
+	while(lo < hi)
+	{
+		pivot = hit_center(tree, tree->order[(lo + hi) / 2], axis);
+		i = lo;
+		j = hi;
+		while(i <= j)
+		{
+			while(hit_center(tree, tree->order[i], axis) < pivot)
+			{
+				i++;
+			}
+			while(hit_center(tree, tree->order[j], axis) > pivot)
+			{
+				j--;
+			}
+			if(i <= j)
+			{
+				swap = tree->order[i];
+				tree->order[i] = tree->order[j];
+				tree->order[j] = swap;
+				i++;
+				j--;
+			}
+		}
+		if(nth <= j)
+		{
+			hi = j;
+		}
+		else if(nth >= i)
+		{
+			lo = i;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+/**
+ * @brief builds the node over a range of the order and everything under it, halving the range until it fits in a leaf
+ * @param tree [in,out]	the tree
+ * @param first		start of the range
+ * @param count		how many items are in the range
+ * @param split		if set the range is split at the median along its longer side, otherwise it is split in place
+ * @return the index of the node
+ */
+static int hit_build(HitTree *tree, int first, int count, int split)
+{
+	int index = tree->numNodes++;
+	int half, right = -1;
+	HitNode *node;
+
+	if(count > HIT_LEAF_SIZE)
+	{
+		half = count / 2;
+		if(split)
+		{
+			hit_select(tree, first, count, half);
+		}
+		hit_build(tree, first, half, split);
+		right = hit_build(tree, first + half, count - half, split);
+	}
+	node = &tree->nodes[index];
+	node->right = right;
+	node->first = first;
+	node->count = right < 0 ? count : 0;
+	if(right < 0)
+	{
+		node->box = hit_leaf_box(tree, first, count);
+	}
+	else
+	{
+		node->box = tree->nodes[index + 1].box;
+		hit_box_union(&node->box, &tree->nodes[right].box);
+	}
+	return index;
+}
+
+/**
+ * @brief recomputes every node's box from its items' boxes, children come after their parents so one backwards pass does it
+ * @param tree [in,out]	the tree
+ */
+static void hit_refit(HitTree *tree)
+{
+	int i;
+	HitNode *node;
+
+	for(i = tree->numNodes - 1; i >= 0; i--)
+	{
+		node = &tree->nodes[i];
+		if(node->right < 0)
+		{
+			node->box = hit_leaf_box(tree, node->first, node->count);
+		}
+		else
+		{
+			node->box = tree->nodes[i + 1].box;
+			hit_box_union(&node->box, &tree->nodes[node->right].box);
+		}
+	}
+}
+
+/**
+ * @brief copies the drawn points of a bolt into the tree and sets the box of each segment, grown by the bolt's radius
+ * @param tree [in,out]	the tree, already big enough
+ * @param bolt [in]		the bolt
+ * @param segments		how many segments are drawn
+ */
+static void hit_copy_bolt(HitTree *tree, Bolt *bolt, int segments)
+{
+	int i;
+	Vect2d a, b;
+
+	if(segments > 0)
+	{
+		memcpy(tree->points, bolt->points, sizeof(Vect2d) * (segments + 1));
+	}
+	tree->radius = bolt->thickness / 2;
+	for(i = 0; i < segments; i++)
+	{
+		a = tree->points[i];
+		b = tree->points[i + 1];
+		tree->boxes[i].minX = MIN(a.x, b.x) - tree->radius;
+		tree->boxes[i].minY = MIN(a.y, b.y) - tree->radius;
+		tree->boxes[i].maxX = MAX(a.x, b.x) + tree->radius;
+		tree->boxes[i].maxY = MAX(a.y, b.y) + tree->radius;
+	}
+	tree->bolt = bolt;
+	tree->version = bolt->version;
+	tree->rects = NULL;
+}
+
+/**
+ * @brief builds a tree over the segments of a bolt that are drawn
+ * @param tree [in,out]	the tree to build, its arrays are reused and grown if they are too small
+ * @param bolt [in]		the bolt
+ * @return 1 if the tree was built, 0 if its arrays could not be grown
+ */
+int hit_tree_build_bolt(HitTree *tree, Bolt *bolt)
+{
+	int i, segments;
+
+	tree->numNodes = 0;
+	tree->numItems = 0;
+	segments = MAX(lightning_bolt_drawn(bolt) - 1, 0);
+	if(!hit_tree_reserve(tree, MAX(segments, 1), segments + 1))
+	{
+		return 0;
+	}
+	hit_copy_bolt(tree, bolt, segments);
+	for(i = 0; i < segments; i++)
+	{
+		tree->order[i] = i;
+	}
+	tree->numItems = segments;
+	if(segments > 0)
+	{
+		/*consecutive segments are next to each other already, splitting along the bolt is as good as sorting*/
+		hit_build(tree, 0, segments, 0);
+	}
+	return 1;
+}
+
+/**
+ * @brief brings a bolt tree up to date with its bolt for as little as it can: nothing if the bolt hasn't changed since the tree was
+ *			built, refitting the boxes if the bolt has the same number of points drawn and rebuilding it otherwise
+ * @param tree [in,out]	the tree to update
+ * @param bolt [in]		the bolt, if it isn't the one the tree was built from the tree is rebuilt
+ * @return 1 if the tree is up to date, 0 if its arrays could not be grown
+ */
+int hit_tree_update_bolt(HitTree *tree, Bolt *bolt)
+{
+	int segments = MAX(lightning_bolt_drawn(bolt) - 1, 0);
+
+	if(tree->bolt != bolt || tree->numItems != segments || segments == 0)
+	{
+		return hit_tree_build_bolt(tree, bolt);
+	}
+	if(tree->version != bolt->version || tree->radius != bolt->thickness / 2)
+	{
+		hit_copy_bolt(tree, bolt, segments);
+		hit_refit(tree);
+	}
+	return 1;
+}
+
+/**
+ * @brief sets the box of every rectangle of a scene tree
+ */
+static void hit_copy_rects(HitTree *tree)
+{
+	int i;
+
+	for(i = 0; i < tree->numItems; i++)
+	{
+		tree->boxes[i].minX = tree->rects[i].x;
+		tree->boxes[i].minY = tree->rects[i].y;
+		tree->boxes[i].maxX = tree->rects[i].x + tree->rects[i].w;
+		tree->boxes[i].maxY = tree->rects[i].y + tree->rects[i].h;
+	}
+}
+
+/**
+ * @brief builds a tree over a scene's rectangles
+ * @param tree [in,out]	the tree to build, its arrays are reused and grown if they are too small
+ * @param rects [in]	the rectangles, kept by the tree so they must stay around as long as it does
+ * @param count			how many rectangles there are
+ * @return 1 if the tree was built, 0 if its arrays could not be grown
+ */
+int hit_tree_build_rects(HitTree *tree, SDL_Rect *rects, int count)
+{
+	int i;
+
+	tree->numNodes = 0;
+	tree->numItems = 0;
+	tree->bolt = NULL;
+	if(!hit_tree_reserve(tree, MAX(count, 1), 0))
+	{
+		return 0;
+	}
+	tree->rects = rects;
+	tree->numItems = count;
+	hit_copy_rects(tree);
+	for(i = 0; i < count; i++)
+	{
+		tree->order[i] = i;
+	}
+	if(count > 0)
+	{
+		hit_build(tree, 0, count, 1);
+	}
+	return 1;
+}
+
+/**
+ * @brief refits the boxes of a scene tree after its rectangles have moved, without changing how they are split. much cheaper than
+ *			building it again, but the tree gets slower to query the further the rectangles have moved since it was built
+ * @param tree [in,out]	the tree built over the rectangles
+ */
+void hit_tree_refit_rects(HitTree *tree)
+{
+	if(!tree->rects)
+	{
+		return;
+	}
+	hit_copy_rects(tree);
+	hit_refit(tree);
+}
+
+/**
+ * @brief checks if a segment crosses or is inside a box, by clipping it to the box
+ */
+static int hit_segment_crosses(Vect2d a, Vect2d b, HitBox *box)
+{
+	int i;
+	float p[4], q[4];
+	float r, t0 = 0, t1 = 1;
+
+	p[0] = a.x - b.x;	q[0] = a.x - box->minX;
+	p[1] = b.x - a.x;	q[1] = box->maxX - a.x;
+	p[2] = a.y - b.y;	q[2] = a.y - box->minY;
+	p[3] = b.y - a.y;	q[3] = box->maxY - a.y;
+	for(i = 0; i < 4; i++)
+	{
+		if(p[i] == 0)
+		{
+			if(q[i] < 0)
+			{
+				return 0;
+			}
+			continue;
+		}
+		r = q[i] / p[i];
+		if(p[i] < 0)
+		{
+			if(r > t1)
+			{
+				return 0;
+			}
+			t0 = MAX(t0, r);
+		}
+		else
+		{
+			if(r < t0)
+			{
+				return 0;
+			}
+			t1 = MIN(t1, r);
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief the closest point on a segment to a point
+ * @param a			start of the segment
+ * @param b			end of the segment
+ * @param point		the point
+ * @param closest [out]	the closest point on the segment
+ * @return the squared distance between them
+ */
+static float hit_segment_closest(Vect2d a, Vect2d b, Vect2d point, Vect2d *closest)
+{
+	float t, length2;
+	Vect2d ab, ap;
+
+	vect2d_subtract(b, a, ab);
+	vect2d_subtract(point, a, ap);
+	length2 = ab.x * ab.x + ab.y * ab.y;
+	t = length2 > 0 ? (ap.x * ab.x + ap.y * ab.y) / length2 : 0;
+	t = MAX(0, MIN(t, 1));
+	closest->x = a.x + ab.x * t;
+	closest->y = a.y + ab.y * t;
+	return (point.x - closest->x) * (point.x - closest->x) + (point.y - closest->y) * (point.y - closest->y);
+}
+
+/**
+ * @brief checks if a segment with a radius touches a box. if it doesn't cross the box the closest they get is between an end of the
+ *			segment and the box, or a corner of the box and the segment
+ */
+static int hit_segment_touches(Vect2d a, Vect2d b, float radius, HitBox *box)
+{
+	int i;
+	float radius2 = radius * radius;
+	Vect2d corner, closest;
+
+	if(hit_segment_crosses(a, b, box))
+	{
+		return 1;
+	}
+	if(radius <= 0)
+	{
+		return 0;
+	}
+	if(hit_box_distance2(box, a) <= radius2 || hit_box_distance2(box, b) <= radius2)
+	{
+		return 1;
+	}
+	for(i = 0; i < 4; i++)
+	{
+		corner = vect2d_new(i & 1 ? box->maxX : box->minX, i & 2 ? box->maxY : box->minY);
+		if(hit_segment_closest(a, b, corner, &closest) <= radius2)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief finds every rectangle of a scene that a bolt touches, counting the bolt's thickness
+ * @param bolt [in,out]		the bolt's tree
+ * @param scene [in,out]	the scene's tree, each rectangle is reported once however many segments touch it
+ * @param hits [out]		the indexes of the rectangles touched, in no particular order
+ * @param maxHits			how many indexes fit in hits, the rest are counted but not written
+ * @return how many rectangles the bolt touches
+ */
+int hit_bolt_rects(HitTree *bolt, HitTree *scene, int *hits, int maxHits)
+{
+	int i, j, s, r, rect, found = 0, top = 0;
+	int stack[HIT_STACK][2];
+	HitNode *a, *b;
+
+	if(!bolt->numNodes || !scene->numNodes)
+	{
+		return 0;
+	}
+	scene->query++;
+	if(scene->query == 0)
+	{
+		memset(scene->marks, 0, sizeof(Uint32) * scene->maxItems);
+		scene->query = 1;
+	}
+
+	stack[top][0] = 0;
+	stack[top][1] = 0;
+	top++;
+	while(top > 0)
+	{
+		top--;
+		i = stack[top][0];
+		j = stack[top][1];
+		a = &bolt->nodes[i];
+		b = &scene->nodes[j];
+		if(!hit_box_overlap(&a->box, &b->box))
+		{
+			continue;
+		}
+		if(a->right < 0 && b->right < 0)
+		{
+			for(s = a->first; s < a->first + a->count; s++)
+			{
+				for(r = b->first; r < b->first + b->count; r++)
+				{
+					rect = scene->order[r];
+					if(scene->marks[rect] == scene->query || !hit_box_overlap(&bolt->boxes[s], &scene->boxes[rect]))
+					{
+						continue;
+					}
+					if(hit_segment_touches(bolt->points[s], bolt->points[s + 1], bolt->radius, &scene->boxes[rect]))
+					{
+						scene->marks[rect] = scene->query;
+						if(found < maxHits)
+						{
+							hits[found] = rect;
+						}
+						found++;
+					}
+				}
+			}
+			continue;
+		}
+		if(top + 2 > HIT_STACK)
+		{
+			slog("hit test ran out of stack, some hits were missed");
+			break;
+		}
+		/*the bigger of the two is opened up, so both trees are walked down about as fast*/
+		if(b->right < 0 || (a->right >= 0 && (a->box.maxX - a->box.minX) * (a->box.maxY - a->box.minY) > (b->box.maxX - b->box.minX) * (b->box.maxY - b->box.minY)))
+		{
+			stack[top][0] = i + 1;
+			stack[top][1] = j;
+			stack[top + 1][0] = a->right;
+			stack[top + 1][1] = j;
+		}
+		else
+		{
+			stack[top][0] = i;
+			stack[top][1] = j + 1;
+			stack[top + 1][0] = i;
+			stack[top + 1][1] = b->right;
+		}
+		top += 2;
+	}
+	return found;
+}
+
+/**
+ * @brief finds the point along a bolt's segments closest to a point
+ * @param bolt [in]			the bolt's tree
+ * @param point				the point to measure from
+ * @param closest [out]		if non-null, set to the closest point on the bolt's center line
+ * @return the distance from point to the center line, the bolt's surface is the tree's radius closer. -1 if the tree is empty
+ */
+float hit_bolt_closest(HitTree *bolt, Vect2d point, Vect2d *closest)
+{
+	int i, s, near, far, top = 0;
+	int stack[HIT_STACK];
+	float best = FLT_MAX, distance;
+	Vect2d candidate, bestPoint = point;
+	HitNode *node;
+
+	if(!bolt->numNodes)
+	{
+		return -1;
+	}
+	stack[top++] = 0;
+	while(top > 0)
+	{
+		i = stack[--top];
+		node = &bolt->nodes[i];
+		if(hit_box_distance2(&node->box, point) >= best)
+		{
+			continue;
+		}
+		if(node->right < 0)
+		{
+			for(s = node->first; s < node->first + node->count; s++)
+			{
+				distance = hit_segment_closest(bolt->points[s], bolt->points[s + 1], point, &candidate);
+				if(distance < best)
+				{
+					best = distance;
+					bestPoint = candidate;
+				}
+			}
+			continue;
+		}
+		if(top + 2 > HIT_STACK)
+		{
+			slog("hit test ran out of stack, the closest point may be missed");
+			break;
+		}
+		/*the nearer child is pushed last so it is searched first and the farther one can usually be skipped*/
+		near = i + 1;
+		far = node->right;
+		if(hit_box_distance2(&bolt->nodes[far].box, point) < hit_box_distance2(&bolt->nodes[near].box, point))
+		{
+			near = node->right;
+			far = i + 1;
+		}
+		stack[top++] = far;
+		stack[top++] = near;
+	}
+	if(closest)
+	{
+		*closest = bestPoint;
+	}
+	return sqrt(best);
+}
+
+/**
+ * @brief finds the closest point along a bolt's segments for each of many points
+ * @param bolt [in]			the bolt's tree
+ * @param points [in]		the points to measure from
+ * @param count				how many points there are
+ * @param closest [out]		if non-null, set to the closest point on the bolt's center line for each point
+ * @param distances [out]	if non-null, set to the distance from each point to the center line, -1 if the tree is empty
+ */
+void hit_bolt_closest_points(HitTree *bolt, Vect2d *points, int count, Vect2d *closest, float *distances)
+{
+	int i;
+	float distance;
+
+	for(i = 0; i < count; i++)
+	{
+		distance = hit_bolt_closest(bolt, points[i], closest ? &closest[i] : NULL);
+		if(distances)
+		{
+			distances[i] = distance;
+		}
+	}
+}
\ No newline at end of file
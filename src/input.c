@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "input.h"
+
+static InputState inputState;
+
+/**
+ * @brief reads where the mouse starts so the first frame has something to aim at
+ */
+void input_init_system()
+{
+	memset(&inputState, 0, sizeof(InputState));
+	SDL_GetMouseState(&inputState.mouseX, &inputState.mouseY);
+
+	/*nothing reads these, so don't let them wake the loop up*/
+	SDL_EventState(SDL_TEXTINPUT, SDL_IGNORE);
+	SDL_EventState(SDL_TEXTEDITING, SDL_IGNORE);
+	SDL_EventState(SDL_KEYUP, SDL_IGNORE);
+	SDL_EventState(SDL_FINGERMOTION, SDL_IGNORE);
+	slog("input system initialized");
+}
+
+/**
+ * @brief folds one event into the input state
+ * @param event [in]	the event to handle
+ */
+static void input_handle_event(SDL_Event *event)
+{
+	inputState.events++;
+	switch(event->type)
+	{
+		case SDL_QUIT:
+			inputState.quit = 1;
+			break;
+		case SDL_KEYDOWN:
+			if(event->key.keysym.scancode == SDL_SCANCODE_ESCAPE)
+			{
+				inputState.quit = 1;
+			}
+			break;
+		case SDL_MOUSEMOTION:
+			/*only the last position matters, the bolt is aimed once per frame*/
+			inputState.mouseX = event->motion.x;
+			inputState.mouseY = event->motion.y;
+			inputState.moved = 1;
+			break;
+		case SDL_WINDOWEVENT:
+			switch(event->window.event)
+			{
+				case SDL_WINDOWEVENT_EXPOSED:
+				case SDL_WINDOWEVENT_SHOWN:
+				case SDL_WINDOWEVENT_RESTORED:
+				case SDL_WINDOWEVENT_SIZE_CHANGED:
+					inputState.redraw = 1;
+					break;
+			}
+			break;
+	}
+}
+
+/**
+ * @brief sleeps until an event arrives or the timeout runs out, then handles every event that is queued
+ * @param timeout	milliseconds to wait at most, 0 only handles what is already queued, negative waits until something happens
+ * @return the state of the input after the wait, the per wait flags only cover this wait
+ */
+InputState *input_wait(int timeout)
+{
+	SDL_Event event;
+
+	inputState.moved = 0;
+	inputState.redraw = 0;
+	inputState.events = 0;
+
+	if(timeout != 0)
+	{
+		if(timeout < 0 ? SDL_WaitEvent(&event) : SDL_WaitEventTimeout(&event, timeout))
+		{
+			input_handle_event(&event);
+		}
+	}
+	while(SDL_PollEvent(&event))
+	{
+		input_handle_event(&event);
+	}
+	return &inputState;
+}
+
+/**
+ * @brief getter for the input state without waiting
+ * @return the state left by the last input_wait
+ */
+InputState *input_get_state()
+{
+	return &inputState;
+}
\ No newline at end of file
@@ -0,0 +1,595 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "vector.h"
+#include "jobs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JOBS_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+ * @struct a worker's deque of jobs
+ * @brief the owner pushes and pops at the bottom, thieves take from the top. the lock is only ever contended when someone steals
+ */
+typedef struct JobDeque_t
+{
+	SDL_SpinLock lock;						/**< guards the deque */
+	int top;								/**< the oldest job, where thieves take from */
+	int bottom;								/**< one past the newest job, where the owner pushes and pops */
+	Job jobs[JOBS_DEQUE_SIZE];				/**< ring of jobs, indexed by top and bottom modulo JOBS_DEQUE_SIZE */
+}JobDeque;
+
+/**
+ * @struct a worker thread
+ * @brief the thread, its deque and its own random state for picking who to steal from
+ */
+typedef struct JobWorker_t
+{
+	SDL_Thread *thread;						/**< the thread, NULL for the calling thread's worker */
+	int index;								/**< which worker this is */
+	Uint32 random;							/**< xorshift state for picking victims */
+	JobDeque deque;							/**< the worker's jobs */
+}JobWorker;
+
+static JobWorker *jobWorkers = NULL;
+static int jobWorkerNum = 0;
+static SDL_TLSID jobWorkerKey = 0;
+static SDL_atomic_t jobQueued;				/* jobs sitting in any deque, so idle workers can look without locking */
+static SDL_atomic_t jobSleeping;			/* workers waiting on jobWake */
+static SDL_atomic_t jobQuit;
+static SDL_sem *jobWake = NULL;
+static int jobExitRegistered = 0;
+
+static void jobs_run(Job *job, int worker);
+
+/**
+ * @brief tells the cpu it is in a spin loop, so a hyperthreaded sibling gets the core while this one waits
+ */
+static void jobs_pause()
+{
+#ifdef JOBS_SSE2
+	_mm_pause();
+#endif
+}
+
+/**
+ * @brief adds a job to the bottom of a worker's deque and wakes a sleeping worker to take it
+ * @param job [in]	the job to copy in
+ * @param worker	whose deque to push onto
+ * @return 1 if the job was queued, 0 if the scheduler isn't running or the deque is full
+ */
+static int jobs_push(Job *job, int worker)
+{
+	JobDeque *deque;
+
+	if(!jobWorkers)
+	{
+		return 0;
+	}
+	deque = &jobWorkers[worker].deque;
+	SDL_AtomicLock(&deque->lock);
+	if(deque->bottom - deque->top >= JOBS_DEQUE_SIZE)
+	{
+		SDL_AtomicUnlock(&deque->lock);
+		return 0;
+	}
+	deque->jobs[deque->bottom & (JOBS_DEQUE_SIZE - 1)] = *job;
+	deque->bottom++;
+	SDL_AtomicUnlock(&deque->lock);
+
+	/*announced after the push, a worker going to sleep announces itself before it looks, so one of the two always sees the other*/
+	SDL_AtomicIncRef(&jobQueued);
+	if(SDL_AtomicGet(&jobSleeping) > 0)
+	{
+		SDL_SemPost(jobWake);
+	}
+	return 1;
+}
+
+/**
+ * @brief takes the newest job off the bottom of a worker's own deque
+ * @param worker	whose deque to pop from
+ * @param job [out]	the job taken
+ * @return 1 if a job was taken
+ */
+static int jobs_pop(int worker, Job *job)
+{
+	JobDeque *deque = &jobWorkers[worker].deque;
+	int found = 0;
+
+	SDL_AtomicLock(&deque->lock);
+	if(deque->bottom > deque->top)
+	{
+		deque->bottom--;
+		*job = deque->jobs[deque->bottom & (JOBS_DEQUE_SIZE - 1)];
+		found = 1;
+	}
+	SDL_AtomicUnlock(&deque->lock);
+	if(found)
+	{
+		SDL_AtomicAdd(&jobQueued, -1);
+	}
+	return found;
+}
+
+/**
+ * @brief takes the oldest job off the top of another worker's deque
+ * @param victim	whose deque to steal from
+ * @param job [out]	the job taken
+ * @return 1 if a job was taken
+ */
+static int jobs_steal(int victim, Job *job)
+{
+	JobDeque *deque = &jobWorkers[victim].deque;
+	int found = 0;
+
+	SDL_AtomicLock(&deque->lock);
+	if(deque->bottom > deque->top)
+	{
+		*job = deque->jobs[deque->top & (JOBS_DEQUE_SIZE - 1)];
+		deque->top++;
+		found = 1;
+	}
+	SDL_AtomicUnlock(&deque->lock);
+	if(found)
+	{
+		SDL_AtomicAdd(&jobQueued, -1);
+	}
+	return found;
+}
+
+/**
+ * @brief finds a job for a worker, its own newest first and then the oldest of a random other worker's
+ * @param worker	the worker looking
+ * @param job [out]	the job found
+ * @return 1 if a job was found
+ */
+static int jobs_find(int worker, Job *job)
+{
+	int i, victim;
+	Uint32 x;
+
+	if(jobs_pop(worker, job))
+	{
+		return 1;
+	}
+	if(SDL_AtomicGet(&jobQueued) <= 0)
+	{
+		return 0;
+	}
+	x = jobWorkers[worker].random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	jobWorkers[worker].random = x;
+	victim = x % jobWorkerNum;
+	for(i = 0; i < jobWorkerNum; i++, victim = (victim + 1) % jobWorkerNum)
+	{
+		if(victim != worker && jobs_steal(victim, job))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void jobs_queue(Job *job, int worker);
+
+/**
+ * @brief counts a job as done, if it was the last one the jobs held back on the counter are queued. the decrement happens under the
+ *			counter's lock and the unlock is the last time the counter is touched, since a waiter may return and drop it right after
+ * @param counter [in,out]	the job's counter, can be NULL
+ * @param worker			the worker that ran the job
+ */
+static void jobs_finish(JobCounter *counter, int worker)
+{
+	Job *job, *next;
+
+	if(!counter)
+	{
+		return;
+	}
+	SDL_AtomicLock(&counter->lock);
+	if(!SDL_AtomicDecRef(&counter->count))
+	{
+		SDL_AtomicUnlock(&counter->lock);
+		return;
+	}
+	job = counter->waiting;
+	counter->waiting = NULL;
+	SDL_AtomicUnlock(&counter->lock);
+	while(job)
+	{
+		next = job->next;
+		jobs_queue(job, worker);
+		free(job);
+		job = next;
+	}
+}
+
+/**
+ * @brief queues a job on the calling thread's deque, or runs it if it can't be queued
+ * @param job [in]	the job, its counter has already been incremented
+ * @param worker	the calling thread's worker, or -1
+ */
+static void jobs_queue(Job *job, int worker)
+{
+	if(jobs_push(job, worker >= 0 ? worker : 0))
+	{
+		return;
+	}
+	if(worker < 0 && jobWorkers)
+	{
+		/*only workers may run jobs, an outside thread waits for room instead*/
+		while(!jobs_push(job, 0))
+		{
+			SDL_Delay(0);
+		}
+		return;
+	}
+	jobs_run(job, worker >= 0 ? worker : 0);
+}
+
+/**
+ * @brief runs a job, first splitting the back half of its range off as new jobs until it is no longer than its grain
+ * @param job [in]	the job to run
+ * @param worker	the worker running it
+ */
+static void jobs_run(Job *job, int worker)
+{
+	Job piece = *job;
+	Job rest;
+
+	while(piece.grain > 0 && piece.end - piece.start > piece.grain)
+	{
+		rest = piece;
+		rest.start = piece.start + (piece.end - piece.start) / 2;
+		if(rest.counter)
+		{
+			SDL_AtomicIncRef(&rest.counter->count);
+		}
+		if(!jobs_push(&rest, worker))
+		{
+			/*no room to split, so this worker runs the whole range*/
+			jobs_finish(rest.counter, worker);
+			break;
+		}
+		piece.end = rest.start;
+	}
+	piece.function(piece.data, piece.start, piece.end, worker);
+	jobs_finish(piece.counter, worker);
+}
+
+/**
+ * @brief loop run by every worker thread, runs jobs while there are any, spins a while when there aren't, then sleeps until a job is queued
+ * @param data [in]	the JobWorker the thread owns
+ * @return 0 when the thread is told to quit
+ */
+static int jobs_worker_thread(void *data)
+{
+	JobWorker *worker = (JobWorker *)data;
+	Job job;
+	int idle = 0;
+
+	SDL_TLSSet(jobWorkerKey, worker, NULL);
+	while(1)
+	{
+		if(jobs_find(worker->index, &job))
+		{
+			jobs_run(&job, worker->index);
+			idle = 0;
+			continue;
+		}
+		if(SDL_AtomicGet(&jobQuit))
+		{
+			break;
+		}
+		if(++idle < JOBS_SPIN)
+		{
+			jobs_pause();
+			continue;
+		}
+		SDL_AtomicIncRef(&jobSleeping);
+		if(SDL_AtomicGet(&jobQueued) <= 0 && !SDL_AtomicGet(&jobQuit))
+		{
+			SDL_SemWait(jobWake);
+		}
+		SDL_AtomicAdd(&jobSleeping, -1);
+		idle = 0;
+	}
+	return 0;
+}
+
+/**
+ * @brief starts the workers, the calling thread becomes worker 0
+ * @param threads	how many workers to run including the calling thread, 0 uses one per cpu core
+ */
+void jobs_init_system(int threads)
+{
+	int i;
+
+	if(jobWorkers)
+	{
+		jobs_close_system();
+	}
+	if(threads <= 0)
+	{
+		threads = SDL_GetCPUCount();
+	}
+	threads = MAX(1, MIN(threads, JOBS_MAX_WORKERS));
+
+	jobWorkers = (JobWorker *)malloc(sizeof(JobWorker) * threads);
+	jobWake = SDL_CreateSemaphore(0);
+	if(!jobWorkerKey)
+	{
+		jobWorkerKey = SDL_TLSCreate();
+	}
+	if(!jobWorkers || !jobWake || !jobWorkerKey)
+	{
+		slog("job system failed to initialize");
+		jobs_close_system();
+		return;
+	}
+	memset(jobWorkers, 0, sizeof(JobWorker) * threads);
+	SDL_AtomicSet(&jobQueued, 0);
+	SDL_AtomicSet(&jobSleeping, 0);
+	SDL_AtomicSet(&jobQuit, 0);
+	for(i = 0; i < threads; i++)
+	{
+		jobWorkers[i].index = i;
+		jobWorkers[i].random = 0x9e3779b9 * (i + 1);
+	}
+	jobWorkerNum = threads;
+	SDL_TLSSet(jobWorkerKey, &jobWorkers[0], NULL);
+
+	for(i = 1; i < threads; i++)
+	{
+		jobWorkers[i].thread = SDL_CreateThread(jobs_worker_thread, "jobs", &jobWorkers[i]);
+		if(!jobWorkers[i].thread)
+		{
+			slog("failed to start job thread: %s", SDL_GetError());
+			jobWorkerNum = i;
+			break;
+		}
+	}
+	slog("job system running %i workers", jobWorkerNum);
+	if(!jobExitRegistered)
+	{
+		atexit(jobs_close_system);
+		jobExitRegistered = 1;
+	}
+}
+
+/**
+ * @brief finishes every queued job, then stops the workers
+ */
+void jobs_close_system()
+{
+	int i;
+	Job job;
+
+	if(jobWorkers)
+	{
+		/*anything still queued is run here so no counter is left waiting forever*/
+		while(jobs_find(0, &job))
+		{
+			jobs_run(&job, 0);
+		}
+		SDL_AtomicSet(&jobQuit, 1);
+		for(i = 1; i < jobWorkerNum; i++)
+		{
+			SDL_SemPost(jobWake);
+		}
+		for(i = 1; i < jobWorkerNum; i++)
+		{
+			SDL_WaitThread(jobWorkers[i].thread, NULL);
+		}
+		SDL_TLSSet(jobWorkerKey, NULL, NULL);
+		free(jobWorkers);
+		jobWorkers = NULL;
+	}
+	if(jobWake)
+	{
+		SDL_DestroySemaphore(jobWake);
+		jobWake = NULL;
+	}
+	jobWorkerNum = 0;
+}
+
+/**
+ * @brief getter for how many workers there are, size per worker scratch space with it
+ * @return the number of workers including the calling thread, 1 if the scheduler isn't running
+ */
+int jobs_get_worker_count()
+{
+	return MAX(jobWorkerNum, 1);
+}
+
+/**
+ * @brief getter for which worker the calling thread is
+ * @return the worker's index, -1 if the thread isn't one of the scheduler's, 0 if the scheduler isn't running
+ */
+int jobs_get_worker_index()
+{
+	JobWorker *worker;
+
+	if(!jobWorkers)
+	{
+		/*with no scheduler every job runs on the thread that submits it*/
+		return 0;
+	}
+	worker = (JobWorker *)SDL_TLSGet(jobWorkerKey);
+	return worker ? worker->index : -1;
+}
+
+/**
+ * @brief sets a counter to 0 with nothing held back on it, call before first use
+ * @param counter [out]	the counter
+ */
+void jobs_counter_init(JobCounter *counter)
+{
+	memset(counter, 0, sizeof(JobCounter));
+}
+
+/**
+ * @brief fills in a job and counts it on its counter
+ * @param job [out]			the job to fill
+ * @param function			what to run
+ * @param data [in,out]		passed to function
+ * @param start				first index of the range
+ * @param end				one past the last index of the range
+ * @param grain				longest piece to run, 0 never splits
+ * @param counter [in,out]	the job's counter, can be NULL
+ */
+static void jobs_make(Job *job, JobFunction function, void *data, int start, int end, int grain, JobCounter *counter)
+{
+	job->function = function;
+	job->data = data;
+	job->start = start;
+	job->end = end;
+	job->grain = grain;
+	job->counter = counter;
+	job->next = NULL;
+	if(counter)
+	{
+		SDL_AtomicIncRef(&counter->count);
+	}
+}
+
+/**
+ * @brief queues one job over a range, the range is run in one call
+ * @param function			what to run
+ * @param data [in,out]		passed to function
+ * @param start				first index of the range
+ * @param end				one past the last index of the range
+ * @param counter [in,out]	incremented now and decremented when the job is done, can be NULL
+ */
+void jobs_submit(JobFunction function, void *data, int start, int end, JobCounter *counter)
+{
+	Job job;
+	jobs_make(&job, function, data, start, end, 0, counter);
+	jobs_queue(&job, jobs_get_worker_index());
+}
+
+/**
+ * @brief queues a range that is split in half as it runs until the pieces are no longer than grain, so idle workers can steal them
+ * @param function			what to run on each piece
+ * @param data [in,out]		passed to function
+ * @param start				first index of the range
+ * @param end				one past the last index of the range
+ * @param grain				the longest piece function is called on, at least 1
+ * @param counter [in,out]	counts the pieces until they are all done, can be NULL
+ */
+void jobs_submit_range(JobFunction function, void *data, int start, int end, int grain, JobCounter *counter)
+{
+	Job job;
+	if(end <= start)
+	{
+		return;
+	}
+	jobs_make(&job, function, data, start, end, MAX(grain, 1), counter);
+	jobs_queue(&job, jobs_get_worker_index());
+}
+
+/**
+ * @brief holds a job back until a counter reaches 0, then queues it
+ * @param dependency [in,out]	the counter to wait for, if it is already 0 the job is queued right away
+ * @param function				what to run
+ * @param data [in,out]			passed to function
+ * @param start					first index of the range
+ * @param end					one past the last index of the range
+ * @param counter [in,out]		incremented now and decremented when the job is done, can be NULL
+ */
+void jobs_submit_after(JobCounter *dependency, JobFunction function, void *data, int start, int end, JobCounter *counter)
+{
+	Job *job;
+
+	job = (Job *)malloc(sizeof(Job));
+	if(!job)
+	{
+		slog("held back job failed to allocate, waiting for its dependency instead");
+		jobs_wait(dependency);
+		jobs_submit(function, data, start, end, counter);
+		return;
+	}
+	jobs_make(job, function, data, start, end, 0, counter);
+
+	/*the count is checked under the lock, the last job to finish decrements it under the lock so it can't miss this job*/
+	SDL_AtomicLock(&dependency->lock);
+	if(SDL_AtomicGet(&dependency->count) > 0)
+	{
+		job->next = dependency->waiting;
+		dependency->waiting = job;
+		job = NULL;
+	}
+	SDL_AtomicUnlock(&dependency->lock);
+	if(job)
+	{
+		jobs_queue(job, jobs_get_worker_index());
+		free(job);
+	}
+}
+
+/**
+ * @brief runs queued jobs until a counter reaches 0, threads that aren't workers sleep instead. the counter can be dropped as soon as
+ *			this returns
+ * @param counter [in]	the counter to wait for
+ */
+void jobs_wait(JobCounter *counter)
+{
+	int worker = jobs_get_worker_index();
+	int idle = 0;
+	Job job;
+
+	while(SDL_AtomicGet(&counter->count) > 0)
+	{
+		if(worker >= 0 && jobWorkers && jobs_find(worker, &job))
+		{
+			jobs_run(&job, worker);
+			idle = 0;
+			continue;
+		}
+		/*whatever is left is running on other workers, spin a while since it is usually about to finish*/
+		if(worker >= 0 && ++idle < JOBS_SPIN)
+		{
+			jobs_pause();
+			continue;
+		}
+		SDL_Delay(worker >= 0 ? 0 : 1);
+	}
+	/*the last job to finish still holds the lock until it is done with the counter, so wait for it to let go*/
+	SDL_AtomicLock(&counter->lock);
+	SDL_AtomicUnlock(&counter->lock);
+}
+
+/**
+ * @brief runs function over a range on every worker and returns once it is all done
+ * @param function			what to run on each piece
+ * @param data [in,out]		passed to function
+ * @param start				first index of the range
+ * @param end				one past the last index of the range
+ * @param grain				the longest piece function is called on, at least 1
+ */
+void jobs_parallel_for(JobFunction function, void *data, int start, int end, int grain)
+{
+	JobCounter counter;
+
+	if(end <= start)
+	{
+		return;
+	}
+	if(jobWorkerNum <= 1 && jobs_get_worker_index() == 0)
+	{
+		/*nothing to share the range with*/
+		function(data, start, end, 0);
+		return;
+	}
+	jobs_counter_init(&counter);
+	jobs_submit_range(function, data, start, end, grain, &counter);
+	jobs_wait(&counter);
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "lightning.h"
+#include "jobs.h"
+
+#define JOBS_BENCH_EMPTY		1000000		/**< how many empty jobs are run to measure the cost of scheduling one */
+
+#define JOBS_BENCH_BOLTS		4000		/**< how many bolts the scaling run generates for every worker count */
+
+/**
+ * @struct scratch space of a worker generating bolts for the benchmark
+ * @brief padded out to its own cache lines so workers don't share them
+ */
+typedef struct JobsBenchWorker_t
+{
+	Vect2d *points;							/**< points of the bolt being generated */
+	int maxPoints;							/**< how many points fit in points */
+	Uint64 segments;						/**< how many segments the worker has generated */
+	Uint8 padding[64];						/**< keeps the next worker's scratch off this one's cache line */
+}JobsBenchWorker;
+
+static JobsBenchWorker *benchWorkers = NULL;
+
+/**
+ * @brief a job that does nothing, so all that is timed is the scheduling
+ * @param data		unused
+ * @param start		unused
+ * @param end		unused
+ * @param worker	unused
+ */
+static void jobs_bench_empty(void *data, int start, int end, int worker)
+{
+}
+
+/**
+ * @brief a job that generates a range of bolts across the screen, each with its own random state so every run makes the same bolts
+ * @param data		unused
+ * @param start		first bolt
+ * @param end		one past the last bolt
+ * @param worker	index of the worker running it
+ */
+static void jobs_bench_bolts(void *data, int start, int end, int worker)
+{
+	int i, numPoints;
+	Uint32 state;
+	JobsBenchWorker *scratch = &benchWorkers[worker];
+
+	for(i = start; i < end; i++)
+	{
+		state = 0x9e3779b9 * (i + 1);
+		numPoints = lightning_generate(vect2d_new(100, 300), vect2d_new(WINDOW_WIDTH - 100, WINDOW_HEIGHT / 2), 3, &state, &scratch->points, &scratch->maxPoints);
+		scratch->segments += MAX(numPoints - 1, 0);
+	}
+}
+
+/**
+ * @brief seconds since a performance counter reading
+ * @param counter	the earlier reading
+ * @return the seconds that have passed
+ */
+static double jobs_bench_seconds(Uint64 counter)
+{
+	return (double)(SDL_GetPerformanceCounter() - counter) / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief measures what scheduling costs per job and how a fixed amount of bolt generation scales from 1 worker up to threads,
+ *			restarting the scheduler for each worker count, and logs the results
+ * @param threads	the most workers to measure, 0 uses one per cpu core
+ */
+void jobs_benchmark(int threads)
+{
+	int i, workers;
+	Uint64 counter, segments;
+	double seconds, single = 0;
+	JobCounter done;
+
+	if(threads <= 0)
+	{
+		threads = SDL_GetCPUCount();
+	}
+	threads = MAX(1, MIN(threads, JOBS_MAX_WORKERS));
+
+	jobs_init_system(threads);
+	jobs_counter_init(&done);
+	counter = SDL_GetPerformanceCounter();
+	for(i = 0; i < JOBS_BENCH_EMPTY; i++)
+	{
+		jobs_submit(jobs_bench_empty, NULL, i, i + 1, &done);
+		if((i & (JOBS_DEQUE_SIZE / 2 - 1)) == 0)
+		{
+			/*drained now and then so the deque never fills and jobs stay queued instead of running inline*/
+			jobs_wait(&done);
+		}
+	}
+	jobs_wait(&done);
+	seconds = jobs_bench_seconds(counter);
+	slog("job benchmark: %i single jobs on %i workers, %.1f ns per job", JOBS_BENCH_EMPTY, jobs_get_worker_count(), seconds * 1e9 / JOBS_BENCH_EMPTY);
+
+	counter = SDL_GetPerformanceCounter();
+	jobs_parallel_for(jobs_bench_empty, NULL, 0, JOBS_BENCH_EMPTY, 1);
+	seconds = jobs_bench_seconds(counter);
+	slog("job benchmark: parallel for over %i indexes split to 1, %.1f ns per piece", JOBS_BENCH_EMPTY, seconds * 1e9 / JOBS_BENCH_EMPTY);
+
+	/*1, 2, 4 and so on up to threads*/
+	for(workers = 1; ; workers = MIN(workers * 2, threads))
+	{
+		jobs_init_system(workers);
+		benchWorkers = (JobsBenchWorker *)malloc(sizeof(JobsBenchWorker) * jobs_get_worker_count());
+		if(!benchWorkers)
+		{
+			slog("job benchmark failed to allocate");
+			break;
+		}
+		memset(benchWorkers, 0, sizeof(JobsBenchWorker) * jobs_get_worker_count());
+
+		counter = SDL_GetPerformanceCounter();
+		jobs_parallel_for(jobs_bench_bolts, NULL, 0, JOBS_BENCH_BOLTS, 16);
+		seconds = jobs_bench_seconds(counter);
+
+		segments = 0;
+		for(i = 0; i < jobs_get_worker_count(); i++)
+		{
+			segments += benchWorkers[i].segments;
+			free(benchWorkers[i].points);
+		}
+		free(benchWorkers);
+		benchWorkers = NULL;
+		if(workers == 1)
+		{
+			single = seconds;
+		}
+		slog("job benchmark: %i bolts, %.0f segments on %i workers in %f seconds, %.2fx the speed of 1 worker",
+			JOBS_BENCH_BOLTS, (double)segments, jobs_get_worker_count(), seconds, single / seconds);
+		if(workers == threads)
+		{
+			break;
+		}
+	}
+	jobs_close_system();
+}
\ No newline at end of file
@@ -0,0 +1,713 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "laplacian.h"
+
+#define LAPLACIAN_RADIUS		(LAPLACIAN_STEP * 0.5f)	/**< radius of a point charge, its potential is 0 at this distance */
+
+#define LAPLACIAN_MAX_DEPTH		24			/**< deepest the quadtree splits, charges closer than the leaves at this depth share a leaf */
+
+#define LAPLACIAN_LATTICE_BITS	16			/**< bits of a lattice position along each axis, positions further than this from the start wrap */
+
+#define LAPLACIAN_LATTICE_START	0x5555		/**< lattice position of the start along each axis, alternating bits keep it off the edges of the big squares */
+
+#define LAPLACIAN_LEAF_BITS		2			/**< a leaf of the site tree is a square 1 << LAPLACIAN_LEAF_BITS lattice positions wide */
+
+#define LAPLACIAN_LEAF_SIZE		(1 << LAPLACIAN_LEAF_BITS)
+
+#define LAPLACIAN_LEAF_SITES	(LAPLACIAN_LEAF_SIZE * LAPLACIAN_LEAF_SIZE)
+
+#define LAPLACIAN_ROOT_LEVEL	(LAPLACIAN_LATTICE_BITS - LAPLACIAN_LEAF_BITS)	/**< level of the site tree's root, leaves are level 0 */
+
+#define LAPLACIAN_MOMENTS		(LAPLACIAN_ETA + 1)	/**< the powers of the potential the site tree sums, enough to weigh a square at any offset */
+
+/**
+ * @struct a square of the Barnes-Hut quadtree
+ * @brief the total charge in the square and where its center of charge is, so far away squares can be treated as one charge
+ */
+typedef struct LaplacianNode_t
+{
+	Vect2d center;							/**< center of the square */
+	float halfSize;							/**< half the width of the square */
+	Vect2d sum;								/**< sum of the positions of every charge in the square */
+	int count;								/**< how many charges are in the square */
+	int children;							/**< index of the first of the four child squares, -1 for a leaf */
+}LaplacianNode;
+
+/**
+ * @struct a square of the site tree, the quadtree of growth sites on the lattice
+ * @brief sums up the sites in the square so the square can be weighed and picked from without visiting them. a far away charge's
+ *			potential is added to the whole square through pending instead of to each site, and since the weight of a site is its
+ *			potential over the lowest raised to LAPLACIAN_ETA, the powers of the potentials over the square's lowest are enough to
+ *			weigh the square against any lowest potential
+ */
+typedef struct LaplacianCell_t
+{
+	int parent;								/**< index of the square this is a quarter of, -1 for the root */
+	int children[4];						/**< index of each quarter, -1 if no site has been in it. unused by leaves */
+	int leaf;								/**< index of the sites of a level 0 square, -1 for the rest */
+	int level;								/**< 0 for the leaves, each level up is twice as wide */
+	int x, y;								/**< which square of its level this is, counted from the lattice's corner */
+	int dirty;								/**< set when the square's sites changed and low and moments have to be worked out again */
+	double pending;							/**< potential added to every site in the square that the sites and quarters don't have */
+	double low;								/**< lowest potential of a site in the square, counting pending but not the squares above */
+	double moments[LAPLACIAN_MOMENTS];		/**< moments[k] is the sum of every site's potential over low to the k, so moments[0] counts them */
+}LaplacianCell;
+
+/**
+ * @struct the lattice positions of a level 0 square of the site tree
+ * @brief which of them are growth sites or channel, and the potential of each site
+ */
+typedef struct LaplacianLeaf_t
+{
+	float sum[LAPLACIAN_LEAF_SITES];		/**< potential at each site, less the pending of the leaf and every square above it */
+	int parent[LAPLACIAN_LEAF_SITES];		/**< index of the channel point each site is next to */
+	Uint16 sites;							/**< bit i is set when position i is a growth site, x is the low bits of i and y the high */
+	Uint16 channel;							/**< bit i is set when position i is part of the channel */
+}LaplacianLeaf;
+
+/* channel */
+static Vect2d *channelSite = NULL;			/* lattice position of each point, used for the potential */
+static Vect2d *channelPoint = NULL;			/* jittered position of each point, used for drawing */
+static int *channelParent = NULL;
+static Lightning **channelSegment = NULL;
+static int channelNum = 0;
+static int channelMax = 0;
+
+/* site tree, cell 0 is the root */
+static LaplacianCell *cellList = NULL;
+static int cellNum = 0;
+static int cellMax = 0;
+static LaplacianLeaf *leafList = NULL;
+static int leafNum = 0;
+static int leafMax = 0;
+static int siteNum = 0;
+static Vect2d siteOrigin;					/* where lattice position 0, 0 is, the start of the bolt */
+static double siteBinomial[LAPLACIAN_MOMENTS][LAPLACIAN_MOMENTS];
+
+/* quadtree */
+static LaplacianNode *nodeList = NULL;
+static int nodeNum = 0;
+static int nodeMax = 0;
+
+/**
+ * @brief initializes the laplacian growth generator
+ * @param maxPoints		the most points a bolt can grow to, 0 uses LAPLACIAN_MAX_POINTS. a bolt makes one segment in the lightningList
+ *						per point, so it needs to fit there as well
+ */
+void laplacian_init_system(int maxPoints)
+{
+	int n, k;
+	if(maxPoints <= 0)
+	{
+		maxPoints = LAPLACIAN_MAX_POINTS;
+	}
+	/*the channel is connected, so its sites fill the leaves they touch. a bolt uses about one leaf for every five points and a
+	  straight line under one a point, and the squares above the leaves come to about half as many again. a site past the end
+	  of the pools is left empty*/
+	leafMax = maxPoints + 8;
+	cellMax = leafMax * 2 + LAPLACIAN_ROOT_LEVEL * 4;
+
+	channelSite = (Vect2d *)malloc(sizeof(Vect2d) * maxPoints);
+	channelPoint = (Vect2d *)malloc(sizeof(Vect2d) * maxPoints);
+	channelParent = (int *)malloc(sizeof(int) * maxPoints);
+	channelSegment = (Lightning **)malloc(sizeof(Lightning *) * maxPoints);
+	cellList = (LaplacianCell *)malloc(sizeof(LaplacianCell) * cellMax);
+	leafList = (LaplacianLeaf *)malloc(sizeof(LaplacianLeaf) * leafMax);
+	nodeMax = maxPoints * 4 + 1;
+	nodeList = (LaplacianNode *)malloc(sizeof(LaplacianNode) * nodeMax);
+	if(!channelSite || !channelPoint || !channelParent || !channelSegment || !cellList || !leafList || !nodeList)
+	{
+		slog("laplacian growth failed to initialize");
+		laplacian_close_system();
+		return;
+	}
+	for(n = 0; n < LAPLACIAN_MOMENTS; n++)
+	{
+		siteBinomial[n][0] = siteBinomial[n][n] = 1;
+		for(k = 1; k < n; k++)
+		{
+			siteBinomial[n][k] = siteBinomial[n - 1][k - 1] + siteBinomial[n - 1][k];
+		}
+	}
+	channelMax = maxPoints;
+	atexit(laplacian_close_system);
+}
+
+/**
+ * @brief frees the laplacian growth generator's buffers
+ */
+void laplacian_close_system()
+{
+	free(channelSite);
+	free(channelPoint);
+	free(channelParent);
+	free(channelSegment);
+	free(cellList);
+	free(leafList);
+	free(nodeList);
+	channelSite = channelPoint = NULL;
+	channelParent = NULL;
+	channelSegment = NULL;
+	cellList = NULL;
+	leafList = NULL;
+	nodeList = NULL;
+	cellMax = leafMax = 0;
+	channelMax = 0;
+}
+
+/**
+ * @brief adds a charge to the quadtree, splitting leaves until it has a square of its own
+ * @param point		position of the charge
+ */
+static void laplacian_tree_insert(Vect2d point)
+{
+	int i, depth, node = 0;
+	int quadrant;
+	LaplacianNode *n, *child;
+	Vect2d old;
+
+	for(depth = 0; ; depth++)
+	{
+		n = &nodeList[node];
+		if(n->children < 0)
+		{
+			if(n->count == 0 || depth >= LAPLACIAN_MAX_DEPTH || nodeNum + 4 > nodeMax)
+			{
+				n->count++;
+				vect2d_add(n->sum, point, n->sum);
+				return;
+			}
+			/*split the leaf and push its one charge down into the child square it falls in*/
+			n->children = nodeNum;
+			for(i = 0; i < 4; i++)
+			{
+				child = &nodeList[nodeNum++];
+				memset(child, 0, sizeof(LaplacianNode));
+				child->halfSize = n->halfSize * 0.5f;
+				child->center.x = n->center.x + ((i & 1) ? child->halfSize : -child->halfSize);
+				child->center.y = n->center.y + ((i & 2) ? child->halfSize : -child->halfSize);
+				child->children = -1;
+			}
+			old = n->sum;
+			quadrant = (old.x >= n->center.x) | ((old.y >= n->center.y) << 1);
+			nodeList[n->children + quadrant].count = 1;
+			nodeList[n->children + quadrant].sum = old;
+		}
+		n->count++;
+		vect2d_add(n->sum, point, n->sum);
+		node = n->children + ((point.x >= n->center.x) | ((point.y >= n->center.y) << 1));
+	}
+}
+
+/**
+ * @brief sums the potential of every charge in the quadtree at a point, squares that are small for their distance count as one charge
+ * @param point		where to find the potential
+ * @return the summed potential
+ */
+static float laplacian_tree_potential(Vect2d point)
+{
+	int stack[LAPLACIAN_MAX_DEPTH * 3 + 4];
+	int top = 0;
+	int i;
+	float sum = 0;
+	float dx, dy, d2;
+	LaplacianNode *n;
+
+	stack[top++] = 0;
+	while(top > 0)
+	{
+		n = &nodeList[stack[--top]];
+		if(n->count == 0)
+		{
+			continue;
+		}
+		dx = point.x - n->sum.x / n->count;
+		dy = point.y - n->sum.y / n->count;
+		d2 = dx * dx + dy * dy;
+		if(n->children < 0 || 4 * n->halfSize * n->halfSize < LAPLACIAN_THETA * LAPLACIAN_THETA * d2)
+		{
+			sum += n->count * (1 - LAPLACIAN_RADIUS / sqrtf(MAX(d2, LAPLACIAN_RADIUS * LAPLACIAN_RADIUS)));
+			continue;
+		}
+		for(i = 0; i < 4; i++)
+		{
+			stack[top++] = n->children + i;
+		}
+	}
+	return sum;
+}
+
+
+/**
+ * @brief adds an empty square to the site tree
+ * @param parent	index of the square it is a quarter of, -1 for the root
+ * @param level		0 for a leaf
+ * @param x			which square of its level it is along x
+ * @param y			which square of its level it is along y
+ * @return index of the square, -1 if the tree is full
+ */
+static int laplacian_cell_new(int parent, int level, int x, int y)
+{
+	int i;
+	LaplacianCell *cell;
+	if(cellNum >= cellMax || (level == 0 && leafNum >= leafMax))
+	{
+		return -1;
+	}
+	cell = &cellList[cellNum];
+	memset(cell, 0, sizeof(LaplacianCell));
+	cell->parent = parent;
+	for(i = 0; i < 4; i++)
+	{
+		cell->children[i] = -1;
+	}
+	cell->leaf = -1;
+	cell->level = level;
+	cell->x = x;
+	cell->y = y;
+	if(level == 0)
+	{
+		cell->leaf = leafNum;
+		memset(&leafList[leafNum++], 0, sizeof(LaplacianLeaf));
+	}
+	return cellNum++;
+}
+
+/**
+ * @brief marks a square and every square above it as changed, stopping at the first one already marked since the ones above it are too
+ * @param cell	index of the square
+ */
+static void laplacian_cell_dirty(int cell)
+{
+	while(cell >= 0 && !cellList[cell].dirty)
+	{
+		cellList[cell].dirty = 1;
+		cell = cellList[cell].parent;
+	}
+}
+
+/**
+ * @brief finds the leaf of the site tree a lattice position is in
+ * @param ux		lattice x, counted from the lattice's corner
+ * @param uy		lattice y, counted from the lattice's corner
+ * @param create	if the leaf and the squares above it should be added when missing
+ * @param pending [out]	the pending potential of the leaf and every square above it, added to what is already there
+ * @return index of the leaf's square, -1 if it is missing or the tree is full
+ */
+static int laplacian_cell_find(int ux, int uy, int create, double *pending)
+{
+	int level, quadrant, shift;
+	int cell = 0, child;
+
+	for(level = LAPLACIAN_ROOT_LEVEL; level > 0; level--)
+	{
+		*pending += cellList[cell].pending;
+		shift = LAPLACIAN_LEAF_BITS + level - 1;
+		quadrant = ((ux >> shift) & 1) | (((uy >> shift) & 1) << 1);
+		child = cellList[cell].children[quadrant];
+		if(child < 0)
+		{
+			if(!create)
+			{
+				return -1;
+			}
+			child = laplacian_cell_new(cell, level - 1, ux >> shift, uy >> shift);
+			if(child < 0)
+			{
+				return -1;
+			}
+			cellList[cell].children[quadrant] = child;
+		}
+		cell = child;
+	}
+	*pending += cellList[cell].pending;
+	return cell;
+}
+
+/**
+ * @brief adds the potential of a new charge to every growth site. squares of the site tree that are small for their distance get it once
+ *			through their pending potential, the rest are split down to the sites
+ * @param cell		index of the square to add it to, 0 for the whole tree
+ * @param point		position of the new charge
+ */
+static void laplacian_cell_charge(int cell, Vect2d point)
+{
+	int i;
+	float width, first, dx, dy, d2, potential;
+	LaplacianCell *c = &cellList[cell];
+	LaplacianLeaf *leaf;
+
+	if(!c->dirty && c->moments[0] == 0)
+	{
+		return;
+	}
+	width = (float)(LAPLACIAN_LEAF_SIZE << c->level);
+	first = (float)((c->x * LAPLACIAN_LEAF_SIZE) << c->level) - LAPLACIAN_LATTICE_START + (width - 1) * 0.5f;
+	dx = siteOrigin.x + first * LAPLACIAN_STEP - point.x;
+	first = (float)((c->y * LAPLACIAN_LEAF_SIZE) << c->level) - LAPLACIAN_LATTICE_START + (width - 1) * 0.5f;
+	dy = siteOrigin.y + first * LAPLACIAN_STEP - point.y;
+	d2 = dx * dx + dy * dy;
+	width *= LAPLACIAN_STEP;
+	if(width * width < LAPLACIAN_THETA * LAPLACIAN_THETA * d2)
+	{
+		potential = 1 - LAPLACIAN_RADIUS / sqrtf(d2);
+		c->pending += potential;
+		c->low += potential;
+		return;
+	}
+	c->dirty = 1;
+	if(c->leaf < 0)
+	{
+		for(i = 0; i < 4; i++)
+		{
+			if(c->children[i] >= 0)
+			{
+				laplacian_cell_charge(c->children[i], point);
+			}
+		}
+		return;
+	}
+	/*sites are never closer than one step to a charge, the charge's own position is channel*/
+	leaf = &leafList[c->leaf];
+	for(i = 0; i < LAPLACIAN_LEAF_SITES; i++)
+	{
+		if(!(leaf->sites & (1 << i)))
+		{
+			continue;
+		}
+		dx = siteOrigin.x + (float)(((c->x << LAPLACIAN_LEAF_BITS) | (i & (LAPLACIAN_LEAF_SIZE - 1))) - LAPLACIAN_LATTICE_START) * LAPLACIAN_STEP - point.x;
+		dy = siteOrigin.y + (float)(((c->y << LAPLACIAN_LEAF_BITS) | (i >> LAPLACIAN_LEAF_BITS)) - LAPLACIAN_LATTICE_START) * LAPLACIAN_STEP - point.y;
+		leaf->sum[i] += 1 - LAPLACIAN_RADIUS / sqrtf(dx * dx + dy * dy);
+	}
+}
+
+/**
+ * @brief works out the lowest potential and the moments again for a changed square and every changed square below it
+ * @param cell	index of the square
+ */
+static void laplacian_cell_refresh(int cell)
+{
+	int i, j, k;
+	double low, value, power;
+	double powers[LAPLACIAN_MOMENTS];
+	LaplacianCell *c = &cellList[cell];
+	LaplacianCell *child;
+	LaplacianLeaf *leaf;
+
+	if(!c->dirty)
+	{
+		return;
+	}
+	c->dirty = 0;
+	memset(c->moments, 0, sizeof(c->moments));
+	low = DBL_MAX;
+	if(c->leaf >= 0)
+	{
+		leaf = &leafList[c->leaf];
+		for(i = 0; i < LAPLACIAN_LEAF_SITES; i++)
+		{
+			if(leaf->sites & (1 << i))
+			{
+				low = MIN(low, leaf->sum[i]);
+			}
+		}
+		for(i = 0; i < LAPLACIAN_LEAF_SITES; i++)
+		{
+			if(!(leaf->sites & (1 << i)))
+			{
+				continue;
+			}
+			value = leaf->sum[i] - low;
+			power = 1;
+			for(k = 0; k < LAPLACIAN_MOMENTS; k++)
+			{
+				c->moments[k] += power;
+				power *= value;
+			}
+		}
+		c->low = low + c->pending;
+		return;
+	}
+	for(i = 0; i < 4; i++)
+	{
+		if(c->children[i] >= 0)
+		{
+			laplacian_cell_refresh(c->children[i]);
+			child = &cellList[c->children[i]];
+			if(child->moments[0] > 0)
+			{
+				low = MIN(low, child->low);
+			}
+		}
+	}
+	/*move each quarter's moments from its lowest potential to this square's, (v - low)^k expands binomially in the difference*/
+	for(i = 0; i < 4; i++)
+	{
+		if(c->children[i] < 0 || cellList[c->children[i]].moments[0] == 0)
+		{
+			continue;
+		}
+		child = &cellList[c->children[i]];
+		if(child->low == low)
+		{
+			for(k = 0; k < LAPLACIAN_MOMENTS; k++)
+			{
+				c->moments[k] += child->moments[k];
+			}
+			continue;
+		}
+		powers[0] = 1;
+		for(k = 1; k < LAPLACIAN_MOMENTS; k++)
+		{
+			powers[k] = powers[k - 1] * (child->low - low);
+		}
+		for(k = 0; k < LAPLACIAN_MOMENTS; k++)
+		{
+			for(j = 0; j <= k; j++)
+			{
+				c->moments[k] += siteBinomial[k][j] * powers[k - j] * child->moments[j];
+			}
+		}
+	}
+	c->low = low + c->pending;
+}
+
+/**
+ * @brief weighs every site in a square at once
+ * @param cell		the square, its moments up to date
+ * @param offset	how far the square's lowest potential is over the lowest of any site
+ * @return the sum of each site's potential over the lowest of any site, raised to LAPLACIAN_ETA
+ */
+static double laplacian_cell_weight(LaplacianCell *cell, double offset)
+{
+	int k;
+	double power = 1, weight = 0;
+	for(k = LAPLACIAN_ETA; k >= 0; k--)
+	{
+		weight += siteBinomial[LAPLACIAN_ETA][k] * power * cell->moments[k];
+		power *= offset;
+	}
+	return weight;
+}
+
+/**
+ * @brief picks the next growth site, weighing each by its potential over the lowest raised to LAPLACIAN_ETA as in the grid model.
+ *			the grid model also divides by the range of the potentials, which scales every weight the same and so is left out.
+ *			the pick walks down the site tree weighing four squares a level, so it never visits the sites it passes over
+ * @param bit [out]	which position of the leaf was picked
+ * @return index of the leaf's square
+ */
+static int laplacian_pick_site(int *bit)
+{
+	int i, e, next, cell = 0;
+	double base, choice, weight, shift = 0, value;
+	LaplacianCell *child;
+	LaplacianLeaf *leaf;
+
+	*bit = 0;
+	laplacian_cell_refresh(0);
+	base = cellList[0].low;
+	choice = ((double)rand() / (double)RAND_MAX) * cellList[0].moments[LAPLACIAN_ETA];
+	while(cellList[cell].leaf < 0)
+	{
+		shift += cellList[cell].pending;
+		next = -1;
+		for(i = 0; i < 4; i++)
+		{
+			if(cellList[cell].children[i] < 0 || cellList[cellList[cell].children[i]].moments[0] == 0)
+			{
+				continue;
+			}
+			next = cellList[cell].children[i];
+			child = &cellList[next];
+			weight = laplacian_cell_weight(child, child->low + shift - base);
+			choice -= weight;
+			if(choice <= 0)
+			{
+				choice += weight;
+				break;
+			}
+		}
+		cell = next;
+	}
+	shift += cellList[cell].pending;
+	leaf = &leafList[cellList[cell].leaf];
+	for(i = 0; i < LAPLACIAN_LEAF_SITES; i++)
+	{
+		if(!(leaf->sites & (1 << i)))
+		{
+			continue;
+		}
+		*bit = i;
+		value = leaf->sum[i] + shift - base;
+		weight = value;
+		for(e = 1; e < LAPLACIAN_ETA; e++)
+		{
+			weight *= value;
+		}
+		choice -= weight;
+		if(choice <= 0)
+		{
+			break;
+		}
+	}
+	return cell;
+}
+
+/**
+ * @brief makes an empty lattice position a growth site, seeding its potential from the quadtree
+ * @param ix		lattice x of the position
+ * @param iy		lattice y of the position
+ * @param parent	index of the channel point it is next to
+ * @param end		the target of the bolt
+ */
+static void laplacian_add_site(int ix, int iy, int parent, Vect2d end)
+{
+	int cell, bit;
+	int ux = (ix + LAPLACIAN_LATTICE_START) & ((1 << LAPLACIAN_LATTICE_BITS) - 1);
+	int uy = (iy + LAPLACIAN_LATTICE_START) & ((1 << LAPLACIAN_LATTICE_BITS) - 1);
+	double pending = 0;
+	Vect2d pos, diff;
+	LaplacianLeaf *leaf;
+
+	cell = laplacian_cell_find(ux, uy, 1, &pending);
+	if(cell < 0)
+	{
+		return;
+	}
+	leaf = &leafList[cellList[cell].leaf];
+	bit = (ux & (LAPLACIAN_LEAF_SIZE - 1)) | ((uy & (LAPLACIAN_LEAF_SIZE - 1)) << LAPLACIAN_LEAF_BITS);
+	if((leaf->sites | leaf->channel) & (1 << bit))
+	{
+		return;
+	}
+	pos.x = siteOrigin.x + ix * LAPLACIAN_STEP;
+	pos.y = siteOrigin.y + iy * LAPLACIAN_STEP;
+	vect2d_subtract(end, pos, diff);
+	/*the squares above already hold part of the potential of every site in them, so only the rest is stored*/
+	leaf->sum[bit] = (float)(laplacian_tree_potential(pos) - LAPLACIAN_TARGET_WEIGHT * vect2d_get_length(diff) / LAPLACIAN_STEP - pending);
+	leaf->parent[bit] = parent;
+	leaf->sites |= 1 << bit;
+	siteNum++;
+	laplacian_cell_dirty(cell);
+}
+
+/**
+ * @brief adds a point to the channel, grows the quadtree and makes the empty lattice positions around it growth sites
+ * @param site		lattice position of the point
+ * @param ix		lattice x of the point
+ * @param iy		lattice y of the point
+ * @param point		where the point is drawn
+ * @param parent	index of the channel point it grew from, -1 for the first point
+ * @param end		the target of the bolt
+ */
+static void laplacian_add_point(Vect2d site, int ix, int iy, Vect2d point, int parent, Vect2d end)
+{
+	int dx, dy;
+
+	channelSite[channelNum] = site;
+	channelPoint[channelNum] = point;
+	channelParent[channelNum] = parent;
+	channelSegment[channelNum] = NULL;
+	channelNum++;
+
+	laplacian_cell_charge(0, site);
+	laplacian_tree_insert(site);
+
+	for(dy = -1; dy <= 1; dy++)
+	{
+		for(dx = -1; dx <= 1; dx++)
+		{
+			laplacian_add_site(ix + dx, iy + dy, channelNum - 1, end);
+		}
+	}
+}
+
+/**
+ * @brief grows a branched bolt from start towards end, writing each new point into the system's lightningList as one segment so it is drawn by
+ *			lightning_draw_all. the channel that reaches end is drawn twice as thick as the branches
+ * @param system [in,out]	the lightning system to create the segments in
+ * @param start		where the channel starts growing from
+ * @param end		the point the channel grows towards, growth stops when it is reached
+ * @param thickness	thickness of the branches
+ * @return the number of segments created
+ */
+int laplacian_create_bolt(LightningSystem *system, Vect2d start, Vect2d end, float thickness)
+{
+	int i, cell, bit, last;
+	int ix, iy;
+	int segments = 0;
+	double pending = 0;
+	Vect2d site, point, diff;
+	Lightning *segment;
+	LaplacianCell *c;
+	LaplacianLeaf *leaf;
+
+	if(!channelMax)
+	{
+		slog("laplacian growth uninitialized");
+		return 0;
+	}
+
+	vect2d_subtract(end, start, diff);
+	channelNum = 0;
+	siteNum = 0;
+	siteOrigin = start;
+	cellNum = leafNum = 0;
+	laplacian_cell_new(-1, LAPLACIAN_ROOT_LEVEL, 0, 0);
+	nodeNum = 1;
+	memset(nodeList, 0, sizeof(LaplacianNode));
+	nodeList[0].center = vect2d_new(start.x + diff.x * 0.5f, start.y + diff.y * 0.5f);
+	nodeList[0].halfSize = vect2d_get_length(diff) + LAPLACIAN_STEP * 8;
+	nodeList[0].children = -1;
+
+	cell = laplacian_cell_find(1 << (LAPLACIAN_LATTICE_BITS - 1), 1 << (LAPLACIAN_LATTICE_BITS - 1), 1, &pending);
+	leafList[cellList[cell].leaf].channel = 1;
+	laplacian_add_point(start, 0, 0, start, -1, end);
+
+	while(channelNum < channelMax && siteNum > 0)
+	{
+		/*take the site out of the site tree, its position is channel from now on*/
+		cell = laplacian_pick_site(&bit);
+		c = &cellList[cell];
+		leaf = &leafList[c->leaf];
+		ix = ((c->x << LAPLACIAN_LEAF_BITS) | (bit & (LAPLACIAN_LEAF_SIZE - 1))) - LAPLACIAN_LATTICE_START;
+		iy = ((c->y << LAPLACIAN_LEAF_BITS) | (bit >> LAPLACIAN_LEAF_BITS)) - LAPLACIAN_LATTICE_START;
+		last = leaf->parent[bit];
+		leaf->sites &= ~(1 << bit);
+		leaf->channel |= 1 << bit;
+		siteNum--;
+		laplacian_cell_dirty(cell);
+
+		site.x = start.x + ix * LAPLACIAN_STEP;
+		site.y = start.y + iy * LAPLACIAN_STEP;
+		point.x = site.x + (((float)rand() / (float)RAND_MAX) - 0.5f) * LAPLACIAN_STEP * 0.7f;
+		point.y = site.y + (((float)rand() / (float)RAND_MAX) - 0.5f) * LAPLACIAN_STEP * 0.7f;
+		laplacian_add_point(site, ix, iy, point, last, end);
+		channelSegment[channelNum - 1] = lightning_new(system, channelPoint[last], point, thickness);
+		segments++;
+
+		vect2d_subtract(end, site, diff);
+		if(vect2d_get_length(diff) <= LAPLACIAN_STEP * 1.5f)
+		{
+			lightning_new(system, point, end, thickness * 2);
+			segments++;
+			/*the path back to the start is the main channel*/
+			for(i = channelNum - 1; i > 0; i = channelParent[i])
+			{
+				segment = channelSegment[i];
+				if(segment)
+				{
+					segment->thickness = thickness * 2;
+				}
+			}
+			break;
+		}
+	}
+	return segments;
+}
\ No newline at end of file
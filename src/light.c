@@ -0,0 +1,1002 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL_image.h"
+#include "simple_logger.h"
+
+#include "graphics.h"
+#include "jobs.h"
+#include "light.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_SSE2
+#include <emmintrin.h>
+#endif
+
+#define LIGHT_FAR				1e30f		/**< the squared distance a texel starts at before any segment of a light is measured */
+
+#define LIGHT_COMPOSITE_ROWS	16			/**< screen rows in each piece of the composite */
+
+/**
+ * @struct the tile a job worker adds light into
+ * @brief each worker gets its own scratch so tiles never have to be locked
+ */
+typedef struct LightWorker_t
+{
+	float light[3][LIGHT_TILE_SIZE * LIGHT_TILE_SIZE];			/**< the red, green and blue light added to the current tile */
+	float distance[LIGHT_TILE_SIZE * LIGHT_TILE_SIZE];			/**< squared distance from each texel to the closest segment of the current light */
+	float *row;													/**< one row of the light buffer upsampled vertically, 4 floats a texel, for the composite */
+}LightWorker;
+
+/**
+ * @struct a frame of the CPU rasterizer being composited
+ */
+typedef struct LightFrame_t
+{
+	Uint8 *pixels;							/**< the frame */
+	int pitch;								/**< bytes in one row of it */
+}LightFrame;
+
+/* light buffer */
+static Uint8 *lightTexels = NULL;
+static int lightWidth = 0;
+static int lightHeight = 0;
+static int lightScale = 0;
+static SDL_Texture *lightTexture = NULL;
+
+/* background, stretched to the screen */
+static Uint8 *lightBackground = NULL;
+static int lightScreenWidth = 0;
+static int lightScreenHeight = 0;
+static SDL_Texture *lightBackgroundTexture = NULL;
+
+/* the texel to the left and right of each screen column and how far between them it is, for upsampling */
+static int *lightColumns = NULL;
+static float *lightColumnWeights = NULL;
+
+/* light queue */
+static Light *lightLights = NULL;
+static int lightLightNum = 0;
+static int lightLightMax = 0;
+static LightSegment *lightSegments = NULL;
+static int lightSegmentNum = 0;
+static int lightSegmentMax = 0;
+
+/* tile bins, the segments reaching tile i are lightTileIndex[lightTileStart[i]] to lightTileIndex[lightTileStart[i + 1] - 1] */
+static int lightTilesX = 0;
+static int lightTilesY = 0;
+static int *lightTileStart = NULL;
+static int *lightTileIndex = NULL;
+static int lightTileIndexMax = 0;
+
+/* one scratch per job worker, grown if the job system is restarted with more workers */
+static LightWorker *lightWorkers = NULL;
+static float *lightRows = NULL;
+static int lightWorkerNum = 0;
+
+/**
+ * @brief initializes the lighting and allocates a light buffer covering the screen at one texel per scale pixels
+ * @param width		width of the screen in pixels
+ * @param height	height of the screen in pixels
+ * @param scale		screen pixels per light buffer texel along each axis, 0 uses LIGHT_SCALE
+ */
+void light_init_system(int width, int height, int scale)
+{
+	int x;
+	float u;
+
+	if(scale <= 0)
+	{
+		scale = LIGHT_SCALE;
+	}
+	if(width <= 0 || height <= 0)
+	{
+		slog("light size must be positive (%i x %i)", width, height);
+		return;
+	}
+
+	lightWidth = (width + scale - 1) / scale;
+	lightHeight = (height + scale - 1) / scale;
+	lightTexels = (Uint8 *)malloc(lightWidth * lightHeight * 4);
+	lightTilesX = (lightWidth + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	lightTilesY = (lightHeight + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	lightTileStart = (int *)malloc(sizeof(int) * (lightTilesX * lightTilesY + 1));
+	lightColumns = (int *)malloc(sizeof(int) * width * 2);
+	lightColumnWeights = (float *)malloc(sizeof(float) * width);
+	if(!lightTexels || !lightTileStart || !lightColumns || !lightColumnWeights)
+	{
+		slog("light failed to initialize");
+		light_close_system();
+		return;
+	}
+	memset(lightTexels, 0, lightWidth * lightHeight * 4);
+	lightScale = scale;
+	lightScreenWidth = width;
+	lightScreenHeight = height;
+
+	/*texel i is centered on screen pixel (i + 0.5) * scale, the same place a linear filtered texture stretched by scale puts it*/
+	for(x = 0; x < width; x++)
+	{
+		u = (x + 0.5f) / scale - 0.5f;
+		lightColumns[x * 2] = MIN(MAX((int)floor(u), 0), lightWidth - 1);
+		lightColumns[x * 2 + 1] = MIN(lightColumns[x * 2] + 1, lightWidth - 1);
+		lightColumnWeights[x] = MIN(MAX(u - (float)floor(u), 0), 1);
+		if(u < 0)
+		{
+			lightColumnWeights[x] = 0;
+		}
+	}
+
+	slog("light buffer %i x %i for %i x %i", lightWidth, lightHeight, width, height);
+	atexit(light_close_system);
+}
+
+/**
+ * @brief frees the light buffer, the background, the queued lights and the workers' scratch
+ */
+void light_close_system()
+{
+	free(lightWorkers);
+	free(lightRows);
+	lightWorkers = NULL;
+	lightRows = NULL;
+	lightWorkerNum = 0;
+	if(lightTexture)
+	{
+		SDL_DestroyTexture(lightTexture);
+		lightTexture = NULL;
+	}
+	if(lightBackgroundTexture)
+	{
+		SDL_DestroyTexture(lightBackgroundTexture);
+		lightBackgroundTexture = NULL;
+	}
+	free(lightTexels);
+	free(lightBackground);
+	free(lightColumns);
+	free(lightColumnWeights);
+	free(lightLights);
+	free(lightSegments);
+	free(lightTileStart);
+	free(lightTileIndex);
+	lightTexels = NULL;
+	lightBackground = NULL;
+	lightColumns = NULL;
+	lightColumnWeights = NULL;
+	lightLights = NULL;
+	lightSegments = NULL;
+	lightTileStart = NULL;
+	lightTileIndex = NULL;
+	lightLightNum = lightLightMax = 0;
+	lightSegmentNum = lightSegmentMax = 0;
+	lightTileIndexMax = 0;
+	lightWidth = lightHeight = 0;
+	lightScreenWidth = lightScreenHeight = 0;
+}
+
+/**
+ * @brief loads the image that is lit and stretches it over the screen
+ * @param filename	the image to load
+ * @return 1 if it was loaded, 0 otherwise
+ */
+int light_load_background(char *filename)
+{
+	int x, y, c, x0, y0, x1, y1;
+	float u, v, fx, fy;
+	Uint8 *source, *pixel;
+	SDL_Surface *loaded, *converted;
+
+	if(!lightTexels)
+	{
+		slog("light uninitialized");
+		return 0;
+	}
+	loaded = IMG_Load(filename);
+	if(!loaded)
+	{
+		slog("failed to load background %s: %s", filename, IMG_GetError());
+		return 0;
+	}
+	converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(loaded);
+	if(!converted)
+	{
+		slog("failed to convert background %s: %s", filename, SDL_GetError());
+		return 0;
+	}
+	free(lightBackground);
+	lightBackground = (Uint8 *)malloc(lightScreenWidth * lightScreenHeight * 4);
+	if(!lightBackground)
+	{
+		slog("failed to allocate background %s", filename);
+		SDL_FreeSurface(converted);
+		return 0;
+	}
+
+	/*stretched once here with a bilinear filter, so neither the GPU nor the composite has to scale it every frame*/
+	source = (Uint8 *)converted->pixels;
+	for(y = 0; y < lightScreenHeight; y++)
+	{
+		v = MAX((y + 0.5f) * converted->h / lightScreenHeight - 0.5f, 0);
+		y0 = MIN((int)v, converted->h - 1);
+		y1 = MIN(y0 + 1, converted->h - 1);
+		fy = v - y0;
+		for(x = 0; x < lightScreenWidth; x++)
+		{
+			u = MAX((x + 0.5f) * converted->w / lightScreenWidth - 0.5f, 0);
+			x0 = MIN((int)u, converted->w - 1);
+			x1 = MIN(x0 + 1, converted->w - 1);
+			fx = u - x0;
+			pixel = &lightBackground[(y * lightScreenWidth + x) * 4];
+			for(c = 0; c < 4; c++)
+			{
+				pixel[c] = (Uint8)(source[y0 * converted->pitch + x0 * 4 + c] * (1 - fx) * (1 - fy) + source[y0 * converted->pitch + x1 * 4 + c] * fx * (1 - fy)
+					+ source[y1 * converted->pitch + x0 * 4 + c] * (1 - fx) * fy + source[y1 * converted->pitch + x1 * 4 + c] * fx * fy + 0.5f);
+			}
+		}
+	}
+	slog("background %s, %i x %i stretched to %i x %i", filename, converted->w, converted->h, lightScreenWidth, lightScreenHeight);
+	SDL_FreeSurface(converted);
+	if(lightBackgroundTexture)
+	{
+		SDL_DestroyTexture(lightBackgroundTexture);
+		lightBackgroundTexture = NULL;
+	}
+	return 1;
+}
+
+/**
+ * @brief empties the queued lights
+ */
+void light_clear()
+{
+	lightLightNum = 0;
+	lightSegmentNum = 0;
+}
+
+/**
+ * @brief doubles a queue's capacity, at least to 1024
+ * @param list [in,out]	the queue, moved if it grows
+ * @param max [in,out]	how many items fit in it
+ * @param size			bytes in one item
+ * @return 1 if it grew, 0 otherwise
+ */
+static int light_grow(void **list, int *max, size_t size)
+{
+	void *grown;
+
+	grown = realloc(*list, size * MAX(1024, *max * 2));
+	if(!grown)
+	{
+		slog("light queue failed to grow");
+		return 0;
+	}
+	*list = grown;
+	*max = MAX(1024, *max * 2);
+	return 1;
+}
+
+/**
+ * @brief starts a new light for the next light_render, its segments are queued with light_add_segment. the light at a texel comes from
+ *			the light's closest segment, so the segments can overlap and branch without lighting any brighter where they do
+ * @param color		color of the light, each component 0 - 255
+ * @param radius	screen pixels the light reaches
+ * @param intensity	brightness of the light right at its segments
+ * @return 1 if the light was queued, 0 if the queue could not grow
+ */
+int light_add_light(Vect3d color, float radius, float intensity)
+{
+	Light *light;
+
+	if(!lightTexels)
+	{
+		slog("light uninitialized");
+		return 0;
+	}
+	if(radius <= 0 || intensity <= 0)
+	{
+		return 0;
+	}
+	if(lightLightNum >= lightLightMax && !light_grow((void **)&lightLights, &lightLightMax, sizeof(Light)))
+	{
+		return 0;
+	}
+	light = &lightLights[lightLightNum++];
+	vect3d_scale(light->color, color, (intensity / 255.0f));
+	light->radius = radius / lightScale;
+	light->invRadius2 = 1.0f / (light->radius * light->radius);
+	return 1;
+}
+
+/**
+ * @brief queues a segment of the light last started with light_add_light
+ * @param start		starting point of the segment in screen pixels
+ * @param end		end point of the segment in screen pixels
+ */
+void light_add_segment(Vect2d start, Vect2d end)
+{
+	LightSegment *segment;
+	float invScale;
+
+	if(lightLightNum <= 0)
+	{
+		slog("light segment added without a light");
+		return;
+	}
+	if(lightSegmentNum >= lightSegmentMax && !light_grow((void **)&lightSegments, &lightSegmentMax, sizeof(LightSegment)))
+	{
+		return;
+	}
+	invScale = 1.0f / lightScale;
+	segment = &lightSegments[lightSegmentNum++];
+	vect2d_scale(segment->start, start, invScale);
+	vect2d_scale(segment->end, end, invScale);
+	segment->light = lightLightNum - 1;
+}
+
+/**
+ * @brief queues a polyline as a line light for the next light_render, a polyline of more than LIGHT_MAX_SEGMENTS segments is lit
+ *			along every few of its points
+ * @param points [in]	the points of the polyline in screen pixels
+ * @param count			how many points there are, a single point is lit as a point light
+ * @param color			color of the light, each component 0 - 255
+ * @param radius		screen pixels the light reaches
+ * @param intensity		brightness of the light right at the polyline
+ */
+void light_add_polyline(Vect2d *points, int count, Vect3d color, float radius, float intensity)
+{
+	int i, segments;
+
+	if(!points || count <= 0 || !light_add_light(color, radius, intensity))
+	{
+		return;
+	}
+	if(count == 1)
+	{
+		light_add_segment(points[0], points[0]);
+		return;
+	}
+	/*the light reaches hundreds of pixels, so a few pixels of detail lost between the points kept can't be seen in it*/
+	segments = MIN(count - 1, LIGHT_MAX_SEGMENTS);
+	for(i = 0; i < segments; i++)
+	{
+		light_add_segment(points[i * (count - 1) / segments], points[(i + 1) * (count - 1) / segments]);
+	}
+}
+
+/**
+ * @brief finds the squared distance from a point to a segment
+ * @param segment [in]	the segment
+ * @param x		x of the point
+ * @param y		y of the point
+ * @return the squared distance
+ */
+static float light_segment_distance2(LightSegment *segment, float x, float y)
+{
+	float bax = segment->end.x - segment->start.x;
+	float bay = segment->end.y - segment->start.y;
+	float pax = x - segment->start.x;
+	float pay = y - segment->start.y;
+	float length2 = bax * bax + bay * bay;
+	float h = length2 > 0 ? (pax * bax + pay * bay) / length2 : 0;
+
+	h = MIN(MAX(h, 0), 1);
+	pax -= bax * h;
+	pay -= bay * h;
+	return pax * pax + pay * pay;
+}
+
+/**
+ * @brief finds the range of tiles a segment's light can reach
+ * @param segment [in]	the segment to bound
+ * @param x0 [out]		first tile column
+ * @param y0 [out]		first tile row
+ * @param x1 [out]		last tile column
+ * @param y1 [out]		last tile row
+ * @return 0 if the segment's light is completely off the light buffer, 1 otherwise
+ */
+static int light_segment_tiles(LightSegment *segment, int *x0, int *y0, int *x1, int *y1)
+{
+	float radius = lightLights[segment->light].radius;
+	float minX = MIN(segment->start.x, segment->end.x) - radius;
+	float minY = MIN(segment->start.y, segment->end.y) - radius;
+	float maxX = MAX(segment->start.x, segment->end.x) + radius;
+	float maxY = MAX(segment->start.y, segment->end.y) + radius;
+
+	if(maxX < 0 || maxY < 0 || minX >= lightWidth || minY >= lightHeight)
+	{
+		return 0;
+	}
+	*x0 = MAX(0, (int)minX / LIGHT_TILE_SIZE);
+	*y0 = MAX(0, (int)minY / LIGHT_TILE_SIZE);
+	*x1 = MIN(lightTilesX - 1, (int)maxX / LIGHT_TILE_SIZE);
+	*y1 = MIN(lightTilesY - 1, (int)maxY / LIGHT_TILE_SIZE);
+	return 1;
+}
+
+/**
+ * @brief checks if a segment's light reaches a tile, by the distance from the tile's center to the segment against the light's radius
+ *			plus half the tile's diagonal, which leaves out most of the tiles in the box around a diagonal segment
+ * @param segment [in]	the segment
+ * @param x		column of the tile
+ * @param y		row of the tile
+ * @return 1 if the light may reach the tile, 0 if it can't
+ */
+static int light_segment_reaches(LightSegment *segment, int x, int y)
+{
+	float reach = lightLights[segment->light].radius + LIGHT_TILE_SIZE * 0.7072f;
+	return light_segment_distance2(segment, (x + 0.5f) * LIGHT_TILE_SIZE, (y + 0.5f) * LIGHT_TILE_SIZE) <= reach * reach;
+}
+
+/**
+ * @brief finds the squared distance from a segment to the farthest texel center of a tile, which is at one of the corners since the
+ *			distance to a segment only grows away from it
+ * @param segment [in]	the segment
+ * @param minX		x of the tile's top left texel center
+ * @param minY		y of the tile's top left texel center
+ * @return the squared distance
+ */
+static float light_tile_far2(LightSegment *segment, float minX, float minY)
+{
+	float maxX = minX + LIGHT_TILE_SIZE - 1;
+	float maxY = minY + LIGHT_TILE_SIZE - 1;
+
+	return MAX(MAX(light_segment_distance2(segment, minX, minY), light_segment_distance2(segment, maxX, minY)),
+		MAX(light_segment_distance2(segment, minX, maxY), light_segment_distance2(segment, maxX, maxY)));
+}
+
+/**
+ * @brief finds the squared distance from a segment to the closest point of the box around a tile's texel centers, 0 if the segment
+ *			crosses it. otherwise the closest point is a corner of the box or an end of the segment
+ * @param segment [in]	the segment
+ * @param minX		x of the tile's top left texel center
+ * @param minY		y of the tile's top left texel center
+ * @return the squared distance
+ */
+static float light_tile_near2(LightSegment *segment, float minX, float minY)
+{
+	int i, sides = 0;
+	float maxX = minX + LIGHT_TILE_SIZE - 1;
+	float maxY = minY + LIGHT_TILE_SIZE - 1;
+	float bax = segment->end.x - segment->start.x;
+	float bay = segment->end.y - segment->start.y;
+	float cornerX[4], cornerY[4];
+	float dx, dy, closest = LIGHT_FAR;
+
+	cornerX[0] = cornerX[2] = minX;
+	cornerX[1] = cornerX[3] = maxX;
+	cornerY[0] = cornerY[1] = minY;
+	cornerY[2] = cornerY[3] = maxY;
+	if(MAX(segment->start.x, segment->end.x) >= minX && MIN(segment->start.x, segment->end.x) <= maxX
+		&& MAX(segment->start.y, segment->end.y) >= minY && MIN(segment->start.y, segment->end.y) <= maxY)
+	{
+		/*the boxes overlap, so the segment crosses the tile unless every corner is on the same side of its line*/
+		for(i = 0; i < 4; i++)
+		{
+			sides |= (bax * (cornerY[i] - segment->start.y) - bay * (cornerX[i] - segment->start.x)) >= 0 ? 1 : 2;
+		}
+		if(sides == 3)
+		{
+			return 0;
+		}
+	}
+	for(i = 0; i < 4; i++)
+	{
+		closest = MIN(closest, light_segment_distance2(segment, cornerX[i], cornerY[i]));
+	}
+	dx = MAX(MAX(minX - segment->start.x, segment->start.x - maxX), 0);
+	dy = MAX(MAX(minY - segment->start.y, segment->start.y - maxY), 0);
+	closest = MIN(closest, dx * dx + dy * dy);
+	dx = MAX(MAX(minX - segment->end.x, segment->end.x - maxX), 0);
+	dy = MAX(MAX(minY - segment->end.y, segment->end.y - maxY), 0);
+	return MIN(closest, dx * dx + dy * dy);
+}
+
+/**
+ * @brief sorts the queued segments into per tile lists with a counting sort, so each tile only visits the lights that reach it. the
+ *			segments were queued light by light and the sort keeps their order, so each light's segments are together in every tile
+ * @return 0 if the bins could not be allocated
+ */
+static int light_bin_segments()
+{
+	int i, x, y;
+	int x0, y0, x1, y1;
+	int tileNum = lightTilesX * lightTilesY;
+	int total = 0, count;
+	int *grown;
+
+	memset(lightTileStart, 0, sizeof(int) * (tileNum + 1));
+	for(i = 0; i < lightSegmentNum; i++)
+	{
+		if(!light_segment_tiles(&lightSegments[i], &x0, &y0, &x1, &y1))
+		{
+			continue;
+		}
+		for(y = y0; y <= y1; y++)
+		{
+			for(x = x0; x <= x1; x++)
+			{
+				if(light_segment_reaches(&lightSegments[i], x, y))
+				{
+					lightTileStart[y * lightTilesX + x + 1]++;
+				}
+			}
+		}
+	}
+	for(i = 0; i < tileNum; i++)
+	{
+		count = lightTileStart[i + 1];
+		lightTileStart[i + 1] = total;
+		total += count;
+	}
+	if(total > lightTileIndexMax)
+	{
+		grown = (int *)realloc(lightTileIndex, sizeof(int) * total);
+		if(!grown)
+		{
+			slog("light tile bins failed to grow");
+			return 0;
+		}
+		lightTileIndex = grown;
+		lightTileIndexMax = total;
+	}
+
+	/*lightTileStart[i + 1] is used as the write cursor for tile i, once filled it is the end of tile i*/
+	for(i = 0; i < lightSegmentNum; i++)
+	{
+		if(!light_segment_tiles(&lightSegments[i], &x0, &y0, &x1, &y1))
+		{
+			continue;
+		}
+		for(y = y0; y <= y1; y++)
+		{
+			for(x = x0; x <= x1; x++)
+			{
+				if(light_segment_reaches(&lightSegments[i], x, y))
+				{
+					lightTileIndex[lightTileStart[y * lightTilesX + x + 1]++] = i;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief keeps the squared distance from each texel of a tile to a segment wherever it is closer than the light's segments so far
+ * @param segment [in]		the segment
+ * @param worker [in,out]	the worker whose distances are written
+ * @param tileX		x coordinate of the tile's top left texel
+ * @param tileY		y coordinate of the tile's top left texel
+ */
+static void light_segment(LightSegment *segment, LightWorker *worker, int tileX, int tileY)
+{
+	int x, y, i;
+	float ax = segment->start.x - tileX;
+	float ay = segment->start.y - tileY;
+	float bax = segment->end.x - segment->start.x;
+	float bay = segment->end.y - segment->start.y;
+	float length2 = bax * bax + bay * bay;
+	float invLength2 = length2 > 0 ? 1.0f / length2 : 0;
+	float px, py, pax, pay, h, dx, dy;
+	float *distance = worker->distance;
+#ifdef LIGHT_SSE2
+	__m128 vax, vbax, vbay, vinvLength2, vzero, vone;
+	__m128 vpax, vpay, vh, vdx, vdy;
+#endif
+
+#ifdef LIGHT_SSE2
+	vax = _mm_set1_ps(ax);
+	vbax = _mm_set1_ps(bax);
+	vbay = _mm_set1_ps(bay);
+	vinvLength2 = _mm_set1_ps(invLength2);
+	vzero = _mm_setzero_ps();
+	vone = _mm_set1_ps(1.0f);
+#endif
+
+	for(y = 0; y < LIGHT_TILE_SIZE; y++)
+	{
+		py = y + 0.5f;
+		pay = py - ay;
+		x = 0;
+#ifdef LIGHT_SSE2
+		vpay = _mm_set1_ps(pay);
+		for(; x + 4 <= LIGHT_TILE_SIZE; x += 4)
+		{
+			i = y * LIGHT_TILE_SIZE + x;
+			vpax = _mm_sub_ps(_mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f)), vax);
+			vh = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vpax, vbax), _mm_mul_ps(vpay, vbay)), vinvLength2);
+			vh = _mm_min_ps(_mm_max_ps(vh, vzero), vone);
+			vdx = _mm_sub_ps(vpax, _mm_mul_ps(vbax, vh));
+			vdy = _mm_sub_ps(vpay, _mm_mul_ps(vbay, vh));
+			_mm_storeu_ps(&distance[i], _mm_min_ps(_mm_loadu_ps(&distance[i]), _mm_add_ps(_mm_mul_ps(vdx, vdx), _mm_mul_ps(vdy, vdy))));
+		}
+#endif
+		for(; x < LIGHT_TILE_SIZE; x++)
+		{
+			i = y * LIGHT_TILE_SIZE + x;
+			px = x + 0.5f;
+			pax = px - ax;
+			h = (pax * bax + pay * bay) * invLength2;
+			h = MIN(MAX(h, 0), 1);
+			dx = pax - bax * h;
+			dy = pay - bay * h;
+			distance[i] = MIN(distance[i], dx * dx + dy * dy);
+		}
+	}
+}
+
+/**
+ * @brief adds a light to a tile from the distances to its closest segment, falling off as (1 - d^2 / r^2)^2 so it is smooth and reaches
+ *			nothing past its radius, then resets the distances for the next light
+ * @param light [in]		the light
+ * @param worker [in,out]	the worker whose tile is lit
+ */
+static void light_flush(Light *light, LightWorker *worker)
+{
+	int i = 0;
+	float falloff;
+	float *distance = worker->distance;
+	float *red = worker->light[0];
+	float *green = worker->light[1];
+	float *blue = worker->light[2];
+#ifdef LIGHT_SSE2
+	__m128 vinvRadius2 = _mm_set1_ps(light->invRadius2);
+	__m128 vr = _mm_set1_ps(light->color.r);
+	__m128 vg = _mm_set1_ps(light->color.g);
+	__m128 vb = _mm_set1_ps(light->color.b);
+	__m128 vzero = _mm_setzero_ps();
+	__m128 vone = _mm_set1_ps(1.0f);
+	__m128 vfar = _mm_set1_ps(LIGHT_FAR);
+	__m128 vfalloff;
+
+	for(; i + 4 <= LIGHT_TILE_SIZE * LIGHT_TILE_SIZE; i += 4)
+	{
+		vfalloff = _mm_max_ps(_mm_sub_ps(vone, _mm_mul_ps(_mm_loadu_ps(&distance[i]), vinvRadius2)), vzero);
+		vfalloff = _mm_mul_ps(vfalloff, vfalloff);
+		_mm_storeu_ps(&red[i], _mm_add_ps(_mm_loadu_ps(&red[i]), _mm_mul_ps(vfalloff, vr)));
+		_mm_storeu_ps(&green[i], _mm_add_ps(_mm_loadu_ps(&green[i]), _mm_mul_ps(vfalloff, vg)));
+		_mm_storeu_ps(&blue[i], _mm_add_ps(_mm_loadu_ps(&blue[i]), _mm_mul_ps(vfalloff, vb)));
+		_mm_storeu_ps(&distance[i], vfar);
+	}
+#endif
+	for(; i < LIGHT_TILE_SIZE * LIGHT_TILE_SIZE; i++)
+	{
+		falloff = MAX(1 - distance[i] * light->invRadius2, 0);
+		falloff *= falloff;
+		red[i] += falloff * light->color.r;
+		green[i] += falloff * light->color.g;
+		blue[i] += falloff * light->color.b;
+		distance[i] = LIGHT_FAR;
+	}
+}
+
+/**
+ * @brief lights one tile: measures each light's segments in turn and adds the light once its segments are done, then resolves the tile
+ *			into the light buffer. a segment only lights a texel if it is the light's closest, so a segment that is farther from the
+ *			whole tile than another segment of the same light is from every texel in it is skipped, which leaves a handful of each
+ *			bolt's segments in most tiles however many reach them
+ * @param worker [in,out]	the worker doing the lighting
+ * @param tile				index of the tile
+ */
+static void light_tile(LightWorker *worker, int tile)
+{
+	int i, j, x, y, light, next;
+	float farthest;
+	int tileX = (tile % lightTilesX) * LIGHT_TILE_SIZE;
+	int tileY = (tile / lightTilesX) * LIGHT_TILE_SIZE;
+	int width = MIN(LIGHT_TILE_SIZE, lightWidth - tileX);
+	int height = MIN(LIGHT_TILE_SIZE, lightHeight - tileY);
+	int end = lightTileStart[tile + 1];
+	LightSegment *segment;
+	Uint8 *texel;
+#ifdef LIGHT_SSE2
+	__m128 vone = _mm_set1_ps(1.0f);
+	__m128 v255 = _mm_set1_ps(255.0f);
+	__m128i valpha = _mm_set1_epi32(0xff << 24);
+	__m128i vr, vg, vb;
+#endif
+
+	memset(worker->light, 0, sizeof(worker->light));
+	for(i = 0; i < LIGHT_TILE_SIZE * LIGHT_TILE_SIZE; i++)
+	{
+		worker->distance[i] = LIGHT_FAR;
+	}
+	for(i = lightTileStart[tile]; i < end; i = next)
+	{
+		light = lightSegments[lightTileIndex[i]].light;
+		farthest = LIGHT_FAR;
+		for(next = i; next < end && lightSegments[lightTileIndex[next]].light == light; next++)
+		{
+			farthest = MIN(farthest, light_tile_far2(&lightSegments[lightTileIndex[next]], tileX + 0.5f, tileY + 0.5f));
+		}
+		for(j = i; j < next; j++)
+		{
+			segment = &lightSegments[lightTileIndex[j]];
+			if(light_tile_near2(segment, tileX + 0.5f, tileY + 0.5f) <= farthest)
+			{
+				light_segment(segment, worker, tileX, tileY);
+			}
+		}
+		light_flush(&lightLights[light], worker);
+	}
+
+	for(y = 0; y < height; y++)
+	{
+		texel = &lightTexels[((tileY + y) * lightWidth + tileX) * 4];
+		x = 0;
+#ifdef LIGHT_SSE2
+		for(; x + 4 <= width; x += 4, texel += 16)
+		{
+			i = y * LIGHT_TILE_SIZE + x;
+			vr = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_loadu_ps(&worker->light[0][i]), vone), v255));
+			vg = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_loadu_ps(&worker->light[1][i]), vone), v255));
+			vb = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_loadu_ps(&worker->light[2][i]), vone), v255));
+			vr = _mm_or_si128(_mm_or_si128(vr, _mm_slli_epi32(vg, 8)), _mm_or_si128(_mm_slli_epi32(vb, 16), valpha));
+			_mm_storeu_si128((__m128i *)texel, vr);
+		}
+#endif
+		for(; x < width; x++, texel += 4)
+		{
+			i = y * LIGHT_TILE_SIZE + x;
+			texel[0] = (Uint8)(MIN(worker->light[0][i], 1.0f) * 255.0f);
+			texel[1] = (Uint8)(MIN(worker->light[1][i], 1.0f) * 255.0f);
+			texel[2] = (Uint8)(MIN(worker->light[2][i], 1.0f) * 255.0f);
+			texel[3] = 255;
+		}
+	}
+}
+
+/**
+ * @brief job that lights a range of tiles with the running worker's scratch
+ * @param data		unused
+ * @param start		first tile
+ * @param end		one past the last tile
+ * @param worker	index of the job worker running it
+ */
+static void light_tile_job(void *data, int start, int end, int worker)
+{
+	int tile;
+	for(tile = start; tile < end; tile++)
+	{
+		light_tile(&lightWorkers[worker], tile);
+	}
+}
+
+/**
+ * @brief makes sure every job worker has its scratch
+ * @return 1 if they do, 0 if it could not be allocated
+ */
+static int light_workers()
+{
+	int i;
+	int workers = jobs_get_worker_count();
+
+	if(workers <= lightWorkerNum)
+	{
+		return 1;
+	}
+	free(lightWorkers);
+	free(lightRows);
+	lightWorkers = (LightWorker *)malloc(sizeof(LightWorker) * workers);
+	lightRows = (float *)malloc(sizeof(float) * lightWidth * 4 * workers);
+	if(!lightWorkers || !lightRows)
+	{
+		slog("light failed to allocate scratch for %i workers", workers);
+		free(lightWorkers);
+		free(lightRows);
+		lightWorkers = NULL;
+		lightRows = NULL;
+		lightWorkerNum = 0;
+		return 0;
+	}
+	for(i = 0; i < workers; i++)
+	{
+		lightWorkers[i].row = &lightRows[lightWidth * 4 * i];
+	}
+	lightWorkerNum = workers;
+	return 1;
+}
+
+/**
+ * @brief bins every queued light segment into the tiles it reaches, then adds up the light of every tile in parallel into the light buffer
+ */
+void light_render()
+{
+	if(!lightTexels)
+	{
+		slog("light uninitialized");
+		return;
+	}
+	if(!light_workers() || !light_bin_segments())
+	{
+		return;
+	}
+
+	/*tiles cost very different amounts, so each one is its own piece for idle workers to steal*/
+	jobs_parallel_for(light_tile_job, NULL, 0, lightTilesX * lightTilesY, 1);
+}
+
+/**
+ * @brief job that composites a range of screen rows: each row of the light buffer is upsampled vertically once into the worker's row
+ *			as the background's brightness, ambient times 1 plus the light, then every pixel adds the background times the brightness
+ *			between its two texels
+ * @param data [in]	the LightFrame being composited
+ * @param start		first row
+ * @param end		one past the last row
+ * @param worker	index of the job worker running it
+ */
+static void light_composite_job(void *data, int start, int end, int worker)
+{
+	int x, y, c, i0, i1;
+	float v, fy, fx;
+	float *row = lightWorkers[worker].row;
+	Uint8 *top, *bottom, *pixel, *background;
+	LightFrame *frame = (LightFrame *)data;
+#ifdef LIGHT_SSE2
+	Uint32 packed;
+	__m128 vfy, vbrightness, vpixel, vbackground;
+	__m128 vscale = _mm_set1_ps(LIGHT_AMBIENT / 255.0f);
+	__m128 vambient = _mm_setr_ps(LIGHT_AMBIENT, LIGHT_AMBIENT, LIGHT_AMBIENT, 0);
+	__m128i vzero = _mm_setzero_si128();
+	__m128i vtop, vbottom;
+#else
+	float brightness;
+#endif
+
+	for(y = start; y < end; y++)
+	{
+		v = (y + 0.5f) / lightScale - 0.5f;
+		i0 = MIN(MAX((int)floor(v), 0), lightHeight - 1);
+		i1 = MIN(i0 + 1, lightHeight - 1);
+		fy = v < 0 ? 0 : MIN(v - (float)floor(v), 1);
+		top = &lightTexels[i0 * lightWidth * 4];
+		bottom = &lightTexels[i1 * lightWidth * 4];
+		x = 0;
+#ifdef LIGHT_SSE2
+		vfy = _mm_set1_ps(fy);
+		for(; x < lightWidth; x++)
+		{
+			memcpy(&packed, &top[x * 4], 4);
+			vtop = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)packed), vzero), vzero);
+			memcpy(&packed, &bottom[x * 4], 4);
+			vbottom = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)packed), vzero), vzero);
+			vbrightness = _mm_cvtepi32_ps(vtop);
+			vbrightness = _mm_add_ps(vbrightness, _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(vbottom), vbrightness), vfy));
+			/*the alpha byte is dropped, so the background's alpha is only added at the ambient and the frame stays opaque*/
+			_mm_storeu_ps(&row[x * 4], _mm_add_ps(vambient, _mm_mul_ps(_mm_and_ps(vbrightness, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))), vscale)));
+		}
+#endif
+		for(; x < lightWidth; x++)
+		{
+			for(c = 0; c < 3; c++)
+			{
+				row[x * 4 + c] = LIGHT_AMBIENT * (1 + (top[x * 4 + c] + (bottom[x * 4 + c] - top[x * 4 + c]) * fy) / 255.0f);
+			}
+			row[x * 4 + 3] = 0;
+		}
+
+		pixel = &frame->pixels[y * frame->pitch];
+		background = &lightBackground[y * lightScreenWidth * 4];
+		for(x = 0; x < lightScreenWidth; x++, pixel += 4, background += 4)
+		{
+			i0 = lightColumns[x * 2] * 4;
+			i1 = lightColumns[x * 2 + 1] * 4;
+			fx = lightColumnWeights[x];
+#ifdef LIGHT_SSE2
+			vbrightness = _mm_loadu_ps(&row[i0]);
+			vbrightness = _mm_add_ps(vbrightness, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&row[i1]), vbrightness), _mm_set1_ps(fx)));
+			memcpy(&packed, pixel, 4);
+			vpixel = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)packed), vzero), vzero));
+			memcpy(&packed, background, 4);
+			vbackground = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)packed), vzero), vzero));
+			vtop = _mm_cvttps_epi32(_mm_add_ps(vpixel, _mm_mul_ps(vbackground, vbrightness)));
+			vtop = _mm_packus_epi16(_mm_packs_epi32(vtop, vzero), vzero);
+			packed = (Uint32)_mm_cvtsi128_si32(vtop);
+			memcpy(pixel, &packed, 4);
+#else
+			for(c = 0; c < 3; c++)
+			{
+				brightness = row[i0 + c] + (row[i1 + c] - row[i0 + c]) * fx;
+				pixel[c] = (Uint8)MIN(pixel[c] + background[c] * brightness, 255.0f);
+			}
+#endif
+		}
+	}
+}
+
+/**
+ * @brief lights the background with the light buffer, upsampled, and adds it under a frame of the CPU rasterizer
+ * @param pixels [in,out]	the frame, R, G, B, A bytes the size of the screen
+ * @param pitch				bytes in one row of the frame
+ */
+void light_composite(Uint8 *pixels, int pitch)
+{
+	LightFrame frame;
+
+	if(!lightTexels || !lightBackground || !pixels)
+	{
+		slog("light, its background or the frame uninitialized");
+		return;
+	}
+	if(!light_workers())
+	{
+		return;
+	}
+	frame.pixels = pixels;
+	frame.pitch = pitch;
+	jobs_parallel_for(light_composite_job, &frame, 0, lightScreenHeight, LIGHT_COMPOSITE_ROWS);
+}
+
+/**
+ * @brief draws the background onto the game's renderer with the light buffer, upsampled, brightening it
+ */
+void light_present()
+{
+	SDL_Rect stretched;
+	SDL_BlendMode brighten;
+	SDL_Renderer *renderer = graphics_get_renderer();
+
+	if(!lightTexels || !lightBackground || !renderer)
+	{
+		slog("light, its background or the renderer uninitialized");
+		return;
+	}
+	if(!lightBackgroundTexture)
+	{
+		lightBackgroundTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, lightScreenWidth, lightScreenHeight);
+		if(!lightBackgroundTexture)
+		{
+			slog("unable to create background texture: %s", SDL_GetError());
+			return;
+		}
+		SDL_UpdateTexture(lightBackgroundTexture, NULL, lightBackground, lightScreenWidth * 4);
+		SDL_SetTextureColorMod(lightBackgroundTexture, (Uint8)(LIGHT_AMBIENT * 255), (Uint8)(LIGHT_AMBIENT * 255), (Uint8)(LIGHT_AMBIENT * 255));
+	}
+	if(!lightTexture)
+	{
+		lightTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, lightWidth, lightHeight);
+		if(!lightTexture)
+		{
+			slog("unable to create light texture: %s", SDL_GetError());
+			return;
+		}
+		/*destination times the light plus the destination, the background brightened by the light the same way light_composite does*/
+		brighten = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_DST_COLOR, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD,
+			SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD);
+		if(SDL_SetTextureBlendMode(lightTexture, brighten) != 0)
+		{
+			slog("renderer can't brighten by the light, adding it instead: %s", SDL_GetError());
+			SDL_SetTextureBlendMode(lightTexture, SDL_BLENDMODE_ADD);
+		}
+	}
+	SDL_UpdateTexture(lightTexture, NULL, lightTexels, lightWidth * 4);
+	SDL_RenderCopy(renderer, lightBackgroundTexture, NULL, NULL);
+
+	/*stretched by exactly the scale, past the edge of the screen if need be, so every texel sits where light_composite puts it*/
+	stretched.x = 0;
+	stretched.y = 0;
+	stretched.w = lightWidth * lightScale;
+	stretched.h = lightHeight * lightScale;
+	SDL_RenderCopy(renderer, lightTexture, NULL, &stretched);
+}
+
+/**
+ * @brief getter for the light buffer, texels are stored as R, G, B, A bytes with the light of each channel 0 - 255
+ * @param width [out]	if non-null, set to the width of the light buffer in texels
+ * @param height [out]	if non-null, set to the height of the light buffer in texels
+ * @return the light buffer, NULL if the lighting was never initialized
+ */
+Uint8 *light_get_texels(int *width, int *height)
+{
+	if(width)
+	{
+		*width = lightWidth;
+	}
+	if(height)
+	{
+		*height = lightHeight;
+	}
+	return lightTexels;
+}
\ No newline at end of file
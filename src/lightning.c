@@ -1,19 +1,34 @@
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "simple_logger.h"
 
+#include "boltstream.h"
 #include "graphics.h"
+#include "light.h"
 #include "lightning.h"
+#include "raster.h"
+#include "simplify.h"
+#include "vector_batch.h"
 
-static Sprite *middleChunk = NULL;
-static Sprite *rightCap = NULL;
-static Sprite *leftCap = NULL;
-static Vect3d color = {255, 255, 0};
+#define LIGHTNING_GENERATOR_BLOCK	1024		/**< how many points a generator simplifies at a time, fixed so the bolt doesn't depend on where the slices fell */
 
-static Lightning *lightningList = NULL;
-static int lightningNum = 0;
-static int lightningMax = 0;
+#define LIGHTNING_GENERATOR_CHECK	64			/**< how many points a generator makes between looks at the clock */
+
+#define LIGHTNING_LAYER_MIDDLE		0			/**< the layer of the batch the bodies of the segments are in */
+#define LIGHTNING_LAYER_LEFT		1			/**< the layer of the batch the left caps are in */
+#define LIGHTNING_LAYER_RIGHT		2			/**< the layer of the batch the right caps are in */
+#define LIGHTNING_LAYER_CORE		3			/**< added to a layer for the core drawn over the bloom */
+
+static void lightning_batch_segment(LightningSystem *system, Vect2d start, Vect2d end, float thickness, SDL_Color color);
+static int lightning_measure_segments(LightningSystem *system, Vect2d *points, int numPoints);
+static void lightning_batch_measured(LightningSystem *system, Vect2d *points, int first, int numPoints, Vect2d offset, float thickness, SDL_Color color);
+static SDL_Color lightning_vertex_color(Vect3d color, int alpha, float intensity);
+static void lightning_bolt_uncache(LightningSystem *system, Bolt *bolt);
+static int lightning_cache_make_room(LightningSystem *system, size_t bytes, Bolt *keep, int thisFrame);
+static int lightning_bolt_trail_start(Bolt *bolt, int numPoints, int *returnStroke);
 
 /**
  * @brief sorts the linked list given to it by the pos, smallest to largest, recursively calls itself to shorten until comparing one position to the last position in the list
@@ -27,8 +42,7 @@ Position *sort_positions(Position *head)
 
 	if(!head || !head->next)
 	{
-		slog("list is already sorted/doesn't exist");
-		return;
+		return head;
 	}
 	current = head;
 	smallest = head;
@@ -68,63 +82,131 @@ Position *sort_positions(Position *head)
 }
 
 /**
- * @brief initializes the lightning memory management system, also loads the sprites needed to draw the lightning
+ * @brief creates a lightning system and its memory, also loads the sprites needed to draw the lightning
+ * @param sprites [in,out]	the sprite system to load the sprites from and draw them with
  * @param maxLightning		the maximum amount of lightning segments that can exist at a time
+ * @param maxBolts			the maximum amount of polyline bolts that can exist at a time
+ * @return the new lightning system, NULL if it could not be allocated
  */
-void lightning_init_system(int maxLightning)
+LightningSystem *lightning_system_new(SpriteSystem *sprites, int maxLightning, int maxBolts)
 {
-	int i;
+	LightningSystem *system;
 	if(maxLightning == 0)
 	{
 		slog("Max Lightning == 0");
-		return;
+		return NULL;
+	}
+	system = (LightningSystem *)malloc(sizeof(LightningSystem));
+	if(!system)
+	{
+		slog("lightning system failed to initialize");
+		return NULL;
 	}
-	lightningList = (Lightning *)malloc(sizeof(Lightning) * maxLightning);
-	if(!lightningList)
+	memset(system, 0, sizeof(LightningSystem));
+
+	system->lightningList = (Lightning *)malloc(sizeof(Lightning) * maxLightning);
+	if(!system->lightningList)
 	{
 		slog("lightningList failed to initialize");
-		return;
+		lightning_system_free(&system);
+		return NULL;
+	}
+	memset(system->lightningList, 0, sizeof(Lightning) * maxLightning);
+	system->lightningNum = 0;
+	system->lightningMax = maxLightning;
+
+	if(maxBolts > 0)
+	{
+		system->boltList = (Bolt *)malloc(sizeof(Bolt) * maxBolts);
+		if(!system->boltList)
+		{
+			slog("boltList failed to initialize");
+			lightning_system_free(&system);
+			return NULL;
+		}
+		memset(system->boltList, 0, sizeof(Bolt) * maxBolts);
 	}
-	memset(lightningList, 0, sizeof(Lightning) * maxLightning);
-	
-	middleChunk = sprite_load("images/middle_chunk.png", vect2d_new(1, 8), 1, 1);
-	leftCap = sprite_load("images/left_cap.png", vect2d_new(4, 8), 1, 1);
-	rightCap = sprite_load("images/right_cap.png", vect2d_new(4, 8), 1, 1);
+	system->boltNum = 0;
+	system->boltMax = maxBolts;
+
+	system->sprites = sprites;
+	system->middleChunk = sprite_load(sprites, LIGHTNING_MIDDLE_IMAGE, vect2d_new(1, 8), 1, 1);
+	system->leftCap = sprite_load(sprites, LIGHTNING_LEFT_IMAGE, vect2d_new(4, 8), 1, 1);
+	system->rightCap = sprite_load(sprites, LIGHTNING_RIGHT_IMAGE, vect2d_new(4, 8), 1, 1);
+
+	system->color = vect3d_new(255, 255, 0);
+	system->alpha = 255;
+	system->simplifyTolerance = SIMPLIFY_TOLERANCE;
+	/*bolts are only cached where they can be drawn into a texture*/
+	system->cacheBudget = sprites && SDL_RenderTargetSupported(sprites->renderer) ? LIGHTNING_CACHE_BUDGET : 0;
+	return system;
+}
 
-	lightningNum = 0;
-	lightningMax = maxLightning;
-	atexit(lightning_close_system);
+/**
+ * @brief seeds the random state the system generates its bolts and flickers their bloom with, so the same seed always makes the same
+ *			bolts whatever other systems or rand are doing on other threads
+ * @param system [in,out]	the lightning system to seed
+ * @param seed				the seed, any value works
+ */
+void lightning_system_seed(LightningSystem *system, Uint32 seed)
+{
+	system->randState = seed;
 }
 
 /**
- * @brief closes the lightning memory management system
+ * @brief frees a lightning system, its pools and its references to its sprites, and destroys the pointer to it
+ * @param system [in,out]	the lightning system to free
  */
-void lightning_close_system()
+void lightning_system_free(LightningSystem **system)
 {
 	int i;
-	Lightning *lightning = NULL;
-	if(!lightningList)
+	LightningSystem *target;
+	if(!system || !*system)
 	{
-		slog("lightningList not initialized");
 		return;
 	}
-	for(i = 0; i < lightningMax; ++i)
+	target = *system;
+
+	if(target->simplifyBefore > 0)
+	{
+		slog("simplification kept %u of %u bolt points (%f of the segments drawn)",
+			(Uint32)target->simplifyAfter, (Uint32)target->simplifyBefore, lightning_get_simplify_ratio(target));
+	}
+
+	free(target->lightningList);
+	for(i = 0; i < target->boltMax; ++i)
+	{
+		lightning_bolt_uncache(target, &target->boltList[i]);
+		free(target->boltList[i].points);
+	}
+	free(target->boltList);
+	free(target->scratchPoints);
+	for(i = 0; i < LIGHTNING_LAYERS; i++)
+	{
+		free(target->batchVertices[i]);
+	}
+	free(target->batchIndices);
+	free(target->segmentLengths);
+	free(target->segmentDirections);
+	if(target->trail)
 	{
-		lightning = &lightningList[i];
-		lightning_free(&lightning);
+		SDL_DestroyTexture(target->trail);
 	}
 
-	free(lightningList);
-	lightningList = NULL;
-	lightningNum = 0;
-	lightningMax = 0;
+	sprite_free(target->sprites, &target->middleChunk);
+	sprite_free(target->sprites, &target->leftCap);
+	sprite_free(target->sprites, &target->rightCap);
+
+	free(target);
+	*system = NULL;
 }
 
 /**
  * @brief frees a lightning segment from the lightningList and destroys the pointer to it so anything with a pointer to that lightning segment is destroyed
+ * @param system [in,out]			the lightning system the lightning belongs to
  * @param lightning [in,out]		the lightning that is to be removed from memory
  */
-void lightning_free(Lightning **lightning)
+void lightning_free(LightningSystem *system, Lightning **lightning)
 {
 	Lightning *target;
 	if(!lightning)
@@ -138,46 +220,47 @@ void lightning_free(Lightning **lightning)
 	target = *lightning;
 
 	target->inUse = 0;
-	lightningNum--;
+	system->lightningNum--;
 	*lightning = NULL;
 }
 
 /**
  * @brief creates a new lightning in the lightningList with the given info
+ * @param system [in,out]	the lightning system to create it in
  * @param start		vect2d of the starting point for the lightning
  * @param end		vect2d of the ending point for the lightning
  * @param thickness	how thick the lightning will be 
  * @return pointer to the position in the lightningList where the newly created lightning exists
  */
-Lightning *lightning_new(Vect2d start, Vect2d end, float thickness)
+Lightning *lightning_new(LightningSystem *system, Vect2d start, Vect2d end, float thickness)
 {
 	int i;
 	Lightning *lightning = NULL;
 
-	if(!lightningList)
+	if(!system || !system->lightningList)
 	{
 		slog("lightningList uninitialized");
 		return NULL;
 	}
 
-	if(lightningNum + 1 > lightningMax)
+	if(system->lightningNum + 1 > system->lightningMax)
 	{
 		slog("Maximum Lightning Reached.");
 		exit(1);
 	}
 
-	for(i = 0; i < lightningMax; i++)
+	for(i = 0; i < system->lightningMax; i++)
 	{
-		if(!lightningList[i].inUse)
+		if(!system->lightningList[i].inUse)
 		{
-			lightning = &lightningList[i];
+			lightning = &system->lightningList[i];
 			break;
 		}
 	}
 
 	memset(lightning,0,sizeof(Lightning));
 
-	lightningNum++;
+	system->lightningNum++;
 	lightning->inUse = 1;
 	lightning->start = start;
 	lightning->end = end;
@@ -189,164 +272,685 @@ Lightning *lightning_new(Vect2d start, Vect2d end, float thickness)
 }
 
 /**
- * @brief draws the lightning to the renderer using the statically held sprites, also draws the bloom for the lightning
- *			uses trig to determine how long the lightning should be, and what angle it should be drawn at
- * @param self [in]	the lightning that is to be drawn
+ * @brief queues the lightning and its bloom in the system's color onto the system's batch of geometry, which lightning_draw_all
+ *			draws with one call per sprite. uses trig to determine how long the lightning should be, and what angle it should be drawn at
+ * @param system [in,out]	the lightning system the lightning belongs to
+ * @param self [in]			the lightning that is to be drawn
+ */
+void lightning_draw(LightningSystem *system, Lightning *self)
+{
+	lightning_batch_segment(system, self->start, self->end, self->thickness, lightning_vertex_color(system->color, system->alpha, 1));
+}
+
+/**
+ * @brief the sprite a layer of the batch is drawn with
+ * @param system [in]	the lightning system
+ * @param layer			which layer of the batch
+ * @return the body, the left cap or the right cap
+ */
+static Sprite *lightning_layer_sprite(LightningSystem *system, int layer)
+{
+	switch(layer % LIGHTNING_LAYER_CORE)
+	{
+		case LIGHTNING_LAYER_LEFT:
+			return system->leftCap;
+		case LIGHTNING_LAYER_RIGHT:
+			return system->rightCap;
+		default:
+			return system->middleChunk;
+	}
+}
+
+/**
+ * @brief makes room for one more quad in a layer of the system's batch
+ * @param system [in,out]	the lightning system
+ * @param layer				which layer of the batch
+ * @return the quad's four vertices to fill in, NULL if the layer could not grow
+ */
+static SDL_Vertex *lightning_batch_quad(LightningSystem *system, int layer)
+{
+	int max;
+	SDL_Vertex *grown;
+
+	if(system->batchNum[layer] + 4 > system->batchMax[layer])
+	{
+		max = MAX(1024, system->batchMax[layer] * 2);
+		grown = (SDL_Vertex *)realloc(system->batchVertices[layer], sizeof(SDL_Vertex) * max);
+		if(!grown)
+		{
+			slog("lightning batch failed to grow");
+			return NULL;
+		}
+		system->batchVertices[layer] = grown;
+		system->batchMax[layer] = max;
+	}
+	system->batchNum[layer] += 4;
+	return &system->batchVertices[layer][system->batchNum[layer] - 4];
+}
+
+/**
+ * @brief queues a sprite placed the way SDL_RenderCopyEx places it, rotated about its top left corner
+ * @param system [in,out]	the lightning system
+ * @param layer				which layer of the batch, which also picks the sprite
+ * @param corner			where the top left corner of the sprite goes
+ * @param size				the width and height the sprite is drawn at
+ * @param direction			unit vector the top edge of the sprite runs along
+ * @param color				the color and alpha of every vertex
+ */
+static void lightning_batch_sprite(LightningSystem *system, int layer, Vect2d corner, Vect2d size, Vect2d direction, SDL_Color color)
+{
+	int i;
+	Sprite *sprite = lightning_layer_sprite(system, layer);
+	SDL_Vertex *quad = lightning_batch_quad(system, layer);
+
+	if(!quad)
+	{
+		return;
+	}
+	quad[0].position.x = corner.x;
+	quad[0].position.y = corner.y;
+	quad[1].position.x = corner.x + direction.x * size.x;
+	quad[1].position.y = corner.y + direction.y * size.x;
+	quad[2].position.x = quad[1].position.x - direction.y * size.y;
+	quad[2].position.y = quad[1].position.y + direction.x * size.y;
+	quad[3].position.x = corner.x - direction.y * size.y;
+	quad[3].position.y = corner.y + direction.x * size.y;
+	quad[0].tex_coord.x = quad[3].tex_coord.x = 0;
+	quad[1].tex_coord.x = quad[2].tex_coord.x = sprite->frameSize.x / sprite->imageSize.x;
+	quad[0].tex_coord.y = quad[1].tex_coord.y = 0;
+	quad[2].tex_coord.y = quad[3].tex_coord.y = sprite->frameSize.y / sprite->imageSize.y;
+	for(i = 0; i < 4; i++)
+	{
+		quad[i].color = color;
+	}
+}
+
+/**
+ * @brief the random numbers bolts are generated with, from a state of their own instead of rand so threads never share one
+ * @param state [in,out]	xorshift state to draw from, 0 starts from a fixed seed
+ * @return a random number between 0 and RAND_MAX
+ */
+static int lightning_rand(Uint32 *state)
+{
+	Uint32 x;
+	x = *state ? *state : 0x9e3779b9;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return (int)(x % ((Uint32)RAND_MAX + 1));
+}
+
+/**
+ * @brief queues a sprite's bloom, the sprite grown by a random amount on every side so the glow flickers
+ * @param system [in,out]	the lightning system
+ * @param layer				which layer of the batch, which also picks the sprite
+ * @param corner			where the top left corner of the sprite goes
+ * @param size				the width and height the sprite is drawn at
+ * @param direction			unit vector the top edge of the sprite runs along
+ * @param color				the color and alpha of every vertex
+ */
+static void lightning_batch_bloom(LightningSystem *system, int layer, Vect2d corner, Vect2d size, Vect2d direction, SDL_Color color)
+{
+	int grow = lightning_rand(&system->randState) % 25;
+
+	corner.x -= grow / 2;
+	corner.y -= grow / 2;
+	size.x += grow;
+	size.y += grow;
+	lightning_batch_sprite(system, layer, corner, size, direction, color);
+}
+
+/**
+ * @brief queues one segment whose length and direction are already known onto the system's batch, its bloom under the body and both caps
+ * @param system [in,out]	the lightning system whose sprites to draw with
+ * @param start		starting point of the segment
+ * @param end		end point of the segment
+ * @param length	length of the segment
+ * @param direction	unit vector the segment runs along, (1, 0) if it has no length
+ * @param thickness	how thick the segment is
+ * @param color		color and alpha of the segment, the bloom is drawn at LIGHTNING_BLOOM_ALPHA of the alpha
  */
-void lightning_draw(Lightning *self)
+static void lightning_batch_oriented(LightningSystem *system, Vect2d start, Vect2d end, float length, Vect2d direction, float thickness, SDL_Color color)
 {
-	Vect2d tangent; 
-	Vect2d leftCapPosition, rightCapPosition;
-	Vect2d middleOrigin, middleScale;
-	float rot, thick;
-	SDL_Point *center = NULL;
+	float thick;
+	Vect2d body, leftCap, rightCap, capSize;
+	SDL_Color glow = color;
+
+	thick = thickness / LIGHTNING_THICKNESS;
+	glow.a = color.a * LIGHTNING_BLOOM_ALPHA / 255;
 
-	center = (SDL_Point *) malloc(sizeof(SDL_Point));
-	memset(center, 0, sizeof(SDL_Point));
+	body = vect2d_new(system->middleChunk->frameSize.x * (length + 1), system->middleChunk->frameSize.y * thick);
+	leftCap = vect2d_new(start.x - thick, start.y - thick);
+	rightCap = end;
+	vect2d_scale(capSize, system->leftCap->frameSize, thick);
 
-	vect2d_subtract(self->end, self->start, tangent);
-	rot = atan2(tangent.y, tangent.x) * 57.2957795;
-	thick = self->thickness / LIGHTNING_THICKNESS;
+	lightning_batch_bloom(system, LIGHTNING_LAYER_MIDDLE, start, body, direction, glow);
+	lightning_batch_bloom(system, LIGHTNING_LAYER_LEFT, leftCap, capSize, direction, glow);
+	lightning_batch_bloom(system, LIGHTNING_LAYER_RIGHT, rightCap, capSize, direction, glow);
 
-	center->x = 0;
-	center->y = 0;
+	lightning_batch_sprite(system, LIGHTNING_LAYER_CORE + LIGHTNING_LAYER_MIDDLE, start, body, direction, color);
+	lightning_batch_sprite(system, LIGHTNING_LAYER_CORE + LIGHTNING_LAYER_LEFT, leftCap, capSize, direction, color);
+	lightning_batch_sprite(system, LIGHTNING_LAYER_CORE + LIGHTNING_LAYER_RIGHT, rightCap, capSize, direction, color);
+}
+
+/**
+ * @brief queues one segment onto the system's batch, its bloom under the body and both caps
+ * @param system [in,out]	the lightning system whose sprites to draw with
+ * @param start		starting point of the segment
+ * @param end		end point of the segment
+ * @param thickness	how thick the segment is
+ * @param color		color and alpha of the segment, the bloom is drawn at LIGHTNING_BLOOM_ALPHA of the alpha
+ */
+static void lightning_batch_segment(LightningSystem *system, Vect2d start, Vect2d end, float thickness, SDL_Color color)
+{
+	float length;
+	Vect2d tangent, direction;
 
-	SDL_SetTextureBlendMode(leftCap->image, SDL_BLENDMODE_BLEND);
-	SDL_SetTextureBlendMode(rightCap->image, SDL_BLENDMODE_BLEND);
-	sprite_bloom_draw(middleChunk, 1, self->start, vect2d_new(vect2d_get_length(tangent) + 1, thick), center, rot, SDL_FLIP_NONE);
-	sprite_bloom_draw(leftCap, 1, vect2d_new(self->start.x - thick, self->start.y - thick), vect2d_new(thick, thick), center, rot, SDL_FLIP_NONE);
-	sprite_bloom_draw(rightCap, 1, self->end, vect2d_new(thick, thick), center, rot, SDL_FLIP_NONE);
+	vect2d_subtract(end, start, tangent);
+	length = vect2d_get_length(tangent);
+	direction = length > 0 ? vect2d_new(tangent.x / length, tangent.y / length) : vect2d_new(1, 0);
+	lightning_batch_oriented(system, start, end, length, direction, thickness, color);
+}
 
-	sprite_draw(middleChunk, 1, self->start, vect2d_new(vect2d_get_length(tangent) + 1, thick), center, rot, SDL_FLIP_NONE);
-	sprite_draw(leftCap, 1, vect2d_new(self->start.x - thick, self->start.y - thick), vect2d_new(thick, thick), center, rot, SDL_FLIP_NONE);
-	sprite_draw(rightCap, 1, self->end, vect2d_new(thick, thick), center, rot, SDL_FLIP_NONE);
+/**
+ * @brief measures every segment of a bolt at once into the system's segmentLengths and segmentDirections, growing them if needed
+ * @param system [in,out]	the lightning system
+ * @param points [in]		the bolt's points
+ * @param numPoints			how many of them are drawn
+ * @return 1 if the segments were measured, 0 if there was no room for them
+ */
+static int lightning_measure_segments(LightningSystem *system, Vect2d *points, int numPoints)
+{
+	int max;
+	float *lengths;
+	Vect2d *directions;
 
+	if(numPoints < 2)
+	{
+		return 0;
+	}
+	if(numPoints - 1 > system->segmentMax)
+	{
+		max = MAX(256, numPoints - 1);
+		lengths = (float *)realloc(system->segmentLengths, sizeof(float) * max);
+		if(lengths)
+		{
+			system->segmentLengths = lengths;
+		}
+		directions = (Vect2d *)realloc(system->segmentDirections, sizeof(Vect2d) * max);
+		if(directions)
+		{
+			system->segmentDirections = directions;
+		}
+		if(!lengths || !directions)
+		{
+			slog("lightning failed to grow its segment measurements");
+			return 0;
+		}
+		system->segmentMax = max;
+	}
+	vect2d_batch_segments(points, numPoints, system->segmentLengths, NULL, system->segmentDirections);
+	return 1;
 }
 
 /**
- * @brief draw all lighting in the lightningList that has a draw function. Also color mods the sprites that all lightning share periodically to go throught the rainbow.
+ * @brief queues the segments of a bolt measured by lightning_measure_segments onto the system's batch
+ * @param system [in,out]	the lightning system
+ * @param points [in]		the bolt's points, the ones that were measured
+ * @param first				the first segment to queue
+ * @param numPoints			how many of the points are drawn
+ * @param offset			added to every point
+ * @param thickness			how thick the segments are
+ * @param color				color and alpha of every segment
  */
-void lightning_draw_all()
+static void lightning_batch_measured(LightningSystem *system, Vect2d *points, int first, int numPoints, Vect2d offset, float thickness, SDL_Color color)
 {
 	int i;
-	static int alpha = 255;
-	static int red = 0;
-	static int green = 1;
-	static int blue = 0;
-	static int up = 0;
+	Vect2d start, end;
 
-	SDL_SetTextureAlphaMod(middleChunk->image, alpha);
-	SDL_SetTextureAlphaMod(rightCap->image, alpha);
-	SDL_SetTextureAlphaMod(leftCap->image, alpha);
+	for(i = first; i + 1 < numPoints; i++)
+	{
+		vect2d_add(points[i], offset, start);
+		vect2d_add(points[i + 1], offset, end);
+		lightning_batch_oriented(system, start, end, system->segmentLengths[i], system->segmentDirections[i], thickness, color);
+	}
+}
 
-	SDL_SetTextureColorMod(leftCap->image, color.r, color.g, color.b);
-	SDL_SetTextureColorMod(middleChunk->image, color.r, color.g, color.b);
-	SDL_SetTextureColorMod(rightCap->image, color.r, color.g, color.b);
+/**
+ * @brief draws everything queued on the system's batch onto the current render target, one call per layer, and empties it.
+ *			the colors are all in the vertices, so the sprites' own color and alpha are left untinted
+ * @param system [in,out]	the lightning system
+ */
+static void lightning_batch_submit(LightningSystem *system)
+{
+	int i, layer, quads = 0;
+	int *grown;
+	Sprite *sprite;
 
-	if(red)
+	for(layer = 0; layer < LIGHTNING_LAYERS; layer++)
+	{
+		quads = MAX(quads, system->batchNum[layer] / 4);
+	}
+	if(quads * 6 > system->batchIndexMax)
 	{
-		if(up)
+		grown = (int *)realloc(system->batchIndices, sizeof(int) * quads * 6);
+		if(!grown)
 		{
-			color.r += 5;
-			if(color.r >= 255)
-			{
-				color.r = 255;
-				up = 0;
-				red = 0;
-				green = 1;
-			}
+			slog("lightning batch indices failed to grow");
+			memset(system->batchNum, 0, sizeof(system->batchNum));
+			return;
+		}
+		/*every quad is split the same way, so the indices only ever need to be written once*/
+		for(i = system->batchIndexMax / 6; i < quads; i++)
+		{
+			grown[i * 6] = i * 4;
+			grown[i * 6 + 1] = i * 4 + 1;
+			grown[i * 6 + 2] = i * 4 + 2;
+			grown[i * 6 + 3] = i * 4;
+			grown[i * 6 + 4] = i * 4 + 2;
+			grown[i * 6 + 5] = i * 4 + 3;
+		}
+		system->batchIndices = grown;
+		system->batchIndexMax = quads * 6;
+	}
+
+	for(layer = 0; layer < LIGHTNING_LAYERS; layer++)
+	{
+		if(!system->batchNum[layer])
+		{
+			continue;
+		}
+		sprite = lightning_layer_sprite(system, layer);
+		SDL_SetTextureBlendMode(sprite->image, SDL_BLENDMODE_BLEND);
+		SDL_SetTextureColorMod(sprite->image, 255, 255, 255);
+		SDL_SetTextureAlphaMod(sprite->image, 255);
+		if(SDL_RenderGeometry(system->sprites->renderer, sprite->image, system->batchVertices[layer], system->batchNum[layer],
+			system->batchIndices, system->batchNum[layer] / 4 * 6) != 0)
+		{
+			slog("unable to draw the lightning: %s", SDL_GetError());
+		}
+		system->batchNum[layer] = 0;
+	}
+}
+
+/**
+ * @brief a color as the color of a vertex
+ * @param color		the color, each component 0 - 255
+ * @param alpha		the alpha, 0 - 255
+ * @param intensity	multiplies the color, what goes past 255 is lost
+ * @return the vertex color
+ */
+static SDL_Color lightning_vertex_color(Vect3d color, int alpha, float intensity)
+{
+	SDL_Color vertex;
+
+	vertex.r = (Uint8)MIN(MAX(color.r * intensity, 0), 255);
+	vertex.g = (Uint8)MIN(MAX(color.g * intensity, 0), 255);
+	vertex.b = (Uint8)MIN(MAX(color.b * intensity, 0), 255);
+	vertex.a = (Uint8)MIN(MAX(alpha, 0), 255);
+	return vertex;
+}
+
+/**
+ * @brief the light a bolt adds where it is drawn additively, its color scaled by its intensity and alpha
+ * @param bolt [in]	the bolt
+ * @return the light, each component 0 - 255 and more for a bolt brighter than its color
+ */
+static Vect3d lightning_bolt_light(Bolt *bolt)
+{
+	Vect3d light;
+	vect3d_scale(light, bolt->color, bolt->intensity * bolt->alpha / 255.0f);
+	return light;
+}
+
+/**
+ * @brief the color of the rainbow at a time, fading one channel at a time from yellow through red, magenta, blue, cyan and green
+ * @param time		milliseconds, the rainbow goes around once every LIGHTNING_RAINBOW_TIME
+ * @param hue		how far around the rainbow to start, 0 - 1
+ * @return the color, each component 0 - 255
+ */
+Vect3d lightning_rainbow(Uint32 time, float hue)
+{
+	int leg;
+	float turn, rise;
+
+	turn = (float)(time % LIGHTNING_RAINBOW_TIME) / LIGHTNING_RAINBOW_TIME + hue;
+	turn = (turn - floor(turn)) * 6;
+	leg = MIN((int)turn, 5);
+	rise = (turn - leg) * 255;
+	switch(leg)
+	{
+		case 0:
+			return vect3d_new(255, 255 - rise, 0);
+		case 1:
+			return vect3d_new(255, 0, rise);
+		case 2:
+			return vect3d_new(255 - rise, 0, 255);
+		case 3:
+			return vect3d_new(0, rise, 255);
+		case 4:
+			return vect3d_new(0, 255, 255 - rise);
+		default:
+			return vect3d_new(rise, 255, 0);
+	}
+}
+
+/**
+ * @brief moves the system's color and the color of every bolt following the rainbow to where the rainbow is now
+ * @param system [in,out]	the lightning system
+ */
+static void lightning_update_colors(LightningSystem *system)
+{
+	int i;
+	Uint32 now = get_time();
+
+	system->color = lightning_rainbow(now, 0);
+	for(i = 0; i < system->boltMax; i++)
+	{
+		if(system->boltList[i].inUse && system->boltList[i].rainbow)
+		{
+			system->boltList[i].color = lightning_rainbow(now, system->boltList[i].hue);
+		}
+	}
+}
+
+/**
+ * @brief draws whatever is new of the lightning and bolts onto the current render target, each in its own color, and marks it as
+ *			being in the trail
+ * @param system [in,out]	the lightning system
+ */
+static void lightning_feed_trail(LightningSystem *system)
+{
+	int i, first, numPoints, returnStroke;
+	Lightning *lightningList = system->lightningList;
+	Bolt *boltList = system->boltList;
+	SDL_Color color = lightning_vertex_color(system->color, system->alpha, 1);
+
+	for(i = 0; i < system->lightningMax; i++)
+	{
+		if(lightningList[i].inUse && lightningList[i].draw && !lightningList[i].trailed)
+		{
+			lightningList[i].trailed = 1;
+			lightning_batch_segment(system, lightningList[i].start, lightningList[i].end, lightningList[i].thickness, color);
+		}
+	}
+	for(i = 0; i < system->boltMax; i++)
+	{
+		if(!boltList[i].inUse || !boltList[i].draw)
+		{
+			continue;
+		}
+		numPoints = lightning_bolt_drawn(&boltList[i]);
+		first = lightning_bolt_trail_start(&boltList[i], numPoints, &returnStroke);
+		if((first + 1 >= numPoints && !returnStroke) || !lightning_measure_segments(system, boltList[i].points, numPoints))
+		{
+			continue;
+		}
+		color = lightning_vertex_color(boltList[i].color, boltList[i].alpha, boltList[i].intensity);
+		lightning_batch_measured(system, boltList[i].points, first, numPoints, vect2d_new(0, 0), boltList[i].thickness, color);
+		if(returnStroke)
+		{
+			lightning_batch_measured(system, boltList[i].points, 0, numPoints, vect2d_new(0, 0), boltList[i].thickness * LIGHTNING_RETURN_SCALE, color);
+		}
+	}
+	lightning_batch_submit(system);
+}
+
+/**
+ * @brief fades the trail, draws it onto the screen under everything drawn after it, then draws what is new of the bolts into it.
+ *			the trail is created the first time, opaque black so it can be added onto the screen
+ * @param system [in,out]	the lightning system
+ */
+static void lightning_draw_trail(LightningSystem *system)
+{
+	Uint8 r, g, b, a, fade;
+	SDL_BlendMode mode, subtract;
+	SDL_Texture *previous;
+	SDL_Renderer *renderer = system->sprites->renderer;
+
+	previous = SDL_GetRenderTarget(renderer);
+	SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+	SDL_GetRenderDrawBlendMode(renderer, &mode);
+	if(!system->trail)
+	{
+		system->trail = SDL_RenderTargetSupported(renderer) ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT) : NULL;
+		if(!system->trail)
+		{
+			slog("unable to create the trail, the bolts are drawn without one: %s", SDL_GetError());
+			system->trailFade = 0;
+			return;
+		}
+		SDL_SetTextureBlendMode(system->trail, SDL_BLENDMODE_ADD);
+		SDL_SetRenderTarget(renderer, system->trail);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+		SDL_RenderClear(renderer);
+	}
+	else
+	{
+		/*multiplying by the fade as a color fades the whole trail with one quad*/
+		fade = (Uint8)(system->trailFade * 255 + 0.5f);
+		SDL_SetRenderTarget(renderer, system->trail);
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_MOD);
+		SDL_SetRenderDrawColor(renderer, fade, fade, fade, 255);
+		SDL_RenderFillRect(renderer, NULL);
+
+		/*a GPU rounds the multiply to the nearest step, which leaves the dimmest light stuck, so one step is taken off too where it can be*/
+		subtract = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_REV_SUBTRACT,
+			SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD);
+		if(SDL_SetRenderDrawBlendMode(renderer, subtract) == 0)
+		{
+			SDL_SetRenderDrawColor(renderer, 1, 1, 1, 255);
+			SDL_RenderFillRect(renderer, NULL);
+		}
+		SDL_SetRenderTarget(renderer, previous);
+		SDL_RenderCopy(renderer, system->trail, NULL, NULL);
+		SDL_SetRenderTarget(renderer, system->trail);
+	}
+	/*drawn in after the trail went on the screen, the bolts that are new show once this frame, drawn live*/
+	lightning_feed_trail(system);
+	SDL_SetRenderTarget(renderer, previous);
+	SDL_SetRenderDrawBlendMode(renderer, mode);
+	SDL_SetRenderDrawColor(renderer, r, g, b, a);
+}
+
+/**
+ * @brief draw all lighting in the lightningList and all bolts in the boltList that have a draw function, each in its own color, as one
+ *			batch of geometry per sprite. with a trail, the trail is drawn first and what is new of the bolts is added to it
+ * @param system [in,out]	the lightning system to draw
+ */
+void lightning_draw_all(LightningSystem *system)
+{
+	int i;
+
+	lightning_update_colors(system);
+	if(system->trailFade > 0 && system->sprites)
+	{
+		lightning_draw_trail(system);
+	}
+	system->cacheFrame++;
+
+	//alpha = 100 * (1 + sin(get_time() * 2 * 3.14 / 2000));
+
+	for(i = 0; i < system->lightningMax; i++)
+	{
+		if(system->lightningList[i].inUse && system->lightningList[i].draw)
+		{
+			system->lightningList[i].draw(system, &system->lightningList[i]);
+		}
+	}
+	for(i = 0; i < system->boltMax; i++)
+	{
+		if(system->boltList[i].inUse && system->boltList[i].draw)
+		{
+			system->boltList[i].draw(system, &system->boltList[i]);
+		}
+	}
+	lightning_batch_submit(system);
+}
+
+/**
+ * @brief queues every lightning and bolt that has a draw function onto the CPU rasterizer, in the same colors as lightning_draw_all.
+ *			with a trail, what is new of the bolts is queued with raster_add_trail_segment instead
+ * @param system [in,out]	the lightning system to draw
+ */
+void lightning_raster_all(LightningSystem *system)
+{
+	int i, j, first, numPoints, returnStroke = 0;
+	Lightning *lightningList = system->lightningList;
+	Bolt *boltList = system->boltList;
+	Vect3d color;
+
+	lightning_update_colors(system);
+	color = system->color;
+	for(i = 0; i < system->lightningMax; i++)
+	{
+		if(!lightningList[i].inUse || !lightningList[i].draw)
+		{
+			continue;
+		}
+		if(system->trailFade > 0 && !lightningList[i].trailed)
+		{
+			lightningList[i].trailed = 1;
+			raster_add_trail_segment(lightningList[i].start, lightningList[i].end, lightningList[i].thickness, color);
 		}
 		else
 		{
-			color.r -= 5;
-			if(color.r <= 0)
-			{
-				color.r = 0;
-				red = 0;
-				green = 1;
-				up = 1;
-			}
+			raster_add_segment(lightningList[i].start, lightningList[i].end, lightningList[i].thickness, color);
 		}
 	}
-	if(green)
+	for(i = 0; i < system->boltMax; i++)
 	{
-		if(up)
+		if(!boltList[i].inUse || !boltList[i].draw)
+		{
+			continue;
+		}
+		numPoints = lightning_bolt_drawn(&boltList[i]);
+		first = system->trailFade > 0 ? lightning_bolt_trail_start(&boltList[i], numPoints, &returnStroke) : numPoints;
+		color = lightning_bolt_light(&boltList[i]);
+		for(j = 0; j + 1 < numPoints; j++)
 		{
-			color.g += 5;
-			if(color.g >= 255)
+			if(j >= first)
+			{
+				raster_add_trail_segment(boltList[i].points[j], boltList[i].points[j + 1], boltList[i].thickness, color);
+			}
+			else
 			{
-				color.g = 255;
-				up = 0;
-				green = 0;
-				blue = 1;
+				raster_add_segment(boltList[i].points[j], boltList[i].points[j + 1], boltList[i].thickness, color);
 			}
 		}
-		else
+		if(boltList[i].returnStroke)
 		{
-			color.g -= 5;
-			if(color.g <= 0)
+			/*the rasterizer adds light, so a second thicker pass brightens the bolt the same way the sprites do*/
+			for(j = 0; j + 1 < numPoints; j++)
 			{
-				color.g = 0;
-				green = 0;
-				blue = 1;
-				up = 1;
+				if(returnStroke)
+				{
+					raster_add_trail_segment(boltList[i].points[j], boltList[i].points[j + 1], boltList[i].thickness * LIGHTNING_RETURN_SCALE, color);
+				}
+				else
+				{
+					raster_add_segment(boltList[i].points[j], boltList[i].points[j + 1], boltList[i].thickness * LIGHTNING_RETURN_SCALE, color);
+				}
 			}
 		}
 	}
-	if(blue)
+}
+
+/**
+ * @brief queues every bolt that has a draw function as a line light on the background in its own color, and every lightning segment
+ *			together as one light in the system's color
+ * @param system [in,out]	the lightning system to light with
+ */
+void lightning_light_all(LightningSystem *system)
+{
+	int i, count = 0, stride, kept = 0;
+	Lightning *lightningList = system->lightningList;
+	Bolt *boltList = system->boltList;
+
+	lightning_update_colors(system);
+	for(i = 0; i < system->lightningMax; i++)
+	{
+		if(lightningList[i].inUse && lightningList[i].draw)
+		{
+			count++;
+		}
+	}
+	/*a grown bolt is thousands of short segments, a spread out handful of them lights the background nearly the same at a fraction of the cost*/
+	stride = (count + LIGHT_MAX_SEGMENTS - 1) / LIGHT_MAX_SEGMENTS;
+	if(count > 0 && light_add_light(system->color, LIGHT_RADIUS, LIGHT_INTENSITY))
 	{
-		if(up)
+		for(i = 0; i < system->lightningMax; i++)
 		{
-			color.b += 5;
-			if(color.b >= 255)
+			if(lightningList[i].inUse && lightningList[i].draw && kept++ % stride == 0)
 			{
-				color.b = 255;
-				up = 0;
-				blue = 0;
-				red = 1;
+				light_add_segment(lightningList[i].start, lightningList[i].end);
 			}
 		}
-		else
+	}
+	for(i = 0; i < system->boltMax; i++)
+	{
+		if(boltList[i].inUse && boltList[i].draw)
 		{
-			color.b -= 5;
-			if(color.b <= 0)
-			{
-				color.b = 0;
-				blue = 0;
-				red = 1;
-				up = 1;
-			}
+			light_add_polyline(boltList[i].points, lightning_bolt_drawn(&boltList[i]), boltList[i].color, LIGHT_RADIUS,
+				LIGHT_INTENSITY * boltList[i].intensity * boltList[i].alpha / 255.0f * (boltList[i].returnStroke ? LIGHTNING_RETURN_SCALE : 1));
 		}
 	}
+}
 
-	//alpha = 100 * (1 + sin(get_time() * 2 * 3.14 / 2000));
+/**
+ * @brief adds every lightning and bolt that has a draw function to the bolt stream's frame, a lightning segment goes in as a bolt of two points
+ * @param system [in]	the lightning system to publish
+ */
+void lightning_publish_all(LightningSystem *system)
+{
+	int i;
+	Vect2d ends[2];
+	Lightning *lightningList = system->lightningList;
+	Bolt *boltList = system->boltList;
 
-	for(i = 0; i < lightningMax; i++)
+	for(i = 0; i < system->lightningMax; i++)
 	{
 		if(lightningList[i].inUse && lightningList[i].draw)
 		{
-			lightningList[i].draw(&lightningList[i]);
+			ends[0] = lightningList[i].start;
+			ends[1] = lightningList[i].end;
+			boltstream_add_bolt(ends, 2, lightningList[i].thickness);
+		}
+	}
+	for(i = 0; i < system->boltMax; i++)
+	{
+		if(boltList[i].inUse && boltList[i].draw)
+		{
+			boltstream_add_bolt(boltList[i].points, lightning_bolt_drawn(&boltList[i]), boltList[i].thickness);
 		}
 	}
 }
 
 /**
- * @breif creates the actual bolt of lightning, generates points randomly on the line segment, based on how long it is. 
+ * @brief generates the points of a bolt, generates points randomly on the line segment, based on how long it is. 
  *			Then sorts the linked list of points on the line. Finally randomly displace the points under parameters of the previous point,
  *			and predefined values for sway and jaggedness that we want the bolt to have.
- * @param main_lightning [in]	the main lightning, that defines the start and end of the bolt we are about to make
- * @param thickness				the thickness of the bolt we are creating
+ * @param start				starting point of the bolt
+ * @param end				end point of the bolt
+ * @param thickness			the thickness of the bolt we are creating, has to be positive
+ * @param state [in,out]	random state to generate with
+ * @param points [in,out]	the array to write the points to, grown with realloc if it is too small
+ * @param maxPoints [in,out]	how many points fit in points
+ * @return the number of points written, the first is start and the last is end. 0 if the thickness isn't positive, the bolt
+ *			would need more points than an int holds or the points could not be allocated
  */
-void lightning_create_bolt(Lightning *main_lightning, float thickness)
+static int lightning_generate_points(Vect2d start, Vect2d end, float thickness, Uint32 *state, Vect2d **points, int *maxPoints)
 {
 	int i;
+	int count, numPoints = 0;
 	Vect2d tangent;
 	Vect2d normal;
 	float length;
+	Position *nodes = NULL;
 	Position *headPosition = NULL;
 	Position *currentPosition;
 
-	Vect2d prevPoint = main_lightning->start;
 	float prevDisplacement = 0;
 	float pos, prevPos;
 	float scale;
@@ -354,32 +958,63 @@ void lightning_create_bolt(Lightning *main_lightning, float thickness)
 	float displacement;
 	Vect2d point;
 	Vect2d temp, temp2;
+	Vect2d *grown;
+	double steps;
 
-	vect2d_subtract(main_lightning->end, main_lightning->start, tangent);
+	vect2d_subtract(end, start, tangent);
 	normal = vect2d_new(tangent.y, -tangent.x);
 	vect2d_normalize(&normal);
 	length = vect2d_get_length(tangent);
 
-	headPosition = (Position *)malloc(sizeof(Position));
-	currentPosition = headPosition;
-	currentPosition->pos = 0;
-	currentPosition->next = (Position *)malloc(sizeof(Position));
-	currentPosition = currentPosition->next;
-	currentPosition->next = NULL;
-
-	for(i = 0; i < length / (thickness * 4); i++)
+	/*every generator comes through here, so a thickness of 0 or a point at infinity is turned away before it becomes a count*/
+	steps = ceil(length / (thickness * 4.0));
+	if(!(thickness > 0) || !(steps < INT_MAX - 2))
 	{
-		currentPosition->pos = ((float)rand() / (float)RAND_MAX/1); //random float between 1 and 0
-		currentPosition->next = (Position *)malloc(sizeof(Position));
+		slog("can't generate a bolt %f long and %f thick", length, thickness);
+		return 0;
+	}
+
+	/*the positions are linked inside one array so the whole list is freed at once*/
+	count = (int)steps;
+	nodes = (Position *)malloc(sizeof(Position) * (count + 2));
+	if(*maxPoints < count + 2)
+	{
+		grown = (Vect2d *)realloc(*points, sizeof(Vect2d) * (count + 2));
+		if(grown)
+		{
+			*points = grown;
+			*maxPoints = count + 2;
+		}
+	}
+	if(!nodes || *maxPoints < count + 2)
+	{
+		slog("bolt points failed to allocate");
+		free(nodes);
+		return 0;
+	}
+
+	headPosition = &nodes[0];
+	currentPosition = headPosition;
+	currentPosition->pos = 0;
+	currentPosition->next = &nodes[1];
+	currentPosition = currentPosition->next;
+	currentPosition->next = NULL;
+
+	for(i = 0; i < length / (thickness * 4); i++)
+	{
+		currentPosition->pos = ((float)lightning_rand(state) / (float)RAND_MAX/1); //random float between 1 and 0
+		currentPosition->next = &nodes[i + 2];
 		currentPosition = currentPosition->next;
 		currentPosition->next = NULL;
 	}
+	currentPosition->pos = 1;
 
 	headPosition = sort_positions(headPosition);
 
+	(*points)[numPoints++] = start;
 	currentPosition = headPosition->next;
 	prevPos = headPosition->pos;
-	while(currentPosition->next != NULL)
+	while(currentPosition && currentPosition->next != NULL)
 	{
 		pos = currentPosition->pos;
 		scale = (length * JAGGEDNESS) * (pos - prevPos);
@@ -393,42 +1028,774 @@ void lightning_create_bolt(Lightning *main_lightning, float thickness)
 			envelope = 1;
 		}
 
-		displacement = (rand() % (2 * SWAY)) - SWAY;
+		displacement = (lightning_rand(state) % (2 * SWAY)) - SWAY;
 		displacement -= (displacement - prevDisplacement) * (1 - scale);
 		displacement *= envelope;
 
 		vect2d_scale(temp, tangent, pos);
 		vect2d_scale(temp2, normal, displacement);
 		vect2d_add(temp, temp2, point); 
-		vect2d_add(point, main_lightning->start, point);
-
-		lightning_new(prevPoint, point, thickness);
+		vect2d_add(point, start, point);
 
+		(*points)[numPoints++] = point;
 
-		prevPoint = point;
 		prevDisplacement = displacement;
 		prevPos = pos;
 		currentPosition = currentPosition->next;
 	}
+	(*points)[numPoints++] = end;
+
+	free(nodes);
+	return numPoints;
+}
+
+/**
+ * @brief drops the points of a freshly generated bolt that are too close to the line through their neighbours to see, and counts
+ *			how many were dropped
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param points [in,out]	the points of the bolt
+ * @param numPoints			how many points the bolt has
+ * @return how many points are left
+ */
+static int lightning_simplify_points(LightningSystem *system, Vect2d *points, int numPoints)
+{
+	int kept = simplify_polyline(points, numPoints, system->simplifyTolerance);
+	system->simplifyBefore += numPoints;
+	system->simplifyAfter += kept;
+	return kept;
+}
+
+/**
+ * @brief sets how far in pixels a point of a bolt may be from the line through its neighbours and still be dropped before the bolt
+ *			is drawn. below a pixel the bolt looks the same with far fewer segments to draw
+ * @param system [in,out]	the lightning system to set it for
+ * @param tolerance			the distance in pixels, 0 keeps every point
+ */
+void lightning_set_simplify_tolerance(LightningSystem *system, float tolerance)
+{
+	system->simplifyTolerance = tolerance;
+}
+
+/**
+ * @brief sets how much texture memory the bolts' cached drawings may use, evicting the least recently drawn until they fit. a bolt is
+ *			drawn into its own texture the first frame it is drawn and that texture is drawn as one quad until the bolt changes
+ * @param system [in,out]	the lightning system to set it for
+ * @param bytes				the budget in bytes, 0 frees every cache and draws the bolts directly
+ */
+void lightning_set_cache_budget(LightningSystem *system, size_t bytes)
+{
+	if(bytes > 0 && (!system->sprites || !SDL_RenderTargetSupported(system->sprites->renderer)))
+	{
+		slog("the renderer can't draw into textures, bolts won't be cached");
+		bytes = 0;
+	}
+	system->cacheBudget = bytes;
+	lightning_cache_make_room(system, 0, NULL, 0);
+}
+
+/**
+ * @brief leaves an afterglow behind the bolts. each bolt is drawn into the trail once, the frame it or a part of it is new, and the
+ *			trail is faded by a constant factor every frame and drawn under the bolts, so a longer trail costs nothing more.
+ *			lightning_draw_all keeps the trail in a texture, lightning_raster_all queues it with raster_add_trail_segment, so set
+ *			the rasterizer's trail to the same fade with raster_set_trail
+ * @param system [in,out]	the lightning system to set it for
+ * @param fade				how much of the trail is left after each frame, under 1. 0 leaves no trail
+ */
+void lightning_set_trail(LightningSystem *system, float fade)
+{
+	if(!system)
+	{
+		return;
+	}
+	if(fade >= 1)
+	{
+		slog("trail fade must be under 1 (%f)", fade);
+		return;
+	}
+	system->trailFade = MAX(fade, 0);
+	if(system->trailFade == 0 && system->trail)
+	{
+		SDL_DestroyTexture(system->trail);
+		system->trail = NULL;
+	}
+}
+
+/**
+ * @brief getter for how much simplification has cut the bolts down since the system was created
+ * @param system [in]	the lightning system
+ * @return the number of points kept over the number generated, 1 if nothing has been generated
+ */
+float lightning_get_simplify_ratio(LightningSystem *system)
+{
+	if(!system->simplifyBefore)
+	{
+		return 1;
+	}
+	return (float)((double)system->simplifyAfter / (double)system->simplifyBefore);
+}
+
+/**
+ * @brief creates the actual bolt of lightning as separate segments in the lightningList, see lightning_generate_points for how the bolt is shaped
+ * @param system [in,out]		the lightning system to create the segments in
+ * @param main_lightning [in]	the main lightning, that defines the start and end of the bolt we are about to make
+ * @param thickness				the thickness of the bolt we are creating
+ */
+void lightning_create_bolt(LightningSystem *system, Lightning *main_lightning, float thickness)
+{
+	int i;
+	int numPoints;
+
+	numPoints = lightning_generate_points(main_lightning->start, main_lightning->end, thickness, &system->randState, &system->scratchPoints, &system->scratchMax);
+	numPoints = lightning_simplify_points(system, system->scratchPoints, numPoints);
+	for(i = 0; i + 1 < numPoints; i++)
+	{
+		lightning_new(system, system->scratchPoints[i], system->scratchPoints[i + 1], thickness);
+	}
+}
+
+/**
+ * @brief generates the points of a bolt into the caller's array without touching the lightningList, boltList or rand, so it can be
+ *			called from several threads at once as long as each has its own state and array. shaped like lightning_bolt_new
+ * @param start				starting point of the bolt
+ * @param end				end point of the bolt
+ * @param thickness			the thickness of the bolt
+ * @param state [in,out]	random state to generate with, any seed works and the same seed gives the same bolt
+ * @param points [in,out]	the array to write the points to, grown with realloc if it is too small
+ * @param maxPoints [in,out]	how many points fit in points
+ * @return the number of points written, the first is start and the last is end. 0 if the thickness isn't positive, the bolt
+ *			would need more points than an int holds or the points could not be allocated
+ */
+int lightning_generate(Vect2d start, Vect2d end, float thickness, Uint32 *state, Vect2d **points, int *maxPoints)
+{
+	return lightning_generate_points(start, end, thickness, state, points, maxPoints);
+}
+
+/**
+ * @brief finds the first unused bolt in the system's boltList
+ * @param system [in]	the lightning system to look in
+ * @return the unused bolt, its points array is left as it was so it can be reused
+ */
+static Bolt *lightning_bolt_claim(LightningSystem *system)
+{
+	int i;
+
+	if(!system || !system->boltList)
+	{
+		slog("boltList uninitialized");
+		return NULL;
+	}
+
+	if(system->boltNum + 1 > system->boltMax)
+	{
+		slog("Maximum Bolts Reached.");
+		exit(1);
+	}
+
+	for(i = 0; i < system->boltMax; i++)
+	{
+		if(!system->boltList[i].inUse)
+		{
+			return &system->boltList[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief marks a claimed bolt as in use and gives it its attributes
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param bolt [in,out]		the bolt returned by lightning_bolt_claim
+ * @param thickness			the thickness of the bolt
+ * @return the bolt
+ */
+static Bolt *lightning_bolt_use(LightningSystem *system, Bolt *bolt, float thickness)
+{
+	system->boltNum++;
+	bolt->inUse = 1;
+	bolt->version++;
+	bolt->thickness = thickness;
+	bolt->drawPoints = -1;
+	bolt->returnStroke = 0;
+	bolt->trailPoints = 0;
+	bolt->trailReturn = 0;
+	bolt->color = system->color;
+	bolt->rainbow = 1;
+	bolt->hue = 0;
+	bolt->alpha = system->alpha;
+	bolt->intensity = 1;
+	bolt->free = &lightning_bolt_free;
+	bolt->draw = &lightning_bolt_draw;
+	return bolt;
+}
+
+/**
+ * @brief gives a bolt a color of its own instead of the rainbow
+ * @param bolt [in,out]	the bolt
+ * @param color			its color, each component 0 - 255
+ * @param alpha			its alpha, 0 - 255
+ * @param intensity		how bright it is, multiplies the color
+ */
+void lightning_bolt_set_color(Bolt *bolt, Vect3d color, int alpha, float intensity)
+{
+	bolt->rainbow = 0;
+	bolt->color = color;
+	bolt->alpha = alpha;
+	bolt->intensity = intensity;
+}
+
+/**
+ * @brief sets a bolt's color to follow the rainbow over time, which is what a new bolt does
+ * @param bolt [in,out]	the bolt
+ * @param hue			how far around the rainbow from the other bolts it is, 0 - 1
+ */
+void lightning_bolt_set_rainbow(Bolt *bolt, float hue)
+{
+	bolt->rainbow = 1;
+	bolt->hue = hue;
+}
+
+/**
+ * @brief counts the points of a bolt that are drawn, a bolt that is still growing only draws the start of its points
+ * @param bolt [in]	the bolt
+ * @return how many points from the start are drawn
+ */
+int lightning_bolt_drawn(Bolt *bolt)
+{
+	if(bolt->drawPoints < 0)
+	{
+		return bolt->numPoints;
+	}
+	return MIN(bolt->drawPoints, bolt->numPoints);
+}
+
+/**
+ * @brief finds the part of a bolt that isn't in the trail yet and marks it as being in it, the segments drawn on an earlier frame
+ *			are already there and only fade from then on
+ * @param bolt [in,out]			the bolt
+ * @param numPoints				how many of its points are drawn this frame
+ * @param returnStroke [out]	set if the return stroke is new, it goes into the trail over the whole bolt
+ * @return the first segment that isn't in the trail yet
+ */
+static int lightning_bolt_trail_start(Bolt *bolt, int numPoints, int *returnStroke)
+{
+	int first = MAX(MIN(bolt->trailPoints, numPoints) - 1, 0);
+
+	*returnStroke = bolt->returnStroke && !bolt->trailReturn;
+	bolt->trailPoints = MAX(bolt->trailPoints, numPoints);
+	bolt->trailReturn = bolt->trailReturn || bolt->returnStroke;
+	return first;
+}
+
+/**
+ * @brief creates a bolt of lightning in the boltList, with all its points stored in one array instead of as separate segments
+ * @param system [in,out]	the lightning system to create the bolt in
+ * @param start		starting point of the bolt
+ * @param end		end point of the bolt
+ * @param thickness	the thickness of the bolt
+ * @return pointer to the position in the boltList where the newly created bolt exists
+ */
+Bolt *lightning_bolt_new(LightningSystem *system, Vect2d start, Vect2d end, float thickness)
+{
+	Bolt *bolt = lightning_bolt_claim(system);
+
+	if(!bolt)
+	{
+		return NULL;
+	}
+
+	/*the points array is kept from the bolt's last use so regenerating every think doesn't reallocate*/
+	bolt->numPoints = lightning_generate_points(start, end, thickness, &system->randState, &bolt->points, &bolt->maxPoints);
+	bolt->numPoints = lightning_simplify_points(system, bolt->points, bolt->numPoints);
+	return lightning_bolt_use(system, bolt, thickness);
+}
+
+/**
+ * @brief creates a bolt in the boltList with room for the given number of points, for callers that fill in the points themselves
+ * @param system [in,out]	the lightning system to create the bolt in
+ * @param numPoints			how many points the bolt will have
+ * @param thickness			the thickness of the bolt
+ * @return pointer to the new bolt, its numPoints points are left for the caller to write
+ */
+Bolt *lightning_bolt_alloc(LightningSystem *system, int numPoints, float thickness)
+{
+	Vect2d *grown;
+	Bolt *bolt = lightning_bolt_claim(system);
+
+	if(!bolt)
+	{
+		return NULL;
+	}
+
+	if(bolt->maxPoints < numPoints)
+	{
+		grown = (Vect2d *)realloc(bolt->points, sizeof(Vect2d) * numPoints);
+		if(!grown)
+		{
+			slog("bolt points failed to allocate");
+			return NULL;
+		}
+		bolt->points = grown;
+		bolt->maxPoints = numPoints;
+	}
+	bolt->numPoints = numPoints;
+	return lightning_bolt_use(system, bolt, thickness);
+}
+
+/**
+ * @brief starts growing a bolt in the boltList that is generated a slice at a time by lightning_generator_step, for bolts too big to
+ *			generate in one frame. shaped like lightning_bolt_new, but the points along it are drawn already in order so there is
+ *			nothing to sort
+ * @param system [in,out]		the lightning system to create the bolt in
+ * @param generator [out]		the generator to start, anything it was running is forgotten without being freed
+ * @param start					starting point of the bolt
+ * @param end					end point of the bolt
+ * @param thickness				the thickness of the bolt
+ * @param segments				how many segments to grow the bolt with, 0 picks it from the length and thickness like every other bolt
+ * @param seed					random state to start from, the same seed always grows the same bolt
+ * @return the bolt, which has only its starting point so far. NULL if it could not be created or the thickness isn't positive
+ */
+Bolt *lightning_generator_start(LightningSystem *system, BoltGenerator *generator, Vect2d start, Vect2d end, float thickness, int segments, Uint32 seed)
+{
+	int count;
+	double steps;
+	Vect2d tangent;
+	Bolt *bolt;
+
+	memset(generator, 0, sizeof(BoltGenerator));
+	vect2d_subtract(end, start, tangent);
+	steps = segments > 0 ? segments - 1 : ceil(vect2d_get_length(tangent) / (thickness * 4.0));
+	if(!(thickness > 0) || !(steps < INT_MAX - 2))
+	{
+		slog("can't grow a bolt %f long and %f thick", vect2d_get_length(tangent), thickness);
+		return NULL;
+	}
+	count = (int)steps;
+	bolt = lightning_bolt_alloc(system, count + 2, thickness);
+	if(!bolt)
+	{
+		return NULL;
+	}
 
-	lightning_new(prevPoint, main_lightning->end, thickness);
-	
-	return;
+	generator->bolt = bolt;
+	generator->start = start;
+	generator->end = end;
+	generator->tangent = tangent;
+	generator->normal = vect2d_new(tangent.y, -tangent.x);
+	vect2d_normalize(&generator->normal);
+	generator->length = vect2d_get_length(tangent);
+	generator->count = count;
+	generator->state = seed;
+	bolt->points[0] = start;
+	bolt->numPoints = 1;
+	return bolt;
 }
 
 /**
- * @brief removes all lightning in the lightningList
+ * @brief simplifies the points of a generator's bolt from the last block on, keeping the last point so the next block starts from it
+ * @param system [in,out]		the lightning system the bolt is in
+ * @param generator [in,out]	the generator
  */
-void lightning_purge_system()
+static void lightning_generator_simplify(LightningSystem *system, BoltGenerator *generator)
+{
+	Bolt *bolt = generator->bolt;
+	bolt->numPoints = generator->blockStart + lightning_simplify_points(system, &bolt->points[generator->blockStart], bolt->numPoints - generator->blockStart);
+	generator->blockStart = bolt->numPoints - 1;
+}
+
+/**
+ * @brief generates the next slice of a bolt, stopping once either budget is used up
+ * @param system [in,out]		the lightning system the bolt is in
+ * @param generator [in,out]	the running generator
+ * @param maxPoints				the most points to generate, 0 for no limit
+ * @param maxMilliseconds		how long to spend, 0 for no limit
+ * @return 1 if the bolt is complete or the generator isn't running, 0 if there is more to generate
+ */
+int lightning_generator_step(LightningSystem *system, BoltGenerator *generator, int maxPoints, float maxMilliseconds)
+{
+	int made = 0;
+	float pos, uniform;
+	float scale;
+	float envelope;
+	float displacement;
+	Vect2d point;
+	Vect2d temp, temp2;
+	Uint64 counter = SDL_GetPerformanceCounter();
+	Uint64 limit = (Uint64)(maxMilliseconds * 0.001 * SDL_GetPerformanceFrequency());
+	Bolt *bolt = generator->bolt;
+
+	if(!bolt)
+	{
+		return 1;
+	}
+	if(generator->made <= generator->count)
+	{
+		/*points are about to be added, so whatever was cached of the bolt is stale*/
+		bolt->version++;
+	}
+	while(generator->made < generator->count)
+	{
+		if(maxPoints > 0 && made >= maxPoints)
+		{
+			return 0;
+		}
+		if(limit > 0 && made > 0 && made % LIGHTNING_GENERATOR_CHECK == 0 && SDL_GetPerformanceCounter() - counter >= limit)
+		{
+			return 0;
+		}
+
+		/*the next point along the bolt is the nearest of the positions still to come, each uniform over what is left of the bolt*/
+		uniform = (lightning_rand(&generator->state) + 1.0f) / ((float)RAND_MAX + 1.0f);
+		pos = generator->prevPos + (1 - generator->prevPos) * (float)(1 - pow(uniform, 1.0 / (generator->count - generator->made)));
+		scale = (generator->length * JAGGEDNESS) * (pos - generator->prevPos);
+
+		if(pos > 0.95f)
+		{
+			envelope = 20 * (1 - pos);
+		}
+		else
+		{
+			envelope = 1;
+		}
+
+		displacement = (lightning_rand(&generator->state) % (2 * SWAY)) - SWAY;
+		displacement -= (displacement - generator->prevDisplacement) * (1 - scale);
+		displacement *= envelope;
+
+		vect2d_scale(temp, generator->tangent, pos);
+		vect2d_scale(temp2, generator->normal, displacement);
+		vect2d_add(temp, temp2, point);
+		vect2d_add(point, generator->start, point);
+		bolt->points[bolt->numPoints++] = point;
+
+		generator->prevDisplacement = displacement;
+		generator->prevPos = pos;
+		generator->made++;
+		made++;
+		if(bolt->numPoints - generator->blockStart >= LIGHTNING_GENERATOR_BLOCK)
+		{
+			lightning_generator_simplify(system, generator);
+		}
+	}
+	if(generator->made == generator->count)
+	{
+		bolt->points[bolt->numPoints++] = generator->end;
+		lightning_generator_simplify(system, generator);
+		/*one past count marks the end as added*/
+		generator->made++;
+	}
+	return 1;
+}
+
+/**
+ * @brief generates whatever is left of a bolt and stops the generator, the bolt stays in the boltList
+ * @param system [in,out]		the lightning system the bolt is in
+ * @param generator [in,out]	the generator to finish
+ * @return the complete bolt, NULL if the generator wasn't running
+ */
+Bolt *lightning_generator_finish(LightningSystem *system, BoltGenerator *generator)
+{
+	Bolt *bolt = generator->bolt;
+	lightning_generator_step(system, generator, 0, 0);
+	generator->bolt = NULL;
+	return bolt;
+}
+
+/**
+ * @brief stops a generator and frees the bolt it was growing, call it before the bolt is freed any other way
+ * @param system [in,out]		the lightning system the bolt is in
+ * @param generator [in,out]	the generator to cancel
+ */
+void lightning_generator_cancel(LightningSystem *system, BoltGenerator *generator)
+{
+	if(generator->bolt)
+	{
+		lightning_bolt_free(system, &generator->bolt);
+	}
+}
+
+/**
+ * @brief frees a bolt from the boltList and destroys the pointer to it, the bolt's points are kept to be reused by the next bolt
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param bolt [in,out]		the bolt that is to be removed from memory
+ */
+void lightning_bolt_free(LightningSystem *system, Bolt **bolt)
+{
+	Bolt *target;
+	if(!bolt)
+	{
+		return;
+	}
+	else if(!*bolt)
+	{
+		return;
+	}
+	target = *bolt;
+
+	target->inUse = 0;
+	target->numPoints = 0;
+	system->boltNum--;
+	*bolt = NULL;
+}
+
+/**
+ * @brief queues every segment of the bolt and its bloom onto the system's batch, with all of its segments measured at once first
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param self [in]			the bolt that is to be drawn
+ * @param offset			added to every point, to draw the bolt into its cache instead of onto the screen
+ * @param color				color and alpha of every segment
+ */
+static void lightning_bolt_draw_points(LightningSystem *system, Bolt *self, Vect2d offset, SDL_Color color)
+{
+	int numPoints = lightning_bolt_drawn(self);
+
+	/*the offset moves every point the same, so the lengths and directions are measured once for both passes*/
+	if(!lightning_measure_segments(system, self->points, numPoints))
+	{
+		return;
+	}
+	lightning_batch_measured(system, self->points, 0, numPoints, offset, self->thickness, color);
+	if(!self->returnStroke)
+	{
+		return;
+	}
+	/*drawn over the first pass, so the core and bloom pile up brighter and wider*/
+	lightning_batch_measured(system, self->points, 0, numPoints, offset, self->thickness * LIGHTNING_RETURN_SCALE, color);
+}
+
+/**
+ * @brief destroys a bolt's cached drawing and gives its bytes back to the budget
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param bolt [in,out]		the bolt
+ */
+static void lightning_bolt_uncache(LightningSystem *system, Bolt *bolt)
+{
+	if(!bolt->cache)
+	{
+		return;
+	}
+	SDL_DestroyTexture(bolt->cache);
+	system->cacheBytes -= (size_t)bolt->cacheW * bolt->cacheH * 4;
+	bolt->cache = NULL;
+	bolt->cacheW = 0;
+	bolt->cacheH = 0;
+}
+
+/**
+ * @brief evicts the least recently drawn caches until there is room for more bytes within the budget
+ * @param system [in,out]	the lightning system
+ * @param bytes				how many bytes are needed
+ * @param keep [in]			a bolt whose cache is never evicted, NULL for none
+ * @param thisFrame			if set the caches already drawn this frame are kept too, so bolts that don't all fit in the budget
+ *							don't evict each other every frame, the ones that don't fit are drawn directly instead
+ * @return 1 if the bytes fit, 0 if they don't even with everything that can be evicted gone
+ */
+static int lightning_cache_make_room(LightningSystem *system, size_t bytes, Bolt *keep, int thisFrame)
 {
 	int i;
+	Bolt *oldest;
+
+	while(system->cacheBytes + bytes > system->cacheBudget)
+	{
+		oldest = NULL;
+		for(i = 0; i < system->boltMax; i++)
+		{
+			if(system->boltList[i].cache && &system->boltList[i] != keep
+				&& !(thisFrame && system->boltList[i].cacheUsed == system->cacheFrame)
+				&& (!oldest || (Sint32)(system->boltList[i].cacheUsed - oldest->cacheUsed) < 0))
+			{
+				oldest = &system->boltList[i];
+			}
+		}
+		if(!oldest)
+		{
+			return 0;
+		}
+		lightning_bolt_uncache(system, oldest);
+	}
+	return 1;
+}
+
+/**
+ * @brief draws a bolt into its cache, sized to the box around the points being drawn. the texture is kept if it is big enough,
+ *			otherwise it is replaced, evicting other caches to make room. the bolt is drawn white so the cache can be tinted
+ *			with whatever color the bolt is drawn in later
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param self [in,out]		the bolt to cache
+ * @return 1 if the bolt is cached, 0 if it has to be drawn directly
+ */
+static int lightning_bolt_cache(LightningSystem *system, Bolt *self)
+{
+	int i, pad, width, height, numPoints;
+	float minX, minY, maxX, maxY;
+	Uint8 r, g, b, a;
+	SDL_Color white = {255, 255, 255, 255};
+	SDL_Renderer *renderer = system->sprites->renderer;
+	SDL_Texture *previous;
+	SDL_BlendMode premultiplied;
+
+	numPoints = lightning_bolt_drawn(self);
+	minX = maxX = self->points[0].x;
+	minY = maxY = self->points[0].y;
+	for(i = 1; i < numPoints; i++)
+	{
+		minX = MIN(minX, self->points[i].x);
+		maxX = MAX(maxX, self->points[i].x);
+		minY = MIN(minY, self->points[i].y);
+		maxY = MAX(maxY, self->points[i].y);
+	}
+	pad = LIGHTNING_CACHE_PAD + (int)ceil(self->thickness * (self->returnStroke ? LIGHTNING_RETURN_SCALE : 1));
+	self->cacheBounds.x = (int)floor(minX) - pad;
+	self->cacheBounds.y = (int)floor(minY) - pad;
+	self->cacheBounds.w = (int)ceil(maxX) + pad - self->cacheBounds.x;
+	self->cacheBounds.h = (int)ceil(maxY) + pad - self->cacheBounds.y;
+
+	if(self->cacheW < self->cacheBounds.w || self->cacheH < self->cacheBounds.h)
+	{
+		lightning_bolt_uncache(system, self);
+		width = (self->cacheBounds.w + LIGHTNING_CACHE_ROUND - 1) / LIGHTNING_CACHE_ROUND * LIGHTNING_CACHE_ROUND;
+		height = (self->cacheBounds.h + LIGHTNING_CACHE_ROUND - 1) / LIGHTNING_CACHE_ROUND * LIGHTNING_CACHE_ROUND;
+		if(!lightning_cache_make_room(system, (size_t)width * height * 4, self, 1))
+		{
+			return 0;
+		}
+		self->cache = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+		if(!self->cache)
+		{
+			slog("unable to create a bolt cache: %s", SDL_GetError());
+			return 0;
+		}
+		/*drawing with BLEND into a clear target leaves the color already multiplied by the alpha, so it is only multiplied once more by
+		the tint and otherwise laid over the screen the way the segments would have been drawn onto it directly*/
+		premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+			SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+		if(SDL_SetTextureBlendMode(self->cache, premultiplied) != 0)
+		{
+			slog("renderer can't lay premultiplied bolt caches over the screen, drawing every bolt directly: %s", SDL_GetError());
+			SDL_DestroyTexture(self->cache);
+			self->cache = NULL;
+			system->cacheBudget = 0;
+			return 0;
+		}
+		self->cacheW = width;
+		self->cacheH = height;
+		system->cacheBytes += (size_t)width * height * 4;
+	}
+
+	/*whatever the other bolts queued goes onto the screen before the batch is used to draw into the cache*/
+	lightning_batch_submit(system);
+	previous = SDL_GetRenderTarget(renderer);
+	SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+	SDL_SetRenderTarget(renderer, self->cache);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+	SDL_RenderClear(renderer);
+	SDL_SetRenderDrawColor(renderer, r, g, b, a);
+
+	lightning_bolt_draw_points(system, self, vect2d_new(-self->cacheBounds.x, -self->cacheBounds.y), white);
+	lightning_batch_submit(system);
+	SDL_SetRenderTarget(renderer, previous);
+
+	self->cacheVersion = self->version;
+	self->cachePoints = numPoints;
+	self->cacheReturn = self->returnStroke;
+	return 1;
+}
+
+/**
+ * @brief draws a bolt from its cache as one quad, redrawing the cache first if the bolt has changed since it was drawn
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param self [in,out]		the bolt
+ * @return 1 if the bolt was drawn, 0 if it couldn't be cached and has to be drawn directly
+ */
+static int lightning_bolt_draw_cached(LightningSystem *system, Bolt *self)
+{
+	SDL_Color color;
+	SDL_Rect source;
+
+	/*a bolt still growing changes every frame, so caching it would only add a copy*/
+	if(!system->cacheBudget || !system->sprites || self->drawPoints >= 0 || lightning_bolt_drawn(self) < 2)
+	{
+		return 0;
+	}
+	if(!self->cache || self->cacheVersion != self->version || self->cachePoints != lightning_bolt_drawn(self) || self->cacheReturn != self->returnStroke)
+	{
+		if(!lightning_bolt_cache(system, self))
+		{
+			return 0;
+		}
+	}
+	self->cacheUsed = system->cacheFrame;
+
+	/*the cache is the bolt's own texture, so tinting it is no extra state change. its color is premultiplied, so the tint is too*/
+	color = lightning_vertex_color(self->color, self->alpha, self->intensity);
+	SDL_SetTextureColorMod(self->cache, color.r * color.a / 255, color.g * color.a / 255, color.b * color.a / 255);
+	SDL_SetTextureAlphaMod(self->cache, color.a);
+	source.x = 0;
+	source.y = 0;
+	source.w = self->cacheBounds.w;
+	source.h = self->cacheBounds.h;
+	SDL_RenderCopy(system->sprites->renderer, self->cache, &source, &self->cacheBounds);
+	return 1;
+}
+
+/**
+ * @brief draws the bolt from its cache when it can be cached, otherwise queues every segment and its bloom in the bolt's color onto
+ *			the system's batch of geometry with one walk along its points
+ * @param system [in,out]	the lightning system the bolt belongs to
+ * @param self [in,out]		the bolt that is to be drawn
+ */
+void lightning_bolt_draw(LightningSystem *system, Bolt *self)
+{
+	if(!lightning_bolt_draw_cached(system, self))
+	{
+		lightning_bolt_draw_points(system, self, vect2d_new(0, 0), lightning_vertex_color(self->color, self->alpha, self->intensity));
+	}
+}
+
+/**
+ * @brief sets how much of a bolt is drawn as it grows from its start like a stepped leader, followed by a brighter return stroke
+ *			over the whole bolt. only the bolt's draw count changes, the points are left alone
+ * @param bolt [in,out]	the bolt to animate
+ * @param age			milliseconds since the bolt was created
+ * @return 1 while the bolt is still growing or flashing, 0 once it is drawn normally
+ */
+int lightning_bolt_set_growth(Bolt *bolt, Uint32 age)
+{
+	if(age < LIGHTNING_LEADER_TIME)
+	{
+		bolt->drawPoints = 1 + (int)((Uint64)(bolt->numPoints - 1) * age / LIGHTNING_LEADER_TIME);
+		bolt->returnStroke = 0;
+		return 1;
+	}
+	bolt->drawPoints = -1;
+	bolt->returnStroke = age < LIGHTNING_LEADER_TIME + LIGHTNING_RETURN_TIME;
+	return bolt->returnStroke;
+}
+
+/**
+ * @brief removes all lightning in the lightningList and all bolts in the boltList
+ * @param system [in,out]	the lightning system to empty
+ */
+void lightning_purge_system(LightningSystem *system)
+{
+	int i;
+	Lightning *lightningList = system->lightningList;
+	Bolt *boltList = system->boltList;
 	Lightning *lightning = NULL;
-	for(i = 0; i < lightningMax; i++)
+	Bolt *bolt = NULL;
+	for(i = 0; i < system->lightningMax; i++)
 	{
 		if(lightningList[i].inUse && lightningList[i].free)
 		{
 			lightning = &lightningList[i];
-			lightningList[i].free(&lightning);
+			lightningList[i].free(system, &lightning);
+		}
+	}
+	for(i = 0; i < system->boltMax; i++)
+	{
+		if(boltList[i].inUse && boltList[i].free)
+		{
+			bolt = &boltList[i];
+			boltList[i].free(system, &bolt);
 		}
 	}
 }
\ No newline at end of file
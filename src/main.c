@@ -1,29 +1,156 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "simple_logger.h"
 
+#include "archive.h"
+#include "batch.h"
+#include "bench.h"
+#include "boltstream.h"
+#include "breakdown.h"
+#include "canvas.h"
+#include "capture.h"
 #include "graphics.h"
+#include "input.h"
+#include "jobs.h"
+#include "laplacian.h"
+#include "light.h"
 #include "lightning.h"
+#include "raster.h"
+#include "replay.h"
+#include "scene.h"
+#include "simplify.h"
 #include "sprite.h"
 
-static int nextThink = 0;
+static Uint32 nextThink = 0;
 static int thinkRate = 48;
+static Uint32 nextFrame = 0;
+static int frameRate = 16;
+static Uint32 idleTime = 0;
+static int useRaster = 0;
+static int useBreakdown = 0;
+static int useLaplacian = 0;
+static float simplifyTolerance = SIMPLIFY_TOLERANCE;
+static int cacheMegabytes = -1;
+static int useLight = 0;
+static int lightScale = 0;
+static float trailFade = 0;
+static int trailRate = 16;
+static Uint32 trailTime = 0;
+static Uint32 trailEnd = 0;
+static Uint32 nextTrailFrame = 0;
+static int boltSegments = 0;
+static float growBudget = 4;
+static BoltGenerator generator;
+static int growBolts = 0;
+static Bolt *growingBolt = NULL;
+static Uint32 growStart = 0;
 
+static char *capturePath = NULL;
+static CaptureFormat captureFormat = CAPTURE_RAW;
+static int captureFPS = 0;
+
+#define REPLAY_FRAME_BOLTS		256
+
+static int batchMode = 0;
+static BatchOptions batchOptions;
+
+static int jobBenchmark = 0;
+
+static char *archiveTestPath = NULL;
+
+static int canvasMode = 0;
+static CanvasOptions canvasOptions;
+
+static int benchMode = 0;
+static BenchOptions benchOptions;
+
+static int sceneMode = 0;
+static SceneOptions sceneOptions;
+
+static char *publishName = NULL;
+
+static char *embedPath = NULL;
+static Uint64 startCounter = 0;
+
+static SpriteSystem *spriteSystem = NULL;
+static LightningSystem *lightningSystem = NULL;
+
+static char *recordPath = NULL;
+static char *replayPath = NULL;
+static ReplayMode replayMode = REPLAY_WALL_CLOCK;
+
+void parse_arguments(int argc, char *argv[]);
 void init_all_systems();
+void close_all_systems();
+void spawn_bolt(Vect2d start, Vect2d end, float thickness, Uint32 seed);
 
 
 int main(int argc, char *argv[])
 {
 	int done = 0;
-	int x, y;
-	const Uint8 *keys = NULL;
+	int pitch;
+	int continuous, animating, fading, frameDue, moved = 0, redraw = 1;
+	int timeout;
+	int i, boltCount;
+	int replayFrames = 0, replayBolts = 0;
+	Uint32 seed, frameTime, wake, replayStart = 0;
+	Uint32 now, lastInput;
+	Uint64 replayCounter = 0;
+	double replaySeconds;
+	ReplayBolt bolts[REPLAY_FRAME_BOLTS];
+	InputState *input;
 	SDL_Renderer *the_renderer;
-	Lightning *lightning = NULL;
 	SDL_Point *center = NULL;
 	Sprite *test = NULL;
+	char *embedImages[] = {LIGHTNING_MIDDLE_IMAGE, LIGHTNING_LEFT_IMAGE, LIGHTNING_RIGHT_IMAGE};
 
+	startCounter = SDL_GetPerformanceCounter();
+	parse_arguments(argc, argv);
+	if(embedPath)
+	{
+		init_logger("log.txt");
+		exit(sprite_write_embedded(embedPath, embedImages, sizeof(embedImages) / sizeof(char *)) ? 0 : 1);
+	}
+	if(batchMode)
+	{
+		//batch mode never opens a window, it only needs the logger and the workers
+		init_logger("log.txt");
+		jobs_init_system(batchOptions.threads);
+		exit(batch_run(&batchOptions) ? 0 : 1);
+	}
+	if(canvasMode)
+	{
+		init_logger("log.txt");
+		jobs_init_system(batchOptions.threads);
+		canvasOptions.bolts = &batchOptions;
+		exit(canvas_run(&canvasOptions) ? 0 : 1);
+	}
+	if(jobBenchmark)
+	{
+		init_logger("log.txt");
+		jobs_benchmark(batchOptions.threads);
+		exit(0);
+	}
+	if(benchMode)
+	{
+		init_logger("log.txt");
+		exit(bench_run(&benchOptions) ? 0 : 1);
+	}
+	if(archiveTestPath)
+	{
+		init_logger("log.txt");
+		exit(archive_test(archiveTestPath) ? 0 : 1);
+	}
+	if(sceneMode)
+	{
+		init_logger("log.txt");
+		sceneOptions.threads = batchOptions.threads;
+		exit(scene_run(&sceneOptions) ? 0 : 1);
+	}
 	init_all_systems();
 
 	center = (SDL_Point *) malloc(sizeof(SDL_Point));
@@ -31,34 +158,187 @@ int main(int argc, char *argv[])
 	srand ( time(NULL) );
 
 	the_renderer = graphics_get_renderer();
+	if(replayPath)
+	{
+		replayStart = SDL_GetTicks();
+		replayCounter = SDL_GetPerformanceCounter();
+	}
 
-	do
+	//replays and captures need every frame, otherwise frames are only made when the input or the flicker asks for one
+	continuous = replayPath || capturePath;
+	if(!continuous)
 	{
-		SDL_RenderClear(the_renderer);
+		graphics_set_frame_delay(0);
+	}
+	lastInput = graphics_update_time();
 
-		SDL_GetMouseState(&x, &y);
-		printf("Mouse %d, %d\n", x, y);
+	do
+	{
+		now = get_time();
+		animating = idleTime == 0 || now - lastInput < idleTime;
+		//the trail keeps fading after the flicker stops, until there is nothing left of it
+		fading = now < trailEnd;
+		if(continuous)
+		{
+			timeout = 0;
+		}
+		else if(moved || redraw || generator.bolt || growingBolt)
+		{
+			//something is waiting for the next frame, so sleep until it is due and fold all the motion that came in meanwhile into it
+			if(nextFrame > now)
+			{
+				SDL_Delay(nextFrame - now);
+			}
+			timeout = 0;
+		}
+		else if(animating || fading)
+		{
+			wake = animating ? nextThink : nextTrailFrame;
+			if(fading && nextTrailFrame < wake)
+			{
+				wake = nextTrailFrame;
+			}
+			wake = MAX(wake, nextFrame);
+			timeout = wake > now ? (int)(wake - now) : 0;
+		}
+		else
+		{
+			timeout = -1;
+		}
+		input = input_wait(timeout);
+		if(input->quit)
+		{
+			done = 1;
+			continue;
+		}
+		now = graphics_update_time();
+		if(input->moved)
+		{
+			lastInput = now;
+			animating = 1;
+			moved = 1;
+		}
+		//outside of replays and captures frames are at least frameRate apart, there is no vsync to hold them back
+		frameDue = continuous || now >= nextFrame;
+		if(input->redraw || continuous || (fading && now >= nextTrailFrame))
+		{
+			redraw = 1;
+		}
 
-		if(get_time() > nextThink)
+		if(replayPath)
 		{
-			lightning_purge_system();
+			boltCount = replay_next_frame(&frameTime, bolts, REPLAY_FRAME_BOLTS);
+			if(boltCount < 0)
+			{
+				replaySeconds = (double)(SDL_GetPerformanceCounter() - replayCounter) / SDL_GetPerformanceFrequency();
+				slog("replayed %i frames, %i bolts in %f seconds (%f frames/sec, %f bolts/sec)",
+					replayFrames, replayBolts, replaySeconds, replayFrames / replaySeconds, replayBolts / replaySeconds);
+				break;
+			}
+			while(replayMode == REPLAY_WALL_CLOCK && SDL_GetTicks() - replayStart < frameTime)
+			{
+				SDL_Delay(1);
+			}
+			lightning_generator_cancel(lightningSystem, &generator);
+			lightning_purge_system(lightningSystem);
+			for(i = 0; i < boltCount; i++)
+			{
+				spawn_bolt(bolts[i].start, bolts[i].end, bolts[i].thickness, bolts[i].seed);
+			}
+			replayFrames++;
+			replayBolts += boltCount;
+		}
+		else if(frameDue && (moved || (animating && now >= nextThink && !generator.bolt)))
+		{
+			//all the motion since the last frame retargets the bolt once
+			moved = 0;
+			lightning_generator_cancel(lightningSystem, &generator);
+			lightning_purge_system(lightningSystem);
+
+			seed = rand();
+			spawn_bolt(vect2d_new(100, 300), vect2d_new(input->mouseX, input->mouseY), 6, seed);
+			replay_record_bolt(vect2d_new(100, 300), vect2d_new(input->mouseX, input->mouseY), 6, seed);
 
-			lightning = lightning_new(vect2d_new(100, 300), vect2d_new(x, y), 6);
-			lightning->draw = NULL;
-			lightning_create_bolt(lightning, lightning->thickness/2);
+			//a growing bolt is left to finish its return stroke before the flicker replaces it
+			nextThink = now + (growBolts ? MAX(thinkRate, LIGHTNING_LEADER_TIME + LIGHTNING_RETURN_TIME) : thinkRate);
+			redraw = 1;
+		}
+		if(generator.bolt && frameDue)
+		{
+			//replays and captures need whole bolts in every frame, otherwise each frame grows the bolt by a slice and draws what there is
+			if(continuous || lightning_generator_step(lightningSystem, &generator, 0, growBudget))
+			{
+				lightning_generator_finish(lightningSystem, &generator);
+			}
+			trailEnd = now + trailTime;
+			redraw = 1;
+		}
+		if(growingBolt && frameDue)
+		{
+			if(!lightning_bolt_set_growth(growingBolt, now - growStart))
+			{
+				growingBolt = NULL;
+			}
+			trailEnd = now + trailTime;
+			redraw = 1;
+		}
+		if(!redraw || !frameDue)
+		{
+			continue;
+		}
+		replay_record_frame(now);
 
-			nextThink = get_time() + thinkRate;
+		if(boltstream_is_active())
+		{
+			boltstream_begin_frame(now);
+			lightning_publish_all(lightningSystem);
+			boltstream_end_frame();
 		}
 
-		lightning_draw_all();
+		SDL_RenderClear(the_renderer);
+		if(useLight)
+		{
+			//the bolts light the background in the colors they are drawn with this frame
+			light_clear();
+			lightning_light_all(lightningSystem);
+			light_render();
+		}
+		if(useRaster)
+		{
+			raster_clear(vect3d_new(0, 0, 0));
+			lightning_raster_all(lightningSystem);
+			raster_render();
+			if(useLight)
+			{
+				light_composite(raster_get_pixels(&pitch), pitch);
+			}
+			raster_present();
+			if(capture_is_active())
+			{
+				capture_pixels(raster_get_pixels(&pitch), pitch);
+			}
+		}
+		else
+		{
+			if(useLight)
+			{
+				light_present();
+			}
+			lightning_draw_all(lightningSystem);
+			if(capture_is_active())
+			{
+				capture_frame();
+			}
+		}
 
 		graphics_next_frame();
-		SDL_PumpEvents();
-
-		keys = SDL_GetKeyboardState(NULL);
-		if(keys[SDL_SCANCODE_ESCAPE])
+		redraw = 0;
+		nextFrame = now + frameRate;
+		nextTrailFrame = now + trailRate;
+		if(startCounter)
 		{
-			done = 1;
+			slog("first frame presented %.2f ms after start", (double)(SDL_GetPerformanceCounter() - startCounter) * 1000.0 / SDL_GetPerformanceFrequency());
+			startCounter = 0;
 		}
 
 	}while(!done);
@@ -68,6 +348,282 @@ int main(int argc, char *argv[])
 	return 0;
 }
 
+/**
+ * @brief generates a bolt from its inputs, seeding rand and the lightning system first so the same inputs always make the same bolt
+ * @param start		starting point of the bolt
+ * @param end		end point of the bolt
+ * @param thickness	thickness of the main lightning, the bolt is made half as thick
+ * @param seed		value to seed rand and the lightning system with
+ */
+void spawn_bolt(Vect2d start, Vect2d end, float thickness, Uint32 seed)
+{
+	Bolt *bolt;
+
+	/*the grid generators still draw from rand, the rest from the system's own state*/
+	srand(seed);
+	lightning_system_seed(lightningSystem, seed);
+	growingBolt = NULL;
+	trailEnd = get_time() + trailTime;
+	if(useLaplacian)
+	{
+		laplacian_create_bolt(lightningSystem, start, end, thickness/4);
+		return;
+	}
+	if(useBreakdown)
+	{
+		breakdown_create_bolt(lightningSystem, start, end, thickness/4);
+		return;
+	}
+	if(boltSegments > 0)
+	{
+		bolt = lightning_generator_start(lightningSystem, &generator, start, end, thickness/2, boltSegments, seed);
+	}
+	else
+	{
+		bolt = lightning_bolt_new(lightningSystem, start, end, thickness/2);
+	}
+	if(growBolts && bolt)
+	{
+		growingBolt = bolt;
+		growStart = get_time();
+		lightning_bolt_set_growth(bolt, 0);
+	}
+}
+
+/**
+ * @brief reads the command line options
+ *			-capture <file>		export every frame to the file, - streams them to stdout
+ *			-y4m				export the frames as Y4M instead of raw RGBA
+ *			-fps <rate>			capture on a fixed timestep of the given frame rate, up to 1000, instead of the wall clock
+ *			-record <file>		record the inputs of every bolt generated into a replay log
+ *			-replay <file>		play a replay log instead of following the mouse, then quit
+ *			-fast				play the replay as fast as possible instead of at the recorded pace
+ *			-dbm				grow the bolts with the dielectric breakdown model instead of midpoint displacement
+ *			-laplacian			grow the bolts with the grid-free charge model instead of midpoint displacement
+ *			-idle <ms>			stop the flicker after this long without the mouse moving and sleep until it does, 0 never stops and is the default
+ *			-simplify <px>		drop bolt points closer than this to the line through their neighbours before drawing, 0 keeps them all
+ *			-cache <mb>			texture memory for keeping each bolt drawn between thinks, 0 redraws every segment every frame
+ *			-light				draw images/test.jpg behind the bolts, lit by them
+ *			-lightscale <n>		screen pixels per texel of the light buffer along each axis, 4 if not given
+ *			-trail <fade>		leave an afterglow behind the bolts that keeps this share of its light each frame, 0.9 is short and 0.98 long
+ *			-segments <n>		grow each bolt with n segments a slice per frame, for bolts too big to generate in one frame
+ *			-budget <ms>		how long each frame may spend growing a -segments bolt
+ *			-grow				animate each bolt growing from its start, then flash it with a return stroke
+ *			-publish <name>		publish every frame's bolts to the named shared memory for other processes, see boltstream_reader.h
+ *			-batch <count>		generate count bolts straight to a file without opening a window, then quit
+ *			-out <file>			the file a batch is written to, - streams it to stdout
+ *			-csv				write the batch as CSV instead of binary
+ *			-start <x> <y>		starting point of every bolt in the batch
+ *			-end <x> <y>		end point of every bolt in the batch
+ *			-region <x0> <y0> <x1> <y1>	pick each batch bolt's start and end at random inside this rectangle instead
+ *			-thickness <t>		thickness of the batch bolts
+ *			-seed <seed>		seed of the batch, the same seed always gives the same bolts
+ *			-threads <n>		job workers to run the batch, the canvas or the job benchmark on, 0 uses every core
+ *			-canvas <file> <w> <h>	draw bolts made the way a batch makes them on a w x h canvas, tile by tile into a PPM file, then quit
+ *			-bolts <n>			how many bolts the canvas draws
+ *			-tile <px>			width and height of the tiles the canvas is drawn and written in
+ *			-jobbench			measure the job system's overhead and how bolt generation scales with workers, then quit
+ *			-archivetest <file>	round trip bolts through a bolt archive and check broken archives are turned away, using file as scratch, then quit
+ *			-bench <file>		time the generation, sorting, pool and vector hot paths and write the results as JSON, - writes to stdout, then quit
+ *			-warmup <n>			runs of every benchmark case thrown away before timing
+ *			-reps <n>			timed runs of every benchmark case
+ *			-embed <file>		write the lightning images as C source to compile in place of src/sprite_embedded.c, then quit
+ *			-scenebench			play the scripted scenes headless and fail if a frame time goes over the baseline's thresholds, then quit
+ *			-baseline <file>	the thresholds the scene benchmark is checked against, scene_baseline.txt if not given
+ *			-sceneupdate		rewrite the baseline from this run of the scene benchmark instead of checking it
+ * @param argc			number of arguments
+ * @param argv [in]		the arguments
+ */
+void parse_arguments(int argc, char *argv[])
+{
+	int i;
+	batch_default_options(&batchOptions);
+	bench_default_options(&benchOptions);
+	scene_default_options(&sceneOptions);
+	canvas_default_options(&canvasOptions);
+	for(i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-capture") == 0 && i + 1 < argc)
+		{
+			capturePath = argv[++i];
+		}
+		else if(strcmp(argv[i], "-y4m") == 0)
+		{
+			captureFormat = CAPTURE_Y4M;
+		}
+		else if(strcmp(argv[i], "-fps") == 0 && i + 1 < argc)
+		{
+			captureFPS = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+		{
+			replayPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "-fast") == 0)
+		{
+			replayMode = REPLAY_MAX_THROUGHPUT;
+		}
+		else if(strcmp(argv[i], "-dbm") == 0)
+		{
+			useBreakdown = 1;
+		}
+		else if(strcmp(argv[i], "-laplacian") == 0)
+		{
+			useLaplacian = 1;
+		}
+		else if(strcmp(argv[i], "-idle") == 0 && i + 1 < argc)
+		{
+			idleTime = (Uint32)strtoul(argv[++i], NULL, 10);
+		}
+		else if(strcmp(argv[i], "-simplify") == 0 && i + 1 < argc)
+		{
+			simplifyTolerance = (float)atof(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-cache") == 0 && i + 1 < argc)
+		{
+			cacheMegabytes = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-light") == 0)
+		{
+			useLight = 1;
+		}
+		else if(strcmp(argv[i], "-lightscale") == 0 && i + 1 < argc)
+		{
+			lightScale = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-trail") == 0 && i + 1 < argc)
+		{
+			trailFade = (float)atof(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-segments") == 0 && i + 1 < argc)
+		{
+			boltSegments = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-budget") == 0 && i + 1 < argc)
+		{
+			growBudget = (float)atof(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-grow") == 0)
+		{
+			growBolts = 1;
+		}
+		else if(strcmp(argv[i], "-publish") == 0 && i + 1 < argc)
+		{
+			publishName = argv[++i];
+		}
+		else if(strcmp(argv[i], "-batch") == 0 && i + 1 < argc)
+		{
+			batchMode = 1;
+			batchOptions.count = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-out") == 0 && i + 1 < argc)
+		{
+			batchOptions.path = argv[++i];
+		}
+		else if(strcmp(argv[i], "-csv") == 0)
+		{
+			batchOptions.format = BATCH_CSV;
+		}
+		else if(strcmp(argv[i], "-start") == 0 && i + 2 < argc)
+		{
+			batchOptions.start = vect2d_new(atof(argv[i + 1]), atof(argv[i + 2]));
+			i += 2;
+		}
+		else if(strcmp(argv[i], "-end") == 0 && i + 2 < argc)
+		{
+			batchOptions.end = vect2d_new(atof(argv[i + 1]), atof(argv[i + 2]));
+			i += 2;
+		}
+		else if(strcmp(argv[i], "-region") == 0 && i + 4 < argc)
+		{
+			batchOptions.randomSpawn = 1;
+			batchOptions.spawnMin = vect2d_new(atof(argv[i + 1]), atof(argv[i + 2]));
+			batchOptions.spawnMax = vect2d_new(atof(argv[i + 3]), atof(argv[i + 4]));
+			i += 4;
+		}
+		else if(strcmp(argv[i], "-thickness") == 0 && i + 1 < argc)
+		{
+			batchOptions.thickness = (float)atof(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+		{
+			batchOptions.seed = (Uint32)strtoul(argv[++i], NULL, 10);
+		}
+		else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			batchOptions.threads = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-canvas") == 0 && i + 3 < argc)
+		{
+			canvasMode = 1;
+			canvasOptions.path = argv[i + 1];
+			canvasOptions.width = atoi(argv[i + 2]);
+			canvasOptions.height = atoi(argv[i + 3]);
+			i += 3;
+		}
+		else if(strcmp(argv[i], "-bolts") == 0 && i + 1 < argc)
+		{
+			canvasOptions.count = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-tile") == 0 && i + 1 < argc)
+		{
+			canvasOptions.tileSize = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-jobbench") == 0)
+		{
+			jobBenchmark = 1;
+		}
+		else if(strcmp(argv[i], "-archivetest") == 0 && i + 1 < argc)
+		{
+			archiveTestPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "-bench") == 0 && i + 1 < argc)
+		{
+			benchMode = 1;
+			benchOptions.path = argv[++i];
+		}
+		else if(strcmp(argv[i], "-warmup") == 0 && i + 1 < argc)
+		{
+			benchOptions.warmup = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-reps") == 0 && i + 1 < argc)
+		{
+			benchOptions.repetitions = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-embed") == 0 && i + 1 < argc)
+		{
+			embedPath = argv[++i];
+		}
+		else if(strcmp(argv[i], "-scenebench") == 0)
+		{
+			sceneMode = 1;
+		}
+		else if(strcmp(argv[i], "-baseline") == 0 && i + 1 < argc)
+		{
+			sceneOptions.baseline = argv[++i];
+		}
+		else if(strcmp(argv[i], "-sceneupdate") == 0)
+		{
+			sceneMode = 1;
+			sceneOptions.update = 1;
+		}
+		else
+		{
+			fprintf(stderr, "unknown argument %s\n", argv[i]);
+		}
+	}
+	if((capturePath && strcmp(capturePath, "-") == 0) || (batchMode && strcmp(batchOptions.path, "-") == 0)
+		|| (benchMode && strcmp(benchOptions.path, "-") == 0))
+	{
+		//stdout is carrying the frames, the batch or the benchmark results, so the log can only go to the file
+		set_logger_echo(0);
+	}
+}
+
 void init_all_systems()
 {
 	init_logger("log.txt"); //init simple logger from DJ's source code
@@ -76,9 +632,106 @@ void init_all_systems()
 	graphics_init("Lightning Simulator", vect2d_new(WINDOW_WIDTH, WINDOW_HEIGHT), vect2d_new(WINDOW_WIDTH, WINDOW_HEIGHT), 0);
 	slog("\n\n ============= GRAPHICS START ====================\n\n");
 
-	sprite_init_system(100);
+	spriteSystem = sprite_system_new(100, graphics_get_renderer());
 	slog("\n\n ============= SPRITE START ====================\n\n");
 
-	lightning_init_system(10000);
+	input_init_system();
+	slog("\n\n ============= INPUT START ====================\n\n");
+
+	jobs_init_system(0);
+	slog("\n\n ============= JOBS START ====================\n\n");
+
+	lightningSystem = lightning_system_new(spriteSystem, 10000, REPLAY_FRAME_BOLTS);
+	if(!spriteSystem || !lightningSystem)
+	{
+		exit(1);
+	}
+	lightning_set_simplify_tolerance(lightningSystem, simplifyTolerance);
+	if(cacheMegabytes >= 0)
+	{
+		lightning_set_cache_budget(lightningSystem, (size_t)cacheMegabytes * 1024 * 1024);
+	}
+	atexit(close_all_systems);
 	slog("\n\n ============= LIGHTNING START ====================\n\n");
+
+	if(useBreakdown)
+	{
+		breakdown_init_system();
+		slog("\n\n ============= BREAKDOWN START ====================\n\n");
+	}
+
+	if(useLaplacian)
+	{
+		laplacian_init_system(0);
+		slog("\n\n ============= LAPLACIAN START ====================\n\n");
+	}
+
+	if(graphics_is_software())
+	{
+		useRaster = raster_init_system(WINDOW_WIDTH, WINDOW_HEIGHT);
+		slog("\n\n ============= RASTER START ====================\n\n");
+	}
+
+	lightning_set_trail(lightningSystem, trailFade);
+	if(lightningSystem->trailFade > 0)
+	{
+		if(useRaster)
+		{
+			raster_set_trail(trailFade);
+		}
+		//frames keep coming every trailRate ms after the last new bolt until the trail has faded under a step of brightness
+		trailTime = (Uint32)(ceil(log(0.5 / 255) / log(trailFade)) * trailRate);
+	}
+
+	if(useLight)
+	{
+		light_init_system(WINDOW_WIDTH, WINDOW_HEIGHT, lightScale);
+		if(!light_load_background(LIGHT_BACKGROUND))
+		{
+			useLight = 0;
+		}
+		slog("\n\n ============= LIGHT START ====================\n\n");
+	}
+
+	if(capturePath)
+	{
+		if(captureFPS < 0 || (captureFPS > 0 && !graphics_set_fixed_timestep(captureFPS)))
+		{
+			slog("can't capture at %i frames a second", captureFPS);
+			exit(1);
+		}
+		capture_init(capturePath, captureFormat, WINDOW_WIDTH, WINDOW_HEIGHT, captureFPS > 0 ? captureFPS : 22, 0, captureFPS > 0);
+		slog("\n\n ============= CAPTURE START ====================\n\n");
+	}
+
+	if(publishName)
+	{
+		boltstream_open(publishName, 0, 0);
+	}
+
+	if(recordPath)
+	{
+		replay_record_open(recordPath);
+	}
+	if(replayPath)
+	{
+		if(!replay_open(replayPath))
+		{
+			exit(1);
+		}
+		if(replayMode == REPLAY_MAX_THROUGHPUT)
+		{
+			graphics_set_frame_delay(0);
+		}
+		slog("\n\n ============= REPLAY START ====================\n\n");
+	}
+}
+
+/**
+ * @brief frees the lightning and sprite systems at exit, the lightning first since it holds references to the sprites
+ */
+void close_all_systems()
+{
+	lightning_system_free(&lightningSystem);
+	sprite_system_free(&spriteSystem);
 }
\ No newline at end of file
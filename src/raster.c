@@ -0,0 +1,678 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "graphics.h"
+#include "jobs.h"
+#include "raster.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+ * @struct the tile a job worker accumulates light into
+ * @brief each worker gets its own accumulation buffer so tiles never have to be locked
+ */
+typedef struct RasterWorker_t
+{
+	float accum[3][RASTER_TILE_SIZE * RASTER_TILE_SIZE];			/**< the red, green and blue light added to the current tile */
+}RasterWorker;
+
+/* framebuffer */
+static Uint8 *rasterPixels = NULL;
+static int rasterWidth = 0;
+static int rasterHeight = 0;
+static Vect3d rasterClearColor = {{0}, {0}, {0}};
+static SDL_Texture *rasterTexture = NULL;
+
+/* segment queue */
+static RasterSegment *rasterSegments = NULL;
+static int rasterSegmentNum = 0;
+static int rasterSegmentMax = 0;
+
+/* tile bins, the segments touching tile i are rasterTileIndex[rasterTileStart[i]] to rasterTileIndex[rasterTileStart[i + 1] - 1] */
+static int rasterTilesX = 0;
+static int rasterTilesY = 0;
+static int *rasterTileStart = NULL;
+static int *rasterTileIndex = NULL;
+static int rasterTileIndexMax = 0;
+
+/* one accumulation buffer per job worker, grown if the job system is restarted with more workers */
+static RasterWorker *rasterWorkers = NULL;
+static int rasterWorkerNum = 0;
+
+/* trail, tile i's light is rasterTrail[i * 3 * RASTER_TILE_SIZE * RASTER_TILE_SIZE] on, laid out like a worker's accumulation buffer */
+static float *rasterTrail = NULL;
+static Uint8 *rasterTrailLit = NULL;
+static float rasterTrailFade = 0;
+
+/**
+ * @brief initializes the rasterizer and allocates the framebuffer, tiles are rasterized on the job system's workers
+ * @param width		width of the framebuffer in pixels
+ * @param height	height of the framebuffer in pixels
+ * @return 1 if the rasterizer is ready, 0 if the size isn't positive or the framebuffer could not be allocated
+ */
+int raster_init_system(int width, int height)
+{
+	if(width <= 0 || height <= 0)
+	{
+		slog("raster size must be positive (%i x %i)", width, height);
+		return 0;
+	}
+
+	rasterPixels = (Uint8 *)malloc(width * height * 4);
+	rasterTilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	rasterTilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	rasterTileStart = (int *)malloc(sizeof(int) * (rasterTilesX * rasterTilesY + 1));
+	if(!rasterPixels || !rasterTileStart)
+	{
+		slog("raster failed to initialize");
+		raster_close_system();
+		return 0;
+	}
+	memset(rasterPixels, 0, width * height * 4);
+	rasterWidth = width;
+	rasterHeight = height;
+
+	slog("rasterizer %i x %i", width, height);
+	atexit(raster_close_system);
+	return 1;
+}
+
+/**
+ * @brief frees the framebuffer, the segment queue and the workers' accumulation buffers
+ */
+void raster_close_system()
+{
+	free(rasterWorkers);
+	rasterWorkers = NULL;
+	rasterWorkerNum = 0;
+	if(rasterTexture)
+	{
+		SDL_DestroyTexture(rasterTexture);
+		rasterTexture = NULL;
+	}
+	free(rasterPixels);
+	free(rasterSegments);
+	free(rasterTileStart);
+	free(rasterTileIndex);
+	free(rasterTrail);
+	free(rasterTrailLit);
+	rasterPixels = NULL;
+	rasterSegments = NULL;
+	rasterTileStart = NULL;
+	rasterTileIndex = NULL;
+	rasterTrail = NULL;
+	rasterTrailLit = NULL;
+	rasterTrailFade = 0;
+	rasterSegmentNum = rasterSegmentMax = 0;
+	rasterTileIndexMax = 0;
+	rasterWidth = rasterHeight = 0;
+}
+
+/**
+ * @brief empties the segment queue and sets the color the framebuffer will be cleared to on the next render
+ * @param color		clear color, each component 0 - 255
+ */
+void raster_clear(Vect3d color)
+{
+	rasterSegmentNum = 0;
+	rasterClearColor = color;
+}
+
+/**
+ * @brief queues a segment to be drawn on the next raster_render
+ * @param start		starting point of the segment
+ * @param end		end point of the segment
+ * @param thickness	how thick the segment is
+ * @param color		color of the segment, each component 0 - 255
+ * @param trail		if set the segment is drawn into the trail instead of only this frame
+ */
+static void raster_queue_segment(Vect2d start, Vect2d end, float thickness, Vect3d color, int trail)
+{
+	RasterSegment *segment;
+	RasterSegment *grown;
+	if(!rasterPixels)
+	{
+		slog("raster uninitialized");
+		return;
+	}
+	if(rasterSegmentNum >= rasterSegmentMax)
+	{
+		grown = (RasterSegment *)realloc(rasterSegments, sizeof(RasterSegment) * MAX(1024, rasterSegmentMax * 2));
+		if(!grown)
+		{
+			slog("raster segment queue failed to grow");
+			return;
+		}
+		rasterSegments = grown;
+		rasterSegmentMax = MAX(1024, rasterSegmentMax * 2);
+	}
+	segment = &rasterSegments[rasterSegmentNum++];
+	segment->start = start;
+	segment->end = end;
+	segment->radius = thickness * 0.5f;
+	segment->glowRadius = MAX(thickness * RASTER_GLOW_SCALE, 1.0f);
+	vect3d_scale(segment->color, color, (1.0f / 255.0f));
+	segment->trail = trail;
+}
+
+/**
+ * @brief queues a segment to be drawn on the next raster_render
+ * @param start		starting point of the segment
+ * @param end		end point of the segment
+ * @param thickness	how thick the segment is
+ * @param color		color of the segment, each component 0 - 255
+ */
+void raster_add_segment(Vect2d start, Vect2d end, float thickness, Vect3d color)
+{
+	raster_queue_segment(start, end, thickness, color, 0);
+}
+
+/**
+ * @brief queues a segment to be drawn into the trail on the next raster_render. it shows the same as any other segment that frame,
+ *			then stays behind and fades by the trail's factor every frame after, without being queued again. drawn like
+ *			raster_add_segment if there is no trail
+ * @param start		starting point of the segment
+ * @param end		end point of the segment
+ * @param thickness	how thick the segment is
+ * @param color		color of the segment, each component 0 - 255
+ */
+void raster_add_trail_segment(Vect2d start, Vect2d end, float thickness, Vect3d color)
+{
+	raster_queue_segment(start, end, thickness, color, rasterTrail != NULL);
+}
+
+/**
+ * @brief keeps the light of the segments queued with raster_add_trail_segment in a buffer the size of the framebuffer, multiplied by
+ *			fade every render and added under the frame. the cost per frame is one pass over the lit tiles however long the trail is
+ * @param fade		how much of the trail is left after each frame, under 1. 0 frees the trail
+ */
+void raster_set_trail(float fade)
+{
+	int tileNum = rasterTilesX * rasterTilesY;
+	if(fade <= 0)
+	{
+		free(rasterTrail);
+		free(rasterTrailLit);
+		rasterTrail = NULL;
+		rasterTrailLit = NULL;
+		rasterTrailFade = 0;
+		return;
+	}
+	if(fade >= 1)
+	{
+		slog("raster trail fade must be under 1 (%f)", fade);
+		return;
+	}
+	if(!rasterPixels)
+	{
+		slog("raster uninitialized");
+		return;
+	}
+	if(!rasterTrail)
+	{
+		rasterTrail = (float *)malloc(sizeof(float) * 3 * RASTER_TILE_SIZE * RASTER_TILE_SIZE * tileNum);
+		rasterTrailLit = (Uint8 *)malloc(tileNum);
+		if(!rasterTrail || !rasterTrailLit)
+		{
+			slog("raster trail failed to allocate");
+			raster_set_trail(0);
+			return;
+		}
+		memset(rasterTrail, 0, sizeof(float) * 3 * RASTER_TILE_SIZE * RASTER_TILE_SIZE * tileNum);
+		memset(rasterTrailLit, 0, tileNum);
+	}
+	rasterTrailFade = fade;
+}
+
+/**
+ * @brief finds the range of tiles a segment's glow can reach
+ * @param segment [in]	the segment to bound
+ * @param x0 [out]		first tile column
+ * @param y0 [out]		first tile row
+ * @param x1 [out]		last tile column
+ * @param y1 [out]		last tile row
+ * @return 0 if the segment is completely off the framebuffer, 1 otherwise
+ */
+static int raster_segment_tiles(RasterSegment *segment, int *x0, int *y0, int *x1, int *y1)
+{
+	float minX = MIN(segment->start.x, segment->end.x) - segment->glowRadius;
+	float minY = MIN(segment->start.y, segment->end.y) - segment->glowRadius;
+	float maxX = MAX(segment->start.x, segment->end.x) + segment->glowRadius;
+	float maxY = MAX(segment->start.y, segment->end.y) + segment->glowRadius;
+
+	if(maxX < 0 || maxY < 0 || minX >= rasterWidth || minY >= rasterHeight)
+	{
+		return 0;
+	}
+	*x0 = MAX(0, (int)minX / RASTER_TILE_SIZE);
+	*y0 = MAX(0, (int)minY / RASTER_TILE_SIZE);
+	*x1 = MIN(rasterTilesX - 1, (int)maxX / RASTER_TILE_SIZE);
+	*y1 = MIN(rasterTilesY - 1, (int)maxY / RASTER_TILE_SIZE);
+	return 1;
+}
+
+/**
+ * @brief sorts the queued segments into per tile lists with a counting sort, so each tile only visits the segments that touch it
+ * @return 0 if the bins could not be allocated
+ */
+static int raster_bin_segments()
+{
+	int i, x, y;
+	int x0, y0, x1, y1;
+	int tileNum = rasterTilesX * rasterTilesY;
+	int total = 0, count;
+	int *grown;
+
+	memset(rasterTileStart, 0, sizeof(int) * (tileNum + 1));
+	for(i = 0; i < rasterSegmentNum; i++)
+	{
+		if(!raster_segment_tiles(&rasterSegments[i], &x0, &y0, &x1, &y1))
+		{
+			continue;
+		}
+		for(y = y0; y <= y1; y++)
+		{
+			for(x = x0; x <= x1; x++)
+			{
+				rasterTileStart[y * rasterTilesX + x + 1]++;
+			}
+		}
+	}
+	for(i = 0; i < tileNum; i++)
+	{
+		count = rasterTileStart[i + 1];
+		rasterTileStart[i + 1] = total;
+		total += count;
+	}
+	if(total > rasterTileIndexMax)
+	{
+		grown = (int *)realloc(rasterTileIndex, sizeof(int) * total);
+		if(!grown)
+		{
+			slog("raster tile bins failed to grow");
+			return 0;
+		}
+		rasterTileIndex = grown;
+		rasterTileIndexMax = total;
+	}
+
+	/*rasterTileStart[i + 1] is used as the write cursor for tile i, once filled it is the end of tile i*/
+	for(i = 0; i < rasterSegmentNum; i++)
+	{
+		if(!raster_segment_tiles(&rasterSegments[i], &x0, &y0, &x1, &y1))
+		{
+			continue;
+		}
+		for(y = y0; y <= y1; y++)
+		{
+			for(x = x0; x <= x1; x++)
+			{
+				rasterTileIndex[rasterTileStart[y * rasterTilesX + x + 1]++] = i;
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief adds the light of one capsule to a tile's accumulation buffer. the distance from each pixel center to the segment
+ *			gives an anti-aliased core and a quadratic glow falloff
+ * @param segment [in]	the segment to draw
+ * @param accum [in,out]	the red, green and blue of the tile to add the light to
+ * @param tileX		x coordinate of the tile's top left pixel
+ * @param tileY		y coordinate of the tile's top left pixel
+ */
+static void raster_segment(RasterSegment *segment, float accum[3][RASTER_TILE_SIZE * RASTER_TILE_SIZE], int tileX, int tileY)
+{
+	int x, y, i;
+	int x0, y0, x1, y1;
+	int rowStart, rowEnd;
+	float ax = segment->start.x - tileX;
+	float ay = segment->start.y - tileY;
+	float bax = segment->end.x - segment->start.x;
+	float bay = segment->end.y - segment->start.y;
+	float length2 = bax * bax + bay * bay;
+	float invLength2 = length2 > 0 ? 1.0f / length2 : 0;
+	float edge = segment->radius + 0.5f;
+	float invGlow = 1.0f / segment->glowRadius;
+	float rowHalfWidth = fabs(bay) > 0.01f * fabs(bax) ? segment->glowRadius * sqrt(length2) / fabs(bay) + 1 : 0;
+	float rowCenter;
+	float px, py, pax, pay, h, dx, dy, d, core, glow, light;
+	float *red = accum[0];
+	float *green = accum[1];
+	float *blue = accum[2];
+#ifdef RASTER_SSE2
+	__m128 vax, vay, vbax, vbay, vinvLength2, vedge, vinvGlow, vintensity;
+	__m128 vzero, vone, vpx, vpy, vpax, vpay, vh, vdx, vdy, vd, vcore, vglow, vlight;
+	__m128 vr, vg, vb;
+#endif
+
+	x0 = (int)floor(MIN(ax, ax + bax) - segment->glowRadius);
+	y0 = (int)floor(MIN(ay, ay + bay) - segment->glowRadius);
+	x1 = (int)ceil(MAX(ax, ax + bax) + segment->glowRadius) + 1;
+	y1 = (int)ceil(MAX(ay, ay + bay) + segment->glowRadius) + 1;
+	x0 = MAX(0, x0) & ~3;
+	y0 = MAX(0, y0);
+	x1 = MIN(RASTER_TILE_SIZE, ((x1 + 3) & ~3));
+	y1 = MIN(RASTER_TILE_SIZE, y1);
+
+#ifdef RASTER_SSE2
+	vax = _mm_set1_ps(ax);
+	vay = _mm_set1_ps(ay);
+	vbax = _mm_set1_ps(bax);
+	vbay = _mm_set1_ps(bay);
+	vinvLength2 = _mm_set1_ps(invLength2);
+	vedge = _mm_set1_ps(edge);
+	vinvGlow = _mm_set1_ps(invGlow);
+	vintensity = _mm_set1_ps(RASTER_GLOW_INTENSITY);
+	vzero = _mm_setzero_ps();
+	vone = _mm_set1_ps(1.0f);
+	vr = _mm_set1_ps(segment->color.r);
+	vg = _mm_set1_ps(segment->color.g);
+	vb = _mm_set1_ps(segment->color.b);
+#endif
+
+	for(y = y0; y < y1; y++)
+	{
+		py = y + 0.5f;
+		rowStart = x0;
+		rowEnd = x1;
+		if(rowHalfWidth > 0)
+		{
+			/*only the pixels within the glow radius of the segment's line can be lit, which keeps long diagonal segments cheap*/
+			rowCenter = ax + (py - ay) * bax / bay;
+			rowStart = MAX(x0, ((int)floor(rowCenter - rowHalfWidth) & ~3));
+			rowEnd = MIN(x1, (((int)ceil(rowCenter + rowHalfWidth) + 3) & ~3));
+		}
+		x = rowStart;
+#ifdef RASTER_SSE2
+		vpy = _mm_set1_ps(py);
+		vpay = _mm_sub_ps(vpy, vay);
+		for(; x + 4 <= rowEnd; x += 4)
+		{
+			i = y * RASTER_TILE_SIZE + x;
+			vpx = _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+			vpax = _mm_sub_ps(vpx, vax);
+			vh = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vpax, vbax), _mm_mul_ps(vpay, vbay)), vinvLength2);
+			vh = _mm_min_ps(_mm_max_ps(vh, vzero), vone);
+			vdx = _mm_sub_ps(vpax, _mm_mul_ps(vbax, vh));
+			vdy = _mm_sub_ps(vpay, _mm_mul_ps(vbay, vh));
+			vd = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vdx, vdx), _mm_mul_ps(vdy, vdy)));
+			vcore = _mm_min_ps(_mm_max_ps(_mm_sub_ps(vedge, vd), vzero), vone);
+			vglow = _mm_max_ps(_mm_sub_ps(vone, _mm_mul_ps(vd, vinvGlow)), vzero);
+			vglow = _mm_mul_ps(_mm_mul_ps(vglow, vglow), vintensity);
+			vlight = _mm_add_ps(vcore, vglow);
+			_mm_storeu_ps(&red[i], _mm_add_ps(_mm_loadu_ps(&red[i]), _mm_mul_ps(vlight, vr)));
+			_mm_storeu_ps(&green[i], _mm_add_ps(_mm_loadu_ps(&green[i]), _mm_mul_ps(vlight, vg)));
+			_mm_storeu_ps(&blue[i], _mm_add_ps(_mm_loadu_ps(&blue[i]), _mm_mul_ps(vlight, vb)));
+		}
+#endif
+		for(; x < rowEnd; x++)
+		{
+			i = y * RASTER_TILE_SIZE + x;
+			px = x + 0.5f;
+			pax = px - ax;
+			pay = py - ay;
+			h = (pax * bax + pay * bay) * invLength2;
+			h = MIN(MAX(h, 0), 1);
+			dx = pax - bax * h;
+			dy = pay - bay * h;
+			d = sqrt(dx * dx + dy * dy);
+			core = MIN(MAX(edge - d, 0), 1);
+			glow = MAX(1 - d * invGlow, 0);
+			light = core + glow * glow * RASTER_GLOW_INTENSITY;
+			red[i] += light * segment->color.r;
+			green[i] += light * segment->color.g;
+			blue[i] += light * segment->color.b;
+		}
+	}
+}
+
+/**
+ * @brief fades a tile of the trail by the trail's factor, clearing it once nothing visible is left
+ * @param trail [in,out]	the red, green and blue of the tile
+ * @return 1 if the tile still has light in it, 0 if it was cleared
+ */
+static int raster_fade_trail(float trail[3][RASTER_TILE_SIZE * RASTER_TILE_SIZE])
+{
+	int c, i;
+	float light, brightest = 0;
+	float *channel;
+#ifdef RASTER_SSE2
+	float lanes[4];
+	__m128 vfade = _mm_set1_ps(rasterTrailFade);
+	__m128 vbrightest = _mm_setzero_ps();
+	__m128 vlight;
+#endif
+
+	for(c = 0; c < 3; c++)
+	{
+		channel = trail[c];
+		i = 0;
+#ifdef RASTER_SSE2
+		for(; i + 4 <= RASTER_TILE_SIZE * RASTER_TILE_SIZE; i += 4)
+		{
+			vlight = _mm_mul_ps(_mm_loadu_ps(&channel[i]), vfade);
+			vbrightest = _mm_max_ps(vbrightest, vlight);
+			_mm_storeu_ps(&channel[i], vlight);
+		}
+#endif
+		for(; i < RASTER_TILE_SIZE * RASTER_TILE_SIZE; i++)
+		{
+			light = channel[i] * rasterTrailFade;
+			brightest = MAX(brightest, light);
+			channel[i] = light;
+		}
+	}
+#ifdef RASTER_SSE2
+	_mm_storeu_ps(lanes, vbrightest);
+	brightest = MAX(MAX(brightest, lanes[0]), MAX(MAX(lanes[1], lanes[2]), lanes[3]));
+#endif
+	/*cleared rather than faded forever, which would also sink into denormals that are slow to multiply*/
+	if(brightest < RASTER_TRAIL_FLOOR)
+	{
+		memset(trail, 0, sizeof(float) * 3 * RASTER_TILE_SIZE * RASTER_TILE_SIZE);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief adds a tile of the trail to a worker's accumulation buffer, under whatever is drawn in the tile this frame
+ * @param accum [in,out]	the red, green and blue of the tile being drawn
+ * @param trail [in]		the red, green and blue of the tile's trail
+ */
+static void raster_add_trail(float accum[3][RASTER_TILE_SIZE * RASTER_TILE_SIZE], float trail[3][RASTER_TILE_SIZE * RASTER_TILE_SIZE])
+{
+	int c, i;
+
+	for(c = 0; c < 3; c++)
+	{
+		i = 0;
+#ifdef RASTER_SSE2
+		for(; i + 4 <= RASTER_TILE_SIZE * RASTER_TILE_SIZE; i += 4)
+		{
+			_mm_storeu_ps(&accum[c][i], _mm_add_ps(_mm_loadu_ps(&accum[c][i]), _mm_loadu_ps(&trail[c][i])));
+		}
+#endif
+		for(; i < RASTER_TILE_SIZE * RASTER_TILE_SIZE; i++)
+		{
+			accum[c][i] += trail[c][i];
+		}
+	}
+}
+
+/**
+ * @brief rasterizes one tile: clears the accumulation buffer, adds every binned segment, then resolves it into the framebuffer.
+ *			with a trail, the tile's trail is faded first, the trail's segments are drawn into it and it is added under the rest
+ * @param worker [in,out]	the worker doing the rasterizing
+ * @param tile				index of the tile
+ */
+static void raster_tile(RasterWorker *worker, int tile)
+{
+	int i, x, y;
+	int tileX = (tile % rasterTilesX) * RASTER_TILE_SIZE;
+	int tileY = (tile / rasterTilesX) * RASTER_TILE_SIZE;
+	int width = MIN(RASTER_TILE_SIZE, rasterWidth - tileX);
+	int height = MIN(RASTER_TILE_SIZE, rasterHeight - tileY);
+	int end = rasterTileStart[tile + 1];
+	float clearR = rasterClearColor.r / 255.0f;
+	float clearG = rasterClearColor.g / 255.0f;
+	float clearB = rasterClearColor.b / 255.0f;
+	Uint8 *pixel;
+	RasterSegment *segment;
+	float (*trail)[RASTER_TILE_SIZE * RASTER_TILE_SIZE] = NULL;
+#ifdef RASTER_SSE2
+	__m128 vclearR = _mm_set1_ps(clearR);
+	__m128 vclearG = _mm_set1_ps(clearG);
+	__m128 vclearB = _mm_set1_ps(clearB);
+	__m128 vone = _mm_set1_ps(1.0f);
+	__m128 v255 = _mm_set1_ps(255.0f);
+	__m128i valpha = _mm_set1_epi32(0xff << 24);
+	__m128i vr, vg, vb;
+#endif
+
+	memset(worker->accum, 0, sizeof(worker->accum));
+	if(rasterTrail)
+	{
+		trail = (float (*)[RASTER_TILE_SIZE * RASTER_TILE_SIZE])&rasterTrail[(size_t)tile * 3 * RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+		if(rasterTrailLit[tile])
+		{
+			rasterTrailLit[tile] = raster_fade_trail(trail);
+		}
+	}
+	for(i = rasterTileStart[tile]; i < end; i++)
+	{
+		segment = &rasterSegments[rasterTileIndex[i]];
+		if(segment->trail && trail)
+		{
+			raster_segment(segment, trail, tileX, tileY);
+			rasterTrailLit[tile] = 1;
+		}
+		else
+		{
+			raster_segment(segment, worker->accum, tileX, tileY);
+		}
+	}
+	if(trail && rasterTrailLit[tile])
+	{
+		raster_add_trail(worker->accum, trail);
+	}
+
+	for(y = 0; y < height; y++)
+	{
+		pixel = &rasterPixels[((tileY + y) * rasterWidth + tileX) * 4];
+		x = 0;
+#ifdef RASTER_SSE2
+		for(; x + 4 <= width; x += 4, pixel += 16)
+		{
+			i = y * RASTER_TILE_SIZE + x;
+			vr = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_add_ps(vclearR, _mm_loadu_ps(&worker->accum[0][i])), vone), v255));
+			vg = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_add_ps(vclearG, _mm_loadu_ps(&worker->accum[1][i])), vone), v255));
+			vb = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_add_ps(vclearB, _mm_loadu_ps(&worker->accum[2][i])), vone), v255));
+			vr = _mm_or_si128(_mm_or_si128(vr, _mm_slli_epi32(vg, 8)), _mm_or_si128(_mm_slli_epi32(vb, 16), valpha));
+			_mm_storeu_si128((__m128i *)pixel, vr);
+		}
+#endif
+		for(; x < width; x++, pixel += 4)
+		{
+			i = y * RASTER_TILE_SIZE + x;
+			pixel[0] = (Uint8)(MIN(clearR + worker->accum[0][i], 1.0f) * 255.0f);
+			pixel[1] = (Uint8)(MIN(clearG + worker->accum[1][i], 1.0f) * 255.0f);
+			pixel[2] = (Uint8)(MIN(clearB + worker->accum[2][i], 1.0f) * 255.0f);
+			pixel[3] = 255;
+		}
+	}
+}
+
+/**
+ * @brief job that rasterizes a range of tiles with the running worker's accumulation buffer
+ * @param data		unused
+ * @param start		first tile
+ * @param end		one past the last tile
+ * @param worker	index of the job worker running it
+ */
+static void raster_tile_job(void *data, int start, int end, int worker)
+{
+	int tile;
+	for(tile = start; tile < end; tile++)
+	{
+		raster_tile(&rasterWorkers[worker], tile);
+	}
+}
+
+/**
+ * @brief bins every queued segment into the tiles it touches, then rasterizes all the tiles in parallel into the framebuffer
+ */
+void raster_render()
+{
+	int workers = jobs_get_worker_count();
+	if(!rasterPixels)
+	{
+		slog("raster uninitialized");
+		return;
+	}
+	if(workers > rasterWorkerNum)
+	{
+		free(rasterWorkers);
+		rasterWorkers = (RasterWorker *)malloc(sizeof(RasterWorker) * workers);
+		if(!rasterWorkers)
+		{
+			slog("raster failed to allocate tiles for %i workers", workers);
+			rasterWorkerNum = 0;
+			return;
+		}
+		rasterWorkerNum = workers;
+	}
+	if(!raster_bin_segments())
+	{
+		return;
+	}
+
+	/*tiles cost very different amounts, so each one is its own piece for idle workers to steal*/
+	jobs_parallel_for(raster_tile_job, NULL, 0, rasterTilesX * rasterTilesY, 1);
+}
+
+/**
+ * @brief getter for the framebuffer, pixels are stored as R, G, B, A bytes
+ * @param pitch [out]	if non-null, set to the number of bytes in one row of the framebuffer
+ * @return the framebuffer, NULL if the rasterizer was never initialized
+ */
+Uint8 *raster_get_pixels(int *pitch)
+{
+	if(pitch)
+	{
+		*pitch = rasterWidth * 4;
+	}
+	return rasterPixels;
+}
+
+/**
+ * @brief uploads the framebuffer to a streaming texture and copies it onto the game's renderer
+ */
+void raster_present()
+{
+	SDL_Renderer *renderer = graphics_get_renderer();
+	if(!rasterPixels || !renderer)
+	{
+		slog("raster or renderer uninitialized");
+		return;
+	}
+	if(!rasterTexture)
+	{
+		rasterTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, rasterWidth, rasterHeight);
+		if(!rasterTexture)
+		{
+			slog("unable to create raster texture: %s", SDL_GetError());
+			return;
+		}
+	}
+	SDL_UpdateTexture(rasterTexture, NULL, rasterPixels, rasterWidth * 4);
+	SDL_RenderCopy(renderer, rasterTexture, NULL, NULL);
+}
\ No newline at end of file
@@ -0,0 +1,424 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "simple_logger.h"
+
+#include "replay.h"
+
+#define REPLAY_HEADER_SIZE		8			/**< magic, version and 3 reserved bytes */
+
+#define REPLAY_BOLT_MAX_BYTES	30			/**< the most bytes one encoded bolt can take: five 5 byte zigzag varints and a 5 byte seed */
+
+/**
+ * @struct the values the next bolt is delta encoded against
+ * @brief shared by the recorder and the player so both sides stay in step
+ */
+typedef struct ReplayState_t
+{
+	Sint32 startX, startY;					/**< start of the previous bolt, in subpixels */
+	Sint32 endX, endY;						/**< end of the previous bolt, in subpixels */
+	Sint32 thickness;						/**< thickness of the previous bolt, in subpixels */
+	Uint32 time;							/**< time of the previous frame */
+}ReplayState;
+
+/* recording */
+static FILE *replayRecordFile = NULL;
+static ReplayState replayRecordState;
+static ReplayBolt *replayPending = NULL;
+static int replayPendingNum = 0;
+static int replayPendingMax = 0;
+static int replayFirstFrame = 1;
+static Uint8 *replayEncodeBuffer = NULL;
+static int replayEncodeMax = 0;
+
+/* playing */
+static Uint8 *replayData = NULL;
+static size_t replaySize = 0;
+static size_t replayCursor = 0;
+static ReplayState replayPlayState;
+
+/**
+ * @brief appends an unsigned LEB128 varint to a buffer
+ * @param [out] out	where to write the varint, needs room for 5 bytes
+ * @param value		the value to encode
+ * @return the number of bytes written
+ */
+static int replay_put_varint(Uint8 *out, Uint32 value)
+{
+	int n = 0;
+	while(value >= 0x80)
+	{
+		out[n++] = (Uint8)(value | 0x80);
+		value >>= 7;
+	}
+	out[n++] = (Uint8)value;
+	return n;
+}
+
+/**
+ * @brief appends a signed value as a zigzag varint, so small negative deltas stay small
+ * @param [out] out	where to write the varint, needs room for 5 bytes
+ * @param value		the value to encode
+ * @return the number of bytes written
+ */
+static int replay_put_zigzag(Uint8 *out, Sint32 value)
+{
+	return replay_put_varint(out, ((Uint32)value << 1) ^ (Uint32)(value >> 31));
+}
+
+/**
+ * @brief reads an unsigned varint from the mapped log
+ * @param value [out]	the decoded value
+ * @return 0 if the log ends in the middle of the varint
+ */
+static int replay_get_varint(Uint32 *value)
+{
+	int shift = 0;
+	Uint8 byte;
+	*value = 0;
+	do
+	{
+		if(replayCursor >= replaySize || shift > 28)
+		{
+			return 0;
+		}
+		byte = replayData[replayCursor++];
+		*value |= (Uint32)(byte & 0x7f) << shift;
+		shift += 7;
+	}while(byte & 0x80);
+	return 1;
+}
+
+/**
+ * @brief reads a zigzag varint from the mapped log
+ * @param value [out]	the decoded value
+ * @return 0 if the log ends in the middle of the varint
+ */
+static int replay_get_zigzag(Sint32 *value)
+{
+	Uint32 raw;
+	if(!replay_get_varint(&raw))
+	{
+		return 0;
+	}
+	*value = (Sint32)(raw >> 1) ^ -(Sint32)(raw & 1);
+	return 1;
+}
+
+/**
+ * @brief converts a position or thickness into subpixel steps
+ * @param value		the value in pixels
+ * @return the value in 1/REPLAY_SUBPIXEL pixels
+ */
+static Sint32 replay_quantize(float value)
+{
+	return (Sint32)floor(value * REPLAY_SUBPIXEL + 0.5f);
+}
+
+/**
+ * @brief opens a replay log for recording, an existing log at the path is replaced
+ * @param [in] path		the file to record to
+ * @return 1 if the log was opened, 0 otherwise
+ */
+int replay_record_open(char *path)
+{
+	Uint8 header[REPLAY_HEADER_SIZE] = {0};
+	if(replayRecordFile)
+	{
+		slog("already recording a replay");
+		return 0;
+	}
+	replayRecordFile = fopen(path, "wb");
+	if(!replayRecordFile)
+	{
+		slog("unable to open replay log %s", path);
+		return 0;
+	}
+	memcpy(header, REPLAY_MAGIC, 4);
+	header[4] = REPLAY_VERSION;
+	fwrite(header, 1, REPLAY_HEADER_SIZE, replayRecordFile);
+
+	memset(&replayRecordState, 0, sizeof(ReplayState));
+	replayPendingNum = 0;
+	replayFirstFrame = 1;
+	slog("recording replay to %s", path);
+	atexit(replay_record_close);
+	return 1;
+}
+
+/**
+ * @brief writes out any pending frame and closes the log being recorded
+ */
+void replay_record_close()
+{
+	if(!replayRecordFile)
+	{
+		return;
+	}
+	replay_record_frame(replayRecordState.time);
+	fclose(replayRecordFile);
+	replayRecordFile = NULL;
+	free(replayPending);
+	free(replayEncodeBuffer);
+	replayPending = NULL;
+	replayEncodeBuffer = NULL;
+	replayPendingMax = replayEncodeMax = 0;
+}
+
+/**
+ * @brief adds a bolt request to the frame being recorded
+ * @param start		starting point of the bolt
+ * @param end		end point of the bolt
+ * @param thickness	thickness the bolt is created with
+ * @param seed		the value rand and the lightning system were seeded with right before the bolt is generated
+ */
+void replay_record_bolt(Vect2d start, Vect2d end, float thickness, Uint32 seed)
+{
+	ReplayBolt *grown;
+	if(!replayRecordFile)
+	{
+		return;
+	}
+	if(replayPendingNum >= replayPendingMax)
+	{
+		grown = (ReplayBolt *)realloc(replayPending, sizeof(ReplayBolt) * MAX(16, replayPendingMax * 2));
+		if(!grown)
+		{
+			slog("replay frame failed to grow");
+			return;
+		}
+		replayPending = grown;
+		replayPendingMax = MAX(16, replayPendingMax * 2);
+	}
+	replayPending[replayPendingNum].start = start;
+	replayPending[replayPendingNum].end = end;
+	replayPending[replayPendingNum].thickness = thickness;
+	replayPending[replayPendingNum].seed = seed;
+	replayPendingNum++;
+}
+
+/**
+ * @brief ends the frame being recorded and appends it to the log, frames without any bolts are not written
+ * @param time		the game time of the frame
+ */
+void replay_record_frame(Uint32 time)
+{
+	int i, n;
+	Sint32 value;
+	Uint8 *grown;
+	ReplayBolt *bolt;
+	ReplayState *state = &replayRecordState;
+
+	if(!replayRecordFile || replayPendingNum == 0)
+	{
+		return;
+	}
+	if(replayFirstFrame)
+	{
+		/*the log stores time relative to its first frame*/
+		state->time = time;
+		replayFirstFrame = 0;
+	}
+	if(replayEncodeMax < 10 + replayPendingNum * REPLAY_BOLT_MAX_BYTES)
+	{
+		grown = (Uint8 *)realloc(replayEncodeBuffer, 10 + replayPendingNum * REPLAY_BOLT_MAX_BYTES);
+		if(!grown)
+		{
+			slog("replay encode buffer failed to grow");
+			replayPendingNum = 0;
+			return;
+		}
+		replayEncodeBuffer = grown;
+		replayEncodeMax = 10 + replayPendingNum * REPLAY_BOLT_MAX_BYTES;
+	}
+
+	n = replay_put_varint(replayEncodeBuffer, time - state->time);
+	n += replay_put_varint(&replayEncodeBuffer[n], replayPendingNum);
+	for(i = 0; i < replayPendingNum; i++)
+	{
+		bolt = &replayPending[i];
+		value = replay_quantize(bolt->start.x);
+		n += replay_put_zigzag(&replayEncodeBuffer[n], value - state->startX);
+		state->startX = value;
+		value = replay_quantize(bolt->start.y);
+		n += replay_put_zigzag(&replayEncodeBuffer[n], value - state->startY);
+		state->startY = value;
+		value = replay_quantize(bolt->end.x);
+		n += replay_put_zigzag(&replayEncodeBuffer[n], value - state->endX);
+		state->endX = value;
+		value = replay_quantize(bolt->end.y);
+		n += replay_put_zigzag(&replayEncodeBuffer[n], value - state->endY);
+		state->endY = value;
+		value = replay_quantize(bolt->thickness);
+		n += replay_put_zigzag(&replayEncodeBuffer[n], value - state->thickness);
+		state->thickness = value;
+		n += replay_put_varint(&replayEncodeBuffer[n], bolt->seed);
+	}
+	state->time = time;
+	replayPendingNum = 0;
+
+	/*one write per frame, flushed so a crash loses at most the frame being recorded*/
+	fwrite(replayEncodeBuffer, 1, n, replayRecordFile);
+	fflush(replayRecordFile);
+}
+
+/**
+ * @brief maps a replay log into memory for playing back
+ * @param [in] path		the log to play
+ * @return 1 if the log was opened, 0 otherwise
+ */
+int replay_open(char *path)
+{
+#ifdef _WIN32
+	FILE *file;
+	long size;
+#else
+	int fd;
+	struct stat info;
+#endif
+
+	if(replayData)
+	{
+		slog("already playing a replay");
+		return 0;
+	}
+#ifdef _WIN32
+	file = fopen(path, "rb");
+	if(!file)
+	{
+		slog("unable to open replay log %s", path);
+		return 0;
+	}
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	replayData = (Uint8 *)malloc(MAX(size, 1));
+	if(!replayData || fread(replayData, 1, size, file) != (size_t)size)
+	{
+		slog("unable to read replay log %s", path);
+		fclose(file);
+		free(replayData);
+		replayData = NULL;
+		return 0;
+	}
+	fclose(file);
+	replaySize = size;
+#else
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		slog("unable to open replay log %s", path);
+		return 0;
+	}
+	if(fstat(fd, &info) != 0 || info.st_size < REPLAY_HEADER_SIZE)
+	{
+		slog("replay log %s is too small", path);
+		close(fd);
+		return 0;
+	}
+	replayData = (Uint8 *)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(replayData == MAP_FAILED)
+	{
+		slog("unable to map replay log %s", path);
+		replayData = NULL;
+		return 0;
+	}
+	replaySize = info.st_size;
+#endif
+
+	if(replaySize < REPLAY_HEADER_SIZE || memcmp(replayData, REPLAY_MAGIC, 4) != 0 || replayData[4] != REPLAY_VERSION)
+	{
+		slog("%s is not a version %i replay log", path, REPLAY_VERSION);
+		replay_close();
+		return 0;
+	}
+	replayCursor = REPLAY_HEADER_SIZE;
+	memset(&replayPlayState, 0, sizeof(ReplayState));
+	slog("playing replay %s (%i bytes)", path, (int)replaySize);
+	return 1;
+}
+
+/**
+ * @brief unmaps the replay log being played
+ */
+void replay_close()
+{
+	if(!replayData)
+	{
+		return;
+	}
+#ifdef _WIN32
+	free(replayData);
+#else
+	munmap(replayData, replaySize);
+#endif
+	replayData = NULL;
+	replaySize = 0;
+	replayCursor = 0;
+}
+
+/**
+ * @brief decodes the next frame of the replay log
+ * @param time [out]		the game time the frame was recorded at, relative to the first frame in the log
+ * @param bolts [out]		filled with the frame's bolt requests
+ * @param maxBolts			the most bolts that fit in bolts, any extra in the frame are skipped
+ * @return the number of bolts put in bolts, -1 when there are no frames left
+ */
+int replay_next_frame(Uint32 *time, ReplayBolt *bolts, int maxBolts)
+{
+	Uint32 i;
+	Uint32 delta, count, seed;
+	Sint32 startX, startY, endX, endY, thickness;
+	ReplayState *state = &replayPlayState;
+	int num = 0;
+
+	if(!replayData)
+	{
+		return -1;
+	}
+	if(!replay_get_varint(&delta) || !replay_get_varint(&count))
+	{
+		return -1;
+	}
+	for(i = 0; i < count; i++)
+	{
+		if(!replay_get_zigzag(&startX) || !replay_get_zigzag(&startY) ||
+		   !replay_get_zigzag(&endX) || !replay_get_zigzag(&endY) ||
+		   !replay_get_zigzag(&thickness) || !replay_get_varint(&seed))
+		{
+			/*the last frame was cut short, treat it as the end of the log*/
+			return -1;
+		}
+		state->startX += startX;
+		state->startY += startY;
+		state->endX += endX;
+		state->endY += endY;
+		state->thickness += thickness;
+		if(num < maxBolts)
+		{
+			bolts[num].start = vect2d_new(state->startX / REPLAY_SUBPIXEL, state->startY / REPLAY_SUBPIXEL);
+			bolts[num].end = vect2d_new(state->endX / REPLAY_SUBPIXEL, state->endY / REPLAY_SUBPIXEL);
+			bolts[num].thickness = state->thickness / REPLAY_SUBPIXEL;
+			bolts[num].seed = seed;
+			num++;
+		}
+	}
+	state->time += delta;
+	if(time)
+	{
+		*time = state->time;
+	}
+	return num;
+}
\ No newline at end of file
@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "simple_logger.h"
+
+#include "scene.h"
+#include "jobs.h"
+#include "raster.h"
+
+#define SCENE_STATS				3			/**< p50, p99 and max */
+
+#define SCENE_BASELINE_STATS	2			/**< the first of the stats, p50 and p99, are the ones the baseline has thresholds for */
+
+/**
+ * @brief generates one frame's bolts of a scene
+ * @param system [in,out]	the lightning system to generate them in
+ * @param frame		which frame of the scene it is
+ * @param bolts		how many bolts the scene draws a frame
+ */
+typedef void (*SceneSpawn)(LightningSystem *system, int frame, int bolts);
+
+/**
+ * @struct one scripted scene
+ */
+typedef struct SceneScript_t
+{
+	char *name;								/**< what the scene is called in the report and the baseline */
+	int frames;								/**< how many frames it plays */
+	int bolts;								/**< how many bolts it draws a frame */
+	SceneSpawn spawn;						/**< generates each frame's bolts */
+}SceneScript;
+
+static void scene_spawn_single(LightningSystem *system, int frame, int bolts);
+static void scene_spawn_storm(LightningSystem *system, int frame, int bolts);
+static void scene_spawn_longest(LightningSystem *system, int frame, int bolts);
+
+static SceneScript sceneScripts[] =
+{
+	{"single", 600, 1, scene_spawn_single},
+	{"storm", 60, 1000, scene_spawn_storm},
+	{"longest", 120, 16, scene_spawn_longest}
+};
+
+#define SCENE_COUNT				(sizeof(sceneScripts) / sizeof(SceneScript))
+
+static char *scenePhaseNames[SCENE_PHASES] = {"generate", "draw", "present", "total"};
+static char *sceneStatNames[SCENE_STATS] = {"p50", "p99", "max"};
+
+static float sceneResults[SCENE_COUNT][SCENE_PHASES][SCENE_STATS];
+
+/**
+ * @brief fills in the options a scene benchmark uses when nothing else is asked for
+ * @param options [out]	the options to fill
+ */
+void scene_default_options(SceneOptions *options)
+{
+	memset(options, 0, sizeof(SceneOptions));
+	options->baseline = SCENE_BASELINE;
+}
+
+/**
+ * @brief one bolt from the top of the window to a target circling its center
+ */
+static void scene_spawn_single(LightningSystem *system, int frame, int bolts)
+{
+	float angle = frame * 0.05f;
+	Vect2d target = vect2d_new(WINDOW_WIDTH / 2 + cos(angle) * WINDOW_HEIGHT / 3, WINDOW_HEIGHT / 2 + sin(angle) * WINDOW_HEIGHT / 3);
+
+	lightning_bolt_new(system, vect2d_new(WINDOW_WIDTH / 2, 0), target, 3);
+}
+
+/**
+ * @brief bolts from random points along the top of the window to random points along the bottom, of random thickness
+ */
+static void scene_spawn_storm(LightningSystem *system, int frame, int bolts)
+{
+	int i;
+	Vect2d start, end;
+
+	for(i = 0; i < bolts; i++)
+	{
+		start = vect2d_new(rand() % WINDOW_WIDTH, 0);
+		end = vect2d_new(rand() % WINDOW_WIDTH, WINDOW_HEIGHT);
+		lightning_bolt_new(system, start, end, 1 + rand() % 3);
+	}
+}
+
+/**
+ * @brief the thinnest bolts, which have the most points, from corner to corner so they are as long as the window allows
+ */
+static void scene_spawn_longest(LightningSystem *system, int frame, int bolts)
+{
+	int i;
+
+	for(i = 0; i < bolts; i++)
+	{
+		if((frame + i) % 2)
+		{
+			lightning_bolt_new(system, vect2d_new(0, 0), vect2d_new(WINDOW_WIDTH, WINDOW_HEIGHT), 1);
+		}
+		else
+		{
+			lightning_bolt_new(system, vect2d_new(WINDOW_WIDTH, 0), vect2d_new(0, WINDOW_HEIGHT), 1);
+		}
+	}
+}
+
+/**
+ * @brief milliseconds between two performance counter readings
+ * @param from		the earlier reading
+ * @param to		the later reading
+ * @return the milliseconds between them
+ */
+static float scene_milliseconds(Uint64 from, Uint64 to)
+{
+	return (float)((double)(to - from) * 1000.0 / SDL_GetPerformanceFrequency());
+}
+
+/**
+ * @brief orders floats smallest to largest for qsort
+ */
+static int scene_compare(const void *a, const void *b)
+{
+	float x = *(const float *)a;
+	float y = *(const float *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief sorts frame times and picks out the p50, p99 and max, each percentile is the smallest time at least that share of the frames
+ *			took no longer than
+ * @param times [in,out]	the frame times, sorted in place
+ * @param frames	how many there are
+ * @param stats [out]	the p50, p99 and max
+ */
+static void scene_stats(float *times, int frames, float *stats)
+{
+	qsort(times, frames, sizeof(float), scene_compare);
+	stats[0] = times[MAX((frames * 50 + 99) / 100 - 1, 0)];
+	stats[1] = times[MAX((frames * 99 + 99) / 100 - 1, 0)];
+	stats[2] = times[frames - 1];
+}
+
+/**
+ * @brief plays one scene, timing each phase of every frame
+ * @param system [in,out]	the lightning system to generate in, empty when called and left empty
+ * @param script [in]		the scene
+ * @param frame [out]		where the finished frames are copied to, big enough for the framebuffer
+ * @param results [out]		the p50, p99 and max of each phase
+ * @return 1 if the scene was played, 0 if its frame times could not be allocated
+ */
+static int scene_play(LightningSystem *system, SceneScript *script, Uint8 *frame, float results[SCENE_PHASES][SCENE_STATS])
+{
+	int i, phase, pitch;
+	Uint64 counters[SCENE_PHASES];
+	Uint8 *pixels;
+	float *times;
+
+	times = (float *)malloc(sizeof(float) * script->frames * SCENE_PHASES);
+	if(!times)
+	{
+		slog("scene benchmark failed to allocate frame times");
+		return 0;
+	}
+
+	srand(SCENE_SEED);
+	lightning_system_seed(system, SCENE_SEED);
+	for(i = 0; i < script->frames; i++)
+	{
+		counters[SCENE_GENERATE] = SDL_GetPerformanceCounter();
+		lightning_purge_system(system);
+		script->spawn(system, i, script->bolts);
+
+		counters[SCENE_DRAW] = SDL_GetPerformanceCounter();
+		raster_clear(vect3d_new(0, 0, 0));
+		lightning_raster_all(system);
+		raster_render();
+
+		counters[SCENE_PRESENT] = SDL_GetPerformanceCounter();
+		pixels = raster_get_pixels(&pitch);
+		memcpy(frame, pixels, pitch * WINDOW_HEIGHT);
+
+		counters[SCENE_TOTAL] = SDL_GetPerformanceCounter();
+		for(phase = 0; phase < SCENE_TOTAL; phase++)
+		{
+			times[phase * script->frames + i] = scene_milliseconds(counters[phase], counters[phase + 1]);
+		}
+		times[SCENE_TOTAL * script->frames + i] = scene_milliseconds(counters[SCENE_GENERATE], counters[SCENE_TOTAL]);
+	}
+	lightning_purge_system(system);
+
+	for(phase = 0; phase < SCENE_PHASES; phase++)
+	{
+		scene_stats(&times[phase * script->frames], script->frames, results[phase]);
+	}
+	free(times);
+	return 1;
+}
+
+/**
+ * @brief finds a name in a list of names
+ * @param names [in]	the list
+ * @param count		how many names are in it
+ * @param name		the name to look for
+ * @return the index of the name, -1 if it isn't there
+ */
+static int scene_find(char **names, int count, char *name)
+{
+	int i;
+
+	for(i = 0; i < count; i++)
+	{
+		if(strcmp(names[i], name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief checks every threshold in the baseline file against the results, logging each one that was exceeded. the baseline has to
+ *			have every threshold scene_write_baseline writes, one missing fails the check the same as one exceeded
+ * @param path		the baseline file
+ * @return 1 if every threshold was there and none were exceeded, 0 if one was missing or exceeded or the baseline could not be read
+ */
+static int scene_check_baseline(char *path)
+{
+	FILE *file;
+	char line[256], scene[64], phase[16], stat[16];
+	char *sceneNames[SCENE_COUNT];
+	int i, s, p, t, checked = 0, failed = 0, missing = 0;
+	Uint8 seen[SCENE_COUNT][SCENE_PHASES][SCENE_STATS];
+	float limit;
+
+	file = fopen(path, "r");
+	if(!file)
+	{
+		slog("could not open scene baseline %s", path);
+		return 0;
+	}
+	for(i = 0; i < SCENE_COUNT; i++)
+	{
+		sceneNames[i] = sceneScripts[i].name;
+	}
+	memset(seen, 0, sizeof(seen));
+	while(fgets(line, sizeof(line), file))
+	{
+		if(line[0] == '#' || sscanf(line, "%63s %15s %15s %f", scene, phase, stat, &limit) != 4)
+		{
+			continue;
+		}
+		s = scene_find(sceneNames, SCENE_COUNT, scene);
+		p = scene_find(scenePhaseNames, SCENE_PHASES, phase);
+		t = scene_find(sceneStatNames, SCENE_STATS, stat);
+		if(s < 0 || p < 0 || t < 0)
+		{
+			slog("scene baseline has an unknown threshold: %s %s %s", scene, phase, stat);
+			continue;
+		}
+		checked++;
+		seen[s][p][t] = 1;
+		if(sceneResults[s][p][t] > limit)
+		{
+			slog("scene %s %s %s took %.3f ms, over the baseline's %.3f ms", scene, phase, stat, sceneResults[s][p][t], limit);
+			failed++;
+		}
+	}
+	fclose(file);
+
+	for(s = 0; s < SCENE_COUNT; s++)
+	{
+		for(p = 0; p < SCENE_PHASES; p++)
+		{
+			for(t = 0; t < SCENE_BASELINE_STATS; t++)
+			{
+				if(!seen[s][p][t])
+				{
+					slog("scene baseline has no threshold for %s %s %s", sceneScripts[s].name, scenePhaseNames[p], sceneStatNames[t]);
+					missing++;
+				}
+			}
+		}
+	}
+	slog("scene benchmark: %i of %i thresholds exceeded, %i missing", failed, checked, missing);
+	return checked > 0 && missing == 0 && failed == 0;
+}
+
+/**
+ * @brief rewrites the baseline with thresholds SCENE_HEADROOM over the p50 and p99 of every phase of this run, never under SCENE_FLOOR
+ * @param path		the baseline file
+ * @return 1 if it was written, 0 otherwise
+ */
+static int scene_write_baseline(char *path)
+{
+	FILE *file;
+	int s, p, t;
+
+	file = fopen(path, "w");
+	if(!file)
+	{
+		slog("could not write scene baseline %s", path);
+		return 0;
+	}
+	fprintf(file, "# scene benchmark thresholds, checked by -scenebench and rewritten by -sceneupdate\n");
+	fprintf(file, "# scene phase statistic milliseconds, %.1fx the times of the run that wrote them and at least %.1f ms\n", SCENE_HEADROOM, SCENE_FLOOR);
+	for(s = 0; s < SCENE_COUNT; s++)
+	{
+		for(p = 0; p < SCENE_PHASES; p++)
+		{
+			for(t = 0; t < SCENE_BASELINE_STATS; t++)
+			{
+				fprintf(file, "%s %s %s %.3f\n", sceneScripts[s].name, scenePhaseNames[p], sceneStatNames[t],
+					MAX(sceneResults[s][p][t] * SCENE_HEADROOM, SCENE_FLOOR));
+			}
+		}
+	}
+	if(fclose(file) != 0)
+	{
+		slog("could not write scene baseline %s", path);
+		return 0;
+	}
+	slog("scene benchmark: wrote baseline %s", path);
+	return 1;
+}
+
+/**
+ * @brief plays every scene, logs the p50, p99 and max of each phase and checks them against the baseline, or rewrites the baseline
+ *			from them if options->update is set
+ * @param options [in]	the baseline and how to run
+ * @return 1 if every scene ran within its thresholds, 0 if one was exceeded or the benchmark could not run
+ */
+int scene_run(SceneOptions *options)
+{
+	int s, p, pitch;
+	Uint8 *frame;
+	LightningSystem *system;
+
+	jobs_init_system(options->threads);
+	if(!raster_init_system(WINDOW_WIDTH, WINDOW_HEIGHT))
+	{
+		slog("scene benchmark could not start the rasterizer");
+		return 0;
+	}
+	raster_get_pixels(&pitch);
+	frame = (Uint8 *)malloc(pitch * WINDOW_HEIGHT);
+	system = lightning_system_new(NULL, 1, SCENE_MAX_BOLTS);
+	if(!frame || !system)
+	{
+		slog("scene benchmark failed to initialize");
+		free(frame);
+		lightning_system_free(&system);
+		return 0;
+	}
+
+	for(s = 0; s < SCENE_COUNT; s++)
+	{
+		if(!scene_play(system, &sceneScripts[s], frame, sceneResults[s]))
+		{
+			free(frame);
+			lightning_system_free(&system);
+			return 0;
+		}
+		for(p = 0; p < SCENE_PHASES; p++)
+		{
+			slog("scene %s, %i frames of %i bolts, %s: p50 %.3f ms, p99 %.3f ms, max %.3f ms", sceneScripts[s].name, sceneScripts[s].frames,
+				sceneScripts[s].bolts, scenePhaseNames[p], sceneResults[s][p][0], sceneResults[s][p][1], sceneResults[s][p][2]);
+		}
+	}
+	free(frame);
+	lightning_system_free(&system);
+
+	if(options->update)
+	{
+		return scene_write_baseline(options->baseline);
+	}
+	return scene_check_baseline(options->baseline);
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 
 FILE * __log_file = NULL;
+int __log_echo = 1;
 
 void close_logger()
 {
@@ -27,16 +28,24 @@ void init_logger(const char *log_file_path)
     atexit(close_logger);
 }
 
+void set_logger_echo(int echo)
+{
+    __log_echo = echo;
+}
+
 void _slog(char *f,int l,char *msg,...)
 {
     va_list ap;
     /*echo all logging to stdout*/
-    va_start(ap,msg);
-    fprintf(stdout,"%s:%i: ",f,l);
-    vfprintf(stdout,msg,ap);
-    fprintf(stdout,"\n");
-    va_end(ap);
-    fprintf(stdout,"\n");
+    if (__log_echo)
+    {
+        va_start(ap,msg);
+        fprintf(stdout,"%s:%i: ",f,l);
+        vfprintf(stdout,msg,ap);
+        fprintf(stdout,"\n");
+        va_end(ap);
+        fprintf(stdout,"\n");
+    }
     if (__log_file != NULL)
     {
         va_start(ap,msg);
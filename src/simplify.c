@@ -0,0 +1,105 @@
+#include <stdlib.h>
+
+#include "simplify.h"
+
+/**
+ * @struct a run of points waiting to be simplified
+ * @brief the indexes of the two points that are kept at either end of the run
+ */
+typedef struct SimplifyRange_t
+{
+	int first;
+	int last;
+}SimplifyRange;
+
+/**
+ * @brief simplifies a polyline in place with Douglas-Peucker, without recursing or allocating. the first and last points are
+ *			always kept, and every dropped point is within tolerance of the segment that replaced it
+ * @param points [in,out]	the points of the polyline, the kept points are moved to the front in order
+ * @param numPoints			how many points the polyline has
+ * @param tolerance			largest distance a dropped point may be from the simplified line, 0 or less keeps every point
+ * @return how many points were kept
+ */
+int simplify_polyline(Vect2d *points, int numPoints, float tolerance)
+{
+	SimplifyRange stack[SIMPLIFY_STACK];
+	int top = 0;
+	int i, first, last, farthest;
+	int kept = 1;
+	float tolerance2;
+	float distance, farthestDistance;
+	float chordLength2, along;
+	Vect2d chord, offset;
+
+	if(numPoints < 3 || tolerance <= 0)
+	{
+		return numPoints;
+	}
+	tolerance2 = tolerance * tolerance;
+
+	/*the left half of every split is pushed last so runs finish left to right, the kept points can then be written
+	  over the front of the array as they are found since nothing behind the current run is read again*/
+	stack[top].first = 0;
+	stack[top].last = numPoints - 1;
+	top++;
+	while(top > 0)
+	{
+		top--;
+		first = stack[top].first;
+		last = stack[top].last;
+
+		farthest = -1;
+		farthestDistance = tolerance2;
+		vect2d_subtract(points[last], points[first], chord);
+		chordLength2 = chord.x * chord.x + chord.y * chord.y;
+		for(i = first + 1; i < last; i++)
+		{
+			vect2d_subtract(points[i], points[first], offset);
+			/*squared distance to the segment, bolts can double back so points past either end are measured to that end*/
+			along = chord.x * offset.x + chord.y * offset.y;
+			if(along <= 0)
+			{
+				distance = offset.x * offset.x + offset.y * offset.y;
+			}
+			else if(along >= chordLength2)
+			{
+				vect2d_subtract(points[i], points[last], offset);
+				distance = offset.x * offset.x + offset.y * offset.y;
+			}
+			else
+			{
+				/*inside the segment it is the distance to the line, the cross product is the distance scaled by the chord's length*/
+				distance = chord.x * offset.y - chord.y * offset.x;
+				distance = distance * distance / chordLength2;
+			}
+			if(distance > farthestDistance)
+			{
+				farthestDistance = distance;
+				farthest = i;
+			}
+		}
+
+		if(farthest < 0)
+		{
+			points[kept++] = points[last];
+		}
+		else if(top + 2 > SIMPLIFY_STACK)
+		{
+			/*too deep to split further, keeping every point is always within tolerance*/
+			for(i = first + 1; i <= last; i++)
+			{
+				points[kept++] = points[i];
+			}
+		}
+		else
+		{
+			stack[top].first = farthest;
+			stack[top].last = last;
+			top++;
+			stack[top].first = first;
+			stack[top].last = farthest;
+			top++;
+		}
+	}
+	return kept;
+}
\ No newline at end of file
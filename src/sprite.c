@@ -8,21 +8,16 @@
 #include "graphics.h"
 #include "sprite.h"
 
-static Sprite *spriteList = NULL;
-static int spriteNum = 0;
-static int spriteMax = 0;
-
-
-
 /**
- * @brief	removes one reference from spriteList, if the
+ * @brief	removes one reference from the system's spriteList, if the
  * 			refCount is 0 frees the sprite from spriteList and frees the sprite pointer.
+ * @param [in,out]	system	the sprite system the sprite was loaded from.
  * @param [in,out]	sprite	double pointer to the sprite.
  */
-void sprite_free(Sprite **sprite)
+void sprite_free(SpriteSystem *system, Sprite **sprite)
 {
 	Sprite *target;
-	if(!sprite)
+	if(!system || !sprite)
 	{
 		return;
 	}
@@ -38,102 +33,179 @@ void sprite_free(Sprite **sprite)
 		if(target->image != NULL)
 		{
 			SDL_DestroyTexture(target->image); 
+			target->image = NULL;
 		}
-		spriteNum--;
+		system->spriteNum--;
 	}
 	*sprite = NULL;
 }
 
-/** @brief	closes the sprite system by freeing the entire sprite list and setting the number of sprites in the list to 0*/
-void sprite_close_system()
+/**
+ * @brief	frees a sprite system by destroying every texture in its sprite list and freeing the list, and destroys the pointer to it
+ * @param [in,out]	system	the sprite system to free.
+ */
+void sprite_system_free(SpriteSystem **system)
 {
 	int i;
-	if(!spriteList)
+	SpriteSystem *target;
+	if(!system || !*system)
 	{
-		slog("spriteList not initialized");
 		return;
 	}
-	for(i = 0; i < spriteMax; ++i)
+	target = *system;
+	for(i = 0; i < target->spriteMax; ++i)
 	{
-		if(spriteList[i].image != 0)
+		if(target->spriteList[i].image != 0)
 		{
-			SDL_DestroyTexture(spriteList[i].image);
+			SDL_DestroyTexture(target->spriteList[i].image);
 		}
 	}
 
-	free(spriteList);
-	spriteList = NULL;
-	spriteNum = 0;
-	spriteMax = 0;
+	free(target->spriteList);
+	free(target);
+	*system = NULL;
 }
 
 /**
- *  @brief opens the sprite system by allocating and memsetting the spriteList to have room for the provided number of sprites 
- *  @param	maxSprites	the maximum number of different sprites the spriteList will be able to support
+ *  @brief creates a sprite system by allocating and memsetting a spriteList to have room for the provided number of sprites 
+ *  @param	maxSprites		the maximum number of different sprites the spriteList will be able to support
+ *  @param	[in] renderer	the renderer to load and draw the sprites with
+ *  @return the new sprite system, NULL if it could not be allocated
  */
-void sprite_init_system(int maxSprites)
+SpriteSystem *sprite_system_new(int maxSprites, SDL_Renderer *renderer)
 {
-	int i;
+	SpriteSystem *system;
 	if(maxSprites == 0)
 	{
 		slog("Max sprite == 0");
-		return;
+		return NULL;
 	}
-	spriteList = (Sprite *)malloc(sizeof(Sprite) * maxSprites);
-	if(!spriteList)
+	system = (SpriteSystem *)malloc(sizeof(SpriteSystem));
+	if(!system)
+	{
+		slog("sprite system failed to initialize");
+		return NULL;
+	}
+	memset(system, 0, sizeof(SpriteSystem));
+	system->spriteList = (Sprite *)malloc(sizeof(Sprite) * maxSprites);
+	if(!system->spriteList)
 	{
 		slog("spriteList failed to initialize");
-		return;
+		free(system);
+		return NULL;
+	}
+	memset(system->spriteList, 0, sizeof(Sprite) * maxSprites);
+	system->spriteNum = 0;
+	system->spriteMax = maxSprites;
+	system->renderer = renderer;
+	return system;
+}
+
+/**
+ * @brief finds the embedded copy of an image
+ * @param	[in] filename	the path the image would be loaded from
+ * @return the embedded image, NULL if it wasn't embedded and has to be loaded from disk
+ */
+static SpriteEmbedded *sprite_find_embedded(char *filename)
+{
+	int i;
+
+	for(i = 0; spriteEmbedded[i].filename; i++)
+	{
+		if(strncmp(filename, spriteEmbedded[i].filename, 128) == 0)
+		{
+			return &spriteEmbedded[i];
+		}
 	}
-	memset(spriteList, 0, sizeof(Sprite) * maxSprites);
-	spriteNum = 0;
-	for(i = 0; i < maxSprites; ++i)
+	return NULL;
+}
+
+/**
+ * @brief uploads an embedded image straight into a texture, blended the way SDL_CreateTextureFromSurface sets up a surface with alpha
+ * @param	[in] renderer	the renderer to create the texture for
+ * @param	[in] embedded	the image to upload
+ * @return the texture, NULL if it could not be created
+ */
+static SDL_Texture *sprite_upload_embedded(SDL_Renderer *renderer, SpriteEmbedded *embedded)
+{
+	SDL_Texture *texture;
+
+	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, embedded->w, embedded->h);
+	if(!texture)
 	{
-		spriteList[i].image = NULL;
+		return NULL;
 	}
-	spriteMax = maxSprites;
-	atexit(sprite_close_system);
+	if(SDL_UpdateTexture(texture, NULL, embedded->pixels, embedded->w * 4) != 0)
+	{
+		SDL_DestroyTexture(texture);
+		return NULL;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	return texture;
+}
+
+/**
+ * @brief loads an image from disk and converts it to RGBA bytes, white is made transparent the same as sprite_load's color key
+ * @param	[in] filename	the image to load
+ * @return the converted surface, NULL if it could not be loaded or converted
+ */
+static SDL_Surface *sprite_load_rgba(char *filename)
+{
+	SDL_Surface *loaded, *converted;
+
+	loaded = IMG_Load(filename);
+	if(!loaded)
+	{
+		return NULL;
+	}
+	SDL_SetColorKey(loaded, SDL_TRUE, SDL_MapRGB(loaded->format, 255, 255, 255));
+	converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(loaded);
+	return converted;
 }
 
 /** 
- * @brief loads a sprite into the spriteList using the given info
+ * @brief loads a sprite into the system's spriteList using the given info, images embedded in the binary are uploaded from there
+ *			instead of being loaded from disk
+ * @param	[in,out] system	the sprite system to load into
  * @param	[in] filename	the filepath for the image
  * @param	frameSize		2d vector defining how large a frame of the image will be
  * @param	fpl				the frames per line on the image
  * @param	frames			the total number of frames that the image has, used to know when the sprite has gone through the animation
  * @return A pointer to the sprite with the info provided
  */
-Sprite *sprite_load(char *filename, Vect2d frameSize, int fpl, int frames)
+Sprite *sprite_load(SpriteSystem *system, char *filename, Vect2d frameSize, int fpl, int frames)
 {
 	int i;
 	SDL_Surface *tempSurface;
 	SDL_Texture *tempTexture;
+	SpriteEmbedded *embedded;
+	Vect2d imageSize;
 	Sprite *sprite = NULL;
-	SDL_Renderer *renderer = graphics_get_renderer();
 
-	if(!spriteList)
+	if(!system || !system->spriteList)
 	{
 		slog("spriteList uninitialized");
 		return NULL;
 	}
 	/*first search to see if the requested sprite image is alreday loaded*/
-	for(i = 0; i < spriteMax; i++)
+	for(i = 0; i < system->spriteMax; i++)
 	{
-		if(spriteList[i].refCount == 0)
+		if(system->spriteList[i].refCount == 0)
 		{
 			//this makes it so that the next sprite available in the list will be used if no sprite is found to match this one
 			if(sprite == NULL)
-				sprite = &spriteList[i];
+				sprite = &system->spriteList[i];
 			continue;
 		}
-		if(strncmp(filename, spriteList[i].filename, 128) ==0)
+		if(strncmp(filename, system->spriteList[i].filename, 128) ==0)
 		{
-			spriteList[i].refCount++;
-			return &spriteList[i];
+			system->spriteList[i].refCount++;
+			return &system->spriteList[i];
 		}
 	}
 	/*makesure we have the room for a new sprite*/
-	if(spriteNum + 1 > spriteMax)
+	if(system->spriteNum + 1 > system->spriteMax)
 	{
 		slog("Maximum Sprites Reached.");
 		exit(1);
@@ -141,43 +213,131 @@ Sprite *sprite_load(char *filename, Vect2d frameSize, int fpl, int frames)
 
 	memset(sprite,0,sizeof(Sprite));
 
-	/*if its not already in memory, then load it.*/
-	spriteNum++;
-	tempSurface = IMG_Load(filename);
-
-	if(tempSurface == NULL)
+	/*if its not already in memory, then upload it from the binary or load it.*/
+	system->spriteNum++;
+	embedded = sprite_find_embedded(filename);
+	if(embedded)
 	{
-		slog("unable to load sprite as a surface");
-		exit(4);
+		tempTexture = sprite_upload_embedded(system->renderer, embedded);
+		if(tempTexture == NULL)
+		{
+			slog("unable to upload embedded sprite %s: %s", filename, SDL_GetError());
+			exit(5);
+		}
+		imageSize = vect2d_new(embedded->w, embedded->h);
 	}
 	else
 	{
-		/*sets a transparent color for blitting.*/
-		SDL_SetColorKey(tempSurface, SDL_TRUE , SDL_MapRGB(tempSurface->format, 255,255,255));
-	
-		tempTexture = SDL_CreateTextureFromSurface(renderer, tempSurface);
-		if(tempTexture == NULL)
+		tempSurface = IMG_Load(filename);
+
+		if(tempSurface == NULL)
 		{
-			slog("unable to load sprite as a Texture");
-			exit(5);
+			slog("unable to load sprite as a surface");
+			exit(4);
 		}
+		else
+		{
+			/*sets a transparent color for blitting.*/
+			SDL_SetColorKey(tempSurface, SDL_TRUE , SDL_MapRGB(tempSurface->format, 255,255,255));
+		
+			tempTexture = SDL_CreateTextureFromSurface(system->renderer, tempSurface);
+			if(tempTexture == NULL)
+			{
+				slog("unable to load sprite as a Texture");
+				exit(5);
+			}
+		}
+		imageSize = vect2d_new(tempSurface->w, tempSurface->h);
+		SDL_FreeSurface(tempSurface);
 	}
 	
 	/*then copy the given information to the sprite*/
 	sprite->image = tempTexture;	
 	sprite->fpl = fpl;
-	sprite->imageSize = vect2d_new(tempSurface->w, tempSurface->h); 
+	sprite->imageSize = imageSize; 
 	sprite->frameSize.x = frameSize.x;
 	sprite->frameSize.y = frameSize.y;
 	sprite->filename = filename;
 	sprite->frames = frames;
 	sprite->refCount++;
-	SDL_FreeSurface(tempSurface);
 	return sprite;
 }
 
+/**
+ * @brief loads images from disk the way sprite_load does, converts them to RGBA bytes and writes them as C source for a table of
+ *			SpriteEmbedded, so they can be compiled into the binary in place of sprite_embedded.c
+ * @param	[in] path		the C file to write
+ * @param	[in] filenames	the images to embed, the same paths sprite_load will be asked for
+ * @param	count			how many images there are
+ * @return 1 if every image was written, 0 otherwise
+ */
+int sprite_write_embedded(char *path, char **filenames, int count)
+{
+	int i, x, y, byte;
+	int *sizes;
+	FILE *file;
+	Uint8 *row;
+	SDL_Surface *surface;
+
+	sizes = (int *)malloc(sizeof(int) * 2 * count);
+	if(!sizes)
+	{
+		slog("failed to allocate the sizes of the embedded images");
+		return 0;
+	}
+	file = fopen(path, "w");
+	if(!file)
+	{
+		slog("could not open %s to embed the images in", path);
+		free(sizes);
+		return 0;
+	}
+	fprintf(file, "/*generated by -embed from the images named below, regenerate it whenever one of them changes instead of editing it*/\n");
+	fprintf(file, "#include \"sprite.h\"\n");
+	for(i = 0; i < count; i++)
+	{
+		surface = sprite_load_rgba(filenames[i]);
+		if(!surface)
+		{
+			slog("unable to embed %s: %s", filenames[i], SDL_GetError());
+			fclose(file);
+			free(sizes);
+			return 0;
+		}
+		sizes[i * 2] = surface->w;
+		sizes[i * 2 + 1] = surface->h;
+		fprintf(file, "\n/*%s, %i x %i*/\nstatic const Uint8 spriteEmbedded%i[] =\n{", filenames[i], surface->w, surface->h, i);
+		byte = 0;
+		for(y = 0; y < surface->h; y++)
+		{
+			row = (Uint8 *)surface->pixels + y * surface->pitch;
+			for(x = 0; x < surface->w * 4; x++, byte++)
+			{
+				fprintf(file, "%s0x%02x,", byte % 16 ? " " : "\n\t", row[x]);
+			}
+		}
+		fprintf(file, "\n};\n");
+		SDL_FreeSurface(surface);
+	}
+	fprintf(file, "\nSpriteEmbedded spriteEmbedded[] =\n{\n");
+	for(i = 0; i < count; i++)
+	{
+		fprintf(file, "\t{\"%s\", %i, %i, spriteEmbedded%i},\n", filenames[i], sizes[i * 2], sizes[i * 2 + 1], i);
+	}
+	fprintf(file, "\t{NULL, 0, 0, NULL}\n};\n");
+	free(sizes);
+	if(fclose(file) != 0)
+	{
+		slog("could not write the embedded images to %s", path);
+		return 0;
+	}
+	slog("embedded %i images in %s", count, path);
+	return 1;
+}
+
 /**
  * @brief draws the sprite frame to the screen at the position relative to the camera
+ * @param	[in] system		the sprite system whose renderer to draw with
  * @param	[in] sprite		the image reference to be drawn from
  * @param	frame			the frame of  the image to draw
  * @param	drawPos			2D vector of where the sprite should be drawn in the game world
@@ -186,10 +346,10 @@ Sprite *sprite_load(char *filename, Vect2d frameSize, int fpl, int frames)
  * @param	angle			the angle to rotate it by
  * @param	flip			whether or not to flip the image
  */
-void sprite_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip)
+void sprite_draw(SpriteSystem *system, Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip)
 {
 	SDL_Rect source, destination;
-	SDL_Renderer *renderer = graphics_get_renderer();
+	SDL_Renderer *renderer = system->renderer;
 	if(!sprite)
 	{
 		slog("sprite doesn't point to anything");
@@ -210,6 +370,7 @@ void sprite_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Po
 
 /**
  * @brief draws the sprite frame to the screen with random parameters to give it a blooming effect
+ * @param	[in] system		the sprite system whose renderer to draw with
  * @param	[in] sprite		the image reference to be drawn from
  * @param	frame			the frame of  the image to draw
  * @param	drawPos			2D vector of where the sprite should be drawn in the game world
@@ -218,12 +379,12 @@ void sprite_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Po
  * @param	angle			the angle to rotate it by
  * @param	flip			whether or not to flip the image
  */
-void sprite_bloom_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip)
+void sprite_bloom_draw(SpriteSystem *system, Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale, SDL_Point *center, float angle, SDL_RendererFlip flip)
 {
 	int i;
 	int size_factor;
 	SDL_Rect source, destination;
-	SDL_Renderer *renderer = graphics_get_renderer();
+	SDL_Renderer *renderer = system->renderer;
 	if(!sprite)
 	{
 		slog("sprite doesn't point to anything");
@@ -236,7 +397,12 @@ void sprite_bloom_draw(Sprite *sprite, int frame, Vect2d drawPos, Vect2d scale,
 	source.w = sprite->frameSize.x;
 	source.h = sprite->frameSize.y;
 
-	size_factor = rand() % 25;	
+	/*xorshift instead of rand, a 0 state starts from a fixed seed*/
+	system->randState = system->randState ? system->randState : 0x9e3779b9;
+	system->randState ^= system->randState << 13;
+	system->randState ^= system->randState >> 17;
+	system->randState ^= system->randState << 5;
+	size_factor = system->randState % 25;
 	for(i = 0; i < 1; i++)
 	{
 		destination.x = drawPos.x - (size_factor / 2);
@@ -0,0 +1,43 @@
+/*generated by -embed from the images named below, regenerate it whenever one of them changes instead of editing it*/
+#include "sprite.h"
+
+/*images/middle_chunk.png, 1 x 8*/
+static const Uint8 spriteEmbedded0[] =
+{
+	0xfc, 0xfc, 0xfc, 0x1c, 0xfc, 0xfc, 0xfc, 0x89, 0xfc, 0xfc, 0xfc, 0xe8, 0xfc, 0xfc, 0xfc, 0xfe,
+	0xfc, 0xfc, 0xfc, 0xfe, 0xfc, 0xfc, 0xfc, 0xe8, 0xfc, 0xfc, 0xfc, 0x89, 0xfc, 0xfc, 0xfc, 0x1c,
+};
+
+/*images/left_cap.png, 4 x 8*/
+static const Uint8 spriteEmbedded1[] =
+{
+	0xfc, 0xfc, 0xfc, 0x01, 0xfc, 0xfc, 0xfc, 0x07, 0xfc, 0xfc, 0xfc, 0x11, 0xfc, 0xfc, 0xfc, 0x1a,
+	0xfc, 0xfc, 0xfc, 0x0e, 0xfc, 0xfc, 0xfc, 0x31, 0xfc, 0xfc, 0xfc, 0x5f, 0xfc, 0xfc, 0xfc, 0x83,
+	0xfc, 0xfc, 0xfc, 0x26, 0xfc, 0xfc, 0xfc, 0x76, 0xfc, 0xfc, 0xfc, 0xc4, 0xfc, 0xfc, 0xfc, 0xe6,
+	0xfc, 0xfc, 0xfc, 0x3d, 0xfc, 0xfc, 0xfc, 0xab, 0xfc, 0xfc, 0xfc, 0xf2, 0xfc, 0xfc, 0xfc, 0xfd,
+	0xfc, 0xfc, 0xfc, 0x3d, 0xfc, 0xfc, 0xfc, 0xab, 0xfc, 0xfc, 0xfc, 0xf2, 0xfc, 0xfc, 0xfc, 0xfd,
+	0xfc, 0xfc, 0xfc, 0x26, 0xfc, 0xfc, 0xfc, 0x76, 0xfc, 0xfc, 0xfc, 0xc4, 0xfc, 0xfc, 0xfc, 0xe6,
+	0xfc, 0xfc, 0xfc, 0x0e, 0xfc, 0xfc, 0xfc, 0x31, 0xfc, 0xfc, 0xfc, 0x5f, 0xfc, 0xfc, 0xfc, 0x83,
+	0xfc, 0xfc, 0xfc, 0x01, 0xfc, 0xfc, 0xfc, 0x07, 0xfc, 0xfc, 0xfc, 0x11, 0xfc, 0xfc, 0xfc, 0x1a,
+};
+
+/*images/right_cap.png, 4 x 8*/
+static const Uint8 spriteEmbedded2[] =
+{
+	0xfc, 0xfc, 0xfc, 0x1a, 0xfc, 0xfc, 0xfc, 0x11, 0xfc, 0xfc, 0xfc, 0x07, 0xfc, 0xfc, 0xfc, 0x01,
+	0xfc, 0xfc, 0xfc, 0x83, 0xfc, 0xfc, 0xfc, 0x5f, 0xfc, 0xfc, 0xfc, 0x31, 0xfc, 0xfc, 0xfc, 0x0e,
+	0xfc, 0xfc, 0xfc, 0xe6, 0xfc, 0xfc, 0xfc, 0xc4, 0xfc, 0xfc, 0xfc, 0x76, 0xfc, 0xfc, 0xfc, 0x26,
+	0xfc, 0xfc, 0xfc, 0xfd, 0xfc, 0xfc, 0xfc, 0xf2, 0xfc, 0xfc, 0xfc, 0xab, 0xfc, 0xfc, 0xfc, 0x3d,
+	0xfc, 0xfc, 0xfc, 0xfd, 0xfc, 0xfc, 0xfc, 0xf2, 0xfc, 0xfc, 0xfc, 0xab, 0xfc, 0xfc, 0xfc, 0x3d,
+	0xfc, 0xfc, 0xfc, 0xe6, 0xfc, 0xfc, 0xfc, 0xc4, 0xfc, 0xfc, 0xfc, 0x76, 0xfc, 0xfc, 0xfc, 0x26,
+	0xfc, 0xfc, 0xfc, 0x83, 0xfc, 0xfc, 0xfc, 0x5f, 0xfc, 0xfc, 0xfc, 0x31, 0xfc, 0xfc, 0xfc, 0x0e,
+	0xfc, 0xfc, 0xfc, 0x1a, 0xfc, 0xfc, 0xfc, 0x11, 0xfc, 0xfc, 0xfc, 0x07, 0xfc, 0xfc, 0xfc, 0x01,
+};
+
+SpriteEmbedded spriteEmbedded[] =
+{
+	{"images/middle_chunk.png", 1, 8, spriteEmbedded0},
+	{"images/left_cap.png", 4, 8, spriteEmbedded1},
+	{"images/right_cap.png", 4, 8, spriteEmbedded2},
+	{NULL, 0, 0, NULL}
+};
@@ -0,0 +1,411 @@
+#include <math.h>
+#include <float.h>
+
+#include "vector_batch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VECTOR_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+/*PI from vector.h is only good to five places, the approximations need all of float's*/
+#define VECT_PI					3.14159265f
+#define VECT_HALF_PI			1.57079633f
+#define VECT_TWO_OVER_PI		0.636619772f
+
+/*minimax polynomial for atan on 0 - 1, in powers of the square*/
+#define VECT_ATAN_C1			0.99997726f
+#define VECT_ATAN_C3			-0.33262347f
+#define VECT_ATAN_C5			0.19354346f
+#define VECT_ATAN_C7			-0.11643287f
+#define VECT_ATAN_C9			0.05265332f
+#define VECT_ATAN_C11			-0.01172120f
+
+/*PI/2 split in three so the first two products with the quadrant are exact and the folded angle keeps its accuracy*/
+#define VECT_HALF_PI_1			1.5703125f
+#define VECT_HALF_PI_2			4.837512969970703125e-4f
+#define VECT_HALF_PI_3			7.54978995489188216e-8f
+
+/*minimax polynomials for sin and cos on -PI/4 - PI/4, from Cephes' sinf and cosf*/
+#define VECT_SIN_C3				-1.6666654611e-1f
+#define VECT_SIN_C5				8.3321608736e-3f
+#define VECT_SIN_C7				-1.9515295891e-4f
+#define VECT_COS_C4				4.166664568298827e-2f
+#define VECT_COS_C6				-1.388731625493765e-3f
+#define VECT_COS_C8				2.443315711809948e-5f
+
+/**
+ * @brief	fast atan2, a polynomial on the octant the vector is in. off by at most VECT_ATAN2_ERROR, atan2(0, 0) is 0
+ * @param	y	the y of the vector, finite
+ * @param	x	the x of the vector, finite
+ * @return	the angle of the vector from the x axis, -PI to PI.
+ */
+float vect_atan2(float y, float x)
+{
+	float ax = fabs(x);
+	float ay = fabs(y);
+	float a, s, r;
+
+	/*the smaller over the larger is always 0 - 1, where the polynomial holds, and FLT_MIN keeps 0 / 0 out*/
+	a = MIN(ax, ay) / MAX(MAX(ax, ay), FLT_MIN);
+	s = a * a;
+	r = (((((VECT_ATAN_C11 * s + VECT_ATAN_C9) * s + VECT_ATAN_C7) * s + VECT_ATAN_C5) * s + VECT_ATAN_C3) * s + VECT_ATAN_C1) * a;
+	if(ay > ax)
+	{
+		r = VECT_HALF_PI - r;
+	}
+	if(x < 0)
+	{
+		r = VECT_PI - r;
+	}
+	if(y < 0)
+	{
+		r = -r;
+	}
+	return r;
+}
+
+/**
+ * @brief	fast sine and cosine of the same angle, polynomials on the angle folded into -PI/4 to PI/4. off by at most
+ *			VECT_SINCOS_ERROR within VECT_SINCOS_RANGE of 0
+ * @param	angle	the angle, in radians
+ * @param [out]	sine	the sine of the angle
+ * @param [out]	cosine	the cosine of the angle
+ */
+void vect_sincos(float angle, float *sine, float *cosine)
+{
+	int quadrant;
+	float q, r, z, s, c;
+
+	quadrant = (int)floor(angle * VECT_TWO_OVER_PI + 0.5f);
+	q = (float)quadrant;
+	r = angle - q * VECT_HALF_PI_1;
+	r = r - q * VECT_HALF_PI_2;
+	r = r - q * VECT_HALF_PI_3;
+	z = r * r;
+	s = ((VECT_SIN_C7 * z + VECT_SIN_C5) * z + VECT_SIN_C3) * z * r + r;
+	c = ((VECT_COS_C8 * z + VECT_COS_C6) * z + VECT_COS_C4) * z * z - 0.5f * z + 1.0f;
+
+	/*every quadrant further round swaps the two and flips one of them*/
+	*sine = (quadrant & 1) ? c : s;
+	*cosine = (quadrant & 1) ? s : c;
+	if(quadrant & 2)
+	{
+		*sine = -*sine;
+	}
+	if((quadrant + 1) & 2)
+	{
+		*cosine = -*cosine;
+	}
+}
+
+#ifdef VECTOR_BATCH_SSE2
+/**
+ * @brief loads four vect2ds and splits them into their x and y
+ * @param vects [in]	the four vectors
+ * @param x [out]		their x
+ * @param y [out]		their y
+ */
+static void vect_batch_load(const Vect2d *vects, __m128 *x, __m128 *y)
+{
+	__m128 low = _mm_loadu_ps(&vects[0].x);
+	__m128 high = _mm_loadu_ps(&vects[2].x);
+
+	*x = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+	*y = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+/**
+ * @brief puts four x and y back together and stores them as four vect2ds
+ * @param vects [out]	where the four vectors go
+ * @param x				their x
+ * @param y				their y
+ */
+static void vect_batch_store(Vect2d *vects, __m128 x, __m128 y)
+{
+	_mm_storeu_ps(&vects[0].x, _mm_unpacklo_ps(x, y));
+	_mm_storeu_ps(&vects[2].x, _mm_unpackhi_ps(x, y));
+}
+
+/**
+ * @brief picks from a where the mask is set and from b where it isn't
+ */
+static __m128 vect_batch_select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/**
+ * @brief vect_atan2 of four vectors at once, the same steps in the same order so it gives the same angles
+ */
+static __m128 vect_atan2_sse2(__m128 y, __m128 x)
+{
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 zero = _mm_setzero_ps();
+	__m128 ax = _mm_andnot_ps(sign, x);
+	__m128 ay = _mm_andnot_ps(sign, y);
+	__m128 a, s, r;
+
+	a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(FLT_MIN)));
+	s = _mm_mul_ps(a, a);
+	r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(VECT_ATAN_C11), s), _mm_set1_ps(VECT_ATAN_C9));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(VECT_ATAN_C7));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(VECT_ATAN_C5));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(VECT_ATAN_C3));
+	r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(VECT_ATAN_C1));
+	r = _mm_mul_ps(r, a);
+	r = vect_batch_select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(VECT_HALF_PI), r), r);
+	r = vect_batch_select(_mm_cmplt_ps(x, zero), _mm_sub_ps(_mm_set1_ps(VECT_PI), r), r);
+	return _mm_xor_ps(r, _mm_and_ps(_mm_cmplt_ps(y, zero), sign));
+}
+
+/**
+ * @brief vect_sincos of four angles at once, the same steps in the same order, except that an angle exactly halfway between two
+ *			quadrants is folded into the even one
+ */
+static void vect_sincos_sse2(__m128 angle, __m128 *sine, __m128 *cosine)
+{
+	__m128i quadrant, one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+	__m128 q, r, z, s, c, swap;
+
+	quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(VECT_TWO_OVER_PI)));
+	q = _mm_cvtepi32_ps(quadrant);
+	r = _mm_sub_ps(angle, _mm_mul_ps(q, _mm_set1_ps(VECT_HALF_PI_1)));
+	r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(VECT_HALF_PI_2)));
+	r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(VECT_HALF_PI_3)));
+	z = _mm_mul_ps(r, r);
+
+	s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(VECT_SIN_C7), z), _mm_set1_ps(VECT_SIN_C5));
+	s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(VECT_SIN_C3));
+	s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), r), r);
+	c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(VECT_COS_C8), z), _mm_set1_ps(VECT_COS_C6));
+	c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(VECT_COS_C4));
+	c = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+	c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+	/*bit 1 of the quadrant, and of the quadrant + 1, shifted up into the sign bit*/
+	swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+	*sine = _mm_xor_ps(vect_batch_select(swap, c, s), _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30)));
+	*cosine = _mm_xor_ps(vect_batch_select(swap, s, c),
+		_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30)));
+}
+#endif
+
+/**
+ * @brief	vect_atan2 of every pair of components.
+ * @param [in]	y		the y of every vector
+ * @param [in]	x		the x of every vector
+ * @param [out]	angles	the angle of every vector
+ * @param	count		how many vectors there are
+ */
+void vect_batch_atan2(const float *y, const float *x, float *angles, int count)
+{
+	int i = 0;
+
+#ifdef VECTOR_BATCH_SSE2
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(&angles[i], vect_atan2_sse2(_mm_loadu_ps(&y[i]), _mm_loadu_ps(&x[i])));
+	}
+#endif
+	for(; i < count; i++)
+	{
+		angles[i] = vect_atan2(y[i], x[i]);
+	}
+}
+
+/**
+ * @brief	vect_sincos of every angle.
+ * @param [in]	angles	the angles
+ * @param [out]	sines	the sine of every angle
+ * @param [out]	cosines	the cosine of every angle
+ * @param	count		how many angles there are
+ */
+void vect_batch_sincos(const float *angles, float *sines, float *cosines, int count)
+{
+	int i = 0;
+#ifdef VECTOR_BATCH_SSE2
+	__m128 s, c;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		vect_sincos_sse2(_mm_loadu_ps(&angles[i]), &s, &c);
+		_mm_storeu_ps(&sines[i], s);
+		_mm_storeu_ps(&cosines[i], c);
+	}
+#endif
+	for(; i < count; i++)
+	{
+		vect_sincos(angles[i], &sines[i], &cosines[i]);
+	}
+}
+
+/**
+ * @brief	the length of every vect2d.
+ * @param [in]	vects	the vectors
+ * @param [out]	lengths	the length of every vector
+ * @param	count		how many vectors there are
+ */
+void vect2d_batch_length(const Vect2d *vects, float *lengths, int count)
+{
+	int i = 0;
+#ifdef VECTOR_BATCH_SSE2
+	__m128 x, y;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		vect_batch_load(&vects[i], &x, &y);
+		_mm_storeu_ps(&lengths[i], _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))));
+	}
+#endif
+	for(; i < count; i++)
+	{
+		lengths[i] = vect2d_get_length(vects[i]);
+	}
+}
+
+/**
+ * @brief	normalizes every vect2d in place, vectors of length 0 are left as they are the way vect2d_normalize leaves them.
+ * @param [in,out]	vects	the vectors
+ * @param	count			how many vectors there are
+ */
+void vect2d_batch_normalize(Vect2d *vects, int count)
+{
+	int i = 0;
+#ifdef VECTOR_BATCH_SSE2
+	__m128 x, y, length, scale;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		vect_batch_load(&vects[i], &x, &y);
+		length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+		scale = vect_batch_select(_mm_cmpgt_ps(length, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1.0f), length), _mm_set1_ps(1.0f));
+		vect_batch_store(&vects[i], _mm_mul_ps(x, scale), _mm_mul_ps(y, scale));
+	}
+#endif
+	for(; i < count; i++)
+	{
+		vect2d_normalize(&vects[i]);
+	}
+}
+
+/**
+ * @brief	out = a + b * factor for every vect2d, the step the generators take along a bolt.
+ * @param [out]	out		the results
+ * @param [in]	a		the vectors added to
+ * @param [in]	b		the vectors scaled and added
+ * @param	factor		what every b is scaled by
+ * @param	count		how many vectors there are
+ */
+void vect2d_batch_scale_add(Vect2d *out, const Vect2d *a, const Vect2d *b, float factor, int count)
+{
+	int i = 0;
+	Vect2d step;
+#ifdef VECTOR_BATCH_SSE2
+	__m128 f = _mm_set1_ps(factor);
+
+	/*x and y get the same treatment so they can stay interleaved*/
+	for(; i + 2 <= count; i += 2)
+	{
+		_mm_storeu_ps(&out[i].x, _mm_add_ps(_mm_loadu_ps(&a[i].x), _mm_mul_ps(_mm_loadu_ps(&b[i].x), f)));
+	}
+#endif
+	for(; i < count; i++)
+	{
+		vect2d_scale(step, b[i], factor);
+		vect2d_add(a[i], step, out[i]);
+	}
+}
+
+/**
+ * @brief	rotates every vect2d about the origin by the same angle.
+ * @param [out]	out		the rotated vectors
+ * @param [in]	in		the vectors
+ * @param	angle		how far to rotate them, in radians, positive turns x towards y
+ * @param	count		how many vectors there are
+ */
+void vect2d_batch_rotate(Vect2d *out, const Vect2d *in, float angle, int count)
+{
+	int i = 0;
+	float s = sin(angle);
+	float c = cos(angle);
+	Vect2d v;
+#ifdef VECTOR_BATCH_SSE2
+	__m128 vects, swapped;
+	__m128 cosines = _mm_set1_ps(c);
+	__m128 sines = _mm_set_ps(s, -s, s, -s);
+
+	/*x' = x * c - y * s and y' = y * c + x * s, with x and y swapped in the second register so they stay interleaved*/
+	for(; i + 2 <= count; i += 2)
+	{
+		vects = _mm_loadu_ps(&in[i].x);
+		swapped = _mm_shuffle_ps(vects, vects, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_ps(&out[i].x, _mm_add_ps(_mm_mul_ps(vects, cosines), _mm_mul_ps(swapped, sines)));
+	}
+#endif
+	for(; i < count; i++)
+	{
+		v = in[i];
+		out[i] = vect2d_new(v.x * c - v.y * s, v.y * c + v.x * s);
+	}
+}
+
+/**
+ * @brief	measures every segment of a line through the points, segment i running from points[i] to points[i + 1]. any of the outputs
+ *			can be NULL if it isn't wanted, none of them can be the points.
+ * @param [in]	points		the points along the line
+ * @param	numPoints		how many points there are, there is one segment fewer
+ * @param [out]	lengths		the length of every segment
+ * @param [out]	angles		the angle of every segment from the x axis, from vect_atan2
+ * @param [out]	directions	the unit vector every segment runs along, (1, 0) for segments of length 0 to agree with their angle of 0
+ */
+void vect2d_batch_segments(const Vect2d *points, int numPoints, float *lengths, float *angles, Vect2d *directions)
+{
+	int i = 0;
+	int count = numPoints - 1;
+	float length;
+	Vect2d tangent;
+#ifdef VECTOR_BATCH_SSE2
+	__m128 x0, y0, x1, y1, dx, dy, vlength, nonzero;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		vect_batch_load(&points[i], &x0, &y0);
+		vect_batch_load(&points[i + 1], &x1, &y1);
+		dx = _mm_sub_ps(x1, x0);
+		dy = _mm_sub_ps(y1, y0);
+		vlength = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		if(lengths)
+		{
+			_mm_storeu_ps(&lengths[i], vlength);
+		}
+		if(angles)
+		{
+			_mm_storeu_ps(&angles[i], vect_atan2_sse2(dy, dx));
+		}
+		if(directions)
+		{
+			nonzero = _mm_cmpgt_ps(vlength, _mm_setzero_ps());
+			vect_batch_store(&directions[i], vect_batch_select(nonzero, _mm_div_ps(dx, vlength), _mm_set1_ps(1.0f)),
+				_mm_and_ps(nonzero, _mm_div_ps(dy, vlength)));
+		}
+	}
+#endif
+	for(; i < count; i++)
+	{
+		vect2d_subtract(points[i + 1], points[i], tangent);
+		length = vect2d_get_length(tangent);
+		if(lengths)
+		{
+			lengths[i] = length;
+		}
+		if(angles)
+		{
+			angles[i] = vect_atan2(tangent.y, tangent.x);
+		}
+		if(directions)
+		{
+			directions[i] = length > 0 ? vect2d_new(tangent.x / length, tangent.y / length) : vect2d_new(1, 0);
+		}
+	}
+}
\ No newline at end of file